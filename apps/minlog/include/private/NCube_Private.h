@@ -7,6 +7,7 @@
 #define NCUBE_PRIVATE_H
 
 #include "../NCube.h"
+#include "../../../../include/private/obj_private.h"
 
 /* DATA */
 
@@ -37,4 +38,8 @@ int8_t compareNCubes(const obj *a, const obj *b);
  * manually, instance will be destroyed when reference count reaches 0 */
 void deallocNCube(obj *to_dealloc);
 
+/* returns the class descriptor shared by all NCube instances, so that other
+ * modules may check class membership with OB_ASSERT_CLASS */
+const ob_class * getNCubeClass(void);
+
 #endif
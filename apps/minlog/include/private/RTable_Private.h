@@ -7,6 +7,7 @@
 #define RTABLE_PRIVATE_H
 
 #include "../RTable.h"
+#include "../../../../include/private/obj_private.h"
 #include "../NCube.h"
 
 /* DATA */
@@ -30,6 +31,10 @@ struct RTable_struct{
  * manually, instance will be destroyed when reference count reaches 0 */
 void deallocRTable(obj *to_dealloc);
 
+/* traversal, applies visit to each obvector referenced by the RTable */
+void traverseRTable(const obj *to_traverse, ob_visit_fptr visit,
+                    void *context);
+
 /* used in constructor to determine which Terms covered by which NCubes and
  * which NCubes can be determined to be essential without extra effort */
 void initTermCoverArray(const obvector *cubes, uint32_t term, uint8_t *array);
@@ -7,6 +7,7 @@
 #define TERM_PRIVATE_H
 
 #include "../Term.h"
+#include "../../../../include/private/obj_private.h"
 
 /* DATA */
 
@@ -26,5 +27,9 @@ int8_t compareTerms(const obj *a, const obj *b);
  * manually, instance will be destroyed when reference count reaches 0 */
 void deallocTerm(obj *to_dealloc);
 
+/* returns the class descriptor shared by all Term instances, so that other
+ * modules may check class membership with OB_ASSERT_CLASS */
+const ob_class * getTermClass(void);
+
 
 #endif
@@ -3,6 +3,17 @@
 #include "../../include/private/NCube_Private.h"
 #include "../../include/minlog_funct.h"
 
+/* class descriptor shared by all NCube instances */
+static const ob_class NCube_class = {
+  .classname = "NCube",
+  .size = sizeof(NCube),
+  .dealloc = &deallocNCube,
+  .hash = NULL,
+  .compare = &compareNCubes,
+  .display = NULL,
+  .traverse = NULL
+};
+
 /* PUBLIC METHODS */
 
 NCube * createNCube(uint32_t term, uint8_t is_dont_care){
@@ -186,18 +197,11 @@ char * nCubeStr(const NCube *a, uint8_t is_sop, uint8_t num_var){
 
 NCube * createNCubeWithOrder(uint8_t order){
 
-  static const char classname[] = "NCube";
-
   NCube *new_cube;
 
   assert(order <= 27);
 
-  new_cube = malloc(sizeof(NCube));
-  assert(new_cube != NULL);
-
-  /* initialize reference counting base data */
-  ob_init_base((obj *)new_cube, &deallocNCube, NULL, &compareNCubes, NULL,
-               classname);
+  new_cube = (NCube *)ob_alloc(&NCube_class);
 
   new_cube->terms = malloc(sizeof(uint32_t)*(1<<order));
   assert(new_cube->terms != NULL);
@@ -219,7 +223,8 @@ int8_t compareNCubes(const obj *a, const obj *b){
   NCube *comp_b = (NCube *)b;
 
   assert(a != NULL && b != NULL);
-  assert(ob_has_class(a, "NCube") && ob_has_class(b, "NCube"));
+  OB_ASSERT_CLASS(a, &NCube_class);
+  OB_ASSERT_CLASS(b, &NCube_class);
 
   if(comp_a->order != comp_b->order){
     return OB_NOT_EQUAL;
@@ -240,7 +245,11 @@ void deallocNCube(obj *to_dealloc){
   /* cast generic obj to NCube */
   NCube *instance = (NCube *)to_dealloc;
   assert(instance != NULL);
-  assert(ob_has_class(to_dealloc, "NCube"));
+  OB_ASSERT_CLASS(to_dealloc, &NCube_class);
   free(instance->terms);
   return;
 }
+
+const ob_class * getNCubeClass(void){
+  return &NCube_class;
+}
@@ -1,25 +1,30 @@
 
 #include "../../include/RTable.h"
 #include "../../include/private/RTable_Private.h"
-#include "../../include/Term.h"
+#include "../../include/private/Term_Private.h"
+#include "../../include/private/NCube_Private.h"
 #include "../../include/minlog_funct.h"
 
+/* class descriptor shared by all RTable instances */
+static const ob_class RTable_class = {
+  .classname = "RTable",
+  .size = sizeof(RTable),
+  .dealloc = &deallocRTable,
+  .hash = NULL,
+  .compare = NULL,
+  .display = NULL,
+  .traverse = &traverseRTable
+};
+
 /* PUBLIC METHODS */
 
 /* add arguments to complete initialization as needed, modify RTable.h
  * as well if modifications are made */
 RTable * createRTable(const obvector *prime_implicants, const obvector *terms){
 
-  static const char classname[] = "RTable";
-
   uint64_t i, num_pis, num_terms;
   uint32_t term_num;
-  RTable *new_instance = malloc(sizeof(RTable));
-  assert(new_instance != NULL);
-
-  /* initialize reference counting base of class */
-  ob_init_base((obj *)new_instance, &deallocRTable, NULL, NULL, NULL,
-               classname);
+  RTable *new_instance = (RTable *)ob_alloc(&RTable_class);
 
   new_instance->pis = obvector_copy(prime_implicants);
   new_instance->terms = obvector_copy(terms);
@@ -29,14 +34,16 @@ RTable * createRTable(const obvector *prime_implicants, const obvector *terms){
 
   /* verify vectors are of proper format and allocate/initialize 2D array */
   for(i=0; i<num_pis; i++){
-    assert(ob_has_class(obvector_obj_at_index(new_instance->pis,i), "NCube"));
+    OB_ASSERT_CLASS(obvector_obj_at_index(new_instance->pis,i),
+                    getNCubeClass());
   }
 
   new_instance->cover_flags = malloc(sizeof(uint8_t *)*num_terms);
 
   for(i=0; i<num_terms; i++){
 
-    assert(ob_has_class(obvector_obj_at_index(new_instance->terms,i), "Term"));
+    OB_ASSERT_CLASS(obvector_obj_at_index(new_instance->terms,i),
+                    getTermClass());
 
     new_instance->cover_flags[i] = malloc(sizeof(uint8_t)*num_pis);
     assert(new_instance->cover_flags[i] != NULL);
@@ -144,7 +151,8 @@ void deallocRTable(obj *to_dealloc){
   /* cast generic obj to RTable */
   RTable *instance = (RTable *)to_dealloc;
 
-  assert(to_dealloc && ob_has_class(to_dealloc, "RTable"));
+  assert(to_dealloc);
+  OB_ASSERT_CLASS(to_dealloc, &RTable_class);
 
   num_terms = obvector_length(instance->terms);
   for(i=0; i<num_terms; i++){
@@ -159,6 +167,21 @@ void deallocRTable(obj *to_dealloc){
   return;
 }
 
+void traverseRTable(const obj *to_traverse, ob_visit_fptr visit,
+                    void *context){
+
+  const RTable *instance = (RTable *)to_traverse;
+
+  assert(to_traverse);
+  OB_ASSERT_CLASS(to_traverse, &RTable_class);
+
+  visit((obj *)instance->pis, context);
+  visit((obj *)instance->terms, context);
+  if(instance->essential_pis) visit((obj *)instance->essential_pis, context);
+
+  return;
+}
+
 
 void initTermCoverArray(const obvector *cubes, uint32_t term, uint8_t *array){
 
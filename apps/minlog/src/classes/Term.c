@@ -2,18 +2,22 @@
 #include "../../include/Term.h"
 #include "../../include/private/Term_Private.h"
 
+/* class descriptor shared by all Term instances */
+static const ob_class Term_class = {
+  .classname = "Term",
+  .size = sizeof(Term),
+  .dealloc = &deallocTerm,
+  .hash = NULL,
+  .compare = &compareTerms,
+  .display = NULL,
+  .traverse = NULL
+};
+
 /* PUBLIC METHODS */
 
 Term * createTerm(uint32_t term){
 
-  static char classname[] = "Term";
-
-  Term *new_instance = malloc(sizeof(Term));
-  assert(new_instance != NULL);
-
-  /* initialize reference counting base data */
-  ob_init_base((obj *)new_instance, &deallocTerm, NULL, &compareTerms, NULL,
-               classname);
+  Term *new_instance = (Term *)ob_alloc(&Term_class);
 
   new_instance->term = term;
   return new_instance;
@@ -32,7 +36,8 @@ int8_t compareTerms(const obj *a, const obj *b){
   Term *comp_b = (Term *)b;
 
   assert(a != NULL && b != NULL);
-  assert(ob_has_class(a, "Term") && ob_has_class(b, "Term"));
+  OB_ASSERT_CLASS(a, &Term_class);
+  OB_ASSERT_CLASS(b, &Term_class);
 
   if(comp_a->term > comp_b->term) return OB_GREATER_THAN;
   else if(comp_a->term < comp_b->term) return OB_LESS_THAN;
@@ -43,6 +48,10 @@ void deallocTerm(obj *to_dealloc){
   /* cast generic obj to Term */
   Term *instance = (Term *)to_dealloc;
   assert(instance != NULL);
-  assert(ob_has_class(to_dealloc, "Term"));
+  OB_ASSERT_CLASS(to_dealloc, &Term_class);
   return;
 }
+
+const ob_class * getTermClass(void){
+  return &Term_class;
+}
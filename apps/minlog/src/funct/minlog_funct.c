@@ -1,7 +1,7 @@
 
 #include "../../include/minlog_funct.h"
-#include "../../include/NCube.h"
-#include "../../include/Term.h"
+#include "../../include/private/NCube_Private.h"
+#include "../../include/private/Term_Private.h"
 #include <regex.h>
 
 uint8_t numOneBits(uint32_t num){
@@ -176,7 +176,7 @@ obvector * findLargestPrimeImplicants(const obvector *terms,
   for(i=0; i<maxi; i++){
     /* get term for cube creation */
     tmp_term = (Term *)obvector_obj_at_index(terms, i);
-    assert(ob_has_class((obj *)tmp_term, "Term"));
+    OB_ASSERT_CLASS(tmp_term, getTermClass());
 
     /* create cube from term, which is not a dont care cube */
     tmp_cube = createNCube(getTermValue(tmp_term), 0);
@@ -197,7 +197,7 @@ obvector * findLargestPrimeImplicants(const obvector *terms,
     for(i=0; i<maxi; i++){
       /* get term for cube creation */
       tmp_term = (Term *)obvector_obj_at_index(dont_cares, i);
-      assert(ob_has_class((obj *)tmp_term, "Term"));
+      OB_ASSERT_CLASS(tmp_term, getTermClass());
 
       /* create cube from term, which is not a dont care cube */
       tmp_cube = createNCube(getTermValue(tmp_term), 1);
@@ -301,7 +301,7 @@ void printEqnVector(const obvector *essential_pis, uint8_t is_sop,
   printf("\nReduced Equation:\n");
   for(i=0; i<obvector_length(essential_pis); i++){
 
-    assert(ob_has_class(obvector_obj_at_index(essential_pis, i), "NCube"));
+    OB_ASSERT_CLASS(obvector_obj_at_index(essential_pis, i), getNCubeClass());
     cubestr = nCubeStr((NCube *)obvector_obj_at_index(essential_pis, i), is_sop,
                         num_var);
     printf("%s", cubestr);
@@ -11,6 +11,7 @@ int main(int argc, char **argv){
 
   obvector *terms, *dont_cares, *pis, *essential_pis;
   RTable *reduction_table;
+  ob_arena *arena;
   uint8_t is_minterms, num_var;
   uint32_t max_term, numchar, substrlen;
   int i;
@@ -58,6 +59,11 @@ int main(int argc, char **argv){
   }
   eqnstr[numchar] = '\0'; /* add null terminator to string */
 
+  /* every intermediate cube, term and table lives until the result is printed,
+   * so allocate all of them in an arena and free them at once */
+  arena = ob_arena_new();
+  ob_arena_enter(arena);
+
   terms = obvector_new(32);
   dont_cares = obvector_new(32);
 
@@ -76,24 +82,18 @@ int main(int argc, char **argv){
   /* find prime implicants */
   pis = findLargestPrimeImplicants(terms, dont_cares);
 
-  dont_cares = (obvector *)ob_release((obj *)dont_cares);
-
   /* create the table used to reduce the prime implicants to the minimal
    * essential prime implicants */
   reduction_table = createRTable(pis, terms);
 
-  terms = (obvector *)ob_release((obj *)terms);
-  pis = (obvector *)ob_release((obj *)pis);
-
   /* find the minimal function representation */
   essential_pis = findEssentialPIs(reduction_table, num_var);
 
-  reduction_table = (RTable *)ob_release((obj *)reduction_table);
-
   /* print the result to stdout */
   printEqnVector(essential_pis, !is_minterms, num_var);
 
-  essential_pis = (obvector *)ob_release((obj *)essential_pis);
+  ob_arena_exit();
+  ob_arena_destroy(arena);
 
   return 0;
 }
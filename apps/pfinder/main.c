@@ -28,31 +28,38 @@ int main(){
   candidate = obint_new(3);
   while(1){
 
+    // temporaries of each iteration are autoreleased into a pool, and are
+    // released together when the pool is drained at the end of the iteration
+    ob_push_autorelease_pool();
+
     maybe_prime = 1;
 
     // search for a prime factor of candidate
     for(i=0; i<obvector_length(primes); i++){
-      remainder = obint_mod(candidate, (obint *)obvector_obj_at_index(primes, i));
+      remainder = (obint *)ob_autorelease((obj *)obint_mod(candidate,
+                                (obint *)obvector_obj_at_index(primes, i)));
       // if the remainder is 0 then the candidate number is not prime
-      if(obint_is_zero(remainder)) maybe_prime = 0;
-      ob_release((obj *)remainder);
-      if(!maybe_prime) break;
+      if(obint_is_zero(remainder)){
+        maybe_prime = 0;
+        break;
+      }
     }
 
     // if the number is still maybe prime then it is now definitely prime,
     // add it to the end of the primes vector
     if(maybe_prime){
       obvector_store_at_index(primes, (obj *)candidate, obvector_length(primes));
-      numstr = obint_to_string(candidate);
+      numstr = (obstring *)ob_autorelease((obj *)obint_to_string(candidate));
       printf("Prime found: %s\n", obstring_cstring(numstr));
-      ob_release((obj *)numstr);
     }
 
-    // increment candidate by 2 and ob_release old candidate, it is not needed
-    // by main loop
+    // increment candidate by 2, the old candidate is not needed by the main
+    // loop after this iteration
     next = obint_add_primitive(candidate, 2);
-    ob_release((obj *)candidate);
+    ob_autorelease((obj *)candidate);
     candidate = next;
+
+    ob_drain_autorelease_pool();
   }
 }
 
@@ -29,6 +29,12 @@ obdeque * obdeque_new(void);
  * @brief Copy Constructor, creates a new obdeque that contains the same
  * contents as an obdeque instance
  *
+ * @details Copying takes constant time, the copy shares the nodes of to_copy
+ * until either deque is modified, which then copies the nodes of the modified
+ * deque. Only the iterator passed to the modification is moved to the copied
+ * nodes, other iterators of the modified deque are invalidated and fail an
+ * assertion if used with it again, rather than modifying its copies
+ *
  * @param to_copy An instance of obdeque to copy
  *
  * @return Pointer to a newly created and initialized instance of obdeque
@@ -124,6 +130,42 @@ uint8_t obdeque_iterate_next(const obdeque *deque, obdeque_iterator *it);
  */
 uint8_t obdeque_iterate_prev(const obdeque *deque, obdeque_iterator *it);
 
+/**
+ * @brief Positions a cursor at the head of an obdeque
+ *
+ * @param deque An instance of obdeque
+ * @param cursor Cursor to position, usually declared on the stack
+ *
+ * @retval 0 deque is empty, cursor is not positioned at any element
+ * @retval non-zero cursor is positioned at the head of deque
+ *
+ * @details Unlike an obdeque_iterator a cursor is not allocated and does not
+ * retain the node it is positioned at. A full traversal takes the form
+ * `if(obdeque_cursor_begin(d, &c)) do{...}while(obdeque_cursor_next(&c));`
+ *
+ * @warning The cursor must not be used once deque is modified or released
+ */
+uint8_t obdeque_cursor_begin(const obdeque *deque, ob_cursor *cursor);
+
+/**
+ * @brief Advances a cursor of an obdeque to the next element closer to the
+ * tail of the obdeque
+ *
+ * @param cursor Cursor positioned by obdeque_cursor_begin
+ *
+ * @retval 0 cursor was at the tail, and is unchanged
+ * @retval non-zero cursor was advanced
+ */
+uint8_t obdeque_cursor_next(ob_cursor *cursor);
+
+/**
+ * @brief Returns the obj at the position of an obdeque cursor
+ *
+ * @param cursor Cursor positioned by obdeque_cursor_begin
+ * @return The obj stored at the cursor, not retained for the caller
+ */
+obj * obdeque_cursor_get(const ob_cursor *cursor);
+
 /**
  * @brief Add an obj to the head of an obdeque
  *
@@ -174,6 +216,24 @@ obdeque * obdeque_join(const obdeque *d1, const obdeque *d2);
  */
 uint8_t obdeque_find_obj(const obdeque *deque, const obj *to_find);
 
+/**
+ * @brief Searches an obdeque for an obj using a specified comparision function
+ *
+ * @param deque An instance of obdeque
+ * @param to_find An instance of any Offbrand compatible class to search for
+ * within the deque
+ * @param funct A pointer to a comparision function that returns a int8_t when
+ * given two obj * arguments, called with to_find first
+ *
+ * @retval 0 to_find not found within deque
+ * @retval 1 to_find found within the deque
+ *
+ * @details funct is never called with a NULL argument. See
+ * OB_DEFINE_TYPED_COMPARE.
+ */
+uint8_t obdeque_find_obj_with_funct(const obdeque *deque, const obj *to_find,
+                                    ob_compare_fptr funct);
+
 /**
  * @brief Sorts an obdeque from least-to-greatest or greatest-to-least using
  * the standard compare function
@@ -22,6 +22,10 @@ typedef struct obint_struct obint;
  * @param num Integer value for new obint
  *
  * @return An instance of obint with value given by num
+ *
+ * @details Small values, from -5 to 256 unless the library was built with a
+ * different OB_INT_CACHE_MIN and OB_INT_CACHE_MAX, return a preallocated
+ * immortal instance shared by all callers instead of allocating
  */
 obint * obint_new(int64_t num);
 
@@ -197,5 +201,31 @@ obint * obint_mod(const obint *a, const obint *b);
  */
 obint * obint_mod_primitive(const obint *a, int64_t b);
 
+/**
+ * @brief Compares two instances of obint without dispatching through the
+ * class descriptor
+ *
+ * @param a A non-NULL pointer to type obint
+ * @param b A non-NULL pointer to type obint
+ *
+ * @retval OB_LESS_THAN a is less than b
+ * @retval OB_GREATER_THAN a is greater than b
+ * @retval OB_EQUAL_TO a is equal to b
+ *
+ * @details Returns the same value as ob_compare, for callers that already
+ * know both arguments are obints. See ob_compare_typed.
+ */
+int8_t obint_compare_typed(const obint *a, const obint *b);
+
+/**
+ * @brief Hashes an instance of obint without dispatching through the class
+ * descriptor
+ *
+ * @param a A non-NULL pointer to type obint
+ *
+ * @return The same hash value as ob_hash
+ */
+ob_hash_t obint_hash_typed(const obint *a);
+
 #endif
 
@@ -29,9 +29,25 @@ obmap * obmap_new(void);
  */
 obmap * obmap_new_with_capacity(uint32_t capacity);
 
+/**
+ * @brief Constructor, creates a new, empty obmap instance which does not keep
+ * its values alive
+ * @return Pointer to the newly created obmap instance
+ *
+ * @details Values are held through weak handles, see ob_weak_new, while keys
+ * are retained as usual. Once a value is deallocated its key is no longer
+ * found, and the entry is removed from the map the next time it is rehashed,
+ * grown or has a key removed. Copies of the map hold their values weakly as
+ * well.
+ */
+obmap * obmap_new_weak_valued(void);
+
 /**
  * @brief Copy constructor, creates a new obmap with the exact same contents
  * of another obmap
+ * @details Copying takes constant time, the copy shares the pairs and table of
+ * to_copy until either map is modified, which then copies the pairs and
+ * rebuilds the table of the modified map
  * @param to_copy Pointer to an instance of obmap to copy
  * @return A copy of the provided obmap
  */
@@ -57,9 +73,56 @@ void obmap_insert(obmap *m, obj *key, obj *value);
  *
  * @retval NULL Key not found in obmap instance or key bound to NULL value
  * @retval non-NULL Value found at key in obmap
+ *
+ * @details The value is not retained for the caller. For maps created with
+ * obmap_new_weak_valued, NULL is also returned if the value was deallocated
  */
 obj * obmap_lookup(const obmap *m, const obj *key);
 
+/**
+ * @brief Positions a cursor at the first key-value pair of an obmap, in
+ * insertion order
+ *
+ * @param m Pointer to an instance of obmap
+ * @param cursor Cursor to position, usually declared on the stack
+ *
+ * @retval 0 m is empty, cursor is not positioned at any pair
+ * @retval non-zero cursor is positioned at the first pair
+ *
+ * @details A full traversal takes the form
+ * `if(obmap_cursor_begin(m, &c)) do{...}while(obmap_cursor_next(&c));`
+ *
+ * @warning The cursor must not be used once m is modified or released
+ */
+uint8_t obmap_cursor_begin(const obmap *m, ob_cursor *cursor);
+
+/**
+ * @brief Advances a cursor of an obmap to the next key-value pair
+ *
+ * @param cursor Cursor positioned by obmap_cursor_begin
+ *
+ * @retval 0 cursor was at the last pair, and is unchanged
+ * @retval non-zero cursor was advanced
+ */
+uint8_t obmap_cursor_next(ob_cursor *cursor);
+
+/**
+ * @brief Returns the key of the pair at the position of an obmap cursor
+ *
+ * @param cursor Cursor positioned by obmap_cursor_begin
+ * @return The key of the pair, not retained for the caller
+ */
+obj * obmap_cursor_get(const ob_cursor *cursor);
+
+/**
+ * @brief Returns the value of the pair at the position of an obmap cursor
+ *
+ * @param cursor Cursor positioned by obmap_cursor_begin
+ * @return The value of the pair, not retained for the caller. For maps created
+ * with obmap_new_weak_valued, NULL if the value was deallocated
+ */
+obj * obmap_cursor_value(const ob_cursor *cursor);
+
 /**
  * @brief Removes a key-value pair from an obmap
  *
@@ -79,7 +142,9 @@ void obmap_remove(obmap *m, obj *key);
  * @param m Pointer to an instance of obmap
  *
  * @details This method is useful for ensuring that mutable keys will still lead
- * to valid lookups of the associated values even after key(s) have been altered
+ * to valid lookups of the associated values even after key(s) have been
+ * altered. Maps created with obmap_new_weak_valued drop entries whose values
+ * were deallocated while rehashing
  */
 void obmap_rehash(obmap *m);
 
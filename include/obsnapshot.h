@@ -0,0 +1,197 @@
+/**
+ * @file obsnapshot.h
+ * @brief obsnapshot Public Interface
+ * @author theck
+ */
+
+#ifndef OBSNAPSHOT_H
+#define OBSNAPSHOT_H
+
+#include "offbrand.h"
+
+/** Class type declaration */
+typedef struct obsnapshot_struct obsnapshot;
+
+/**
+ * @brief Reference to an instance frozen in a snapshot, valid for as long as
+ * the snapshot it was read from. OBSNAPSHOT_NONE references NULL
+ */
+typedef uint64_t obsnapshot_ref;
+
+/** Reference to a NULL instance, or to no instance at all */
+#define OBSNAPSHOT_NONE 0
+
+/** Kind of a reference to NULL, or of a reference that is not valid */
+#define OBSNAPSHOT_NULL 0
+/** Kind of a reference to a frozen obstring */
+#define OBSNAPSHOT_STRING 1
+/** Kind of a reference to a frozen obvector */
+#define OBSNAPSHOT_VECTOR 2
+/** Kind of a reference to a frozen obmap */
+#define OBSNAPSHOT_MAP 3
+
+
+/* PUBLIC METHODS */
+
+/**
+ * @brief Freezes an obstring, obvector or obmap into a snapshot file
+ *
+ * @param root Instance to freeze, may be NULL. Vectors may hold obstrings,
+ * obvectors, obmaps and NULL, maps must be keyed by obstrings and hold the
+ * same values as vectors
+ * @param path Path of the file to write, replaced if it exists
+ *
+ * @retval 0 The file could not be written
+ * @retval non-zero The snapshot was written
+ *
+ * @details Pairs of maps bound to NULL are not written, and an instance
+ * reachable more than once is written once per path to it
+ */
+uint8_t obsnapshot_write(const obj *root, const char *path);
+
+/**
+ * @brief Constructor, maps a snapshot file read only into memory
+ *
+ * @param path Path of a file written by obsnapshot_write
+ *
+ * @return A new instance of obsnapshot, or NULL if the file could not be
+ * mapped or is not a snapshot written on a machine of the same byte order
+ *
+ * @details Opening takes constant time whatever the size of the snapshot, the
+ * file is read on demand as it is queried and its pages are shared by all
+ * processes mapping it. Each query checks the bounds of the data it reads, so
+ * a damaged snapshot yields OBSNAPSHOT_NONE rather than faulting. References
+ * to an instance that was not written before the instance holding them are
+ * damaged as well, so thawing a damaged snapshot always terminates
+ */
+obsnapshot * obsnapshot_open(const char *path);
+
+/**
+ * @brief Returns the reference to the instance frozen by obsnapshot_write
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @return Reference to the root instance
+ */
+obsnapshot_ref obsnapshot_root(const obsnapshot *s);
+
+/**
+ * @brief Returns the kind of the instance at a reference
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference read from s
+ *
+ * @return OBSNAPSHOT_STRING, OBSNAPSHOT_VECTOR or OBSNAPSHOT_MAP, or
+ * OBSNAPSHOT_NULL if ref is OBSNAPSHOT_NONE or not valid
+ */
+uint8_t obsnapshot_kind(const obsnapshot *s, obsnapshot_ref ref);
+
+/**
+ * @brief Number of characters of a frozen obstring, elements of a frozen
+ * obvector or pairs of a frozen obmap
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference read from s
+ * @return Length of the instance, 0 if ref is not valid
+ */
+uint32_t obsnapshot_length(const obsnapshot *s, obsnapshot_ref ref);
+
+/**
+ * @brief Returns the characters of a frozen obstring without copying them
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference to a frozen obstring
+ * @param length Set to the length of the string if not NULL
+ *
+ * @return NUL terminated characters within the mapping of s, or NULL if ref
+ * does not reference a frozen obstring
+ *
+ * @warning The characters must not be used once s is released
+ */
+const char * obsnapshot_string(const obsnapshot *s, obsnapshot_ref ref,
+                               uint32_t *length);
+
+/**
+ * @brief Returns the reference stored at an index of a frozen obvector
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference to a frozen obvector
+ * @param index Index of the element, negative indices count from the end
+ *
+ * @return Reference to the element, OBSNAPSHOT_NONE if the element is NULL,
+ * index is out of bounds or ref does not reference a frozen obvector
+ */
+obsnapshot_ref obsnapshot_at_index(const obsnapshot *s, obsnapshot_ref ref,
+                                   int64_t index);
+
+/**
+ * @brief Looks up a key in the hash table of a frozen obmap
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference to a frozen obmap
+ * @param key Characters of the key, need not be NUL terminated
+ * @param length Number of characters of the key
+ *
+ * @return Reference to the value bound to key, OBSNAPSHOT_NONE if key is not
+ * bound or ref does not reference a frozen obmap
+ *
+ * @details The lookup reads the mapped table directly and allocates nothing
+ */
+obsnapshot_ref obsnapshot_lookup(const obsnapshot *s, obsnapshot_ref ref,
+                                 const char *key, uint32_t length);
+
+/**
+ * @brief Positions a cursor at the first pair of a frozen obmap, pairs are
+ * visited in table order
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference to a frozen obmap
+ * @param cursor Cursor to position, usually declared on the stack
+ *
+ * @retval 0 The map is empty or ref does not reference a frozen obmap, cursor
+ * is not positioned at any pair
+ * @retval non-zero cursor is positioned at the first pair
+ *
+ * @warning The cursor must not be used once s is released
+ */
+uint8_t obsnapshot_cursor_begin(const obsnapshot *s, obsnapshot_ref ref,
+                                ob_cursor *cursor);
+
+/**
+ * @brief Advances a cursor of a frozen obmap to the next pair
+ *
+ * @param cursor Cursor positioned by obsnapshot_cursor_begin
+ *
+ * @retval 0 cursor was at the last pair, and is unchanged
+ * @retval non-zero cursor was advanced
+ */
+uint8_t obsnapshot_cursor_next(ob_cursor *cursor);
+
+/**
+ * @brief Returns the key of the pair at the position of a snapshot cursor
+ *
+ * @param cursor Cursor positioned by obsnapshot_cursor_begin
+ * @return Reference to the frozen obstring key of the pair
+ */
+obsnapshot_ref obsnapshot_cursor_key(const ob_cursor *cursor);
+
+/**
+ * @brief Returns the value of the pair at the position of a snapshot cursor
+ *
+ * @param cursor Cursor positioned by obsnapshot_cursor_begin
+ * @return Reference to the value of the pair
+ */
+obsnapshot_ref obsnapshot_cursor_value(const ob_cursor *cursor);
+
+/**
+ * @brief Copies a frozen instance and everything it references into new
+ * instances of obstring, obvector and obmap
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference read from s
+ *
+ * @return A new instance equal to the instance that was frozen, NULL if ref is
+ * OBSNAPSHOT_NONE or not valid
+ */
+obj * obsnapshot_thaw(const obsnapshot *s, obsnapshot_ref ref);
+
+#endif
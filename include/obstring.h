@@ -26,7 +26,9 @@ typedef struct obstring_struct obstring;
  *
  * @details The provided C string is not stored directly in an instance of
  * obstring and so can be modified and free'd without affecting the created
- * obstring.
+ * obstring. Empty and single printable character strings are preallocated
+ * immortal instances shared by all callers, which are also returned by the
+ * other methods creating obstrings.
  *
  * @warning Constructor assumes that the input string NUL terminated with
  * finite length, any C strings passed to the constructor should be known to
@@ -153,5 +155,31 @@ uint8_t obstring_find_substring(const obstring *s, const char *to_find);
  */
 obstring * obstring_match_regex(const obstring *s, const char *regex);
 
+/**
+ * @brief Compares two instances of obstring without dispatching through the
+ * class descriptor
+ *
+ * @param a A non-NULL pointer to type obstring
+ * @param b A non-NULL pointer to type obstring
+ *
+ * @retval OB_LESS_THAN a is less than b
+ * @retval OB_GREATER_THAN a is greater than b
+ * @retval OB_EQUAL_TO a is equal to b
+ *
+ * @details Returns the same value as ob_compare, for callers that already
+ * know both arguments are obstrings. See ob_compare_typed.
+ */
+int8_t obstring_compare_typed(const obstring *a, const obstring *b);
+
+/**
+ * @brief Hashes an instance of obstring without dispatching through the class
+ * descriptor
+ *
+ * @param s A non-NULL pointer to type obstring
+ *
+ * @return The same hash value as ob_hash
+ */
+ob_hash_t obstring_hash_typed(const obstring *s);
+
 #endif
 
@@ -0,0 +1,103 @@
+/**
+ * @file obtyped.h
+ * @brief Statically dispatched compare and hash functions
+ *
+ * @details
+ * ob_compare and ob_hash accept any instance, so each call checks the classes
+ * of its arguments and calls the class function through the class descriptor.
+ * Where the class of an instance is known when compiling, ob_compare_typed and
+ * ob_hash_typed select the typed function of the class from the static type of
+ * their first argument instead, and fall back to ob_compare and ob_hash for
+ * any other pointer type. Comparing instances of two different known classes
+ * is diagnosed at compile time rather than returning OB_NOT_EQUAL.
+ *
+ * Containers search and sort with a function of two obj pointers.
+ * OB_DEFINE_TYPED_COMPARE defines such a function calling a typed compare
+ * function directly, which the compiler may inline into the definition, for use
+ * with obvector_sort_with_funct, obvector_find_obj_with_funct and the obdeque
+ * equivalents.
+ *
+ * @code
+ * OB_DEFINE_TYPED_COMPARE(compare_ints, obint, obint_compare_typed)
+ *
+ * obvector_sort_with_funct(numbers, OB_LEAST_TO_GREATEST, &compare_ints);
+ * @endcode
+ *
+ * @author theck
+ */
+
+#ifndef OBTYPED_H
+#define OBTYPED_H
+
+#include "offbrand.h"
+#include "obint.h"
+#include "obstring.h"
+
+/**
+ * @brief Compares two instances, calling the typed compare function of the
+ * class of a when its static type is a known class
+ *
+ * @param a A non-NULL pointer to an instance
+ * @param b A non-NULL pointer to an instance of the same class as a
+ *
+ * @return The same value as ob_compare
+ */
+#define ob_compare_typed(a, b) \
+  _Generic((a), \
+    obint *: obint_compare_typed, \
+    const obint *: obint_compare_typed, \
+    obstring *: obstring_compare_typed, \
+    const obstring *: obstring_compare_typed, \
+    default: ob_compare_untyped)((a), (b))
+
+/**
+ * @brief Hashes an instance, calling the typed hash function of its class when
+ * its static type is a known class
+ *
+ * @param x A non-NULL pointer to an instance
+ *
+ * @return The same value as ob_hash
+ */
+#define ob_hash_typed(x) \
+  _Generic((x), \
+    obint *: obint_hash_typed, \
+    const obint *: obint_hash_typed, \
+    obstring *: obstring_hash_typed, \
+    const obstring *: obstring_hash_typed, \
+    default: ob_hash_untyped)((x))
+
+/**
+ * @brief Defines a static function with the signature of ob_compare_fptr that
+ * compares two instances of a class with a typed compare function
+ *
+ * @param name Name of the defined function
+ * @param type Class of the compared instances
+ * @param typed_compare Function comparing two const type pointers
+ *
+ * @details NULL arguments are compared as ob_compare does, as sorting passes
+ * the empty slots of a container to the function.
+ */
+#define OB_DEFINE_TYPED_COMPARE(name, type, typed_compare) \
+  static int8_t name(const obj *a, const obj *b){ \
+    if(a == NULL && b == NULL) return OB_EQUAL_TO; \
+    if(a == NULL || b == NULL) return OB_NOT_EQUAL; \
+    return typed_compare((const type *)a, (const type *)b); \
+  }
+
+/**
+ * @brief Default case of ob_compare_typed, accepts pointers to instances of any
+ * class
+ */
+static inline int8_t ob_compare_untyped(const void *a, const void *b){
+  return ob_compare((const obj *)a, (const obj *)b);
+}
+
+/**
+ * @brief Default case of ob_hash_typed, accepts pointers to instances of any
+ * class
+ */
+static inline ob_hash_t ob_hash_untyped(const void *x){
+  return ob_hash((const obj *)x);
+}
+
+#endif
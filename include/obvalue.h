@@ -0,0 +1,180 @@
+/**
+ * @file obvalue.h
+ * @brief Definitions shared by the unboxed container templates
+ *
+ * @details
+ * obvector, obdeque and obmap hold references to instances, so storing a
+ * machine integer in them requires boxing it in an instance of its own. The
+ * templates obvalue_vector.h, obvalue_deque.h and obvalue_map.h generate
+ * classes holding values of a type chosen when compiling inline, in contiguous
+ * storage. Each generated container is itself an Offbrand compatible class,
+ * reference counted and usable with the standard library, but its elements are
+ * not instances and are neither retained nor released.
+ *
+ * A template is instantiated by defining its parameters and including it. Every
+ * template takes the following parameters, and undefines all parameters once
+ * included:
+ *
+ * - OB_VALUE_NAME: Name of the generated class, which prefixes the name of
+ *   every generated function
+ * - OB_VALUE_TYPE: Type of the stored values, any type that can be assigned
+ * - OB_VALUE_COMPARE(a, b): Optional, compares two values returning
+ *   OB_LESS_THAN, OB_GREATER_THAN or OB_EQUAL_TO. Defaults to the relational
+ *   operators
+ * - OB_VALUE_EQUAL(a, b): Optional, non-zero if two values are equal. Defaults
+ *   to ==, which lets the compiler vectorize searches
+ * - OB_VALUE_HASH(x): Optional, hashes a value given as an lvalue. Defaults to
+ *   ob_hash_bytes over the bytes of the value, see OB_VALUE_DEFAULT_HASH
+ * - OB_VALUE_IMPLEMENTATION: Defined in exactly one source file including the
+ *   instantiation, which then also defines the class descriptor and the
+ *   functions too large to inline
+ *
+ * Values that are equal must hash equally, which hashing their bytes only
+ * guarantees if equal values have equal bytes. Struct types must therefore
+ * define OB_VALUE_EQUAL and OB_VALUE_HASH, hashing their members rather than
+ * their padding, and OB_VALUE_COMPARE if sorted, as must any other type whose
+ * equal values may differ in their bytes. The default hash handles the floating
+ * point types itself, hashing 0.0 and -0.0 equally. NaN is equal to nothing,
+ * itself included, so it is never found by a search, and obvalue_map.h asserts
+ * that no key is NaN. Instantiations are usually wrapped in a header of their
+ * own:
+ *
+ * @code
+ * // u32vector.h
+ * #ifndef U32VECTOR_H
+ * #define U32VECTOR_H
+ * #define OB_VALUE_NAME u32vector
+ * #define OB_VALUE_TYPE uint32_t
+ * #include "obvalue_vector.h"
+ * #endif
+ *
+ * // u32vector.c
+ * #define OB_VALUE_IMPLEMENTATION
+ * #include "u32vector.h"
+ * @endcode
+ *
+ * Generated functions assert their arguments as the library classes do, but do
+ * not check the class of their instance arguments, which is known statically.
+ *
+ * A generated class embeds the obj base and defines a class descriptor, so
+ * like the private header of every class, obvalue.h includes
+ * private/obj_private.h. Including a template therefore opts the whole
+ * translation unit into the private definitions of the library, including the
+ * inline fast paths: ob_retain, ob_release, ob_hash and ob_compare become
+ * macros reading the obj base of their arguments directly. They behave as the
+ * functions do, but tie the translation unit to the layout of obj of the
+ * library it was compiled against. Define OB_NO_INLINE_FAST_PATHS before
+ * including a template to call the out of line functions instead.
+ *
+ * @author theck
+ */
+
+#ifndef OBVALUE_H
+#define OBVALUE_H
+
+#include "offbrand.h"
+/* generated classes are class implementations, see the file details above */
+#include "private/obj_private.h"
+
+/** Pastes two tokens together after expanding them */
+#define OB_VALUE_CAT(a, b) OB_VALUE_CAT_EXPANDED(a, b)
+/** Pastes two tokens together, see OB_VALUE_CAT */
+#define OB_VALUE_CAT_EXPANDED(a, b) a##b
+
+/** String literal of a token after expanding it */
+#define OB_VALUE_STR(x) OB_VALUE_STR_EXPANDED(x)
+/** String literal of a token, see OB_VALUE_STR */
+#define OB_VALUE_STR_EXPANDED(x) #x
+
+/** Name of a function generated for the instantiation being included */
+#define OB_VALUE_FN(suffix) OB_VALUE_CAT(OB_VALUE_NAME, suffix)
+
+/** Compares two values with the relational operators */
+#define OB_VALUE_DEFAULT_COMPARE(a, b) \
+  ((a) < (b) ? OB_LESS_THAN : ((b) < (a) ? OB_GREATER_THAN : OB_EQUAL_TO))
+
+/** Tests two values for equality with == */
+#define OB_VALUE_DEFAULT_EQUAL(a, b) ((a) == (b))
+
+/**
+ * @brief Hashes a float, hashing -0.0 as 0.0
+ *
+ * @param value A non-NULL pointer to a float
+ * @param size Unused, for OB_VALUE_DEFAULT_HASH
+ *
+ * @return Hash of the float
+ */
+static inline ob_hash_t ob_value_hash_float(const void *value, size_t size){
+
+  float x;
+
+  (void)size;
+  x = *(const float *)value;
+  if(x == 0) x = 0; /* 0.0 and -0.0 are equal but differ in sign bit */
+
+  return ob_hash_bytes(&x, sizeof(x));
+}
+
+/**
+ * @brief Hashes a double, hashing -0.0 as 0.0
+ *
+ * @param value A non-NULL pointer to a double
+ * @param size Unused, for OB_VALUE_DEFAULT_HASH
+ *
+ * @return Hash of the double
+ */
+static inline ob_hash_t ob_value_hash_double(const void *value, size_t size){
+
+  double x;
+
+  (void)size;
+  x = *(const double *)value;
+  if(x == 0) x = 0; /* 0.0 and -0.0 are equal but differ in sign bit */
+
+  return ob_hash_bytes(&x, sizeof(x));
+}
+
+/**
+ * @brief Hashes a long double, hashing -0.0 as 0.0
+ *
+ * @details The bytes of a long double may include padding, so it is hashed as
+ * the double it rounds to, which is equal for equal long doubles.
+ *
+ * @param value A non-NULL pointer to a long double
+ * @param size Unused, for OB_VALUE_DEFAULT_HASH
+ *
+ * @return Hash of the long double
+ */
+static inline ob_hash_t ob_value_hash_long_double(const void *value,
+                                                  size_t size){
+
+  double x;
+
+  (void)size;
+  x = (double)*(const long double *)value;
+  if(x == 0) x = 0; /* 0.0 and -0.0 are equal but differ in sign bit */
+
+  return ob_hash_bytes(&x, sizeof(x));
+}
+
+/**
+ * Hashes a value given as an lvalue. Floating point values are hashed by the
+ * functions above, so that 0.0 and -0.0 hash equally, and the bytes of other
+ * values are hashed
+ */
+#define OB_VALUE_DEFAULT_HASH(x) \
+  _Generic((x), float: ob_value_hash_float, \
+                double: ob_value_hash_double, \
+                long double: ob_value_hash_long_double, \
+                default: ob_hash_bytes)(&(x), sizeof(x))
+
+/**
+ * Number of values compared between each test for a match while searching. The
+ * comparisons of a block are independent, so the compiler may vectorize them
+ */
+#define OB_VALUE_SCAN_BLOCK 16
+
+/** Capacity of a generated container created with a capacity of 0 */
+#define OB_VALUE_MIN_CAPACITY 4
+
+#endif
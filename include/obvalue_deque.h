@@ -0,0 +1,530 @@
+/**
+ * @file obvalue_deque.h
+ * @brief Template of a double ended queue of unboxed values
+ *
+ * @details
+ * Generates the class OB_VALUE_NAME, holding values of OB_VALUE_TYPE in a ring
+ * buffer. Values are added and removed at either end in constant time, without
+ * allocating a node for each. See obvalue.h for the template parameters. For
+ * an instantiation named u32deque the generated interface is:
+ *
+ * - u32deque * u32deque_new(uint64_t initial_capacity)
+ * - u32deque * u32deque_copy(const u32deque *deque)
+ * - uint64_t u32deque_length(const u32deque *deque)
+ * - uint8_t u32deque_is_empty(const u32deque *deque)
+ * - uint32_t u32deque_at(const u32deque *deque, uint64_t index)
+ * - void u32deque_set(u32deque *deque, uint64_t index, uint32_t value)
+ * - void u32deque_add_at_head(u32deque *deque, uint32_t value)
+ * - void u32deque_add_at_tail(u32deque *deque, uint32_t value)
+ * - uint32_t u32deque_value_at_head(const u32deque *deque)
+ * - uint32_t u32deque_value_at_tail(const u32deque *deque)
+ * - uint32_t u32deque_remove_head(u32deque *deque)
+ * - uint32_t u32deque_remove_tail(u32deque *deque)
+ * - void u32deque_reserve(u32deque *deque, uint64_t capacity)
+ * - void u32deque_clear(u32deque *deque)
+ * - uint8_t u32deque_find(const u32deque *deque, uint32_t value)
+ * - void u32deque_sort(u32deque *deque, int8_t order)
+ *
+ * Indices count from the head. Two deques compare OB_EQUAL_TO if they hold
+ * equal values in the same order, and OB_NOT_EQUAL otherwise.
+ *
+ * @author theck
+ */
+
+#include "obvalue.h"
+
+#ifndef OB_VALUE_NAME
+#error "obvalue_deque.h requires OB_VALUE_NAME"
+#endif
+#ifndef OB_VALUE_TYPE
+#error "obvalue_deque.h requires OB_VALUE_TYPE"
+#endif
+#ifndef OB_VALUE_COMPARE
+#define OB_VALUE_COMPARE(a, b) OB_VALUE_DEFAULT_COMPARE(a, b)
+#endif
+#ifndef OB_VALUE_EQUAL
+#define OB_VALUE_EQUAL(a, b) OB_VALUE_DEFAULT_EQUAL(a, b)
+#endif
+#ifndef OB_VALUE_HASH
+#define OB_VALUE_HASH(x) OB_VALUE_DEFAULT_HASH(x)
+#endif
+
+/** Class type declaration */
+typedef struct OB_VALUE_FN(_struct) OB_VALUE_NAME;
+
+/**
+ * Unboxed deque data, defined in the header so that element access is inlined
+ * into callers. Members must only be accessed by generated functions
+ */
+struct OB_VALUE_FN(_struct){
+  obj base; /**< obj containing reference count and class membership data */
+  OB_VALUE_TYPE *values; /**< ring buffer of capacity values */
+  uint64_t head; /**< index in values of the value at the head */
+  uint64_t length; /**< number of values stored */
+  uint64_t capacity; /**< number of values storage can hold, a power of 2 */
+};
+
+
+/* PUBLIC METHODS */
+
+/**
+ * @brief Creates a new, empty deque
+ *
+ * @param initial_capacity Number of values the deque can hold before resizing,
+ * rounded up to a power of 2
+ *
+ * @return A new instance of OB_VALUE_NAME
+ */
+OB_VALUE_NAME * OB_VALUE_FN(_new)(uint64_t initial_capacity);
+
+/**
+ * @brief Creates a new deque holding a copy of the values of another
+ *
+ * @param deque A non-NULL pointer to the deque to copy
+ *
+ * @return A new instance of OB_VALUE_NAME
+ */
+OB_VALUE_NAME * OB_VALUE_FN(_copy)(const OB_VALUE_NAME *deque);
+
+/**
+ * @brief Changes the capacity of a deque, which never becomes less than its
+ * length, and moves the head value to the start of storage
+ *
+ * @param deque A non-NULL pointer to a deque
+ * @param capacity Number of values the deque can hold before resizing,
+ * rounded up to a power of 2
+ */
+void OB_VALUE_FN(_reserve)(OB_VALUE_NAME *deque, uint64_t capacity);
+
+/**
+ * @brief Sorts the values of a deque from least-to-greatest or
+ * greatest-to-least with OB_VALUE_COMPARE, keeping the order of equal values
+ *
+ * @param deque A non-NULL pointer to a deque
+ * @param order Accepts OB_LEAST_TO_GREATEST or OB_GREATEST_TO_LEAST as valid
+ * sorting orders
+ */
+void OB_VALUE_FN(_sort)(OB_VALUE_NAME *deque, int8_t order);
+
+/**
+ * @brief Returns the number of values in a deque
+ *
+ * @param deque A non-NULL pointer to a deque
+ *
+ * @return Number of values stored
+ */
+static inline uint64_t OB_VALUE_FN(_length)(const OB_VALUE_NAME *deque){
+  assert(deque);
+  return deque->length;
+}
+
+/**
+ * @brief Checks if a deque holds no values
+ *
+ * @param deque A non-NULL pointer to a deque
+ *
+ * @retval 0 The deque holds values
+ * @retval 1 The deque is empty
+ */
+static inline uint8_t OB_VALUE_FN(_is_empty)(const OB_VALUE_NAME *deque){
+  assert(deque);
+  return deque->length == 0;
+}
+
+/**
+ * @brief Returns the value at an index of a deque, counting from the head
+ *
+ * @param deque A non-NULL pointer to a deque
+ * @param index Index less than the length of the deque
+ *
+ * @return Value at index
+ */
+static inline OB_VALUE_TYPE OB_VALUE_FN(_at)(const OB_VALUE_NAME *deque,
+                                             uint64_t index){
+  assert(deque);
+  assert(index < deque->length);
+  return deque->values[(deque->head + index) & (deque->capacity - 1)];
+}
+
+/**
+ * @brief Replaces the value at an index of a deque, counting from the head
+ *
+ * @param deque A non-NULL pointer to a deque
+ * @param index Index less than the length of the deque
+ * @param value Value to store
+ */
+static inline void OB_VALUE_FN(_set)(OB_VALUE_NAME *deque, uint64_t index,
+                                     OB_VALUE_TYPE value){
+  assert(deque);
+  assert(index < deque->length);
+  deque->values[(deque->head + index) & (deque->capacity - 1)] = value;
+}
+
+/**
+ * @brief Adds a value before the head of a deque, doubling its capacity if full
+ *
+ * @param deque A non-NULL pointer to a deque
+ * @param value Value to add
+ */
+static inline void OB_VALUE_FN(_add_at_head)(OB_VALUE_NAME *deque,
+                                             OB_VALUE_TYPE value){
+  assert(deque);
+  if(deque->length == deque->capacity)
+    OB_VALUE_FN(_reserve)(deque, deque->capacity*2);
+  deque->head = (deque->head - 1) & (deque->capacity - 1);
+  deque->values[deque->head] = value;
+  deque->length++;
+}
+
+/**
+ * @brief Adds a value after the tail of a deque, doubling its capacity if full
+ *
+ * @param deque A non-NULL pointer to a deque
+ * @param value Value to add
+ */
+static inline void OB_VALUE_FN(_add_at_tail)(OB_VALUE_NAME *deque,
+                                             OB_VALUE_TYPE value){
+  assert(deque);
+  if(deque->length == deque->capacity)
+    OB_VALUE_FN(_reserve)(deque, deque->capacity*2);
+  deque->values[(deque->head + deque->length) & (deque->capacity - 1)] = value;
+  deque->length++;
+}
+
+/**
+ * @brief Returns the value at the head of a deque
+ *
+ * @param deque A non-NULL pointer to a non-empty deque
+ *
+ * @return Value at the head
+ */
+static inline OB_VALUE_TYPE OB_VALUE_FN(_value_at_head)(
+                                                 const OB_VALUE_NAME *deque){
+  assert(deque);
+  assert(deque->length > 0);
+  return deque->values[deque->head];
+}
+
+/**
+ * @brief Returns the value at the tail of a deque
+ *
+ * @param deque A non-NULL pointer to a non-empty deque
+ *
+ * @return Value at the tail
+ */
+static inline OB_VALUE_TYPE OB_VALUE_FN(_value_at_tail)(
+                                                 const OB_VALUE_NAME *deque){
+  assert(deque);
+  assert(deque->length > 0);
+  return deque->values[(deque->head + deque->length - 1) &
+                       (deque->capacity - 1)];
+}
+
+/**
+ * @brief Removes and returns the value at the head of a deque
+ *
+ * @param deque A non-NULL pointer to a non-empty deque
+ *
+ * @return Removed value
+ */
+static inline OB_VALUE_TYPE OB_VALUE_FN(_remove_head)(OB_VALUE_NAME *deque){
+
+  OB_VALUE_TYPE value;
+
+  assert(deque);
+  assert(deque->length > 0);
+
+  value = deque->values[deque->head];
+  deque->head = (deque->head + 1) & (deque->capacity - 1);
+  deque->length--;
+
+  return value;
+}
+
+/**
+ * @brief Removes and returns the value at the tail of a deque
+ *
+ * @param deque A non-NULL pointer to a non-empty deque
+ *
+ * @return Removed value
+ */
+static inline OB_VALUE_TYPE OB_VALUE_FN(_remove_tail)(OB_VALUE_NAME *deque){
+  assert(deque);
+  assert(deque->length > 0);
+  deque->length--;
+  return deque->values[(deque->head + deque->length) & (deque->capacity - 1)];
+}
+
+/**
+ * @brief Removes all values from a deque, keeping its capacity
+ *
+ * @param deque A non-NULL pointer to a deque
+ */
+static inline void OB_VALUE_FN(_clear)(OB_VALUE_NAME *deque){
+  assert(deque);
+  deque->head = 0;
+  deque->length = 0;
+}
+
+/**
+ * @brief Searches contiguous values for a value equal to another
+ *
+ * @param values First value to search
+ * @param length Number of values to search
+ * @param value Value to search for
+ *
+ * @retval 0 value was not found
+ * @retval 1 value was found
+ */
+static inline uint8_t OB_VALUE_FN(_scan)(const OB_VALUE_TYPE *values,
+                                         uint64_t length,
+                                         OB_VALUE_TYPE value){
+
+  uint64_t i, j;
+  uint8_t found;
+
+  /* test blocks of values without branching, so that the comparisons within
+   * a block can be vectorized */
+  for(i=0; i+OB_VALUE_SCAN_BLOCK<=length; i+=OB_VALUE_SCAN_BLOCK){
+    found = 0;
+    for(j=0; j<OB_VALUE_SCAN_BLOCK; j++)
+      found |= OB_VALUE_EQUAL(values[i+j], value);
+    if(found) return 1;
+  }
+
+  for( ; i<length; i++)
+    if(OB_VALUE_EQUAL(values[i], value)) return 1;
+
+  return 0;
+}
+
+/**
+ * @brief Searches a deque for a value equal to another
+ *
+ * @param deque A non-NULL pointer to a deque
+ * @param value Value to search for
+ *
+ * @retval 0 value was not found in the deque
+ * @retval 1 value exists in the deque
+ */
+static inline uint8_t OB_VALUE_FN(_find)(const OB_VALUE_NAME *deque,
+                                         OB_VALUE_TYPE value){
+
+  uint64_t first;
+
+  assert(deque);
+
+  /* the ring buffer holds at most two contiguous runs of values */
+  first = deque->capacity - deque->head;
+  if(first > deque->length) first = deque->length;
+
+  return OB_VALUE_FN(_scan)(deque->values + deque->head, first, value) ||
+         OB_VALUE_FN(_scan)(deque->values, deque->length - first, value);
+}
+
+
+#ifdef OB_VALUE_IMPLEMENTATION
+
+#include "private/obvalue_sort_private.h"
+
+/* PRIVATE METHODS */
+
+/**
+ * @brief Destructor for a deque, frees its storage
+ * @param to_dealloc An obj pointer to a deque
+ */
+static void OB_VALUE_FN(_destroy)(obj *to_dealloc){
+  assert(to_dealloc);
+  free(((OB_VALUE_NAME *)to_dealloc)->values);
+}
+
+/**
+ * @brief Hash function for a deque, combining the hashes of its values from
+ * head to tail
+ * @param to_hash An obj pointer to a deque
+ * @return Hash of the deque
+ */
+static ob_hash_t OB_VALUE_FN(_hash)(const obj *to_hash){
+
+  uint64_t i;
+  ob_hash_t value;
+  OB_VALUE_TYPE element;
+  const OB_VALUE_NAME *deque = (const OB_VALUE_NAME *)to_hash;
+
+  assert(to_hash);
+
+  value = ob_hash_seed();
+  for(i=0; i<deque->length; i++){
+    element = OB_VALUE_FN(_at)(deque, i);
+    value = ob_hash_combine(value, OB_VALUE_HASH(element));
+  }
+
+  return value;
+}
+
+/**
+ * @brief Compares two deques
+ *
+ * @param a A non-NULL obj pointer to a deque
+ * @param b A non-NULL obj pointer to a deque
+ *
+ * @retval OB_EQUAL_TO The deques hold equal values in the same order
+ * @retval OB_NOT_EQUAL The deques are not equal
+ */
+static int8_t OB_VALUE_FN(_compare)(const obj *a, const obj *b){
+
+  uint64_t i;
+  const OB_VALUE_NAME *comp_a = (const OB_VALUE_NAME *)a;
+  const OB_VALUE_NAME *comp_b = (const OB_VALUE_NAME *)b;
+
+  assert(a);
+  assert(b);
+
+  if(comp_a->length != comp_b->length) return OB_NOT_EQUAL;
+
+  for(i=0; i<comp_a->length; i++)
+    if(!OB_VALUE_EQUAL(OB_VALUE_FN(_at)(comp_a, i),
+                       OB_VALUE_FN(_at)(comp_b, i)))
+      return OB_NOT_EQUAL;
+
+  return OB_EQUAL_TO;
+}
+
+/**
+ * @brief Display function for a deque, values are not printed as their type
+ * is not known to the template
+ * @param to_print A non-NULL obj pointer to a deque
+ */
+static void OB_VALUE_FN(_display)(const obj *to_print){
+
+  const OB_VALUE_NAME *deque = (const OB_VALUE_NAME *)to_print;
+
+  assert(to_print);
+  fprintf(stderr, "%s with %llu values\n", to_print->cls->classname,
+          (unsigned long long)deque->length);
+}
+
+/**
+ * @brief Reports the storage of a deque
+ *
+ * @param to_measure A non-NULL obj pointer to a deque
+ * @param count Function counting each block of storage
+ * @param context Context passed to count
+ */
+static void OB_VALUE_FN(_footprint)(const obj *to_measure,
+                                    ob_storage_fptr count, void *context){
+
+  const OB_VALUE_NAME *deque = (const OB_VALUE_NAME *)to_measure;
+
+  assert(to_measure);
+  assert(count);
+
+  count(deque->values, deque->capacity*sizeof(OB_VALUE_TYPE),
+        (deque->capacity - deque->length)*sizeof(OB_VALUE_TYPE), context);
+}
+
+/** class descriptor shared by all instances of the generated deque */
+static const ob_class OB_VALUE_FN(_class) = {
+  .classname = OB_VALUE_STR(OB_VALUE_NAME),
+  .size = sizeof(OB_VALUE_NAME),
+  .dealloc = &OB_VALUE_FN(_destroy),
+  .hash = &OB_VALUE_FN(_hash),
+  .compare = &OB_VALUE_FN(_compare),
+  .display = &OB_VALUE_FN(_display),
+  .footprint = &OB_VALUE_FN(_footprint)
+};
+
+
+/* PUBLIC METHODS */
+
+OB_VALUE_NAME * OB_VALUE_FN(_new)(uint64_t initial_capacity){
+
+  OB_VALUE_NAME *deque;
+  uint64_t capacity;
+
+  deque = (OB_VALUE_NAME *)ob_alloc(&OB_VALUE_FN(_class));
+
+  capacity = OB_VALUE_MIN_CAPACITY;
+  while(capacity < initial_capacity) capacity *= 2;
+
+  deque->values = malloc(sizeof(OB_VALUE_TYPE)*capacity);
+  assert(deque->values != NULL);
+  deque->head = 0;
+  deque->length = 0;
+  deque->capacity = capacity;
+
+  return deque;
+}
+
+
+OB_VALUE_NAME * OB_VALUE_FN(_copy)(const OB_VALUE_NAME *deque){
+
+  OB_VALUE_NAME *copy;
+  uint64_t first;
+
+  assert(deque);
+
+  copy = OB_VALUE_FN(_new)(deque->length);
+
+  first = deque->capacity - deque->head;
+  if(first > deque->length) first = deque->length;
+  memcpy(copy->values, deque->values + deque->head,
+         sizeof(OB_VALUE_TYPE)*first);
+  memcpy(copy->values + first, deque->values,
+         sizeof(OB_VALUE_TYPE)*(deque->length - first));
+  copy->length = deque->length;
+
+  return copy;
+}
+
+
+void OB_VALUE_FN(_reserve)(OB_VALUE_NAME *deque, uint64_t capacity){
+
+  OB_VALUE_TYPE *values;
+  uint64_t rounded, first;
+
+  assert(deque);
+
+  rounded = OB_VALUE_MIN_CAPACITY;
+  while(rounded < capacity || rounded < deque->length) rounded *= 2;
+
+  values = malloc(sizeof(OB_VALUE_TYPE)*rounded);
+  assert(values != NULL);
+
+  /* unwrap the ring buffer, so the head value is the first of the storage */
+  first = deque->capacity - deque->head;
+  if(first > deque->length) first = deque->length;
+  memcpy(values, deque->values + deque->head, sizeof(OB_VALUE_TYPE)*first);
+  memcpy(values + first, deque->values,
+         sizeof(OB_VALUE_TYPE)*(deque->length - first));
+
+  free(deque->values);
+  deque->values = values;
+  deque->head = 0;
+  deque->capacity = rounded;
+
+  return;
+}
+
+
+void OB_VALUE_FN(_sort)(OB_VALUE_NAME *deque, int8_t order){
+
+  assert(deque);
+
+  /* values must be contiguous to be sorted */
+  if(deque->head + deque->length > deque->capacity)
+    OB_VALUE_FN(_reserve)(deque, deque->capacity);
+
+  OB_VALUE_FN(_sort_values)(deque->values + deque->head, deque->length, order);
+
+  return;
+}
+
+#undef OB_VALUE_IMPLEMENTATION
+#endif
+
+#undef OB_VALUE_NAME
+#undef OB_VALUE_TYPE
+#undef OB_VALUE_COMPARE
+#undef OB_VALUE_EQUAL
+#undef OB_VALUE_HASH
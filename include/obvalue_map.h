@@ -0,0 +1,505 @@
+/**
+ * @file obvalue_map.h
+ * @brief Template of a hash table of unboxed keys and values
+ *
+ * @details
+ * Generates the class OB_VALUE_NAME, mapping keys of OB_VALUE_KEY_TYPE to
+ * values of OB_VALUE_TYPE. Keys and values are stored inline in open addressed
+ * arrays with linear probing, with no allocation per pair, and removal shifts
+ * following pairs back rather than leaving markers. The table is kept at most
+ * three quarters full. See obvalue.h for the common template parameters, keys
+ * additionally take:
+ *
+ * - OB_VALUE_KEY_TYPE: Type of the keys
+ * - OB_VALUE_KEY_EQUAL(a, b): Optional, non-zero if two keys are equal.
+ *   Defaults to ==
+ * - OB_VALUE_KEY_HASH(x): Optional, hashes a key given as an lvalue. Defaults
+ *   to ob_hash_bytes over the bytes of the key, see OB_VALUE_DEFAULT_HASH.
+ *   Like OB_VALUE_HASH, must hash equal keys equally
+ *
+ * OB_VALUE_EQUAL and OB_VALUE_HASH apply to values, and are only used when
+ * maps are compared or hashed. For an instantiation named u32map, mapping
+ * uint32_t keys to double values, the generated interface is:
+ *
+ * - u32map * u32map_new(uint64_t initial_capacity)
+ * - u32map * u32map_copy(const u32map *m)
+ * - uint64_t u32map_length(const u32map *m)
+ * - void u32map_insert(u32map *m, uint32_t key, double value)
+ * - uint8_t u32map_lookup(const u32map *m, uint32_t key, double *value)
+ * - uint8_t u32map_remove(u32map *m, uint32_t key)
+ * - uint8_t u32map_next(const u32map *m, uint64_t *cursor, uint32_t *key,
+ *   double *value)
+ * - void u32map_clear(u32map *m)
+ *
+ * Two maps compare OB_EQUAL_TO if they hold the same keys mapped to equal
+ * values, and OB_NOT_EQUAL otherwise, as obmaps do.
+ *
+ * @author theck
+ */
+
+#include "obvalue.h"
+
+#ifndef OB_VALUE_NAME
+#error "obvalue_map.h requires OB_VALUE_NAME"
+#endif
+#ifndef OB_VALUE_KEY_TYPE
+#error "obvalue_map.h requires OB_VALUE_KEY_TYPE"
+#endif
+#ifndef OB_VALUE_TYPE
+#error "obvalue_map.h requires OB_VALUE_TYPE"
+#endif
+#ifndef OB_VALUE_KEY_EQUAL
+#define OB_VALUE_KEY_EQUAL(a, b) OB_VALUE_DEFAULT_EQUAL(a, b)
+#endif
+#ifndef OB_VALUE_KEY_HASH
+#define OB_VALUE_KEY_HASH(x) OB_VALUE_DEFAULT_HASH(x)
+#endif
+#ifndef OB_VALUE_EQUAL
+#define OB_VALUE_EQUAL(a, b) OB_VALUE_DEFAULT_EQUAL(a, b)
+#endif
+#ifndef OB_VALUE_HASH
+#define OB_VALUE_HASH(x) OB_VALUE_DEFAULT_HASH(x)
+#endif
+
+/** Class type declaration */
+typedef struct OB_VALUE_FN(_struct) OB_VALUE_NAME;
+
+/**
+ * Unboxed map data, defined in the header so that lookups are inlined into
+ * callers. Members must only be accessed by generated functions
+ */
+struct OB_VALUE_FN(_struct){
+  obj base; /**< obj containing reference count and class membership data */
+  OB_VALUE_KEY_TYPE *keys; /**< key of each slot */
+  OB_VALUE_TYPE *values; /**< value of each slot */
+  uint8_t *used; /**< non-zero for each slot holding a pair */
+  uint64_t length; /**< number of pairs stored */
+  uint64_t capacity; /**< number of slots, a power of 2 */
+};
+
+
+/* PUBLIC METHODS */
+
+/**
+ * @brief Creates a new, empty map
+ *
+ * @param initial_capacity Number of pairs the map can hold before resizing
+ *
+ * @return A new instance of OB_VALUE_NAME
+ */
+OB_VALUE_NAME * OB_VALUE_FN(_new)(uint64_t initial_capacity);
+
+/**
+ * @brief Creates a new map holding a copy of the pairs of another
+ *
+ * @param m A non-NULL pointer to the map to copy
+ *
+ * @return A new instance of OB_VALUE_NAME
+ */
+OB_VALUE_NAME * OB_VALUE_FN(_copy)(const OB_VALUE_NAME *m);
+
+/**
+ * @brief Maps a key to a value, replacing any value the key was mapped to
+ *
+ * @param m A non-NULL pointer to a map
+ * @param key Key to map, which must equal itself, so not NaN
+ * @param value Value to map key to
+ */
+void OB_VALUE_FN(_insert)(OB_VALUE_NAME *m, OB_VALUE_KEY_TYPE key,
+                          OB_VALUE_TYPE value);
+
+/**
+ * @brief Removes a key and its value from a map
+ *
+ * @param m A non-NULL pointer to a map
+ * @param key Key to remove
+ *
+ * @retval 0 key was not in the map
+ * @retval 1 key was removed
+ */
+uint8_t OB_VALUE_FN(_remove)(OB_VALUE_NAME *m, OB_VALUE_KEY_TYPE key);
+
+/**
+ * @brief Removes all pairs from a map, keeping its capacity
+ *
+ * @param m A non-NULL pointer to a map
+ */
+void OB_VALUE_FN(_clear)(OB_VALUE_NAME *m);
+
+/**
+ * @brief Returns the number of pairs in a map
+ *
+ * @param m A non-NULL pointer to a map
+ *
+ * @return Number of pairs stored
+ */
+static inline uint64_t OB_VALUE_FN(_length)(const OB_VALUE_NAME *m){
+  assert(m);
+  return m->length;
+}
+
+/**
+ * @brief Finds the slot holding a key, or the empty slot ending its probe
+ * sequence
+ *
+ * @param m A non-NULL pointer to a map
+ * @param key Key to find
+ *
+ * @return Index of the slot
+ */
+static inline uint64_t OB_VALUE_FN(_slot)(const OB_VALUE_NAME *m,
+                                          OB_VALUE_KEY_TYPE key){
+
+  uint64_t slot, mask;
+
+  mask = m->capacity - 1;
+  slot = OB_VALUE_KEY_HASH(key) & mask;
+
+  /* the table is never full, so every probe sequence ends */
+  while(m->used[slot] && !OB_VALUE_KEY_EQUAL(m->keys[slot], key))
+    slot = (slot + 1) & mask;
+
+  return slot;
+}
+
+/**
+ * @brief Looks up the value a key is mapped to
+ *
+ * @param m A non-NULL pointer to a map
+ * @param key Key to look up
+ * @param value Set to the value key is mapped to if found, may be NULL
+ *
+ * @retval 0 key is not in the map
+ * @retval 1 key is in the map
+ */
+static inline uint8_t OB_VALUE_FN(_lookup)(const OB_VALUE_NAME *m,
+                                           OB_VALUE_KEY_TYPE key,
+                                           OB_VALUE_TYPE *value){
+
+  uint64_t slot;
+
+  assert(m);
+
+  slot = OB_VALUE_FN(_slot)(m, key);
+  if(!m->used[slot]) return 0;
+
+  if(value) *value = m->values[slot];
+  return 1;
+}
+
+/**
+ * @brief Iterates over the pairs of a map, in no particular order
+ *
+ * @param m A non-NULL pointer to a map
+ * @param cursor Position of the iteration, set to 0 before the first call
+ * @param key Set to the key of the next pair, may be NULL
+ * @param value Set to the value of the next pair, may be NULL
+ *
+ * @retval 0 No pairs remain, key and value are unchanged
+ * @retval 1 key and value were set to the next pair
+ *
+ * @warning The map must not be modified during an iteration
+ */
+static inline uint8_t OB_VALUE_FN(_next)(const OB_VALUE_NAME *m,
+                                         uint64_t *cursor,
+                                         OB_VALUE_KEY_TYPE *key,
+                                         OB_VALUE_TYPE *value){
+  assert(m);
+  assert(cursor);
+
+  while(*cursor < m->capacity && !m->used[*cursor]) (*cursor)++;
+  if(*cursor == m->capacity) return 0;
+
+  if(key) *key = m->keys[*cursor];
+  if(value) *value = m->values[*cursor];
+  (*cursor)++;
+
+  return 1;
+}
+
+
+#ifdef OB_VALUE_IMPLEMENTATION
+
+/* PRIVATE METHODS */
+
+/**
+ * @brief Allocates the slots of a map, all empty
+ *
+ * @param m A non-NULL pointer to a map
+ * @param capacity Number of slots, a power of 2
+ */
+static void OB_VALUE_FN(_allocate)(OB_VALUE_NAME *m, uint64_t capacity){
+
+  m->keys = malloc(sizeof(OB_VALUE_KEY_TYPE)*capacity);
+  m->values = malloc(sizeof(OB_VALUE_TYPE)*capacity);
+  m->used = calloc(capacity, sizeof(uint8_t));
+  assert(m->keys != NULL && m->values != NULL && m->used != NULL);
+  m->length = 0;
+  m->capacity = capacity;
+}
+
+/**
+ * @brief Doubles the number of slots of a map, reinserting each pair
+ *
+ * @param m A non-NULL pointer to a map
+ */
+static void OB_VALUE_FN(_grow)(OB_VALUE_NAME *m){
+
+  uint64_t i, slot, capacity;
+  OB_VALUE_KEY_TYPE *keys;
+  OB_VALUE_TYPE *values;
+  uint8_t *used;
+
+  keys = m->keys;
+  values = m->values;
+  used = m->used;
+  capacity = m->capacity;
+
+  OB_VALUE_FN(_allocate)(m, capacity*2);
+
+  /* keys are unique, so each is placed in the first empty slot probed */
+  for(i=0; i<capacity; i++){
+    if(!used[i]) continue;
+    slot = OB_VALUE_FN(_slot)(m, keys[i]);
+    m->keys[slot] = keys[i];
+    m->values[slot] = values[i];
+    m->used[slot] = 1;
+    m->length++;
+  }
+
+  free(keys);
+  free(values);
+  free(used);
+}
+
+/**
+ * @brief Destructor for a map, frees its slots
+ * @param to_dealloc An obj pointer to a map
+ */
+static void OB_VALUE_FN(_destroy)(obj *to_dealloc){
+
+  OB_VALUE_NAME *m = (OB_VALUE_NAME *)to_dealloc;
+
+  assert(to_dealloc);
+
+  free(m->keys);
+  free(m->values);
+  free(m->used);
+}
+
+/**
+ * @brief Hash function for a map, independent of the order pairs were added
+ * @param to_hash An obj pointer to a map
+ * @return Hash of the map
+ */
+static ob_hash_t OB_VALUE_FN(_hash)(const obj *to_hash){
+
+  uint64_t i;
+  ob_hash_t value, pair;
+  const OB_VALUE_NAME *m = (const OB_VALUE_NAME *)to_hash;
+
+  assert(to_hash);
+
+  /* sum pair hashes before combining, so order of addition to table does not
+   * matter */
+  value = 0;
+  for(i=0; i<m->capacity; i++){
+    if(!m->used[i]) continue;
+    pair = ob_hash_combine(ob_hash_seed(), OB_VALUE_KEY_HASH(m->keys[i]));
+    value += ob_hash_combine(pair, OB_VALUE_HASH(m->values[i]));
+  }
+
+  return ob_hash_combine(ob_hash_seed(), value);
+}
+
+/**
+ * @brief Compares two maps
+ *
+ * @param a A non-NULL obj pointer to a map
+ * @param b A non-NULL obj pointer to a map
+ *
+ * @retval OB_EQUAL_TO The maps hold the same keys mapped to equal values
+ * @retval OB_NOT_EQUAL The maps are not equal
+ */
+static int8_t OB_VALUE_FN(_compare)(const obj *a, const obj *b){
+
+  uint64_t i;
+  OB_VALUE_TYPE value;
+  const OB_VALUE_NAME *comp_a = (const OB_VALUE_NAME *)a;
+  const OB_VALUE_NAME *comp_b = (const OB_VALUE_NAME *)b;
+
+  assert(a);
+  assert(b);
+
+  if(comp_a->length != comp_b->length) return OB_NOT_EQUAL;
+
+  for(i=0; i<comp_a->capacity; i++){
+    if(!comp_a->used[i]) continue;
+    if(!OB_VALUE_FN(_lookup)(comp_b, comp_a->keys[i], &value) ||
+       !OB_VALUE_EQUAL(comp_a->values[i], value))
+      return OB_NOT_EQUAL;
+  }
+
+  return OB_EQUAL_TO;
+}
+
+/**
+ * @brief Display function for a map, pairs are not printed as their types are
+ * not known to the template
+ * @param to_print A non-NULL obj pointer to a map
+ */
+static void OB_VALUE_FN(_display)(const obj *to_print){
+
+  const OB_VALUE_NAME *m = (const OB_VALUE_NAME *)to_print;
+
+  assert(to_print);
+  fprintf(stderr, "%s with %llu pairs\n", to_print->cls->classname,
+          (unsigned long long)m->length);
+}
+
+/**
+ * @brief Reports the slots of a map
+ *
+ * @param to_measure A non-NULL obj pointer to a map
+ * @param count Function counting each block of storage
+ * @param context Context passed to count
+ */
+static void OB_VALUE_FN(_footprint)(const obj *to_measure,
+                                    ob_storage_fptr count, void *context){
+
+  uint64_t empty;
+  const OB_VALUE_NAME *m = (const OB_VALUE_NAME *)to_measure;
+
+  assert(to_measure);
+  assert(count);
+
+  empty = m->capacity - m->length;
+  count(m->keys, m->capacity*sizeof(OB_VALUE_KEY_TYPE),
+        empty*sizeof(OB_VALUE_KEY_TYPE), context);
+  count(m->values, m->capacity*sizeof(OB_VALUE_TYPE),
+        empty*sizeof(OB_VALUE_TYPE), context);
+  count(m->used, m->capacity, empty, context);
+}
+
+/** class descriptor shared by all instances of the generated map */
+static const ob_class OB_VALUE_FN(_class) = {
+  .classname = OB_VALUE_STR(OB_VALUE_NAME),
+  .size = sizeof(OB_VALUE_NAME),
+  .dealloc = &OB_VALUE_FN(_destroy),
+  .hash = &OB_VALUE_FN(_hash),
+  .compare = &OB_VALUE_FN(_compare),
+  .display = &OB_VALUE_FN(_display),
+  .footprint = &OB_VALUE_FN(_footprint)
+};
+
+
+/* PUBLIC METHODS */
+
+OB_VALUE_NAME * OB_VALUE_FN(_new)(uint64_t initial_capacity){
+
+  OB_VALUE_NAME *m;
+  uint64_t capacity;
+
+  m = (OB_VALUE_NAME *)ob_alloc(&OB_VALUE_FN(_class));
+
+  /* leave a quarter of the slots empty when holding initial_capacity pairs */
+  capacity = OB_VALUE_MIN_CAPACITY;
+  while(capacity*3 < initial_capacity*4) capacity *= 2;
+
+  OB_VALUE_FN(_allocate)(m, capacity);
+
+  return m;
+}
+
+
+OB_VALUE_NAME * OB_VALUE_FN(_copy)(const OB_VALUE_NAME *m){
+
+  OB_VALUE_NAME *copy;
+
+  assert(m);
+
+  /* same capacity keeps every pair in the same slot */
+  copy = (OB_VALUE_NAME *)ob_alloc(&OB_VALUE_FN(_class));
+  OB_VALUE_FN(_allocate)(copy, m->capacity);
+  memcpy(copy->keys, m->keys, sizeof(OB_VALUE_KEY_TYPE)*m->capacity);
+  memcpy(copy->values, m->values, sizeof(OB_VALUE_TYPE)*m->capacity);
+  memcpy(copy->used, m->used, m->capacity);
+  copy->length = m->length;
+
+  return copy;
+}
+
+
+void OB_VALUE_FN(_insert)(OB_VALUE_NAME *m, OB_VALUE_KEY_TYPE key,
+                          OB_VALUE_TYPE value){
+
+  uint64_t slot;
+
+  assert(m);
+  assert(OB_VALUE_KEY_EQUAL(key, key)); /* a NaN key could never be found */
+
+  slot = OB_VALUE_FN(_slot)(m, key);
+
+  if(!m->used[slot]){
+    /* grow before the table is more than three quarters full */
+    if((m->length + 1)*4 > m->capacity*3){
+      OB_VALUE_FN(_grow)(m);
+      slot = OB_VALUE_FN(_slot)(m, key);
+    }
+    m->keys[slot] = key;
+    m->used[slot] = 1;
+    m->length++;
+  }
+
+  m->values[slot] = value;
+
+  return;
+}
+
+
+uint8_t OB_VALUE_FN(_remove)(OB_VALUE_NAME *m, OB_VALUE_KEY_TYPE key){
+
+  uint64_t hole, slot, home, mask;
+
+  assert(m);
+
+  hole = OB_VALUE_FN(_slot)(m, key);
+  if(!m->used[hole]) return 0;
+
+  m->used[hole] = 0;
+  m->length--;
+
+  /* shift back each following pair of the run that would no longer be found
+   * past the hole, that is whose home slot is not cyclically within
+   * (hole, slot] */
+  mask = m->capacity - 1;
+  for(slot=(hole + 1) & mask; m->used[slot]; slot=(slot + 1) & mask){
+    home = OB_VALUE_KEY_HASH(m->keys[slot]) & mask;
+    if(((slot - home) & mask) < ((slot - hole) & mask)) continue;
+    m->keys[hole] = m->keys[slot];
+    m->values[hole] = m->values[slot];
+    m->used[hole] = 1;
+    m->used[slot] = 0;
+    hole = slot;
+  }
+
+  return 1;
+}
+
+
+void OB_VALUE_FN(_clear)(OB_VALUE_NAME *m){
+  assert(m);
+  memset(m->used, 0, m->capacity);
+  m->length = 0;
+}
+
+#undef OB_VALUE_IMPLEMENTATION
+#endif
+
+#undef OB_VALUE_NAME
+#undef OB_VALUE_KEY_TYPE
+#undef OB_VALUE_TYPE
+#undef OB_VALUE_KEY_EQUAL
+#undef OB_VALUE_KEY_HASH
+#undef OB_VALUE_EQUAL
+#undef OB_VALUE_HASH
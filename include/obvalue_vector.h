@@ -0,0 +1,392 @@
+/**
+ * @file obvalue_vector.h
+ * @brief Template of an automatically resizing array of unboxed values
+ *
+ * @details
+ * Generates the class OB_VALUE_NAME, holding values of OB_VALUE_TYPE in a
+ * single contiguous array. See obvalue.h for the template parameters. For an
+ * instantiation named u32vector the generated interface is:
+ *
+ * - u32vector * u32vector_new(uint64_t initial_capacity)
+ * - u32vector * u32vector_copy(const u32vector *v)
+ * - uint64_t u32vector_length(const u32vector *v)
+ * - uint32_t * u32vector_values(const u32vector *v)
+ * - uint32_t u32vector_at(const u32vector *v, uint64_t index)
+ * - void u32vector_set(u32vector *v, uint64_t index, uint32_t value)
+ * - void u32vector_append(u32vector *v, uint32_t value)
+ * - uint32_t u32vector_pop(u32vector *v)
+ * - void u32vector_reserve(u32vector *v, uint64_t capacity)
+ * - void u32vector_clear(u32vector *v)
+ * - uint8_t u32vector_find(const u32vector *v, uint32_t value)
+ * - void u32vector_sort(u32vector *v, int8_t order)
+ *
+ * Two vectors compare OB_EQUAL_TO if they hold equal values in the same order,
+ * and OB_NOT_EQUAL otherwise, as obvectors do.
+ *
+ * @author theck
+ */
+
+#include "obvalue.h"
+
+#ifndef OB_VALUE_NAME
+#error "obvalue_vector.h requires OB_VALUE_NAME"
+#endif
+#ifndef OB_VALUE_TYPE
+#error "obvalue_vector.h requires OB_VALUE_TYPE"
+#endif
+#ifndef OB_VALUE_COMPARE
+#define OB_VALUE_COMPARE(a, b) OB_VALUE_DEFAULT_COMPARE(a, b)
+#endif
+#ifndef OB_VALUE_EQUAL
+#define OB_VALUE_EQUAL(a, b) OB_VALUE_DEFAULT_EQUAL(a, b)
+#endif
+#ifndef OB_VALUE_HASH
+#define OB_VALUE_HASH(x) OB_VALUE_DEFAULT_HASH(x)
+#endif
+
+/** Class type declaration */
+typedef struct OB_VALUE_FN(_struct) OB_VALUE_NAME;
+
+/**
+ * Unboxed vector data, defined in the header so that element access is inlined
+ * into callers. Members must only be accessed by generated functions
+ */
+struct OB_VALUE_FN(_struct){
+  obj base; /**< obj containing reference count and class membership data */
+  OB_VALUE_TYPE *values; /**< contiguous storage of capacity values */
+  uint64_t length; /**< number of values stored */
+  uint64_t capacity; /**< number of values storage can hold */
+};
+
+
+/* PUBLIC METHODS */
+
+/**
+ * @brief Creates a new, empty vector
+ *
+ * @param initial_capacity Number of values the vector can hold before resizing
+ *
+ * @return A new instance of OB_VALUE_NAME
+ */
+OB_VALUE_NAME * OB_VALUE_FN(_new)(uint64_t initial_capacity);
+
+/**
+ * @brief Creates a new vector holding a copy of the values of another
+ *
+ * @param v A non-NULL pointer to the vector to copy
+ *
+ * @return A new instance of OB_VALUE_NAME
+ */
+OB_VALUE_NAME * OB_VALUE_FN(_copy)(const OB_VALUE_NAME *v);
+
+/**
+ * @brief Changes the capacity of a vector, which never becomes less than its
+ * length
+ *
+ * @param v A non-NULL pointer to a vector
+ * @param capacity Number of values the vector can hold before resizing
+ */
+void OB_VALUE_FN(_reserve)(OB_VALUE_NAME *v, uint64_t capacity);
+
+/**
+ * @brief Sorts the values of a vector from least-to-greatest or
+ * greatest-to-least with OB_VALUE_COMPARE, keeping the order of equal values
+ *
+ * @param v A non-NULL pointer to a vector
+ * @param order Accepts OB_LEAST_TO_GREATEST or OB_GREATEST_TO_LEAST as valid
+ * sorting orders
+ */
+void OB_VALUE_FN(_sort)(OB_VALUE_NAME *v, int8_t order);
+
+/**
+ * @brief Returns the number of values in a vector
+ *
+ * @param v A non-NULL pointer to a vector
+ *
+ * @return Number of values stored
+ */
+static inline uint64_t OB_VALUE_FN(_length)(const OB_VALUE_NAME *v){
+  assert(v);
+  return v->length;
+}
+
+/**
+ * @brief Returns the storage of a vector, holding its values at indices 0 to
+ * length-1
+ *
+ * @param v A non-NULL pointer to a vector
+ *
+ * @return Pointer to the first value, valid until the vector is resized
+ */
+static inline OB_VALUE_TYPE * OB_VALUE_FN(_values)(const OB_VALUE_NAME *v){
+  assert(v);
+  return v->values;
+}
+
+/**
+ * @brief Returns the value at an index of a vector
+ *
+ * @param v A non-NULL pointer to a vector
+ * @param index Index less than the length of the vector
+ *
+ * @return Value at index
+ */
+static inline OB_VALUE_TYPE OB_VALUE_FN(_at)(const OB_VALUE_NAME *v,
+                                             uint64_t index){
+  assert(v);
+  assert(index < v->length);
+  return v->values[index];
+}
+
+/**
+ * @brief Replaces the value at an index of a vector
+ *
+ * @param v A non-NULL pointer to a vector
+ * @param index Index less than the length of the vector
+ * @param value Value to store
+ */
+static inline void OB_VALUE_FN(_set)(OB_VALUE_NAME *v, uint64_t index,
+                                     OB_VALUE_TYPE value){
+  assert(v);
+  assert(index < v->length);
+  v->values[index] = value;
+}
+
+/**
+ * @brief Adds a value to the end of a vector, doubling its capacity if full
+ *
+ * @param v A non-NULL pointer to a vector
+ * @param value Value to add
+ */
+static inline void OB_VALUE_FN(_append)(OB_VALUE_NAME *v, OB_VALUE_TYPE value){
+  assert(v);
+  if(v->length == v->capacity) OB_VALUE_FN(_reserve)(v, v->capacity*2);
+  v->values[v->length++] = value;
+}
+
+/**
+ * @brief Removes and returns the value at the end of a vector
+ *
+ * @param v A non-NULL pointer to a non-empty vector
+ *
+ * @return Removed value
+ */
+static inline OB_VALUE_TYPE OB_VALUE_FN(_pop)(OB_VALUE_NAME *v){
+  assert(v);
+  assert(v->length > 0);
+  return v->values[--v->length];
+}
+
+/**
+ * @brief Removes all values from a vector, keeping its capacity
+ *
+ * @param v A non-NULL pointer to a vector
+ */
+static inline void OB_VALUE_FN(_clear)(OB_VALUE_NAME *v){
+  assert(v);
+  v->length = 0;
+}
+
+/**
+ * @brief Searches a vector for a value equal to another
+ *
+ * @param v A non-NULL pointer to a vector
+ * @param value Value to search for
+ *
+ * @retval 0 value was not found in the vector
+ * @retval 1 value exists in the vector
+ */
+static inline uint8_t OB_VALUE_FN(_find)(const OB_VALUE_NAME *v,
+                                         OB_VALUE_TYPE value){
+
+  uint64_t i, j;
+  uint8_t found;
+
+  assert(v);
+
+  /* test blocks of values without branching, so that the comparisons within
+   * a block can be vectorized */
+  for(i=0; i+OB_VALUE_SCAN_BLOCK<=v->length; i+=OB_VALUE_SCAN_BLOCK){
+    found = 0;
+    for(j=0; j<OB_VALUE_SCAN_BLOCK; j++)
+      found |= OB_VALUE_EQUAL(v->values[i+j], value);
+    if(found) return 1;
+  }
+
+  for( ; i<v->length; i++)
+    if(OB_VALUE_EQUAL(v->values[i], value)) return 1;
+
+  return 0;
+}
+
+
+#ifdef OB_VALUE_IMPLEMENTATION
+
+#include "private/obvalue_sort_private.h"
+
+/* PRIVATE METHODS */
+
+/**
+ * @brief Destructor for a vector, frees its storage
+ * @param to_dealloc An obj pointer to a vector
+ */
+static void OB_VALUE_FN(_destroy)(obj *to_dealloc){
+  assert(to_dealloc);
+  free(((OB_VALUE_NAME *)to_dealloc)->values);
+}
+
+/**
+ * @brief Hash function for a vector, combining the hashes of its values in
+ * order
+ * @param to_hash An obj pointer to a vector
+ * @return Hash of the vector
+ */
+static ob_hash_t OB_VALUE_FN(_hash)(const obj *to_hash){
+
+  uint64_t i;
+  ob_hash_t value;
+  const OB_VALUE_NAME *v = (const OB_VALUE_NAME *)to_hash;
+
+  assert(to_hash);
+
+  value = ob_hash_seed();
+  for(i=0; i<v->length; i++)
+    value = ob_hash_combine(value, OB_VALUE_HASH(v->values[i]));
+
+  return value;
+}
+
+/**
+ * @brief Compares two vectors
+ *
+ * @param a A non-NULL obj pointer to a vector
+ * @param b A non-NULL obj pointer to a vector
+ *
+ * @retval OB_EQUAL_TO The vectors hold equal values in the same order
+ * @retval OB_NOT_EQUAL The vectors are not equal
+ */
+static int8_t OB_VALUE_FN(_compare)(const obj *a, const obj *b){
+
+  uint64_t i;
+  const OB_VALUE_NAME *comp_a = (const OB_VALUE_NAME *)a;
+  const OB_VALUE_NAME *comp_b = (const OB_VALUE_NAME *)b;
+
+  assert(a);
+  assert(b);
+
+  if(comp_a->length != comp_b->length) return OB_NOT_EQUAL;
+
+  for(i=0; i<comp_a->length; i++)
+    if(!OB_VALUE_EQUAL(comp_a->values[i], comp_b->values[i]))
+      return OB_NOT_EQUAL;
+
+  return OB_EQUAL_TO;
+}
+
+/**
+ * @brief Display function for a vector, values are not printed as their type
+ * is not known to the template
+ * @param to_print A non-NULL obj pointer to a vector
+ */
+static void OB_VALUE_FN(_display)(const obj *to_print){
+
+  const OB_VALUE_NAME *v = (const OB_VALUE_NAME *)to_print;
+
+  assert(to_print);
+  fprintf(stderr, "%s with %llu values\n", to_print->cls->classname,
+          (unsigned long long)v->length);
+}
+
+/**
+ * @brief Reports the storage of a vector
+ *
+ * @param to_measure A non-NULL obj pointer to a vector
+ * @param count Function counting each block of storage
+ * @param context Context passed to count
+ */
+static void OB_VALUE_FN(_footprint)(const obj *to_measure,
+                                    ob_storage_fptr count, void *context){
+
+  const OB_VALUE_NAME *v = (const OB_VALUE_NAME *)to_measure;
+
+  assert(to_measure);
+  assert(count);
+
+  count(v->values, v->capacity*sizeof(OB_VALUE_TYPE),
+        (v->capacity - v->length)*sizeof(OB_VALUE_TYPE), context);
+}
+
+/** class descriptor shared by all instances of the generated vector */
+static const ob_class OB_VALUE_FN(_class) = {
+  .classname = OB_VALUE_STR(OB_VALUE_NAME),
+  .size = sizeof(OB_VALUE_NAME),
+  .dealloc = &OB_VALUE_FN(_destroy),
+  .hash = &OB_VALUE_FN(_hash),
+  .compare = &OB_VALUE_FN(_compare),
+  .display = &OB_VALUE_FN(_display),
+  .footprint = &OB_VALUE_FN(_footprint)
+};
+
+
+/* PUBLIC METHODS */
+
+OB_VALUE_NAME * OB_VALUE_FN(_new)(uint64_t initial_capacity){
+
+  OB_VALUE_NAME *v;
+
+  v = (OB_VALUE_NAME *)ob_alloc(&OB_VALUE_FN(_class));
+
+  if(initial_capacity < OB_VALUE_MIN_CAPACITY)
+    initial_capacity = OB_VALUE_MIN_CAPACITY;
+
+  v->values = malloc(sizeof(OB_VALUE_TYPE)*initial_capacity);
+  assert(v->values != NULL);
+  v->length = 0;
+  v->capacity = initial_capacity;
+
+  return v;
+}
+
+
+OB_VALUE_NAME * OB_VALUE_FN(_copy)(const OB_VALUE_NAME *v){
+
+  OB_VALUE_NAME *copy;
+
+  assert(v);
+
+  copy = OB_VALUE_FN(_new)(v->length);
+  memcpy(copy->values, v->values, sizeof(OB_VALUE_TYPE)*v->length);
+  copy->length = v->length;
+
+  return copy;
+}
+
+
+void OB_VALUE_FN(_reserve)(OB_VALUE_NAME *v, uint64_t capacity){
+
+  assert(v);
+
+  if(capacity < v->length) capacity = v->length;
+  if(capacity < OB_VALUE_MIN_CAPACITY) capacity = OB_VALUE_MIN_CAPACITY;
+
+  v->values = realloc(v->values, sizeof(OB_VALUE_TYPE)*capacity);
+  assert(v->values != NULL);
+  v->capacity = capacity;
+
+  return;
+}
+
+
+void OB_VALUE_FN(_sort)(OB_VALUE_NAME *v, int8_t order){
+  assert(v);
+  OB_VALUE_FN(_sort_values)(v->values, v->length, order);
+}
+
+#undef OB_VALUE_IMPLEMENTATION
+#endif
+
+#undef OB_VALUE_NAME
+#undef OB_VALUE_TYPE
+#undef OB_VALUE_COMPARE
+#undef OB_VALUE_EQUAL
+#undef OB_VALUE_HASH
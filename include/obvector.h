@@ -30,7 +30,9 @@ obvector * obvector_new(uint32_t initial_capacity);
  * of another obvector.
  *
  * @details The new copy is a shallow copy, it references the same obj pointers
- * rather that creating unique copies of each contained obj
+ * rather that creating unique copies of each contained obj. Copying takes
+ * constant time, the copy shares the storage of to_copy until either vector is
+ * modified, which then copies the storage of the modified vector
  *
  * @param to_copy The obvector instance to be copied
  * @return A new instance of obvector that is a shallow copy of to_copy
@@ -87,6 +89,41 @@ void obvector_store_at_index(obvector *v, obj *to_add, int64_t index);
  */
 obj * obvector_obj_at_index(const obvector *v, int64_t index);
 
+/**
+ * @brief Positions a cursor at the first index of an obvector
+ *
+ * @param v A pointer to an instance of obvector
+ * @param cursor Cursor to position, usually declared on the stack
+ *
+ * @retval 0 v is empty, cursor is not positioned at any index
+ * @retval non-zero cursor is positioned at index 0
+ *
+ * @details A full traversal takes the form
+ * `if(obvector_cursor_begin(v, &c)) do{...}while(obvector_cursor_next(&c));`
+ *
+ * @warning The cursor must not be used once v is modified or released
+ */
+uint8_t obvector_cursor_begin(const obvector *v, ob_cursor *cursor);
+
+/**
+ * @brief Advances a cursor of an obvector to the next index
+ *
+ * @param cursor Cursor positioned by obvector_cursor_begin
+ *
+ * @retval 0 cursor was at the last index, and is unchanged
+ * @retval non-zero cursor was advanced
+ */
+uint8_t obvector_cursor_next(ob_cursor *cursor);
+
+/**
+ * @brief Returns the obj at the index of an obvector cursor
+ *
+ * @param cursor Cursor positioned by obvector_cursor_begin
+ * @return The obj stored at the index, or NULL if the index is empty. The obj
+ * is not retained for the caller
+ */
+obj * obvector_cursor_get(const ob_cursor *cursor);
+
 /**
  * @brief Adds the contents of on vector to the end of another, concatenating
  * the two.
@@ -114,6 +151,25 @@ void obvector_concat(obvector *destination, obvector *to_append);
  */
 uint8_t obvector_find_obj(const obvector *v, const obj *to_find);
 
+/**
+ * @brief Searches for an instance of any Offbrand compatible class in an
+ * obvector using a specified comparision function
+ *
+ * @param v A pointer to an instance of obvector
+ * @param to_find A pointer to an instance of any Offbrand compatible class
+ * @param funct A compare_fptr to a function that returns an int8_t when given
+ * two obj * arguments, called with to_find first
+ *
+ * @retval 0 to_find was not found in the obvector
+ * @retval 1 to_find exists in the obvector
+ *
+ * @details funct is never called with a NULL argument. A function defined with
+ * OB_DEFINE_TYPED_COMPARE compares each element with a direct call to the
+ * typed compare function of a class, rather than through ob_compare.
+ */
+uint8_t obvector_find_obj_with_funct(const obvector *v, const obj *to_find,
+                                     ob_compare_fptr funct);
+
 /**
  * @brief Sorts an obvector from least-to-greatest or greatest-to-least using
  * the standard compare function
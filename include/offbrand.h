@@ -35,12 +35,51 @@
 /** Sorting Order Constant, sort elements from greatest to least*/
 #define OB_GREATEST_TO_LEAST 1
 
+/** Operation Trace Phase Constant, the operation is starting */
+#define OB_OP_TRACE_BEGIN 0
+/** Operation Trace Phase Constant, the operation has completed */
+#define OB_OP_TRACE_END 1
+
+/**
+ * basic generic type used to track reference counts, reference the class
+ * descriptor, and form the basis for all generic container classes and
+ * functions. Each class embeds an obj as its first member, so a pointer to any
+ * class instance is also a valid obj pointer.
+ */
+typedef struct obj_struct obj;
+
+/**
+ * class descriptor, holds the class name and class specific function pointers
+ * shared by every instance of an offbrand compatible class
+ */
+typedef struct ob_class_struct ob_class;
+
+/**
+ * region of instances allocated together and destroyed together, see
+ * ob_arena_new
+ */
+typedef struct ob_arena_struct ob_arena;
+
+/**
+ * weak reference to an instance, which does not keep the instance alive, see
+ * ob_weak_new
+ */
+typedef struct ob_weak_struct ob_weak;
+
+/**
+ * buffered destination of serialized instances, see ob_writer_new_file
+ */
+typedef struct ob_writer_struct ob_writer;
+
+/**
+ * buffered source of serialized instances, see ob_reader_new_file
+ */
+typedef struct ob_reader_struct ob_reader;
+
 /**
- * basic generic type used to track reference counts, store class specific
- * function pointers, and form the basis for all generic container classes
- * and functions.
+ * pool of threads running tasks in parallel, see ob_pool_new
  */
-typedef struct obj_struct * obj;
+typedef struct ob_pool_struct ob_pool;
 
 /**
  * reference count, tracks references to instances of offbrand compatible
@@ -48,6 +87,57 @@ typedef struct obj_struct * obj;
  */
 typedef uint32_t ob_ref_count_t;
 
+/**
+ * allocation statistics of a single class, merged across all threads
+ */
+typedef struct ob_class_stats_struct{
+  const char *classname; /**< name of the class */
+  uint64_t allocations; /**< number of instances ever allocated */
+  uint64_t frees; /**< number of instances ever freed */
+  uint64_t live; /**< number of instances currently allocated */
+  uint64_t peak_live; /**< largest number of instances allocated at once */
+  uint64_t live_bytes; /**< bytes held by currently allocated instances,
+                            excluding class specific storage */
+} ob_class_stats;
+
+/**
+ * memory held by an instance and the instances it references, see
+ * ob_memory_footprint
+ */
+typedef struct ob_footprint_struct{
+  uint64_t shallow_bytes; /**< bytes of the instance and the storage it owns,
+                               excluding referenced instances */
+  uint64_t deep_bytes; /**< bytes of the instance and every instance reachable
+                            from it, counting shared instances and storage
+                            once */
+  uint64_t unused_bytes; /**< bytes of deep_bytes reserved by capacity but
+                              holding nothing */
+  uint64_t objs; /**< number of instances counted by deep_bytes */
+} ob_footprint;
+
+/**
+ * beginning or end of an expensive internal operation, see
+ * ob_set_op_trace_hook
+ */
+typedef struct ob_op_trace_event_struct{
+  const char *operation; /**< name of the function performing the operation */
+  const obj *instance; /**< instance operated on */
+  uint64_t size; /**< number of elements, pairs or digits operated on */
+  uint64_t timestamp_ns; /**< time of the event on the monotonic clock */
+  uint8_t phase; /**< OB_OP_TRACE_BEGIN or OB_OP_TRACE_END */
+} ob_op_trace_event;
+
+/**
+ * position within a container, a plain value usually declared on the stack.
+ * Containers provide begin, next and get functions for cursors, which never
+ * allocate, retain or release anything. Members are private to the container.
+ */
+typedef struct ob_cursor_struct{
+  const obj *container; /**< container being traversed */
+  const void *position; /**< container specific position of the element */
+  uint64_t index; /**< container specific index of the element */
+} ob_cursor;
+
 /** function pointer to a deallocator for any OffBrand compatible class */
 typedef void (*ob_dealloc_fptr)(obj *);
 
@@ -67,28 +157,161 @@ typedef int8_t (*ob_compare_fptr)(const obj *, const obj *);
 /** function pointer to a display function for any offbrand compatible class */
 typedef void (*ob_display_fptr)(const obj *);
 
+/**
+ * function pointer to a visitor, called with each obj referenced by an instance
+ * and the context pointer supplied to the traversal
+ */
+typedef void (*ob_visit_fptr)(obj *, void *);
+
+/**
+ * function pointer to a traversal function for any offbrand compatible class,
+ * applies the visitor to every non-NULL obj the instance holds a reference to
+ */
+typedef void (*ob_traverse_fptr)(const obj *, ob_visit_fptr, void *);
+
+/**
+ * function pointer to a serialization function for any offbrand compatible
+ * class, writes the class specific data of an instance
+ */
+typedef void (*ob_serialize_fptr)(const obj *, ob_writer *);
+
+/**
+ * function pointer to a deserialization function for any offbrand compatible
+ * class, reads the data written by the serialization function of the class
+ * and returns a new instance, or NULL if the data was malformed
+ */
+typedef obj * (*ob_deserialize_fptr)(ob_reader *);
+
+/**
+ * function pointer to a storage counter, called with the address of a block of
+ * storage owned by an instance, the size of the block in bytes, the number of
+ * those bytes reserved but unused, and the context pointer supplied to the
+ * footprint function
+ */
+typedef void (*ob_storage_fptr)(const void *, size_t, size_t, void *);
+
+/**
+ * function pointer to a memory footprint function for any offbrand compatible
+ * class, applies the storage counter to every block of storage the instance
+ * owns apart from its own allocation and referenced objs
+ */
+typedef void (*ob_footprint_fptr)(const obj *, ob_storage_fptr, void *);
+
+/**
+ * function pointer to an operation trace hook, called with each event and the
+ * context pointer supplied along with the hook
+ */
+typedef void (*ob_op_trace_fptr)(const ob_op_trace_event *, void *);
+
+/**
+ * function pointer to a task run by a pool, called with the context pointer
+ * supplied along with the task
+ */
+typedef void (*ob_task_fptr)(void *);
+
+/**
+ * function pointer to the body of a parallel loop, called with the first
+ * iteration of a range, the iteration following its last, and the context
+ * pointer supplied to the loop
+ */
+typedef void (*ob_range_fptr)(uint64_t, uint64_t, void *);
+
 
 /* OFFBRAND STANDARD LIB */
 
 /**
  * @brief Initializes instances of all offbrand compatible classes with a
- * reference count of 1, a deallocator, a hash function, and the provided class
- * name
+ * reference count of 1 and a reference to the class descriptor
+ *
+ * @param instance An newly allocated instance of any offbrand compatible class,
+ * the obj base data is stored within the instance allocation itself
+ * @param cls A pointer to the constant descriptor of the instances class,
+ * which must remain valid for the lifetime of the instance
+ *
+ * @details Each class defines a single static const descriptor that is shared
+ * by all instances, so the per instance base contains only a reference count
+ * and a descriptor pointer.
+ */
+void ob_init_base(obj *instance, const ob_class *cls);
+
+/**
+ * @brief Allocates a new instance of an offbrand compatible class and
+ * initializes its obj base with a reference count of 1
+ *
+ * @param cls A pointer to the constant descriptor of the instances class, whose
+ * size field holds the size of the class struct
+ *
+ * @return A new instance of the class with only the obj base initialized
  *
- * @param instance An newly allocated instance of any offbrand compatible class
- * @param dealloc_funct Function pointer to the deallocator for the instances
- * class
- * @param hash_funct Function pointer to the hash function for the instances
- * class
- * @param compare_funct Function pointer to the compare function for the
- * instances class
- * @param display_funct Function pointer to the display function for the
- * instances class
- * @param classname C string containing instances classname.
+ * @details Small instances are allocated from per thread slab caches of fixed
+ * size blocks, which are reused when instances are released instead of being
+ * returned to malloc. Larger instances, or all instances if the library was
+ * built with OB_NO_SLAB, are allocated with malloc.
  */
-void ob_init_base(obj *instance, ob_dealloc_fptr dealloc_funct,
-                  ob_hash_fptr hash_funct, ob_compare_fptr compare_funct,
-                  ob_display_fptr display_funct, const char *classname);
+obj * ob_alloc(const ob_class *cls);
+
+/**
+ * @brief Creates a new, empty arena
+ *
+ * @return A new arena, which is not active until entered
+ *
+ * @details Instances created by a thread while it has entered an arena are
+ * bump allocated from large chunks owned by the arena. Releasing an arena
+ * instance never deallocates it, instead all arena instances are deallocated
+ * together by ob_arena_destroy, without per instance release cascades between
+ * instances of the same arena. Arena instances may reference and be referenced
+ * by normally allocated instances, but must not be referenced by instances
+ * outliving the arena unless copied out with ob_arena_copy_out.
+ */
+ob_arena * ob_arena_new(void);
+
+/**
+ * @brief Makes an arena the active arena of the calling thread, so that all
+ * following instances created by the thread are allocated within it
+ *
+ * @param arena Arena to enter, which must not already be entered
+ *
+ * @details Arenas nest, exiting an arena restores the arena that was active
+ * when it was entered.
+ */
+void ob_arena_enter(ob_arena *arena);
+
+/**
+ * @brief Exits the active arena of the calling thread, restoring the arena
+ * that was active before it was entered
+ */
+void ob_arena_exit(void);
+
+/**
+ * @brief Deallocates every instance allocated within an arena, and the arena
+ * itself
+ *
+ * @param arena Arena to destroy, which must not be entered
+ *
+ * @details The class deallocator of each instance that was not copied out is
+ * called once, to release normally allocated instances it references and free
+ * class specific storage. The arena memory is then freed one chunk at a
+ * time.
+ */
+void ob_arena_destroy(ob_arena *arena);
+
+/**
+ * @brief Copies an arena instance out of its arena, so that it survives
+ * destruction of the arena
+ *
+ * @param instance Instance to copy out of its arena
+ *
+ * @return A normally allocated instance with a reference count of 1, holding
+ * the data and references of instance. If instance is not an arena instance it
+ * is retained and returned instead.
+ *
+ * @details The copy takes over all storage and references held by the arena
+ * instance, which must not be used afterwards. The instance must not reference
+ * other arena instances, which is asserted when assertions are enabled.
+ * Containers of arena instances are copied out by copying out each contained
+ * instance into a new normally allocated container.
+ */
+obj * ob_arena_copy_out(obj *instance);
 
 /**
  * @brief Decrements the instances reference count by 1. If the reference count
@@ -99,6 +322,8 @@ void ob_init_base(obj *instance, ob_dealloc_fptr dealloc_funct,
  * referenced
  * @retval NULL Reference count was decremented to 0 and deallocator was called
  * on instance
+ *
+ * @details Releasing an immortal instance has no effect, see ob_is_immortal
  */
 obj * ob_release(obj *instance);
 
@@ -109,14 +334,476 @@ obj * ob_release(obj *instance);
  * @param instance An instance of any offbrand compatible class
  *
  * @return A reference to the argument instance.
+ *
+ * @details Retaining an immortal instance has no effect, see ob_is_immortal
  */
 obj * ob_retain(obj *instance);
 
+/**
+ * @brief Defers a release of the instance until the innermost autorelease pool
+ * of the calling thread is drained
+ *
+ * @param instance An instance of any offbrand compatible class, or NULL
+ *
+ * @return The argument instance, so that a newly created temporary can be
+ * returned or passed on without the caller managing its reference
+ *
+ * @warning An autorelease pool must have been pushed on the calling thread
+ */
+obj * ob_autorelease(obj *instance);
+
+/**
+ * @brief Pushes a new autorelease pool on the calling thread, all following
+ * calls to ob_autorelease on that thread add to the new pool until it is
+ * drained
+ *
+ * @details Pools nest, each thread keeps its own stack of pools
+ */
+void ob_push_autorelease_pool(void);
+
+/**
+ * @brief Drains the innermost autorelease pool of the calling thread,
+ * releasing every instance autoreleased into it in one batch, and pops the pool
+ *
+ * @details Instances autoreleased by deallocators during the drain are
+ * released as part of the same drain.
+ */
+void ob_drain_autorelease_pool(void);
+
+/**
+ * @brief Enables or disables deferred destruction on the calling thread
+ *
+ * @param enabled non-zero to defer destruction, 0 to destroy instances as soon
+ * as they are no longer referenced
+ *
+ * @details While enabled, instances released to a reference count of zero by
+ * the calling thread are queued instead of deallocated, and are destroyed
+ * later by ob_drain_deferred. Instances released by a deallocator during a
+ * drain are queued as well, so destroying a large or deeply nested container
+ * never recurses and can be spread over many bounded drains. If a reaper
+ * thread is running, shared instances are handed to it instead. Disabling
+ * deferred destruction does not drain instances already queued.
+ */
+void ob_defer_destruction(uint8_t enabled);
+
+/**
+ * @brief Destroys up to max_objs instances queued for deferred destruction on
+ * the calling thread
+ *
+ * @param max_objs Maximum number of instances to destroy
+ *
+ * @return Number of instances still queued on the calling thread
+ */
+uint64_t ob_drain_deferred(uint64_t max_objs);
+
+/**
+ * @brief Starts a background reaper thread, which destroys shared instances
+ * released while deferred destruction is enabled
+ *
+ * @details Only shared instances are handed to the reaper, as only they may be
+ * deallocated by a thread other than their owner. See ob_share.
+ */
+void ob_start_reaper(void);
+
+/**
+ * @brief Stops the reaper thread, after it has destroyed every instance handed
+ * to it
+ */
+void ob_stop_reaper(void);
+
+/**
+ * @brief Creates a weak reference to an instance
+ *
+ * @param target An instance of any offbrand compatible class, to which the
+ * caller holds a reference
+ *
+ * @return A weak handle to target, itself an offbrand compatible instance to be
+ * released by the caller
+ *
+ * @details A weak handle does not retain its target. Once the target is
+ * deallocated the handle resolves to NULL, see ob_weak_lock. Handles are
+ * recorded in a side table keyed by target, so instances without weak
+ * references carry no extra cost. Each target has at most one handle at a
+ * time, further calls return the existing handle retained, so handles compare
+ * and hash by target identity. Handles are never arena instances, but may
+ * refer to arena instances, which they stop resolving to once released or
+ * once their arena is destroyed.
+ */
+ob_weak * ob_weak_new(obj *target);
+
+/**
+ * @brief Obtains a reference to the target of a weak handle, if the target is
+ * still alive
+ *
+ * @param weak A weak handle created by ob_weak_new
+ *
+ * @retval NULL The target has been released to a reference count of 0
+ * @retval non-NULL The target, retained on behalf of the caller
+ *
+ * @details Locking a handle whose target is shared is safe from any thread,
+ * the target can not be deallocated between the check and the retain.
+ */
+obj * ob_weak_lock(ob_weak *weak);
+
+/**
+ * @brief Creates a writer buffering serialized instances to a stdio stream
+ *
+ * @param file Stream opened for writing, which the writer does not close
+ * @return A new writer, to be destroyed with ob_writer_destroy
+ */
+ob_writer * ob_writer_new_file(FILE *file);
+
+/**
+ * @brief Creates a writer buffering serialized instances to a file descriptor
+ *
+ * @param fd File descriptor open for writing, which the writer does not close
+ * @return A new writer, to be destroyed with ob_writer_destroy
+ */
+ob_writer * ob_writer_new_fd(int fd);
+
+/**
+ * @brief Writes all buffered data of a writer to its destination
+ *
+ * @param writer A writer
+ *
+ * @retval 0 A write to the destination failed, now or earlier
+ * @retval non-zero All data serialized so far has been written
+ */
+uint8_t ob_writer_flush(ob_writer *writer);
+
+/**
+ * @brief Flushes and frees a writer
+ *
+ * @param writer A writer, call ob_writer_flush first to learn if all data was
+ * written
+ */
+void ob_writer_destroy(ob_writer *writer);
+
+/**
+ * @brief Creates a reader of serialized instances from a stdio stream
+ *
+ * @param file Stream opened for reading, which the reader does not close
+ * @return A new reader, to be destroyed with ob_reader_destroy
+ *
+ * @warning The reader reads ahead of the instances it returns, the position of
+ * file is undefined once the reader is used
+ */
+ob_reader * ob_reader_new_file(FILE *file);
+
+/**
+ * @brief Creates a reader of serialized instances from a file descriptor
+ *
+ * @param fd File descriptor open for reading, which the reader does not close
+ * @return A new reader, to be destroyed with ob_reader_destroy
+ *
+ * @warning The reader reads ahead of the instances it returns, the offset of
+ * fd is undefined once the reader is used
+ */
+ob_reader * ob_reader_new_fd(int fd);
+
+/**
+ * @brief Tests whether a reader has reached the end of its source
+ *
+ * @param reader A reader
+ *
+ * @retval 0 More data may be read
+ * @retval non-zero The source is exhausted, or reading it failed
+ */
+uint8_t ob_reader_at_end(ob_reader *reader);
+
+/**
+ * @brief Tests whether a reader met malformed or truncated data, or failed to
+ * read its source
+ *
+ * @param reader A reader
+ *
+ * @retval 0 Every instance was read successfully
+ * @retval non-zero Reading failed, ob_deserialize returns NULL from now on
+ */
+uint8_t ob_reader_failed(const ob_reader *reader);
+
+/**
+ * @brief Frees a reader
+ *
+ * @param reader A reader
+ */
+void ob_reader_destroy(ob_reader *reader);
+
+/**
+ * @brief Serializes an instance in a compact binary format
+ *
+ * @param instance An instance of any offbrand compatible class implementing
+ * serialization, or NULL
+ * @param writer Writer receiving the data
+ *
+ * @details Containers serialize every contained instance. Each class is named
+ * only the first time a writer meets it, later instances of the class refer
+ * to it by index, and all lengths and counts are written as variable length
+ * integers. Weak valued obmaps serialize the values alive at the time of the
+ * call, and are read back as regular obmaps.
+ *
+ * @warning instance must not reference itself, directly or indirectly
+ */
+void ob_serialize(const obj *instance, ob_writer *writer);
+
+/**
+ * @brief Reads the next instance serialized by ob_serialize
+ *
+ * @param reader Reader supplying the data
+ *
+ * @return A new instance to be released by the caller, or NULL if NULL was
+ * serialized or reading failed, see ob_reader_failed
+ *
+ * @details Containers are presized from the serialized element counts, up to
+ * a limit protecting against malformed counts, and reading fails on
+ * instances nested deeper than a fixed limit. Instances of the library
+ * classes can be read by any program, regardless of the instances it created
+ */
+obj * ob_deserialize(ob_reader *reader);
+
+/**
+ * @brief Creates a pool of threads running the tasks of parallel loops and
+ * fork-join calls
+ *
+ * @param threads Number of threads running tasks, 0 for the number of online
+ * processors. A pool of 1 thread starts no thread and runs every call serially
+ * and in order on the calling thread
+ *
+ * @return A new pool, to be destroyed with ob_pool_destroy
+ *
+ * @details Each thread keeps its own deque of forked tasks and idle threads
+ * steal from the others. The thread calling into a pool runs tasks as well
+ * until its call completes, so threads - 1 threads are started.
+ */
+ob_pool * ob_pool_new(uint32_t threads);
+
+/**
+ * @brief Stops the threads of a pool and frees it
+ *
+ * @param pool A pool with no call in progress, other than the default pool
+ */
+void ob_pool_destroy(ob_pool *pool);
+
+/**
+ * @brief Returns the default pool, used by every call given a NULL pool
+ *
+ * @return The default pool, created on first use
+ *
+ * @details The default pool has a thread per online processor, unless the
+ * OB_POOL_THREADS environment variable holds another number of threads.
+ * Setting OB_POOL_THREADS to 1 makes every parallel call of the program run
+ * serially, which is deterministic.
+ */
+ob_pool * ob_pool_default(void);
+
+/**
+ * @brief Returns the number of threads running the tasks of a pool
+ *
+ * @param pool A pool, or NULL for the default pool
+ * @return Number of threads, including the calling thread
+ */
+uint32_t ob_pool_threads(const ob_pool *pool);
+
+/**
+ * @brief Runs a loop body over a range of iterations in parallel
+ *
+ * @param pool A pool, or NULL for the default pool
+ * @param begin First iteration
+ * @param end Iteration following the last
+ * @param grain Largest number of iterations passed to body at once, 0 to split
+ * the range into a few chunks per thread
+ * @param body Loop body, called with disjoint ranges covering begin to end
+ * @param context Context pointer passed to body
+ *
+ * @details The range is halved recursively, the calling thread keeps running
+ * one half while the other may be stolen by an idle thread, until halves are
+ * no larger than grain. Returns once body returned for every iteration, and
+ * may be called from within body to nest loops. Serial pools call body on
+ * consecutive ranges of exactly grain iterations, except the last, in order.
+ *
+ * @warning body runs on several threads at once, instances it retains or
+ * releases must have been shared with ob_share beforehand
+ */
+void ob_parallel_for(ob_pool *pool, uint64_t begin, uint64_t end,
+                     uint64_t grain, ob_range_fptr body, void *context);
+
+/**
+ * @brief Runs two functions in parallel, returning once both returned
+ *
+ * @param pool A pool, or NULL for the default pool
+ * @param first Function run by the calling thread
+ * @param first_context Context pointer passed to first
+ * @param second Function which may be stolen by an idle thread
+ * @param second_context Context pointer passed to second
+ *
+ * @details Recursive divide and conquer algorithms fork their subproblems with
+ * nested calls. Serial pools run first, then second.
+ */
+void ob_parallel_invoke(ob_pool *pool, ob_task_fptr first, void *first_context,
+                        ob_task_fptr second, void *second_context);
+
+/**
+ * @brief Retrieves the allocation statistics of a class
+ *
+ * @param classname Name of the class
+ * @param stats Set to the statistics of the class, if found
+ *
+ * @retval 0 No instance of the class has been allocated
+ * @retval non-zero stats holds the statistics of the class
+ *
+ * @details Every thread counts the instances it allocates and frees in its own
+ * table, which are merged on each call. The peak live count is exact for
+ * classes whose instances are freed by the thread that allocated them, and
+ * approximate otherwise. Defining OB_NO_CLASS_STATS when building the library
+ * disables counting.
+ */
+uint8_t ob_get_class_stats(const char *classname, ob_class_stats *stats);
+
+/**
+ * @brief Sums the allocation statistics of every class
+ *
+ * @param stats Set to the sums, with a NULL classname. The peak live count is
+ * the sum of the peaks of each class, an upper bound of the overall peak
+ */
+void ob_get_total_class_stats(ob_class_stats *stats);
+
+/**
+ * @brief Measures the memory held by an instance and by every instance
+ * reachable from it
+ *
+ * @param instance Instance to measure, or NULL
+ * @param footprint Set to the memory held, all zero for NULL
+ *
+ * @details Each instance counts the size of its class struct, plus the blocks
+ * of storage reported by the footprint function of its class, such as element
+ * arrays, digit arrays and string buffers. Reachable instances are found
+ * through the traversal functions of their classes, so the internal instances
+ * of containers are counted as well, like the nodes of an obdeque and the hash
+ * table, pairs and iterators of an obmap. Instances and storage shared by
+ * several parents, or between copies on write, are counted once. Immortal
+ * instances live in static storage and are not counted. Sizes are the sizes
+ * requested from the allocator, excluding its own overhead. The instances
+ * measured must not be modified by other threads meanwhile.
+ */
+void ob_memory_footprint(const obj *instance, ob_footprint *footprint);
+
+/**
+ * @brief Prints the allocation statistics of every class as a table
+ *
+ * @param out Stream to print to
+ */
+void ob_print_class_stats(FILE *out);
+
+/**
+ * @brief Prints the allocation statistics of every class to stderr when the
+ * program exits
+ */
+void ob_print_class_stats_at_exit(void);
+
+/**
+ * @brief Starts recording every allocation, retain, release and deallocation
+ * of all threads into per thread ring buffers
+ *
+ * @details Each thread keeps its most recent 65536 events. Caller addresses
+ * are recorded for all but deallocation events. Defining OB_NO_REF_TRACE when
+ * building the library removes tracing.
+ */
+void ob_start_ref_trace(void);
+
+/**
+ * @brief Stops recording reference counting events, recorded events are kept
+ */
+void ob_stop_ref_trace(void);
+
+/**
+ * @brief Discards all recorded reference counting events
+ *
+ * @warning Must not be called while tracing is started
+ */
+void ob_clear_ref_trace(void);
+
+/**
+ * @brief Prints a report of recorded reference counting events, listing the
+ * call sites causing the most events and instances allocated but not
+ * deallocated within the recorded events
+ *
+ * @param out Stream to print to
+ * @param max_lines Maximum number of call sites and of instances to print
+ *
+ * @warning Must not be called while tracing is started
+ */
+void ob_print_ref_trace_report(FILE *out, uint32_t max_lines);
+
+/**
+ * @brief Sets the hook called at the beginning and end of expensive internal
+ * operations of all threads
+ *
+ * @param hook Function called with each event, NULL to stop tracing
+ * @param context Context pointer passed to hook
+ *
+ * @details Traced operations are those whose cost grows with the size of an
+ * instance, and which are hidden inside cheaper looking calls: growing an
+ * obvector, growing and rehashing an obmap, removing from an obmap, copying
+ * the storage shared by copies on write before modifying it, sorting, and
+ * dividing obints. Operations may nest, an obmap growing emits the events of
+ * its rehash between its own. The hook is called on the thread performing the
+ * operation, so it must be thread safe if several threads use the library.
+ * Operations performed by the hook itself are not traced. While no hook is set
+ * each traced operation costs a single relaxed load and branch, and defining
+ * OB_NO_OP_TRACE when building the library removes tracing entirely.
+ *
+ * @warning Operations running while the hook changes may pass only one of
+ * their two events to a hook, or call the old hook with the new context. Set
+ * the hook to NULL and wait for running operations before replacing one hook
+ * with another.
+ */
+void ob_set_op_trace_hook(ob_op_trace_fptr hook, void *context);
+
+/**
+ * @brief Marks an instance and every instance it references as shared between
+ * threads, so that all further reference counting on them is atomic
+ *
+ * @param instance An instance of any offbrand compatible class
+ *
+ * @details Instances begin owned by the creating thread and count references
+ * with plain loads and stores. The owning thread must call ob_share before the
+ * instance becomes visible to other threads, after which ob_retain and
+ * ob_release may be called on it from any thread. Sharing is permanent.
+ *
+ * @warning Instances added to a shared container after it was shared are not
+ * shared automatically, call ob_share on them before other threads can reach
+ * them. Mutating a container concurrently with other threads is not supported,
+ * only reference counting is made thread safe.
+ */
+void ob_share(obj *instance);
+
+/**
+ * @brief Checks if an instance has been shared between threads with ob_share
+ *
+ * @param instance An instance of any offbrand compatible class
+ *
+ * @retval 0 instance uses single thread reference counting
+ * @retval non-zero instance uses atomic reference counting
+ */
+uint8_t ob_is_shared(const obj *instance);
+
+/**
+ * @brief Checks if an instance is immortal. Immortal instances are preallocated
+ * by their class, such as small obints and short obstrings, are never
+ * deallocated and ignore ob_retain and ob_release
+ *
+ * @param instance An instance of any offbrand compatible class
+ *
+ * @retval 0 instance is reference counted
+ * @retval non-zero instance is immortal
+ */
+uint8_t ob_is_immortal(const obj *instance);
+
 /**
  * @brief Returns the current reference count of the given instance.
  *
  * @param instance An instance of any offbrand compatible class
- * @return An unsigned integer reference count
+ * @return An unsigned integer reference count, always 1 for immortal instances
  */
 uint32_t ob_reference_count(obj *instance);
 
@@ -128,6 +815,9 @@ uint32_t ob_reference_count(obj *instance);
  *
  * @retval 0 a is not an instance of classname
  * @retval non-zero a is an instance of classname
+ *
+ * @details Passing the same string constant used to name the class resolves
+ * with a single pointer comparison, other strings fall back to strcmp
  */
 uint8_t ob_has_class(const obj *a, const char *classname);
 
@@ -139,6 +829,9 @@ uint8_t ob_has_class(const obj *a, const char *classname);
  *
  * @retval 0 a and b are not of the same class
  * @retval non-zero a and b are of the same class
+ *
+ * @details Classes are identified by their unique descriptor, so the check is
+ * a single pointer comparison
  */
 uint8_t ob_has_same_class(const obj *a, const obj *b);
 
@@ -151,6 +844,49 @@ uint8_t ob_has_same_class(const obj *a, const obj *b);
  */
 ob_hash_t ob_hash(const obj *to_hash);
 
+/**
+ * @brief Hashes a sequence of bytes, seeded by the process wide hash seed
+ *
+ * @param bytes Bytes to hash, may be NULL if length is 0
+ * @param length Number of bytes to hash
+ * @return Hash value
+ *
+ * @details Class hash functions of value types should hash their contents
+ * through this function rather than mixing bytes themselves.
+ */
+ob_hash_t ob_hash_bytes(const void *bytes, size_t length);
+
+/**
+ * @brief Combines an element hash into the running hash of a sequence
+ *
+ * @param value Running hash of the preceding elements, begin with ob_hash_seed
+ * @param element Hash of the next element
+ * @return New running hash, which depends on the order of elements
+ *
+ * @details Unordered collections should sum the hashes of their elements and
+ * combine the sum once, so that the hash does not depend on insertion order.
+ */
+ob_hash_t ob_hash_combine(ob_hash_t value, ob_hash_t element);
+
+/**
+ * @brief Returns the process wide seed of all offbrand hashes
+ *
+ * @return Hash seed, chosen at random on first use unless fixed by
+ * ob_set_hash_seed
+ */
+ob_hash_t ob_hash_seed(void);
+
+/**
+ * @brief Fixes the process wide hash seed, making every hash value
+ * reproducible between runs
+ *
+ * @param seed Hash seed to use
+ *
+ * @warning Must be called before any hash is computed and before other
+ * threads are started, changing the seed invalidates existing hash tables.
+ */
+void ob_set_hash_seed(ob_hash_t seed);
+
 /**
  * @brief comparision operator between any two offbrand compatible classes
  *
@@ -8,6 +8,7 @@
 #define OBDEQUE_PRIVATE_H
 
 #include "../obdeque.h"
+#include "obj_private.h"
 
 /* obdeque_node TYPE */
 
@@ -43,6 +44,16 @@ obdeque_node * obdeque_new_node(obj *to_store);
  */
 void obdeque_destroy_node(obj *to_dealloc);
 
+/**
+ * @brief Traversal function for obdeque_node, visits the obj stored in the node
+ *
+ * @param to_traverse An obj pointer to an instance of obdeque_node
+ * @param visit Visitor function applied to each referenced obj
+ * @param context Pointer passed to each call of visit
+ */
+void obdeque_traverse_node(const obj *to_traverse, ob_visit_fptr visit,
+                           void *context);
+
 
 /* obdeque_iterator type */
 
@@ -55,6 +66,7 @@ struct obdeque_iterator_struct{
   const obdeque *deque; /**< obdeque that the iterator is bound to */
   obdeque_node *node; /**< The obdeque_node that the iterator references within
                        deque */
+  uint64_t generation; /**< generation of deque the iterator is valid for */
 };
 
 /* obdeque_iterator Private Methods */
@@ -80,19 +92,42 @@ struct obdeque_iterator_struct * obdeque_new_iterator(const obdeque *deque,
  */
 void obdeque_destroy_iterator(obj *to_dealloc);
 
+/**
+ * @brief Traversal function for obdeque_iterator, visits the obdeque_node referenced by the iterator
+ *
+ * @param to_traverse An obj pointer to an instance of obdeque_iterator
+ * @param visit Visitor function applied to each referenced obj
+ * @param context Pointer passed to each call of visit
+ */
+void obdeque_traverse_iterator(const obj *to_traverse, ob_visit_fptr visit,
+                               void *context);
+
 
 /* obdeque Type */
 
+/**
+ * @brief Ownership token of a list of obdeque_nodes. Copies of a deque share
+ * its nodes and token until one of them is modified, which first moves the
+ * modified deque to a clone of the nodes with a token of its own
+ */
+typedef struct obdeque_storage_struct{
+  _Atomic ob_ref_count_t references; /**< number of deques sharing the nodes */
+} obdeque_storage;
+
 /**
  * @brief obdeque internal structure, encapsulating the data needed for a
  * doubly linked list
  */
 struct obdeque_struct{
   obj base; /**< obj containing reference count and class membership data */
+  obdeque_storage *storage; /**< ownership token of the nodes, possibly
+                                 shared */
   obdeque_node *head; /**< pointer to the obdeque_node at the head of the deque */
   obdeque_node *tail; /**< pointer to the obdeque_node at the tail of the deque */
   uint64_t length; /**< integer length of the deque (or number of elements
                      stored within) */
+  uint64_t generation; /**< incremented each time the deque moves to new nodes,
+                            invalidating the iterators created before */
 };
 
 
@@ -108,6 +143,42 @@ struct obdeque_struct{
  */
 obdeque * obdeque_create_default(void);
 
+/**
+ * @brief Creates an ownership token for a new list of nodes
+ *
+ * @return New token referenced once
+ */
+obdeque_storage * obdeque_new_storage(void);
+
+/**
+ * @brief Drops a deque's reference to a list of nodes, releasing the nodes and
+ * freeing their token if no other deque shares them
+ *
+ * @param storage Ownership token of the nodes
+ * @param head First node of the list
+ */
+void obdeque_release_storage(obdeque_storage *storage, obdeque_node *head);
+
+/**
+ * @brief Releases every node of a list, separating each from the others so
+ * that nodes kept alive by iterators no longer lead into the list
+ *
+ * @param head First node of the list
+ */
+void obdeque_release_nodes(obdeque_node *head);
+
+/**
+ * @brief Ensures that a deque about to be modified does not share its nodes
+ * with any copy, cloning the nodes if it does
+ *
+ * @param deque An instance of obdeque
+ * @param it An iterator of deque moved to the matching cloned node, or NULL
+ *
+ * @details Cloning starts a new generation of deque, so that using any other
+ * iterator of deque fails an assertion rather than modifying its copies
+ */
+void obdeque_own_storage(obdeque *deque, obdeque_iterator *it);
+
 /**
  * @brief Internal merge sort implementation for an obdeque
  *
@@ -161,5 +232,43 @@ void obdeque_display(const obj *to_print);
  */
 void obdeque_destroy(obj *to_dealloc);
 
+/**
+ * @brief Traversal function for obdeque, visits every obdeque_node in the deque
+ *
+ * @param to_traverse An obj pointer to an instance of obdeque
+ * @param visit Visitor function applied to each referenced obj
+ * @param context Pointer passed to each call of visit
+ */
+void obdeque_traverse(const obj *to_traverse, ob_visit_fptr visit,
+                      void *context);
+
+/**
+ * @brief Serialization function for obdeque, writes the length followed by
+ * each element from head to tail
+ *
+ * @param to_write A non-NULL obj pointer to an instance of obdeque
+ * @param writer Writer receiving the data
+ */
+void obdeque_serialize(const obj *to_write, ob_writer *writer);
+
+/**
+ * @brief Deserialization function for obdeque
+ *
+ * @param reader Reader supplying the data
+ * @return A new obdeque, or NULL if the data was malformed
+ */
+obj * obdeque_deserialize(ob_reader *reader);
+
+/**
+ * @brief Footprint function for obdeque, reports the ownership token of the
+ * nodes, the nodes themselves are referenced objs
+ *
+ * @param to_measure A non-NULL obj pointer to an instance of obdeque
+ * @param count Storage counter applied to the ownership token
+ * @param context Context pointer passed to count
+ */
+void obdeque_footprint(const obj *to_measure, ob_storage_fptr count,
+                       void *context);
+
 
 #endif
@@ -8,6 +8,37 @@
 #define OBINT_PRIVATE_H
 
 #include "../obint.h"
+#include "obj_private.h"
+#include <pthread.h>
+
+/* PRIVATE CONSTANTS */
+
+#ifndef OB_INT_CACHE_MIN
+/** Smallest value returned by obint_new as a preallocated immortal instance,
+ * may be defined when building the library to change the cached range */
+#define OB_INT_CACHE_MIN -5
+#endif
+
+#ifndef OB_INT_CACHE_MAX
+/** Largest value returned by obint_new as a preallocated immortal instance,
+ * may be defined when building the library to change the cached range */
+#define OB_INT_CACHE_MAX 256
+#endif
+
+#if OB_INT_CACHE_MIN > OB_INT_CACHE_MAX
+#error "OB_INT_CACHE_MIN must not be greater than OB_INT_CACHE_MAX"
+#endif
+
+/** Number of preallocated immortal obints */
+#define OB_INT_CACHE_SIZE (OB_INT_CACHE_MAX - OB_INT_CACHE_MIN + 1)
+
+/** Maximum number of decimal digits of an int64_t magnitude */
+#define OB_INT_PRIMITIVE_DIGITS 19
+
+/** Largest number of digits of an obint serialized as a single integer */
+#define OB_INT_SERIAL_SMALL_DIGITS 18
+/** Bound of the magnitude of obints serialized as a single integer */
+#define OB_INT_SERIAL_SMALL_MAX 1000000000000000000LL
 
 /* DATA */
 
@@ -20,11 +51,50 @@ struct obint_struct{
   int8_t sign; /**< Sign of integer value, positive or negative */
   int8_t *digits; /**< Digit array, in little endian order */
   uint64_t num_digits; /**< Number of digits in the digit array */
+  _Atomic ob_hash_t hash; /**< cached hash value, 0 if not yet computed. Any
+                               function modifying the digits of an existing
+                               instance must reset it to 0 */
 };
 
 
 /* PRIVATE METHODS */
 
+/**
+ * @brief Creates a new, mortal obint with the value of a primitive integer,
+ * which the caller may modify
+ *
+ * @param num Integer value
+ * @return An instance of class obint
+ *
+ * @details obint_new returns immortal instances for small values, which must
+ * never be modified. Private methods modifying the sign or digits of a result
+ * must create it with this constructor instead
+ */
+obint * obint_create_from_primitive(int64_t num);
+
+/**
+ * @brief Counts the decimal digits of a primitive integer, at least one for 0
+ *
+ * @param num Integer value
+ * @return Number of digits in the magnitude of num
+ */
+uint64_t obint_count_digits(int64_t num);
+
+/**
+ * @brief Stores the sign and digits of a primitive integer in an obint
+ *
+ * @param a A non-NULL pointer to type obint holding at least
+ * obint_count_digits(num) digits
+ * @param num Integer value
+ */
+void obint_store_primitive(obint *a, int64_t num);
+
+/**
+ * @brief Initializes the preallocated immortal obints, called once through
+ * pthread_once
+ */
+void obint_init_cache(void);
+
 /**
  * @brief Default constructor for obint
  * @param num_digits Approximate number of digits required to store the entire,
@@ -85,6 +155,36 @@ void obint_display(const obj *to_print);
  */
 void obint_destroy(obj *to_dealloc);
 
+/**
+ * @brief Serialization function for obint
+ *
+ * @param to_write A non-NULL obj pointer to an instance of obint
+ * @param writer Writer receiving the data
+ *
+ * @details Values of at most OB_INT_SERIAL_SMALL_DIGITS digits are written as
+ * a single variable length integer, larger values as packed decimal digits
+ */
+void obint_serialize(const obj *to_write, ob_writer *writer);
+
+/**
+ * @brief Deserialization function for obint
+ *
+ * @param reader Reader supplying the data
+ * @return A new obint, or NULL if the data was malformed
+ */
+obj * obint_deserialize(ob_reader *reader);
+
+/**
+ * @brief Footprint function for obint, reports the digit array with the digits
+ * above the most significant non-zero digit as unused
+ *
+ * @param to_measure A non-NULL obj pointer to an instance of obint
+ * @param count Storage counter applied to the digit array
+ * @param context Context pointer passed to count
+ */
+void obint_footprint(const obj *to_measure, ob_storage_fptr count,
+                     void *context);
+
 /**
  * @brief Creates a new integer as a result of addition between two obints
  * with sign value ignored
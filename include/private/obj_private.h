@@ -3,10 +3,12 @@
  * @brief Base type for all Offbrand compatible classes.
  *
  * @details
- * The obj type is used to track reference counts, class specific function
- * pointers, and class membership. Each Offbrand compatible class includes an
- * instance of obj as it's base member so that functions can operate generically
- * on all Offbrand classes as if they were objs
+ * The obj type is used to track reference counts and class membership, through
+ * a pointer to a class descriptor holding class specific function pointers.
+ * Each Offbrand compatible class includes an instance of obj as it's base
+ * member so that functions can operate generically on all Offbrand classes as
+ * if they were objs. The obj is embedded directly in the class struct, so each
+ * instance requires only a single allocation
  *
  * @author theck
  */
@@ -15,13 +17,19 @@
 #define OBJ_PRIVATE_H
 
 #include "../offbrand.h"
+#include "offbrand_reftrace_private.h"
+#include <stdatomic.h>
 
 /**
- * @brief Base struct used for within all Offbrand compatible classes that
- * tracks information common to all classes.
+ * @brief Class descriptor struct, defined once per Offbrand compatible class
+ * as a static constant and shared by all instances of that class.
+ *
+ * @details Any function pointer may be NULL, in which case the standard
+ * library default behavior is used for that operation.
  */
-struct obj_struct{
-  ob_ref_count_t references; /**< reference count for each instance */
+struct ob_class_struct{
+  const char *classname; /**< C String classname to which instances belong */
+  size_t size; /**< size in bytes of an instance, used by ob_alloc */
   ob_dealloc_fptr dealloc; /**< pointer to class specific deallocation
                                 function */
   ob_hash_fptr hash; /**< pointer to class specific hash function */
@@ -29,8 +37,271 @@ struct obj_struct{
                                 function */
   ob_display_fptr display; /**< pointer to the class specific display
                                 function */
-  const char *classname; /**< C String classname to which the instance
-                              belongs */
+  ob_traverse_fptr traverse; /**< pointer to the class specific function that
+                                  visits all referenced objs, NULL for classes
+                                  that reference no other objs */
+  ob_serialize_fptr serialize; /**< pointer to the class specific serialization
+                                    function, NULL if not serializable */
+  ob_deserialize_fptr deserialize; /**< pointer to the class specific
+                                        deserialization function, NULL if not
+                                        serializable */
+  ob_footprint_fptr footprint; /**< pointer to the class specific function that
+                                    reports storage owned by an instance, NULL
+                                    for classes owning none besides their
+                                    struct */
 };
 
+/** obj flag, the instance is shared between threads */
+#define OB_FLAG_SHARED 0x01
+/** obj flag, the instance was allocated from the slab allocator */
+#define OB_FLAG_SLAB 0x02
+/** obj flag, the instance was allocated within an arena */
+#define OB_FLAG_ARENA 0x04
+/** obj flag, the arena instance was copied out of its arena and must not be
+ * deallocated when the arena is destroyed */
+#define OB_FLAG_ESCAPED 0x08
+/** obj flag, the instance is never deallocated and retaining or releasing it
+ * leaves its reference count untouched */
+#define OB_FLAG_IMMORTAL 0x10
+
+/**
+ * @brief Base struct used for within all Offbrand compatible classes that
+ * tracks information common to all classes.
+ */
+struct obj_struct{
+  const ob_class *cls; /**< descriptor of the class the instance belongs to */
+  _Atomic ob_ref_count_t references; /**< reference count for each instance,
+                                          accessed atomically only if the
+                                          instance is shared */
+  uint8_t flags; /**< OB_FLAG_* bits describing the instance */
+  _Atomic uint8_t weak; /**< non-zero while weak handles to the instance may
+                             exist, only set or cleared under the weak table
+                             lock. Kept apart from flags so that it can change
+                             while other threads read the flags of a shared
+                             instance */
+};
+
+/**
+ * @brief Static initializer for the obj base of an immortal instance of the
+ * class described by desc, for instances defined at file scope
+ *
+ * @details Immortal instances are shared by every thread without ob_share, as
+ * their reference count is never modified. They must never be mutated, and
+ * are not counted by the class statistics
+ */
+#define OB_IMMORTAL_BASE(desc) \
+  {.cls = (desc), .references = 1, .flags = OB_FLAG_IMMORTAL, .weak = 0}
+
+/**
+ * @brief Per thread autorelease stack, holding every autoreleased obj of all
+ * nested pools in a single array. Each pool owns the range of the array
+ * beginning at its mark.
+ */
+typedef struct ob_autorelease_stack_struct{
+  obj **objs; /**< objs awaiting release, innermost pool at the end */
+  uint64_t length; /**< number of objs awaiting release */
+  uint64_t capacity; /**< capacity of the objs array */
+  uint64_t *marks; /**< start index in objs of each pushed pool */
+  uint64_t depth; /**< number of pushed pools */
+  uint64_t mark_capacity; /**< capacity of the marks array */
+} ob_autorelease_stack;
+
+/**
+ * @brief Work list of unreferenced objs awaiting destruction, used when
+ * destruction is deferred
+ */
+typedef struct ob_deferred_queue_struct{
+  obj **objs; /**< unreferenced objs, destroyed most recent first */
+  uint64_t length; /**< number of objs awaiting destruction */
+  uint64_t capacity; /**< capacity of the objs array */
+  uint8_t enabled; /**< non-zero if releases on the thread defer destruction */
+  uint8_t reaper; /**< non-zero for the queue of the reaper thread itself */
+} ob_deferred_queue;
+
+/**
+ * @brief Initializes the obj base of a new instance, see ob_init_base
+ *
+ * @param instance Newly allocated instance
+ * @param cls Descriptor of the instances class
+ * @param caller Return address into the function allocating the instance,
+ * recorded when reference counts are traced
+ */
+void ob_init_instance(obj *instance, const ob_class *cls, const void *caller);
+
+/**
+ * @brief Initializes the obj base of an immortal instance held in static
+ * storage, for immortal instances that can not be statically initialized
+ *
+ * @param instance Instance in static storage, never passed to ob_alloc
+ * @param cls Descriptor of the instances class
+ *
+ * @see OB_IMMORTAL_BASE
+ */
+void ob_init_immortal(obj *instance, const ob_class *cls);
+
+/**
+ * @brief Deallocates an unreferenced obj and frees its memory back to where it
+ * was allocated from
+ *
+ * @param instance obj whose reference count reached zero
+ */
+void ob_destroy(obj *instance);
+
+/**
+ * @brief Appends an unreferenced obj to a deferred destruction queue, growing
+ * the queue as required
+ *
+ * @param queue Queue to append to
+ * @param instance obj whose reference count reached zero
+ */
+void ob_defer(ob_deferred_queue *queue, obj *instance);
+
+/**
+ * @brief Hands an unreferenced shared obj to the reaper thread
+ *
+ * @param instance Shared obj whose reference count reached zero
+ *
+ * @retval 0 No reaper thread is running, instance was not queued
+ * @retval non-zero instance will be destroyed by the reaper thread
+ */
+uint8_t ob_reaper_defer(obj *instance);
+
+/**
+ * @brief Main routine of the reaper thread, destroys objs handed to it until
+ * stopped and its queue is empty
+ *
+ * @param arg Unused
+ * @return NULL
+ */
+void * ob_reaper_main(void *arg);
+
+/**
+ * @brief Registers ob_thread_storage_exit to run when the calling thread exits,
+ * the first time the thread allocates storage for its autorelease pools or a
+ * deferred destruction queue
+ */
+void ob_thread_storage_register(void);
+
+/**
+ * @brief Thread exit handler, frees the storage of the autorelease pools and
+ * deferred destruction queue of an exiting thread, which draining keeps for
+ * reuse
+ *
+ * @param unused Unused
+ */
+void ob_thread_storage_exit(void *unused);
+
+/**
+ * @brief Visitor used by ob_share to share each obj referenced by a shared
+ * instance
+ *
+ * @param child An obj referenced by an instance being shared
+ * @param context Unused
+ */
+void ob_share_child(obj *child, void *context);
+
+/**
+ * @brief Asserts that an obj is an instance of the class described by desc,
+ * using a single pointer comparison of class descriptors
+ *
+ * @details Class methods use this check on entry. Defining OB_NO_CLASS_CHECKS
+ * when building the library removes the checks entirely, independently of
+ * NDEBUG and the remaining assertions
+ */
+#ifdef OB_NO_CLASS_CHECKS
+#define OB_ASSERT_CLASS(instance, desc) ((void)0)
+#else
+#define OB_ASSERT_CLASS(instance, desc) \
+  assert(((const obj *)(instance))->cls == (desc))
+#endif
+
+/**
+ * @brief Tests whether an obj is referenced only once, so that a container
+ * sharing it with its copies may modify it in place
+ *
+ * @details The acquire load orders any use of the obj by copies that released
+ * it before the modification
+ */
+static inline uint8_t ob_is_unique(const obj *instance){
+  return atomic_load_explicit(&instance->references, memory_order_acquire) == 1;
+}
+
+/* INLINE FAST PATHS */
+
+/**
+ * @brief Inline fast path of ob_retain, incrementing the count of an unshared
+ * mortal instance in place and calling ob_retain otherwise
+ */
+static inline obj * ob_retain_inline(obj *instance){
+
+  ob_ref_count_t count;
+
+  if(!instance || (instance->flags & (OB_FLAG_SHARED | OB_FLAG_IMMORTAL)) ||
+     atomic_load_explicit(&ob_ref_trace_enabled, memory_order_relaxed))
+    return (ob_retain)(instance);
+
+  count = atomic_load_explicit(&instance->references, memory_order_relaxed);
+  assert(count < UINT32_MAX);
+  atomic_store_explicit(&instance->references, count+1, memory_order_relaxed);
+
+  return instance;
+}
+
+/**
+ * @brief Inline fast path of ob_release, decrementing the count of an unshared
+ * mortal instance in place while other references remain and calling
+ * ob_release to release the last reference
+ */
+static inline obj * ob_release_inline(obj *instance){
+
+  ob_ref_count_t count;
+
+  if(!instance || (instance->flags & (OB_FLAG_SHARED | OB_FLAG_IMMORTAL)) ||
+     atomic_load_explicit(&ob_ref_trace_enabled, memory_order_relaxed))
+    return (ob_release)(instance);
+
+  count = atomic_load_explicit(&instance->references, memory_order_relaxed);
+  if(count <= 1) return (ob_release)(instance);
+
+  atomic_store_explicit(&instance->references, count-1, memory_order_relaxed);
+
+  return instance;
+}
+
+/**
+ * @brief Inline fast path of ob_hash, calling the class hash function directly
+ */
+static inline ob_hash_t ob_hash_inline(const obj *to_hash){
+
+  if(to_hash && to_hash->cls->hash) return to_hash->cls->hash(to_hash);
+
+  return (ob_hash)(to_hash);
+}
+
+/**
+ * @brief Inline fast path of ob_compare, calling the class comparison function
+ * directly for instances of the same class
+ */
+static inline int8_t ob_compare_inline(const obj *a, const obj *b){
+
+  if(a && b && a->cls == b->cls && a->cls->compare)
+    return a->cls->compare(a, b);
+
+  return (ob_compare)(a, b);
+}
+
+/**
+ * @brief Code including this header, which is all class implementations, uses
+ * the inline fast paths for calls to ob_retain, ob_release, ob_hash and
+ * ob_compare. The out of line functions remain exported unchanged, and are
+ * still used when taking their address. Define OB_NO_INLINE_FAST_PATHS before
+ * including this header to call them directly.
+ */
+#ifndef OB_NO_INLINE_FAST_PATHS
+#define ob_retain(instance) ob_retain_inline(instance)
+#define ob_release(instance) ob_release_inline(instance)
+#define ob_hash(to_hash) ob_hash_inline(to_hash)
+#define ob_compare(a, b) ob_compare_inline((a), (b))
+#endif
+
 #endif
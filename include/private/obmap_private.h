@@ -8,6 +8,7 @@
 #define OBMAP_PRIVATE_H
 
 #include "../obmap.h"
+#include "obj_private.h"
 #include "../obvector.h"
 #include "../obdeque.h"
 
@@ -103,6 +104,34 @@ void obmap_display_pair(const obj *to_print);
  */
 void obmap_destroy_pair(obj *to_dealloc);
 
+/**
+ * @brief Traversal function for obmap_pair, visits the key and value of the pair
+ *
+ * @param to_traverse An obj pointer to an instance of obmap_pair
+ * @param visit Visitor function applied to each referenced obj
+ * @param context Pointer passed to each call of visit
+ */
+void obmap_traverse_pair(const obj *to_traverse, ob_visit_fptr visit,
+                         void *context);
+
+/**
+ * @brief Returns the pair at the position of an obmap cursor
+ *
+ * @param cursor Cursor positioned by obmap_cursor_begin
+ * @return The pair at the cursor, not retained for the caller
+ */
+obmap_pair * obmap_cursor_pair(const ob_cursor *cursor);
+
+/**
+ * @brief Resolves the value of a pair of a weak valued obmap
+ *
+ * @param mp obmap_pair whose value is a weak handle, or NULL
+ *
+ * @retval NULL The pair holds no value, or its value was deallocated
+ * @retval non-NULL The live value, not retained for the caller
+ */
+obj * obmap_pair_weak_value(const obmap_pair *mp);
+
 
 /* obmap DATA */
 
@@ -114,11 +143,13 @@ struct obmap_struct{
   obj base; /**< obj containing reference count and class membership data */
   uint8_t cap_idx; /**< index within MAP_CAPACITIES used as lookup for
                      capacity of map */
-  obvector *hash_table; /**< map lookup table */
+  obvector *hash_table; /**< map lookup table, possibly shared with copies */
   obdeque *pairs; /**< A dense list of all MapPairs within the map, for speedy
-                    rehash */
+                    rehash, possibly shared with copies */
   uint32_t collisions; /**< variable that tracks the number of hashing
                          colisions encountered when adding keys to the table */
+  uint8_t weak_values; /**< non-zero if pair values are weak handles to the
+                            values inserted */
 };
 
 /* obmap PRIVATE METHODS */
@@ -133,6 +164,22 @@ struct obmap_struct{
  */
 obmap * obmap_create_default(void);
 
+/**
+ * @brief Ensures that a map about to be modified does not share its table and
+ * pairs with any copy, copying the pairs and rebuilding the table if it does
+ *
+ * @param m Pointer to an instance of obmap
+ */
+void obmap_own_storage(obmap *m);
+
+/**
+ * @brief Replaces the table of a map with a new table referencing every pair
+ * of the map
+ *
+ * @param m Pointer to an instance of obmap
+ */
+void obmap_fill_table(obmap *m);
+
 /**
  * @brief Hash function for obmap
  *
@@ -174,6 +221,34 @@ void obmap_display(const obj *to_print);
  */
 void obmap_destroy(obj *to_dealloc);
 
+/**
+ * @brief Traversal function for obmap, visits the hash table and pair deque of the map
+ *
+ * @param to_traverse An obj pointer to an instance of obmap
+ * @param visit Visitor function applied to each referenced obj
+ * @param context Pointer passed to each call of visit
+ */
+void obmap_traverse(const obj *to_traverse, ob_visit_fptr visit,
+                    void *context);
+
+/**
+ * @brief Serialization function for obmap, writes the number of pairs
+ * followed by the key and value of each pair in insertion order
+ *
+ * @param to_write A non-NULL obj pointer to an instance of obmap
+ * @param writer Writer receiving the data
+ */
+void obmap_serialize(const obj *to_write, ob_writer *writer);
+
+/**
+ * @brief Deserialization function for obmap, presizing the table for the
+ * serialized number of pairs
+ *
+ * @param reader Reader supplying the data
+ * @return A new obmap, or NULL if the data was malformed
+ */
+obj * obmap_deserialize(ob_reader *reader);
+
 /**
  * @brief Increases the size of the map to the next capacity within
  * MAP_CAPACITIES array
@@ -201,6 +276,14 @@ void obmap_add_to_table(obmap *m, obdeque_iterator *it);
  */
 ob_hash_t obmap_find_key(const obmap *m, const obj *key);
 
+/**
+ * @brief Removes every pair whose value was deallocated from a weak valued
+ * obmap, without updating the hash table
+ *
+ * @param m The obmap to remove expired pairs from
+ */
+void obmap_remove_expired(obmap *m);
+
 /**
  * @brief Generates an offset from the hash value to rectify collisions
  *
@@ -0,0 +1,211 @@
+/**
+ * @file obsnapshot_private.h
+ * @brief obsnapshot Private Interface
+ *
+ * @details
+ * A snapshot file starts with an obsnapshot_header followed by records, each
+ * aligned to 8 bytes. A reference is the offset of a record from the start of
+ * the file. Records are written after the records they reference, so the root
+ * is the last record of the file. All integers are stored in the byte order of
+ * the writing machine, which is recorded in the header.
+ *
+ * @author theck
+ */
+
+#ifndef OBSNAPSHOT_PRIVATE_H
+#define OBSNAPSHOT_PRIVATE_H
+
+#include "../obsnapshot.h"
+#include "obj_private.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Magic number opening every snapshot file, not NUL terminated */
+#define OBSNAPSHOT_MAGIC "OBSNAPSH"
+/** Version of the snapshot format */
+#define OBSNAPSHOT_VERSION 1
+/** Written as a 32 bit integer to detect a reader of another byte order */
+#define OBSNAPSHOT_BYTE_ORDER 0x01020304
+/** Alignment of every record in a snapshot, in bytes */
+#define OBSNAPSHOT_ALIGNMENT 8
+
+/* DATA */
+
+/**
+ * @brief Header at the start of a snapshot file
+ */
+typedef struct obsnapshot_header_struct{
+  char magic[8]; /**< OBSNAPSHOT_MAGIC */
+  uint32_t version; /**< OBSNAPSHOT_VERSION */
+  uint32_t byte_order; /**< OBSNAPSHOT_BYTE_ORDER */
+  uint64_t seed; /**< hash seed of the hashes stored in the snapshot */
+  uint64_t size; /**< size of the file, in bytes */
+  obsnapshot_ref root; /**< reference to the root instance */
+} obsnapshot_header;
+
+/**
+ * @brief Frozen obstring
+ */
+typedef struct obsnapshot_string_record_struct{
+  uint32_t kind; /**< OBSNAPSHOT_STRING */
+  uint32_t length; /**< number of characters, excluding the NUL terminator */
+  uint64_t hash; /**< hash of the characters with the seed of the snapshot */
+  char str[]; /**< NUL terminated characters */
+} obsnapshot_string_record;
+
+/**
+ * @brief Frozen obvector
+ */
+typedef struct obsnapshot_vector_record_struct{
+  uint32_t kind; /**< OBSNAPSHOT_VECTOR */
+  uint32_t length; /**< number of elements */
+  obsnapshot_ref elements[]; /**< references to the elements */
+} obsnapshot_vector_record;
+
+/**
+ * @brief Slot of the hash table of a frozen obmap
+ */
+typedef struct obsnapshot_slot_struct{
+  uint64_t hash; /**< hash of the key, compared before the key itself */
+  obsnapshot_ref key; /**< reference to a frozen obstring, OBSNAPSHOT_NONE if
+                           the slot is empty */
+  obsnapshot_ref value; /**< reference to the value bound to key */
+} obsnapshot_slot;
+
+/**
+ * @brief Frozen obmap, an open addressed hash table probed linearly
+ */
+typedef struct obsnapshot_map_record_struct{
+  uint32_t kind; /**< OBSNAPSHOT_MAP */
+  uint32_t count; /**< number of pairs */
+  uint64_t capacity; /**< number of slots, 0 or a power of 2 at least twice
+                          count */
+  obsnapshot_slot slots[]; /**< hash table */
+} obsnapshot_map_record;
+
+/**
+ * @brief obsnapshot internal structure, encapsulating all data needed for
+ * an instance of obsnapshot
+ */
+struct obsnapshot_struct{
+  obj base; /**< obj containing reference count and class membership data */
+  const unsigned char *data; /**< read only mapping of the snapshot file */
+  uint64_t size; /**< size of the mapping, in bytes */
+  const obsnapshot_header *header; /**< header at the start of data */
+};
+
+/**
+ * @brief State of a snapshot file being written
+ */
+typedef struct obsnapshot_writer_struct{
+  FILE *file; /**< snapshot file */
+  uint64_t offset; /**< offset of the next record in file */
+  uint8_t failed; /**< non-zero once a write to file failed */
+} obsnapshot_writer;
+
+
+/* PRIVATE METHODS */
+
+/**
+ * @brief Destructor for obsnapshot, unmaps the snapshot file
+ *
+ * @param to_dealloc An obj pointer to an instance of obsnapshot with a
+ * reference count of 0
+ */
+void obsnapshot_destroy(obj *to_dealloc);
+
+/**
+ * @brief Display function for an instance of obsnapshot
+ *
+ * @param to_print An obj pointer to an instance of obsnapshot
+ */
+void obsnapshot_display(const obj *to_print);
+
+/**
+ * @brief Checks a reference read from a record, which must reference a record
+ * written before it
+ *
+ * @param parent Reference to the record holding child
+ * @param child A reference read from the record at parent
+ *
+ * @return child, or OBSNAPSHOT_NONE if child does not precede parent
+ */
+obsnapshot_ref obsnapshot_child(obsnapshot_ref parent, obsnapshot_ref child);
+
+/**
+ * @brief Finds the record at a reference, checking that it lies within the
+ * mapping
+ *
+ * @param s A pointer to an instance of obsnapshot
+ * @param ref A reference read from s
+ * @param kind Expected kind of the record, OBSNAPSHOT_NULL for any kind
+ *
+ * @return The record, or NULL if ref is OBSNAPSHOT_NONE, misaligned, of
+ * another kind or does not fit within the mapping
+ */
+const void * obsnapshot_record(const obsnapshot *s, obsnapshot_ref ref,
+                               uint8_t kind);
+
+/**
+ * @brief Writes an instance and everything it references to a snapshot file
+ *
+ * @param writer Writer of the snapshot file
+ * @param instance An obstring, obvector or obmap, or NULL
+ * @return Reference to the record of instance
+ */
+obsnapshot_ref obsnapshot_write_instance(obsnapshot_writer *writer,
+                                         const obj *instance);
+
+/**
+ * @brief Writes the record of an obstring
+ *
+ * @param writer Writer of the snapshot file
+ * @param instance An obj pointer to an instance of obstring
+ * @return Reference to the record
+ */
+obsnapshot_ref obsnapshot_write_string(obsnapshot_writer *writer,
+                                       const obj *instance);
+
+/**
+ * @brief Writes the records of the elements of an obvector, followed by the
+ * record of the vector
+ *
+ * @param writer Writer of the snapshot file
+ * @param instance An obj pointer to an instance of obvector
+ * @return Reference to the record of the vector
+ */
+obsnapshot_ref obsnapshot_write_vector(obsnapshot_writer *writer,
+                                       const obj *instance);
+
+/**
+ * @brief Writes the records of the keys and values of an obmap, followed by
+ * the record of its hash table
+ *
+ * @param writer Writer of the snapshot file
+ * @param instance An obj pointer to an instance of obmap
+ * @return Reference to the record of the map
+ */
+obsnapshot_ref obsnapshot_write_map(obsnapshot_writer *writer,
+                                    const obj *instance);
+
+/**
+ * @brief Appends bytes to a snapshot file
+ *
+ * @param writer Writer of the snapshot file
+ * @param data Bytes to write
+ * @param length Number of bytes to write
+ */
+void obsnapshot_write_bytes(obsnapshot_writer *writer, const void *data,
+                            uint64_t length);
+
+/**
+ * @brief Pads a snapshot file with zeros up to the alignment of the next
+ * record
+ *
+ * @param writer Writer of the snapshot file
+ */
+void obsnapshot_write_padding(obsnapshot_writer *writer);
+
+#endif
@@ -8,6 +8,17 @@
 #define OBSTRING_PRIVATE_H
 
 #include "../obstring.h"
+#include "obj_private.h"
+#include <pthread.h>
+
+/* PRIVATE CONSTANTS */
+
+/** First character with a preallocated immortal single character obstring */
+#define OB_STRING_CACHE_FIRST ' '
+/** Last character with a preallocated immortal single character obstring */
+#define OB_STRING_CACHE_LAST '~'
+/** Number of preallocated immortal single character obstrings */
+#define OB_STRING_CACHE_SIZE (OB_STRING_CACHE_LAST - OB_STRING_CACHE_FIRST + 1)
 
 /* DATA */
 
@@ -19,11 +30,31 @@ struct obstring_struct{
   obj base; /**< obj containing reference count and class membership data */
   char *str; /**< encapsulated NUL terminated C string */
   uint32_t length; /**< integer tracking str length */
+  _Atomic ob_hash_t hash; /**< cached hash value, 0 if not yet computed. Any
+                               function modifying str of an existing instance
+                               must reset it to 0 */
 };
 
 
 /* PRIVATE METHODS */
 
+/**
+ * @brief Finds the preallocated immortal obstring equal to a string, if any
+ *
+ * @param str Characters of the string, need not be NUL terminated
+ * @param length Number of characters in str
+ *
+ * @retval NULL No immortal obstring holds str
+ * @retval non-NULL The immortal empty or single character obstring equal to str
+ */
+obstring * obstring_find_immortal(const char *str, uint32_t length);
+
+/**
+ * @brief Initializes the preallocated immortal single character obstrings,
+ * called once through pthread_once
+ */
+void obstring_init_cache(void);
+
 /**
  * @brief Default constructor for obstring
  * @return An instance of class obstring
@@ -67,5 +98,32 @@ void obstring_display(const obj *str);
  */
 void obstring_destroy(obj *to_dealloc);
 
+/**
+ * @brief Serialization function for obstring, writes the length followed by
+ * the characters
+ *
+ * @param to_write A non-NULL obj pointer to an instance of obstring
+ * @param writer Writer receiving the data
+ */
+void obstring_serialize(const obj *to_write, ob_writer *writer);
+
+/**
+ * @brief Deserialization function for obstring
+ *
+ * @param reader Reader supplying the data
+ * @return A new obstring, or NULL if the data was malformed
+ */
+obj * obstring_deserialize(ob_reader *reader);
+
+/**
+ * @brief Footprint function for obstring, reports the character buffer
+ *
+ * @param to_measure A non-NULL obj pointer to an instance of obstring
+ * @param count Storage counter applied to the character buffer
+ * @param context Context pointer passed to count
+ */
+void obstring_footprint(const obj *to_measure, ob_storage_fptr count,
+                        void *context);
+
 #endif
 
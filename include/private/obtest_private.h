@@ -8,6 +8,7 @@
 #define OBTEST_PRIVATE_H
 
 #include "../obtest.h"
+#include "obj_private.h"
 
 /* DATA */
 
@@ -0,0 +1,89 @@
+/**
+ * @file obvalue_sort_private.h
+ * @brief Sort of unboxed values, shared by the container templates
+ *
+ * @details
+ * Included by a container template for each instantiation defining
+ * OB_VALUE_IMPLEMENTATION, with OB_VALUE_NAME, OB_VALUE_TYPE and
+ * OB_VALUE_COMPARE defined. Generates a static function named
+ * OB_VALUE_NAME_sort_values, which sorts an array with OB_VALUE_COMPARE
+ * inlined into its loops. Short runs are insertion sorted, then merged bottom
+ * up between the array and a scratch array. The sort is stable.
+ *
+ * @author theck
+ */
+
+/** Length of the runs insertion sorted before merging */
+#ifndef OB_VALUE_SORT_RUN
+#define OB_VALUE_SORT_RUN 16
+#endif
+
+/**
+ * @brief Sorts an array of values
+ *
+ * @param values Array to sort
+ * @param length Number of values in the array
+ * @param order Accepts OB_LEAST_TO_GREATEST or OB_GREATEST_TO_LEAST as valid
+ * sorting orders
+ */
+static void OB_VALUE_FN(_sort_values)(OB_VALUE_TYPE *values, uint64_t length,
+                                      int8_t order){
+
+  uint64_t i, j, out, width, begin, middle, end;
+  OB_VALUE_TYPE *from, *to, *swap;
+  OB_VALUE_TYPE value;
+
+  assert(order == OB_LEAST_TO_GREATEST || order == OB_GREATEST_TO_LEAST);
+
+  /* insertion sort each run, a value only moves before those it strictly
+   * precedes so equal values keep their order */
+  for(begin=0; begin<length; begin+=OB_VALUE_SORT_RUN){
+    end = begin + OB_VALUE_SORT_RUN < length ? begin + OB_VALUE_SORT_RUN :
+                                               length;
+    for(i=begin+1; i<end; i++){
+      value = values[i];
+      for(j=i; j>begin && OB_VALUE_COMPARE(value, values[j-1]) == order; j--)
+        values[j] = values[j-1];
+      values[j] = value;
+    }
+  }
+
+  if(length <= OB_VALUE_SORT_RUN) return;
+
+  to = malloc(sizeof(OB_VALUE_TYPE)*length);
+  assert(to != NULL);
+  from = values;
+
+  /* merge pairs of sorted runs, doubling their width each pass */
+  for(width=OB_VALUE_SORT_RUN; width<length; width*=2){
+    for(begin=0; begin<length; begin+=2*width){
+
+      middle = begin + width < length ? begin + width : length;
+      end = begin + 2*width < length ? begin + 2*width : length;
+      i = begin;
+      j = middle;
+      out = begin;
+
+      /* a right value is taken first only if it strictly precedes the left */
+      while(i < middle && j < end){
+        if(OB_VALUE_COMPARE(from[j], from[i]) == order) to[out++] = from[j++];
+        else to[out++] = from[i++];
+      }
+      while(i < middle) to[out++] = from[i++];
+      while(j < end) to[out++] = from[j++];
+    }
+
+    swap = from;
+    from = to;
+    to = swap;
+  }
+
+  /* the last pass may have left the result in the scratch array */
+  if(from != values){
+    memcpy(values, from, sizeof(OB_VALUE_TYPE)*length);
+    free(from);
+  }
+  else free(to);
+
+  return;
+}
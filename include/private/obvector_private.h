@@ -8,17 +8,31 @@
 #define OBVECTOR_PRIVATE_H
 
 #include "../obvector.h"
+#include "obj_private.h"
 
 /* DATA */
 
+/**
+ * @brief Element storage of an obvector. Copies of a vector share its storage
+ * until one of them is modified, which first moves the modified vector to a
+ * storage of its own
+ */
+typedef struct obvector_storage_struct{
+  _Atomic ob_ref_count_t references; /**< number of vectors sharing the
+                                          storage */
+  obj *array[]; /**< element slots, every slot at or beyond the length of the
+                     vectors sharing the storage is NULL */
+} obvector_storage;
+
 /**
  * @brief obvector internal structure, encapsulating all data needed for
  * an instance of obvector
  */
 struct obvector_struct{
   obj base; /**< obj containing reference count and class membership data */
-  obj **array; /**< intenal dynamically sized array of pointers to Offbrand
-                    compatible class instances */
+  obvector_storage *storage; /**< element storage, possibly shared */
+  obj **array; /**< the element slots of storage, referenced directly to avoid
+                    an extra indirection on each access */
   uint32_t length; /**< Integer size to find all objects stored in Vector */
   uint32_t capacity; /**< Integer count of the capacity of the internal array */
 };
@@ -34,8 +48,40 @@ struct obvector_struct{
 obvector * obvector_create_default(uint32_t initial_capacity);
 
 /**
- * @brief Resizes a vector if the number of objects it contains is equal to its
- * capacity by doubling the potential capacity of the vector
+ * @brief Allocates element storage referenced by a single vector, with every
+ * slot set to NULL
+ * @param capacity Number of element slots
+ * @return New element storage
+ */
+obvector_storage * obvector_new_storage(uint32_t capacity);
+
+/**
+ * @brief Drops a vector's reference to its element storage, releasing the
+ * stored objs and freeing the storage if no other vector shares it
+ * @param storage Element storage
+ * @param capacity Number of element slots in storage
+ */
+void obvector_release_storage(obvector_storage *storage, uint32_t capacity);
+
+/**
+ * @brief Moves a vector to new element storage of the given capacity, copying
+ * its elements. Elements are retained only if the old storage remains shared
+ * with other vectors
+ * @param v Pointer to an instance of obvector
+ * @param capacity Capacity of the new storage, at least the length of v
+ */
+void obvector_replace_storage(obvector *v, uint32_t capacity);
+
+/**
+ * @brief Ensures that a vector about to be modified does not share its element
+ * storage with any copy
+ * @param v Pointer to an instance of obvector
+ */
+void obvector_own_storage(obvector *v);
+
+/**
+ * @brief Ensures a vector can store an element at index without affecting
+ * its copies, doubling the capacity of the vector as needed
  * @param v Pointer to an instance of obvector
  * @param index Index that vector must be resized to contain
  */
@@ -95,6 +141,45 @@ void obvector_display(const obj *to_print);
  */
 void obvector_destroy(obj *to_dealloc);
 
+/**
+ * @brief Traversal function for obvector, visits every obj stored in the vector
+ *
+ * @param to_traverse An obj pointer to an instance of obvector
+ * @param visit Visitor function applied to each referenced obj
+ * @param context Pointer passed to each call of visit
+ */
+void obvector_traverse(const obj *to_traverse, ob_visit_fptr visit,
+                       void *context);
+
+/**
+ * @brief Serialization function for obvector, writes the length followed by
+ * each element
+ *
+ * @param to_write A non-NULL obj pointer to an instance of obvector
+ * @param writer Writer receiving the data
+ */
+void obvector_serialize(const obj *to_write, ob_writer *writer);
+
+/**
+ * @brief Deserialization function for obvector, presizing the vector for the
+ * serialized length
+ *
+ * @param reader Reader supplying the data
+ * @return A new obvector, or NULL if the data was malformed
+ */
+obj * obvector_deserialize(ob_reader *reader);
+
+/**
+ * @brief Footprint function for obvector, reports the element storage with the
+ * slots beyond the length as unused
+ *
+ * @param to_measure A non-NULL obj pointer to an instance of obvector
+ * @param count Storage counter applied to the element storage
+ * @param context Context pointer passed to count
+ */
+void obvector_footprint(const obj *to_measure, ob_storage_fptr count,
+                        void *context);
+
 /* PRIVATE UTILITY METHODS */
 
 /**
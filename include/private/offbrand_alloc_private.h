@@ -0,0 +1,161 @@
+/**
+ * @file offbrand_alloc_private.h
+ * @brief Slab allocator for small offbrand instances
+ *
+ * @details
+ * Instances allocated with ob_alloc are carved from large chunks divided into
+ * fixed size blocks, grouped into size classes in steps of OB_SLAB_GRANULE
+ * bytes. Each thread caches free blocks of every size class in a private free
+ * list, so that allocation and deallocation are a pointer pop and push. Blocks
+ * move between thread caches and global free lists in batches of
+ * OB_SLAB_BATCH, under a single global lock. Defining OB_NO_SLAB when building
+ * the library allocates every instance with malloc instead, for use with
+ * memory debugging tools.
+ *
+ * While an arena is entered by a thread, ob_alloc instead bump allocates
+ * instances from the chunks of that arena. Arena instances are never freed
+ * individually, the arena runs the deallocator of each remaining instance and
+ * frees all of its chunks at once when destroyed.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_ALLOC_PRIVATE_H
+#define OFFBRAND_ALLOC_PRIVATE_H
+
+#include "../offbrand.h"
+#include <pthread.h>
+
+/** Size class step, and alignment of every slab block, in bytes */
+#define OB_SLAB_GRANULE 16
+/** Largest instance size, in bytes, allocated from a slab */
+#define OB_SLAB_MAX_SIZE 256
+/** Number of slab size classes */
+#define OB_SLAB_NUM_CLASSES (OB_SLAB_MAX_SIZE/OB_SLAB_GRANULE)
+/** Size of each chunk allocated from malloc and divided into blocks */
+#define OB_SLAB_CHUNK_SIZE (64*1024)
+/** Number of blocks moved between a thread cache and the global lists */
+#define OB_SLAB_BATCH 32
+/** Default size of each arena chunk */
+#define OB_ARENA_CHUNK_SIZE (256*1024)
+
+/**
+ * @brief A free slab block, linked into a free list through its first word
+ */
+typedef struct ob_slab_block_struct{
+  struct ob_slab_block_struct *next; /**< next free block of the size class */
+} ob_slab_block;
+
+/**
+ * @brief Per thread cache of free blocks for each size class
+ */
+typedef struct ob_slab_cache_struct{
+  ob_slab_block *free_lists[OB_SLAB_NUM_CLASSES]; /**< free blocks of each size
+                                                      class */
+  uint32_t counts[OB_SLAB_NUM_CLASSES]; /**< number of blocks in each list */
+  uint8_t registered; /**< non-zero once the thread exit handler is set */
+} ob_slab_cache;
+
+/**
+ * @brief Header of each arena chunk, instances follow the header contiguously
+ * in allocation order
+ */
+typedef struct ob_arena_chunk_struct{
+  struct ob_arena_chunk_struct *next; /**< previously filled chunk */
+  char *used_end; /**< end of the last instance allocated in the chunk */
+} ob_arena_chunk;
+
+/** Size of the arena chunk header, rounded up to keep instances aligned */
+#define OB_ARENA_HEADER_SIZE \
+  ((sizeof(ob_arena_chunk) + OB_SLAB_GRANULE - 1)/OB_SLAB_GRANULE \
+   * OB_SLAB_GRANULE)
+
+/**
+ * @brief Region of bump allocated instances, destroyed all at once
+ */
+struct ob_arena_struct{
+  ob_arena_chunk *chunks; /**< chunk currently allocated from, followed by
+                               all previously filled chunks */
+  char *end; /**< end of the memory available in the current chunk */
+  ob_arena *previous; /**< arena active in the thread before this arena was
+                           entered, restored on exit */
+  uint8_t entered; /**< non-zero while the arena is active in a thread */
+};
+
+/**
+ * @brief Allocates a block for an instance of the given size from the calling
+ * thread's slab cache
+ *
+ * @param size Size in bytes of the instance
+ *
+ * @retval NULL size is larger than OB_SLAB_MAX_SIZE, or slabs are disabled
+ * @retval non-NULL A block of at least size bytes
+ */
+void * ob_slab_alloc(size_t size);
+
+/**
+ * @brief Returns a block allocated by ob_slab_alloc to the calling thread's
+ * slab cache
+ *
+ * @param block Block to free
+ * @param size Size in bytes supplied to ob_slab_alloc for the block
+ */
+void ob_slab_free(void *block, size_t size);
+
+/**
+ * @brief Moves a batch of free blocks of a size class from the global lists to
+ * a thread cache, carving a new chunk if the global list is empty
+ *
+ * @param cache Slab cache of the calling thread
+ * @param size_class Index of the size class to refill
+ */
+void ob_slab_refill(ob_slab_cache *cache, uint32_t size_class);
+
+/**
+ * @brief Moves up to count free blocks of a size class from a thread cache to
+ * the global lists
+ *
+ * @param cache Slab cache of the calling thread
+ * @param size_class Index of the size class to flush
+ * @param count Maximum number of blocks to move
+ */
+void ob_slab_flush(ob_slab_cache *cache, uint32_t size_class, uint32_t count);
+
+/**
+ * @brief Allocates an instance as ob_alloc does, ignoring the arena entered by
+ * the calling thread
+ *
+ * @param cls Descriptor of the instances class
+ * @return A new instance that is not an arena instance
+ */
+obj * ob_alloc_outside_arena(const ob_class *cls);
+
+/**
+ * @brief Bump allocates a block for an instance from an arena, adding a new
+ * chunk when the current chunk is full
+ *
+ * @param arena Arena to allocate from
+ * @param size Size in bytes of the instance
+ *
+ * @return A block of at least size bytes, aligned to OB_SLAB_GRANULE
+ */
+void * ob_arena_alloc(ob_arena *arena, size_t size);
+
+/**
+ * @brief Visitor used by ob_arena_copy_out to verify that a copied out
+ * instance references no objs remaining in an arena
+ *
+ * @param child obj referenced by the copied out instance
+ * @param context Unused
+ */
+void ob_arena_check_child(obj *child, void *context);
+
+/**
+ * @brief Thread exit handler, returns all blocks cached by an exiting thread to
+ * the global lists
+ *
+ * @param cache Slab cache of the exiting thread
+ */
+void ob_slab_thread_exit(void *cache);
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file offbrand_footprint_private.h
+ * @brief Memory footprints of object graphs
+ *
+ * @details
+ * A measurement walks the graph reachable from an instance with an explicit
+ * work list rather than recursion, so long chains of instances can not
+ * overflow the stack. Every instance and block of storage counted is recorded
+ * in an open addressed set of addresses, so instances with several parents and
+ * storage shared between copies are counted once, and reference cycles end.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_FOOTPRINT_PRIVATE_H
+#define OFFBRAND_FOOTPRINT_PRIVATE_H
+
+#include "../offbrand.h"
+
+/** Initial capacity of the set of counted addresses, a power of 2 */
+#define OB_FOOTPRINT_INITIAL_CAPACITY 64
+/** Initial capacity of the list of instances awaiting measurement */
+#define OB_FOOTPRINT_INITIAL_PENDING 32
+
+/**
+ * @brief State of one measurement
+ */
+typedef struct ob_footprint_walk_struct{
+  ob_footprint *footprint; /**< totals being measured */
+  const void **seen; /**< open addressed set of counted addresses, linear
+                          probing, NULL for an empty slot */
+  uint64_t seen_capacity; /**< number of slots of seen, a power of 2 */
+  uint64_t seen_count; /**< number of addresses in seen */
+  obj **pending; /**< instances counted but whose storage and references are
+                      not yet measured */
+  uint64_t pending_length; /**< number of instances in pending */
+  uint64_t pending_capacity; /**< capacity of the pending array */
+} ob_footprint_walk;
+
+/**
+ * @brief Adds an address to the set of counted addresses
+ *
+ * @param walk State of the measurement
+ * @param address Address of an instance or block of storage
+ *
+ * @retval 0 The address was already counted
+ * @retval non-zero The address was added and must be counted
+ */
+uint8_t ob_footprint_mark(ob_footprint_walk *walk, const void *address);
+
+/**
+ * @brief Doubles the capacity of the set of counted addresses
+ *
+ * @param walk State of the measurement
+ */
+void ob_footprint_grow(ob_footprint_walk *walk);
+
+/**
+ * @brief Storage counter passed to footprint functions, counts a block once
+ *
+ * @param block Address of the block
+ * @param size Size of the block, in bytes
+ * @param unused Bytes of the block reserved but unused
+ * @param walk State of the measurement
+ */
+void ob_footprint_count_storage(const void *block, size_t size, size_t unused,
+                                void *walk);
+
+/**
+ * @brief Visitor passed to traversal functions, counts an instance once and
+ * queues it for measurement of its storage and references
+ *
+ * @param instance Referenced instance
+ * @param walk State of the measurement
+ */
+void ob_footprint_count_obj(obj *instance, void *walk);
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file offbrand_hash_private.h
+ * @brief Hashing primitives shared by all offbrand classes
+ *
+ * @details
+ * All hashes are seeded by a single process wide seed, chosen once on first
+ * use unless fixed beforehand with ob_set_hash_seed. Byte sequences are hashed
+ * a 64 bit word at a time, and every hash is passed through a final avalanche
+ * step so that hash tables may use the low bits directly.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_HASH_PRIVATE_H
+#define OFFBRAND_HASH_PRIVATE_H
+
+#include "../offbrand.h"
+#include <pthread.h>
+
+/** Multiplier used to spread each word and combined hash */
+#define OB_HASH_K1 0x87c37b91114253d5ULL
+/** Multiplier applied to each word after rotation */
+#define OB_HASH_K2 0x4cf5ad432745937fULL
+/** Constant added to the running hash after each word */
+#define OB_HASH_K3 0x52dce729ULL
+
+/** Rotates a 64 bit value left by r bits, 0 < r < 64 */
+#define OB_HASH_ROTL(value, r) (((value) << (r)) | ((value) >> (64 - (r))))
+
+/**
+ * @brief Initializes the process wide seed, called once through pthread_once
+ */
+void ob_hash_init_seed(void);
+
+/**
+ * @brief Hashes a sequence of bytes with a given seed rather than the process
+ * wide seed, so that hashes stored by another process may be reproduced
+ *
+ * @param bytes Bytes to hash, may be NULL if length is 0
+ * @param length Number of bytes to hash
+ * @param seed Seed of the hash
+ * @return Hash of the bytes, equal to ob_hash_bytes if seed is ob_hash_seed
+ */
+ob_hash_t ob_hash_bytes_seeded(const void *bytes, size_t length,
+                               ob_hash_t seed);
+
+/**
+ * @brief Mixes a single 64 bit word before it is merged into a running hash
+ *
+ * @param word Word read from the hashed byte sequence
+ * @return Mixed word
+ */
+uint64_t ob_hash_mix_word(uint64_t word);
+
+/**
+ * @brief Avalanches all bits of a running hash into a final hash value
+ *
+ * @param value Running hash value
+ * @return Final hash value
+ */
+uint64_t ob_hash_finalize(uint64_t value);
+
+#endif
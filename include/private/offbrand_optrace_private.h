@@ -0,0 +1,55 @@
+/**
+ * @file offbrand_optrace_private.h
+ * @brief Tracing of expensive internal operations
+ *
+ * @details
+ * Classes mark the beginning and end of each operation whose cost grows with
+ * the size of an instance with OB_OP_TRACE. While no hook is set the macro is
+ * a relaxed load and branch, otherwise the event is timestamped and passed to
+ * the hook. Events raised while a thread runs the hook are dropped, so hooks
+ * may use the library without tracing themselves. Unlike reference count
+ * tracing nothing is recorded, the hook decides what to keep. Defining
+ * OB_NO_OP_TRACE when building the library removes tracing entirely.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_OPTRACE_PRIVATE_H
+#define OFFBRAND_OPTRACE_PRIVATE_H
+
+#include "../offbrand.h"
+#include <stdatomic.h>
+
+/** hook of ob_set_op_trace_hook, NULL while operations are not traced */
+extern _Atomic(ob_op_trace_fptr) ob_op_trace_hook;
+
+/**
+ * @brief Passes an event to the hook if one is set
+ *
+ * @details Evaluates to nothing when the library is built with
+ * OB_NO_OP_TRACE.
+ */
+#ifdef OB_NO_OP_TRACE
+#define OB_OP_TRACE(phase, operation, instance, size) ((void)0)
+#else
+#define OB_OP_TRACE(phase, operation, instance, size) \
+  do{ \
+    if(atomic_load_explicit(&ob_op_trace_hook, memory_order_relaxed)) \
+      ob_op_trace_emit((phase), (operation), (const obj *)(instance), \
+                       (size)); \
+  }while(0)
+#endif
+
+/**
+ * @brief Timestamps an event and calls the hook with it, unless the calling
+ * thread is already running the hook
+ *
+ * @param phase OB_OP_TRACE_BEGIN or OB_OP_TRACE_END
+ * @param operation Name of the function performing the operation
+ * @param instance Instance operated on
+ * @param size Number of elements, pairs or digits processed
+ */
+void ob_op_trace_emit(uint8_t phase, const char *operation,
+                      const obj *instance, uint64_t size);
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file offbrand_pool_private.h
+ * @brief Work stealing thread pools
+ *
+ * @details
+ * Every worker thread owns a deque of tasks. A worker pushes the tasks it
+ * forks to the bottom of its deque and pops them back from the bottom, so it
+ * continues with the most recent and cache warm work, while idle workers steal
+ * from the top of other deques, taking the oldest and usually largest tasks.
+ * Threads outside the pool push their tasks to one extra deque shared by all
+ * of them. A thread waiting for its forked tasks runs pending tasks until they
+ * complete rather than blocking, so nested parallelism cannot deadlock. Idle
+ * workers sleep on a condition variable, which is only signalled while some
+ * worker is asleep.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_POOL_PRIVATE_H
+#define OFFBRAND_POOL_PRIVATE_H
+
+#include "../offbrand.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <unistd.h>
+
+/** Initial number of tasks each deque can hold, a power of 2 */
+#define OB_POOL_INITIAL_CAPACITY 64
+/** Number of chunks each thread is given when no grain size is specified */
+#define OB_POOL_CHUNKS_PER_THREAD 8
+/** Environment variable overriding the number of threads of the default pool,
+ * 1 running every task serially on the calling thread */
+#define OB_POOL_THREADS_VARIABLE "OB_POOL_THREADS"
+
+/**
+ * @brief Completion counter of the tasks forked by a single call
+ */
+typedef struct ob_pool_join_struct{
+  _Atomic uint64_t pending; /**< number of forked tasks not yet completed */
+} ob_pool_join;
+
+/**
+ * @brief Task, either a function or a range of iterations split in halves
+ * until no larger than its grain
+ */
+typedef struct ob_pool_task_struct{
+  ob_task_fptr task; /**< function to run, NULL for a range */
+  ob_range_fptr body; /**< loop body of a range */
+  void *context; /**< context pointer passed to task or body */
+  uint64_t begin; /**< first iteration of a range */
+  uint64_t end; /**< iteration following the last of a range */
+  uint64_t grain; /**< largest number of iterations passed to body at once */
+  ob_pool_join *join; /**< counter decremented once the task completes */
+} ob_pool_task;
+
+/**
+ * @brief Deque of tasks, a ring buffer guarded by its own lock
+ */
+typedef struct ob_pool_deque_struct{
+  pthread_mutex_t lock; /**< guards all other members */
+  ob_pool_task *tasks; /**< ring buffer of tasks */
+  uint64_t capacity; /**< size of tasks, a power of 2 */
+  uint64_t top; /**< index of the oldest task, taken by thieves */
+  uint64_t bottom; /**< index following the newest task, taken by the owner */
+} ob_pool_deque;
+
+/**
+ * @brief Worker thread of a pool
+ */
+typedef struct ob_pool_worker_struct{
+  ob_pool *pool; /**< pool of the worker */
+  uint32_t index; /**< index of the deque owned by the worker */
+  pthread_t thread; /**< thread running the worker */
+} ob_pool_worker;
+
+/**
+ * @brief Pool internal structure
+ */
+struct ob_pool_struct{
+  uint32_t threads; /**< number of threads running tasks, including the
+                         thread waiting for them */
+  uint32_t worker_count; /**< number of worker threads, threads - 1 */
+  ob_pool_worker *workers; /**< worker threads */
+  ob_pool_deque *deques; /**< one deque per worker, followed by the deque of
+                              threads outside the pool */
+  _Atomic uint64_t queued; /**< number of tasks in all deques */
+  _Atomic uint32_t sleeping; /**< number of workers waiting for tasks */
+  uint8_t shutdown; /**< non-zero once workers must exit, guarded by lock */
+  pthread_mutex_t lock; /**< guards shutdown and sleeping workers */
+  pthread_cond_t wake; /**< signalled when tasks are queued for sleepers */
+};
+
+/**
+ * @brief Worker thread routine, runs tasks until the pool shuts down
+ *
+ * @param arg Worker of the thread
+ * @return NULL
+ */
+void * ob_pool_worker_main(void *arg);
+
+/**
+ * @brief Creates the default pool, called once through pthread_once
+ */
+void ob_pool_init_default(void);
+
+/**
+ * @brief Finds the deque a thread pushes its tasks to
+ *
+ * @param pool A pool
+ * @return Index of the deque of the calling worker of pool, or of the shared
+ * deque if the calling thread is not a worker of pool
+ */
+uint32_t ob_pool_home(const ob_pool *pool);
+
+/**
+ * @brief Pushes a task to the bottom of a deque and wakes a sleeping worker
+ *
+ * @param pool A pool
+ * @param home Index of the deque
+ * @param task Task to push, its join counter already counts it
+ */
+void ob_pool_push(ob_pool *pool, uint32_t home, const ob_pool_task *task);
+
+/**
+ * @brief Takes a task, popping the deque of the calling thread first and
+ * stealing from the other deques otherwise
+ *
+ * @param pool A pool
+ * @param home Index of the deque of the calling thread
+ * @param task Set to the task taken
+ *
+ * @retval 0 All deques were empty
+ * @retval non-zero A task was taken
+ */
+uint8_t ob_pool_take(ob_pool *pool, uint32_t home, ob_pool_task *task);
+
+/**
+ * @brief Runs a task, forking the upper halves of a range to the deque of the
+ * calling thread until it is no larger than its grain
+ *
+ * @param pool A pool
+ * @param home Index of the deque of the calling thread
+ * @param task Task to run
+ */
+void ob_pool_run(ob_pool *pool, uint32_t home, ob_pool_task *task);
+
+/**
+ * @brief Runs pending tasks until every task counted by a join completes
+ *
+ * @param pool A pool
+ * @param home Index of the deque of the calling thread
+ * @param join Counter of the tasks to wait for
+ */
+void ob_pool_wait(ob_pool *pool, uint32_t home, ob_pool_join *join);
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file offbrand_reftrace_private.h
+ * @brief Reference count tracing
+ *
+ * @details
+ * While tracing is started, every allocation, retain, release and
+ * deallocation is recorded into a fixed size ring buffer owned by the calling
+ * thread, overwriting its oldest events once full. Only the owning thread
+ * writes a buffer, so recording is a few stores and an index increment, and
+ * when tracing is stopped the cost is a single relaxed load and branch.
+ * Buffers are kept for the lifetime of the process, so that reports cover
+ * threads which have exited. Defining OB_NO_REF_TRACE when building the
+ * library removes tracing entirely.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_REFTRACE_PRIVATE_H
+#define OFFBRAND_REFTRACE_PRIVATE_H
+
+#include "../offbrand.h"
+#include <stdatomic.h>
+#include <pthread.h>
+
+/** Number of events held by each thread's ring buffer, a power of 2 */
+#define OB_REF_TRACE_CAPACITY (1<<16)
+
+/** Trace event type, an instance was allocated */
+#define OB_REF_TRACE_ALLOC 0
+/** Trace event type, an instance was retained */
+#define OB_REF_TRACE_RETAIN 1
+/** Trace event type, an instance was released */
+#define OB_REF_TRACE_RELEASE 2
+/** Trace event type, an instance was deallocated */
+#define OB_REF_TRACE_DEALLOC 3
+
+/**
+ * @brief A single traced reference counting event
+ */
+typedef struct ob_ref_trace_event_struct{
+  const obj *instance; /**< address of the instance */
+  const ob_class *cls; /**< class of the instance */
+  const void *caller; /**< return address into the calling function, NULL if
+                           unknown */
+  ob_ref_count_t count; /**< reference count after the event */
+  uint8_t type; /**< OB_REF_TRACE_* type of the event */
+} ob_ref_trace_event;
+
+/**
+ * @brief Ring buffer of trace events recorded by one thread
+ */
+typedef struct ob_ref_trace_buffer_struct{
+  ob_ref_trace_event events[OB_REF_TRACE_CAPACITY]; /**< recorded events */
+  _Atomic uint64_t recorded; /**< total events ever recorded, the next event
+                                  is written at recorded % capacity */
+  struct ob_ref_trace_buffer_struct *next; /**< next buffer of any thread */
+} ob_ref_trace_buffer;
+
+/** non-zero while tracing is started, read on every traced operation */
+extern _Atomic uint8_t ob_ref_trace_enabled;
+
+/**
+ * @brief Records an event if tracing is started
+ *
+ * @details The class is passed rather than read from the instance, as a
+ * shared instance may be deallocated by another thread as soon as this thread
+ * releases it. Evaluates to nothing when the library is built with
+ * OB_NO_REF_TRACE.
+ */
+#ifdef OB_NO_REF_TRACE
+#define OB_REF_TRACE(type, instance, cls, count, caller) ((void)(cls))
+#else
+#define OB_REF_TRACE(type, instance, cls, count, caller) \
+  do{ \
+    if(atomic_load_explicit(&ob_ref_trace_enabled, memory_order_relaxed)) \
+      ob_ref_trace_record((type), (instance), (cls), (count), (caller)); \
+  }while(0)
+#endif
+
+/**
+ * @brief Appends an event to the ring buffer of the calling thread, creating
+ * the buffer on first use
+ *
+ * @param type OB_REF_TRACE_* type of the event
+ * @param instance Instance the event applies to, never dereferenced
+ * @param cls Class of the instance
+ * @param count Reference count of the instance after the event
+ * @param caller Return address into the function causing the event
+ */
+void ob_ref_trace_record(uint8_t type, const obj *instance,
+                         const ob_class *cls, ob_ref_count_t count,
+                         const void *caller);
+
+/**
+ * @brief Copies the events held by every buffer into a single array
+ *
+ * @param count Set to the number of events copied
+ * @return Array of events, to be freed by the caller
+ */
+ob_ref_trace_event * ob_ref_trace_collect(uint64_t *count);
+
+/**
+ * @brief Prints a call site as an offset into the executable or library
+ * containing it, followed by a newline
+ *
+ * @param out Stream to print to
+ * @param caller Return address of the call site, may be NULL
+ */
+void ob_ref_trace_print_site(FILE *out, const void *caller);
+
+/**
+ * @brief qsort comparison of events by caller and type
+ */
+int ob_ref_trace_compare_site(const void *a, const void *b);
+
+/**
+ * @brief qsort comparison of grouped call sites, most frequent first
+ */
+int ob_ref_trace_compare_frequency(const void *a, const void *b);
+
+/**
+ * @brief qsort comparison of events by instance address
+ */
+int ob_ref_trace_compare_instance(const void *a, const void *b);
+
+#endif
@@ -0,0 +1,215 @@
+/**
+ * @file offbrand_serial_private.h
+ * @brief Binary serialization of offbrand instances
+ *
+ * @details
+ * Every serialized instance starts with a class reference, a variable length
+ * integer that is 0 for NULL, 1 for a class not yet met in the stream, in which
+ * case the length prefixed class name follows, or 2 plus the index of a class
+ * already met. The class specific data written by the serialize function of the
+ * class follows. Variable length integers hold 7 bits per byte, least
+ * significant first, with the high bit of each byte set if more bytes follow.
+ *
+ * Class names are resolved to the descriptors of the library classes, so that
+ * a program may read instances of classes it never allocated.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_SERIAL_PRIVATE_H
+#define OFFBRAND_SERIAL_PRIVATE_H
+
+#include "../offbrand.h"
+#include <unistd.h>
+#include <errno.h>
+
+/** Size of the buffer of each writer and reader, in bytes */
+#define OB_SERIAL_BUFFER_SIZE (64*1024)
+/** Longest class name accepted by a reader */
+#define OB_SERIAL_MAX_NAME 255
+/** Largest number of elements a container is presized for while being read,
+ * larger containers grow as they are read */
+#define OB_SERIAL_PRESIZE_LIMIT (64*1024)
+/** Deepest nesting of instances accepted by a reader, reading recurses once
+ * per level so deeper streams are rejected rather than exhausting the stack */
+#define OB_SERIAL_MAX_DEPTH 1024
+/** Class reference of a NULL instance */
+#define OB_SERIAL_NULL 0
+/** Class reference of a class named in the stream */
+#define OB_SERIAL_NEW_CLASS 1
+/** Class reference of the first class already met in the stream */
+#define OB_SERIAL_FIRST_INDEX 2
+
+/**
+ * @brief Classes met by a writer or reader, in order of first appearance
+ */
+typedef struct ob_serial_classes_struct{
+  const ob_class **classes; /**< class descriptors, indexed by class index */
+  uint64_t count; /**< number of classes met */
+  uint64_t capacity; /**< number of descriptors classes can hold */
+} ob_serial_classes;
+
+/**
+ * @brief Writer internal structure
+ */
+struct ob_writer_struct{
+  FILE *file; /**< destination stream, NULL if writing to fd */
+  int fd; /**< destination file descriptor, used if file is NULL */
+  uint8_t failed; /**< non-zero once a write to the destination failed */
+  size_t used; /**< number of bytes held in buffer */
+  ob_serial_classes met; /**< classes already named in the stream */
+  unsigned char buffer[OB_SERIAL_BUFFER_SIZE]; /**< data not yet written */
+};
+
+/**
+ * @brief Reader internal structure
+ */
+struct ob_reader_struct{
+  FILE *file; /**< source stream, NULL if reading from fd */
+  int fd; /**< source file descriptor, used if file is NULL */
+  uint8_t failed; /**< non-zero once malformed data was read */
+  uint8_t exhausted; /**< non-zero once the source returned no more data */
+  uint32_t depth; /**< number of instances being read, nested in each other */
+  size_t start; /**< index of the first unread byte in buffer */
+  size_t end; /**< index following the last byte read into buffer */
+  ob_serial_classes met; /**< classes already named in the stream */
+  unsigned char buffer[OB_SERIAL_BUFFER_SIZE]; /**< data read ahead */
+};
+
+/**
+ * @brief Allocates and initializes a writer
+ *
+ * @param file Destination stream, or NULL
+ * @param fd Destination file descriptor, used if file is NULL
+ * @return A new writer
+ */
+ob_writer * ob_writer_create(FILE *file, int fd);
+
+/**
+ * @brief Appends bytes to the data of a writer
+ *
+ * @param writer A writer
+ * @param data Bytes to write
+ * @param length Number of bytes to write
+ */
+void ob_writer_write(ob_writer *writer, const void *data, size_t length);
+
+/**
+ * @brief Appends a variable length integer to the data of a writer
+ *
+ * @param writer A writer
+ * @param value Integer to write
+ */
+void ob_writer_write_varint(ob_writer *writer, uint64_t value);
+
+/**
+ * @brief Writes the buffered bytes of a writer to its destination, emptying
+ * the buffer
+ *
+ * @param writer A writer
+ */
+void ob_writer_drain(ob_writer *writer);
+
+/**
+ * @brief Allocates and initializes a reader
+ *
+ * @param file Source stream, or NULL
+ * @param fd Source file descriptor, used if file is NULL
+ * @return A new reader
+ */
+ob_reader * ob_reader_create(FILE *file, int fd);
+
+/**
+ * @brief Reads bytes from a reader
+ *
+ * @param reader A reader
+ * @param data Destination of the bytes
+ * @param length Number of bytes to read
+ *
+ * @retval 0 The source ended before length bytes, or reading already failed.
+ * The reader is marked as failed
+ * @retval non-zero length bytes were read
+ */
+uint8_t ob_reader_read(ob_reader *reader, void *data, size_t length);
+
+/**
+ * @brief Reads a variable length integer from a reader
+ *
+ * @param reader A reader
+ * @param value Destination of the integer
+ *
+ * @retval 0 The integer was truncated or malformed, the reader is marked as
+ * failed
+ * @retval non-zero The integer was read
+ */
+uint8_t ob_reader_read_varint(ob_reader *reader, uint64_t *value);
+
+/**
+ * @brief Reads bytes from a reader into a new buffer
+ *
+ * @param reader A reader
+ * @param length Number of bytes to read
+ * @param extra Number of bytes to allocate following the bytes read
+ *
+ * @return A buffer of length plus extra bytes to be freed by the caller, or
+ * NULL if the source ended before length bytes
+ *
+ * @details The buffer grows as data arrives, so a malformed length fails at
+ * the end of the data rather than allocating its full size
+ */
+void * ob_reader_read_buffer(ob_reader *reader, uint64_t length, size_t extra);
+
+/**
+ * @brief Marks a reader as failed, used by deserialization functions reading
+ * well formed but invalid data
+ *
+ * @param reader A reader
+ */
+void ob_reader_fail(ob_reader *reader);
+
+/**
+ * @brief Reads more data from the source of a reader into its buffer
+ *
+ * @param reader A reader whose buffer holds no unread data
+ */
+void ob_reader_fill(ob_reader *reader);
+
+/**
+ * @brief Finds the index of a class among the classes met in a stream
+ *
+ * @param met Classes met in a stream
+ * @param cls Class descriptor
+ * @return Index of cls, or met->count if it was not met
+ */
+uint64_t ob_serial_find_met(const ob_serial_classes *met, const ob_class *cls);
+
+/**
+ * @brief Records a class as met in a stream
+ *
+ * @param met Classes met in a stream
+ * @param cls Class descriptor not yet met
+ */
+void ob_serial_add_met(ob_serial_classes *met, const ob_class *cls);
+
+/**
+ * @brief Resolves a class name to the descriptor of a library class
+ *
+ * @param classname NUL terminated class name
+ * @return The class descriptor, or NULL if no serializable class has the name
+ */
+const ob_class * ob_serial_find_class(const char *classname);
+
+/* LIBRARY CLASSES RESOLVED BY NAME */
+
+/** @return The class descriptor of obint */
+const ob_class * obint_class_descriptor(void);
+/** @return The class descriptor of obstring */
+const ob_class * obstring_class_descriptor(void);
+/** @return The class descriptor of obvector */
+const ob_class * obvector_class_descriptor(void);
+/** @return The class descriptor of obdeque */
+const ob_class * obdeque_class_descriptor(void);
+/** @return The class descriptor of obmap */
+const ob_class * obmap_class_descriptor(void);
+
+#endif
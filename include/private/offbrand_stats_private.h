@@ -0,0 +1,102 @@
+/**
+ * @file offbrand_stats_private.h
+ * @brief Per class allocation statistics
+ *
+ * @details
+ * Each thread counts allocations and frees of every class it sees in a
+ * private open addressed table keyed by class descriptor, so recording an
+ * allocation is a table probe and two plain stores. Tables are registered in a
+ * global list and merged when statistics are queried. A thread exiting merges
+ * its table into a retired table so its counts are not lost. Defining
+ * OB_NO_CLASS_STATS when building the library removes all counting.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_STATS_PRIVATE_H
+#define OFFBRAND_STATS_PRIVATE_H
+
+#include "../offbrand.h"
+#include <stdatomic.h>
+#include <pthread.h>
+
+/** Initial capacity of each thread's statistics table, a power of 2 */
+#define OB_STATS_INITIAL_CAPACITY 32
+
+/**
+ * @brief Counters of one class within one thread. Only the owning thread
+ * modifies the counters, other threads read them while merging
+ */
+typedef struct ob_stats_entry_struct{
+  _Atomic(const ob_class *) cls; /**< class counted, NULL for an empty slot */
+  _Atomic uint64_t allocations; /**< instances allocated by the thread */
+  _Atomic uint64_t frees; /**< instances freed by the thread */
+  _Atomic uint64_t peak_live; /**< largest allocations - frees reached */
+} ob_stats_entry;
+
+/**
+ * @brief Statistics table of one thread
+ */
+typedef struct ob_stats_table_struct{
+  ob_stats_entry *entries; /**< open addressed entries, linear probing */
+  uint32_t capacity; /**< number of entries, a power of 2 */
+  uint32_t count; /**< number of classes in the table */
+  pthread_mutex_t lock; /**< held by the owner while growing the table and by
+                             threads merging it */
+  struct ob_stats_table_struct *next; /**< next registered table */
+  uint8_t registered; /**< non-zero once in the global list of tables */
+} ob_stats_table;
+
+/**
+ * @brief Counts an allocated instance of cls on the calling thread
+ *
+ * @param cls Descriptor of the allocated instance
+ */
+void ob_stats_record_alloc(const ob_class *cls);
+
+/**
+ * @brief Counts a freed instance of cls on the calling thread
+ *
+ * @param cls Descriptor of the freed instance
+ */
+void ob_stats_record_free(const ob_class *cls);
+
+/**
+ * @brief Finds the entry for cls in a table, inserting an empty entry if the
+ * class was not yet counted in the table
+ *
+ * @param table Statistics table of the calling thread
+ * @param cls Class to find
+ * @return Entry of cls
+ */
+ob_stats_entry * ob_stats_entry_for(ob_stats_table *table, const ob_class *cls);
+
+/**
+ * @brief Merges every registered and retired table into an array of class
+ * statistics
+ *
+ * @param count Set to the number of classes in the returned array
+ * @return Array of statistics, one per class, to be freed by the caller
+ */
+ob_class_stats * ob_stats_merge(uint64_t *count);
+
+/**
+ * @brief Thread exit handler, moves the counts of an exiting thread into the
+ * retired table
+ *
+ * @param table Statistics table of the exiting thread
+ */
+void ob_stats_thread_exit(void *table);
+
+/**
+ * @brief Registers ob_stats_print_at_exit with atexit, called once through
+ * pthread_once
+ */
+void ob_stats_register_at_exit(void);
+
+/**
+ * @brief Prints all class statistics to stderr, registered with atexit
+ */
+void ob_stats_print_at_exit(void);
+
+#endif
@@ -0,0 +1,105 @@
+/**
+ * @file offbrand_weak_private.h
+ * @brief Weak references to offbrand instances
+ *
+ * @details
+ * Weak handles are recorded in a single process wide side table, an open
+ * addressed table keyed by target address holding the one handle of each
+ * target. Targets with a handle have their weak field set, so destroying an
+ * instance only consults the table if it was ever weakly referenced. The table,
+ * the target of every handle and the weak field of every instance are changed
+ * only while holding the table lock.
+ *
+ * @author theck
+ */
+
+#ifndef OFFBRAND_WEAK_PRIVATE_H
+#define OFFBRAND_WEAK_PRIVATE_H
+
+#include "../offbrand.h"
+#include <pthread.h>
+
+/** Initial capacity of the weak table, a power of 2 */
+#define OB_WEAK_INITIAL_CAPACITY 64
+
+/**
+ * @brief Weak handle internal structure
+ */
+struct ob_weak_struct{
+  obj base; /**< obj containing reference count and class membership data */
+  obj *target; /**< instance referred to, not retained. NULL once the target
+                    was deallocated or the handle replaced in the table */
+};
+
+/**
+ * @brief Side table of the handle of each weakly referenced instance
+ */
+typedef struct ob_weak_table_struct{
+  ob_weak **handles; /**< open addressed handles, linear probing, NULL for an
+                          empty slot */
+  uint64_t capacity; /**< number of slots, a power of 2 */
+  uint64_t count; /**< number of handles in the table */
+} ob_weak_table;
+
+/**
+ * @brief Detaches the handle of an instance being deallocated, so that it no
+ * longer resolves to the instance
+ *
+ * @param target Instance whose weak field is set
+ */
+void ob_weak_clear(obj *target);
+
+/**
+ * @brief Retains an instance only if its reference count has not reached 0
+ *
+ * @param instance Instance whose memory is known to be valid
+ *
+ * @retval 0 instance was released to a count of 0, and was not retained
+ * @retval non-zero instance was retained
+ */
+uint8_t ob_weak_retain_if_live(obj *instance);
+
+/**
+ * @brief Finds the slot of a target in the weak table
+ *
+ * @param target Instance to find
+ * @return Index of the slot holding the handle of target, or of the empty slot
+ * where it would be inserted
+ *
+ * @warning Must be called with the table lock held
+ */
+uint64_t ob_weak_table_slot(const obj *target);
+
+/**
+ * @brief Removes the handle stored at a slot of the weak table, moving later
+ * handles of the same probe sequence back so no tombstones are needed
+ *
+ * @param slot Index of an occupied slot
+ *
+ * @warning Must be called with the table lock held
+ */
+void ob_weak_table_remove(uint64_t slot);
+
+/**
+ * @brief Doubles the capacity of the weak table
+ *
+ * @warning Must be called with the table lock held
+ */
+void ob_weak_table_grow(void);
+
+/**
+ * @brief Deallocator for weak handles, removes the handle from the weak table
+ * if it is still the handle of its target
+ *
+ * @param to_dealloc An obj pointer to a weak handle
+ */
+void ob_weak_destroy(obj *to_dealloc);
+
+/**
+ * @brief Display function for weak handles
+ *
+ * @param to_print An obj pointer to a weak handle
+ */
+void ob_weak_display(const obj *to_print);
+
+#endif
@@ -8,6 +8,7 @@
 #define %MACRONAME%_PRIVATE_H
 
 #include "../%CLASSNAME%.h"
+#include "obj_private.h"
 
 /* DATA */
 
@@ -7,6 +7,18 @@
 #include "../../include/%CLASSNAME%.h"
 #include "../../include/private/%CLASSNAME%_private.h"
 
+/** class descriptor shared by all %CLASSNAME% instances */
+static const ob_class %CLASSNAME%_class = {
+  .classname = "%CLASSNAME%",
+  .size = sizeof(%CLASSNAME%),
+  .dealloc = &%CLASSNAME%_destroy,
+  .hash = &%CLASSNAME%_hash,
+  .compare = &%CLASSNAME%_compare,
+  .display = &%CLASSNAME%_display,
+  .traverse = NULL /* supply a traversal function if instances hold references
+                      to other objs */
+};
+
 /* PUBLIC METHODS */
 
 
@@ -19,14 +31,7 @@
  * %CLASSNAME%_private.h as well if modifications are made */
 %CLASSNAME% * %CLASSNAME%_create_default(void){
 
-  static const char classname[] = "%CLASSNAME%";
-  %CLASSNAME% *new_instance = malloc(sizeof(%CLASSNAME%));
-  assert(new_instance != NULL);
-
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &%CLASSNAME%_destroy,
-               &%CLASSNAME%_hash, &%CLASSNAME%_compare,
-               &%CLASSNAME%_display, classname);
+  %CLASSNAME% *new_instance = (%CLASSNAME% *)ob_alloc(&%CLASSNAME%_class);
 
   /* ADD CLASS SPECIFIC INITIALIZATION HERE */
 
@@ -43,7 +48,7 @@ ob_hash_t %CLASSNAME%_hash(const obj *to_hash){
   %CLASSNAME% *instance = (%CLASSNAME% *)to_hash;
 
   assert(to_hash);
-  assert(ob_has_class(to_hash, "%CLASSNAME%"));
+  OB_ASSERT_CLASS(to_hash, &%CLASSNAME%_class);
 
   if(init == 0){
     srand(time(NULL));
@@ -56,26 +61,26 @@ ob_hash_t %CLASSNAME%_hash(const obj *to_hash){
   /* Implement a hash function suitable for uniquely itentifying
    * %CLASSNAME% instances. If instance address munging is an acceptable
    * hash then this method can be deleted and NULL should be supplied to the
-   * hash_funct argument of initBase in createdDefault%CLASSNAME% */
+   * hash member of %CLASSNAME%_class */
 
   return 0;
 }
 
 
-int8_t %CLASSNAME%_compares(const obj *a, const obj *b){
+int8_t %CLASSNAME%_compare(const obj *a, const obj *b){
 
   const %CLASSNAME% *comp_a = (%CLASSNAME% *)a;
   const %CLASSNAME% *comp_b = (%CLASSNAME% *)b;
 
   assert(a);
   assert(b);
-  assert(ob_has_class(a, "%CLASSNAME%"));
-  assert(ob_has_class(b, "%CLASSNAME%"));
+  OB_ASSERT_CLASS(a, &%CLASSNAME%_class);
+  OB_ASSERT_CLASS(b, &%CLASSNAME%_class);
 
   /* add specific comparison logic, following the description in the header
    * file. If pointer based comparision is all that is needed then this method
-   * can be deleted and NULL should be supplied to the compare_funct argument of
-   * initBase in createdDefault%CLASSNAME% */
+   * can be deleted and NULL should be supplied to the compare member of
+   * %CLASSNAME%_class */
 
   return OB_EQUAL_TO;
 }
@@ -86,12 +91,11 @@ void %CLASSNAME%_display(const obj *to_print){
   const %CLASSNAME% *instance = (%CLASSNAME% *)to_print;
 
   assert(to_print);
-  assert(ob_has_class(to_print, "%CLASSNAME%"));
+  OB_ASSERT_CLASS(to_print, &%CLASSNAME%_class);
 
   /* add class specific display logic. If printing the classname and address
    * of an instance is all that is needed then this method can be deleted and
-   * NULL should be supplid to the display_funct argument of initBase in
-   * %CLASSNAME%_create_default */
+   * NULL should be supplid to the display member of %CLASSNAME%_class */
 
   return;
 }
@@ -103,7 +107,7 @@ void %CLASSNAME%_destroy(obj *to_dealloc){
   %CLASSNAME% *instance = (%CLASSNAME% *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "%CLASSNAME%"));
+  OB_ASSERT_CLASS(to_dealloc, &%CLASSNAME%_class);
 
   /* PERFORM CLASS SPECIFIC MEMORY MANAGEMENT ON instance HERE BUT DO NOT
    * FREE INSTANCE, THE LIBRARY WILL DO THAT */
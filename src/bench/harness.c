@@ -0,0 +1,185 @@
+/**
+ * @file harness.c
+ * @brief Benchmark Harness Implementation
+ * @author theck
+ */
+
+#include "harness.h"
+
+/** non-zero to print JSON lines rather than a table */
+static uint8_t json_output = 0;
+/** substring of the names of benchmarks to run, NULL for all */
+static const char *name_filter = NULL;
+/** minimum time of the timed operations, in nanoseconds */
+static uint64_t min_time_ns = OB_BENCH_DEFAULT_MIN_TIME*1000000ULL;
+/** number of runs that failed */
+static uint32_t failed_runs = 0;
+
+/**
+ * @brief Reads the monotonic clock
+ * @return Time in nanoseconds
+ */
+static uint64_t ob_bench_now(void){
+
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * @brief Counts the instances allocated so far by all threads
+ * @return Number of instances allocated
+ */
+static uint64_t ob_bench_allocations(void){
+
+  ob_class_stats stats;
+
+  ob_get_total_class_stats(&stats);
+
+  return stats.allocations;
+}
+
+/**
+ * @brief Calibrates and measures a benchmark at one size, then reports it,
+ * called in the child process of the run
+ *
+ * @param name Name of the benchmark
+ * @param benchmark Benchmark to run
+ * @param size Size of the run
+ */
+static void ob_bench_measure(const char *name, ob_bench_fptr benchmark,
+                             uint64_t size){
+
+  ob_bench b;
+  struct rusage usage;
+  uint64_t next;
+  double ns_per_op, allocations_per_op;
+
+  b.size = size;
+  b.iterations = 1;
+
+  for(;;){
+    b.elapsed_ns = 0;
+    b.allocations = 0;
+    benchmark(&b);
+
+    if(b.elapsed_ns >= min_time_ns || b.iterations >= OB_BENCH_MAX_ITERATIONS)
+      break;
+
+    /* aim past the minimum time, growing at least twofold and at most a
+     * hundredfold per run */
+    next = b.elapsed_ns ? b.iterations*(min_time_ns*6/5)/b.elapsed_ns : 0;
+    if(next < b.iterations*2) next = b.iterations*2;
+    if(next > b.iterations*100) next = b.iterations*100;
+    if(next > OB_BENCH_MAX_ITERATIONS) next = OB_BENCH_MAX_ITERATIONS;
+    b.iterations = next;
+  }
+
+  getrusage(RUSAGE_SELF, &usage);
+  ns_per_op = (double)b.elapsed_ns/b.iterations;
+  allocations_per_op = (double)b.allocations/b.iterations;
+
+  if(json_output){
+    printf("{\"benchmark\": \"%s\", \"size\": %llu, \"iterations\": %llu, "
+           "\"ns_per_op\": %.2f, \"allocs_per_op\": %.3f, "
+           "\"peak_rss_kib\": %ld}\n", name, (unsigned long long)size,
+           (unsigned long long)b.iterations, ns_per_op, allocations_per_op,
+           usage.ru_maxrss);
+  }
+  else{
+    printf("%-28s %10llu %12llu %14.1f ns/op %12.3f allocs/op %10ld KiB\n",
+           name, (unsigned long long)size, (unsigned long long)b.iterations,
+           ns_per_op, allocations_per_op, usage.ru_maxrss);
+  }
+
+  fflush(stdout);
+}
+
+
+void ob_bench_init(int argc, char **argv){
+
+  int i;
+
+  for(i=1; i<argc; i++){
+    if(strcmp(argv[i], "--json") == 0) json_output = 1;
+    else if(strcmp(argv[i], "--filter") == 0 && i+1 < argc)
+      name_filter = argv[++i];
+    else if(strcmp(argv[i], "--min-time") == 0 && i+1 < argc)
+      min_time_ns = strtoull(argv[++i], NULL, 10)*1000000ULL;
+    else{
+      fprintf(stderr, "usage: %s [--json] [--filter substring] "
+                      "[--min-time milliseconds]\n", argv[0]);
+      exit(1);
+    }
+  }
+
+  return;
+}
+
+
+void ob_bench_run(const char *name, ob_bench_fptr benchmark,
+                  const uint64_t *sizes){
+
+  pid_t child;
+  int status;
+
+  assert(name != NULL);
+  assert(benchmark != NULL);
+  assert(sizes != NULL);
+
+  if(name_filter && !strstr(name, name_filter)) return;
+
+  for(; *sizes; sizes++){
+
+    fflush(stdout);
+    child = fork();
+    assert(child >= 0);
+
+    if(child == 0){
+      ob_bench_measure(name, benchmark, *sizes);
+      _exit(0);
+    }
+
+    if(waitpid(child, &status, 0) != child || !WIFEXITED(status) ||
+       WEXITSTATUS(status) != 0){
+      fprintf(stderr, "%s at size %llu failed\n", name,
+              (unsigned long long)*sizes);
+      failed_runs++;
+    }
+  }
+
+  return;
+}
+
+
+int ob_bench_finish(void){
+  return failed_runs ? 1 : 0;
+}
+
+
+void ob_bench_start(ob_bench *b){
+  b->start_allocations = ob_bench_allocations();
+  b->start_ns = ob_bench_now();
+}
+
+
+void ob_bench_stop(ob_bench *b){
+  b->elapsed_ns += ob_bench_now() - b->start_ns;
+  b->allocations += ob_bench_allocations() - b->start_allocations;
+}
+
+
+uint64_t ob_bench_random(uint64_t *state){
+
+  uint64_t value;
+
+  /* splitmix64, fast and well distributed */
+  *state += 0x9e3779b97f4a7c15ULL;
+  value = *state;
+  value = (value ^ (value >> 30))*0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27))*0x94d049bb133111ebULL;
+
+  return value ^ (value >> 31);
+}
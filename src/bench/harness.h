@@ -0,0 +1,100 @@
+/**
+ * @file harness.h
+ * @brief Benchmark Harness Interface
+ *
+ * @details
+ * Every benchmark program registers its benchmarks with ob_bench_run, each run
+ * once per size. A benchmark sets up its data, times b->iterations operations
+ * between ob_bench_start and ob_bench_stop, then frees its data. The harness
+ * grows the iterations until the timed operations take at least the minimum
+ * time, and reports the last run. Each benchmark and size runs in a child
+ * process, so that its peak resident set size is its own and a crash does not
+ * end the program.
+ *
+ * Programs accept the options:
+ *  - --json, print one JSON object per line instead of a table
+ *  - --filter substring, run only benchmarks whose name contains substring
+ *  - --min-time milliseconds, minimum time of the timed operations, 200 by
+ *    default
+ *
+ * @author theck
+ */
+
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include "../../include/offbrand.h"
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/** Default minimum time of the timed operations, in milliseconds */
+#define OB_BENCH_DEFAULT_MIN_TIME 200
+/** Largest number of iterations of a single run */
+#define OB_BENCH_MAX_ITERATIONS (1ULL << 32)
+
+/**
+ * @brief State of a benchmark run
+ */
+typedef struct ob_bench_struct{
+  uint64_t size; /**< size parameter of the run */
+  uint64_t iterations; /**< number of operations to time */
+  uint64_t start_ns; /**< time of ob_bench_start */
+  uint64_t elapsed_ns; /**< time between ob_bench_start and ob_bench_stop */
+  uint64_t start_allocations; /**< instances allocated before ob_bench_start */
+  uint64_t allocations; /**< instances allocated while timed */
+} ob_bench;
+
+/** function pointer to a benchmark, timing b->iterations operations */
+typedef void (*ob_bench_fptr)(ob_bench *b);
+
+/**
+ * @brief Parses the options of a benchmark program
+ *
+ * @param argc Argument count passed to main
+ * @param argv Arguments passed to main
+ */
+void ob_bench_init(int argc, char **argv);
+
+/**
+ * @brief Runs a benchmark once per size and reports each run
+ *
+ * @param name Name of the benchmark, reported along with each size
+ * @param benchmark Benchmark to run
+ * @param sizes Sizes to run the benchmark with, terminated by 0
+ */
+void ob_bench_run(const char *name, ob_bench_fptr benchmark,
+                  const uint64_t *sizes);
+
+/**
+ * @brief Ends a benchmark program
+ *
+ * @return Exit status of the program, non-zero if any run failed
+ */
+int ob_bench_finish(void);
+
+/**
+ * @brief Starts timing the operations of a run, call after setting up
+ *
+ * @param b State of the run
+ */
+void ob_bench_start(ob_bench *b);
+
+/**
+ * @brief Stops timing the operations of a run, call before freeing data
+ *
+ * @param b State of the run
+ */
+void ob_bench_stop(ob_bench *b);
+
+/**
+ * @brief Returns a pseudo random number of a fixed sequence, so that every run
+ * operates on the same data
+ *
+ * @param state Generator state, seed it with any value
+ * @return Next number of the sequence
+ */
+uint64_t ob_bench_random(uint64_t *state);
+
+#endif
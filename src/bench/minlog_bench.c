@@ -0,0 +1,110 @@
+/**
+ * @file minlog_bench.c
+ * @brief minlog Workload Benchmark
+ *
+ * @details
+ * Minimizes generated boolean functions the way the minlog application does,
+ * from parsing the equation to finding the essential prime implicants, with
+ * every intermediate object allocated in an arena.
+ *
+ * @author theck
+ */
+
+#include "harness.h"
+#include "../../include/obvector.h"
+#include "../../apps/minlog/include/Term.h"
+#include "../../apps/minlog/include/NCube.h"
+#include "../../apps/minlog/include/RTable.h"
+#include "../../apps/minlog/include/minlog_funct.h"
+
+/** Numbers of variables of the functions minimized, terminated by 0. The
+ * equations of larger functions do not fit the buffers of parseEqnString */
+static const uint64_t sizes[] = {4, 6, 8, 0};
+/** Size of the equation buffer of parseEqnString */
+#define EQUATION_SIZE 1024
+
+/**
+ * @brief Generates the equation of a sum of random products, which unlike a
+ * random truth table rarely leaves minlog an exponential search for the cover
+ *
+ * @param num_var Number of variables of the function
+ * @param equation Buffer of EQUATION_SIZE characters set to the equation
+ */
+static void generate_equation(uint64_t num_var, char *equation){
+
+  uint64_t i, term, state = num_var, care, value;
+  uint8_t *minterms;
+  int written;
+
+  minterms = calloc(1ULL << num_var, 1);
+  assert(minterms != NULL);
+
+  /* num_var products, each fixing every variable with probability 3/5 */
+  for(i=0; i<num_var; i++){
+    care = value = 0;
+    for(term=0; term<num_var; term++){
+      if(ob_bench_random(&state) % 5 < 3){
+        care |= 1ULL << term;
+        value |= (ob_bench_random(&state) & 1) << term;
+      }
+    }
+    for(term=0; term<(1ULL << num_var); term++)
+      if((term & care) == value) minterms[term] = 1;
+  }
+
+  written = sprintf(equation, "m");
+  for(term=0; term<(1ULL << num_var); term++){
+    if(minterms[term]){
+      assert(written + 12 < EQUATION_SIZE);
+      written += sprintf(equation + written, " %llu",
+                         (unsigned long long)term);
+    }
+  }
+
+  free(minterms);
+}
+
+/**
+ * @brief One operation minimizes a function of b->size variables
+ */
+static void bench_minimize(ob_bench *b){
+
+  uint64_t i;
+  char equation[EQUATION_SIZE];
+  obvector *terms, *dont_cares, *pis, *essential_pis;
+  RTable *reduction_table;
+  ob_arena *arena;
+
+  generate_equation(b->size, equation);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+
+    arena = ob_arena_new();
+    ob_arena_enter(arena);
+
+    terms = obvector_new(32);
+    dont_cares = obvector_new(32);
+    parseEqnString(equation, terms, dont_cares, 0);
+    pis = findLargestPrimeImplicants(terms, dont_cares);
+    reduction_table = createRTable(pis, terms);
+    essential_pis = findEssentialPIs(reduction_table, (uint8_t)b->size);
+    assert(obvector_length(essential_pis) > 0);
+
+    ob_arena_exit();
+    ob_arena_destroy(arena);
+  }
+  ob_bench_stop(b);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("minlog_minimize", &bench_minimize, sizes);
+
+  return ob_bench_finish();
+}
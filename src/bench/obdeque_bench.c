@@ -0,0 +1,121 @@
+/**
+ * @file obdeque_bench.c
+ * @brief obdeque Benchmarks
+ * @author theck
+ */
+
+#include "harness.h"
+#include "../../include/obint.h"
+#include "../../include/obdeque.h"
+
+/** Sizes of the deques benchmarked, terminated by 0 */
+static const uint64_t sizes[] = {16, 1024, 65536, 0};
+
+/**
+ * @brief Creates a deque of size integers in a fixed random order
+ *
+ * @param size Number of integers
+ * @return New deque
+ */
+static obdeque * new_random_deque(uint64_t size){
+
+  uint64_t i, state = size;
+  obint *element;
+  obdeque *deque;
+
+  deque = obdeque_new();
+  for(i=0; i<size; i++){
+    element = obint_new((int64_t)(ob_bench_random(&state) >> 1));
+    obdeque_add_at_tail(deque, (obj *)element);
+    ob_release((obj *)element);
+  }
+
+  return deque;
+}
+
+/**
+ * @brief One operation adds an element at the tail of a deque of b->size
+ * elements and removes the element at its head
+ */
+static void bench_queue(ob_bench *b){
+
+  uint64_t i;
+  obint *element;
+  obdeque *deque;
+
+  deque = new_random_deque(b->size);
+  element = obint_new(1);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    obdeque_add_at_tail(deque, (obj *)element);
+    obdeque_remove_head(deque);
+  }
+  ob_bench_stop(b);
+
+  ob_release((obj *)element);
+  ob_release((obj *)deque);
+}
+
+/**
+ * @brief One operation sorts a copy of a shuffled deque of b->size elements
+ */
+static void bench_sort(ob_bench *b){
+
+  uint64_t i;
+  obdeque *deque, *copy;
+
+  deque = new_random_deque(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    copy = obdeque_copy(deque);
+    obdeque_sort(copy, OB_LEAST_TO_GREATEST);
+    ob_release((obj *)copy);
+  }
+  ob_bench_stop(b);
+
+  ob_release((obj *)deque);
+}
+
+/**
+ * @brief One operation visits an element of a deque of b->size elements with
+ * a cursor
+ */
+static void bench_cursor(ob_bench *b){
+
+  uint64_t i;
+  uintptr_t sum = 0;
+  obdeque *deque;
+  ob_cursor cursor;
+
+  deque = new_random_deque(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; ){
+    if(!obdeque_cursor_begin(deque, &cursor)) break;
+    do{
+      sum += (uintptr_t)obdeque_cursor_get(&cursor);
+      i++;
+    }while(i<b->iterations && obdeque_cursor_next(&cursor));
+  }
+  ob_bench_stop(b);
+
+  assert(sum != 0);
+
+  ob_release((obj *)deque);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("obdeque_queue", &bench_queue, sizes);
+  ob_bench_run("obdeque_sort", &bench_sort, sizes);
+  ob_bench_run("obdeque_cursor", &bench_cursor, sizes);
+
+  return ob_bench_finish();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file obint_bench.c
+ * @brief obint Benchmarks
+ * @author theck
+ */
+
+#include "harness.h"
+#include "../../include/obint.h"
+#include "../../include/obstring.h"
+
+/** Numbers of decimal digits of the integers benchmarked, terminated by 0 */
+static const uint64_t sizes[] = {8, 64, 1024, 0};
+
+/**
+ * @brief Creates an integer of a number of random decimal digits
+ *
+ * @param digits Number of digits
+ * @param state Random generator state
+ * @return New integer
+ */
+static obint * new_random_obint(uint64_t digits, uint64_t *state){
+
+  uint64_t i;
+  char *buffer;
+  obstring *numstr;
+  obint *a;
+
+  buffer = malloc(digits + 1);
+  assert(buffer != NULL);
+
+  for(i=0; i<digits; i++)
+    buffer[i] = '0' + (char)(ob_bench_random(state) % 10);
+  buffer[0] = '1' + (char)(ob_bench_random(state) % 9);
+  buffer[digits] = '\0';
+
+  numstr = obstring_new(buffer);
+  a = obint_from_string(numstr);
+  ob_release((obj *)numstr);
+  free(buffer);
+
+  return a;
+}
+
+/**
+ * @brief One operation adds two integers of b->size digits
+ */
+static void bench_add(ob_bench *b){
+
+  uint64_t i, state = b->size;
+  obint *x, *y;
+
+  x = new_random_obint(b->size, &state);
+  y = new_random_obint(b->size, &state);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++) ob_release((obj *)obint_add(x, y));
+  ob_bench_stop(b);
+
+  ob_release((obj *)x);
+  ob_release((obj *)y);
+}
+
+/**
+ * @brief One operation multiplies two integers of b->size digits
+ */
+static void bench_multiply(ob_bench *b){
+
+  uint64_t i, state = b->size;
+  obint *x, *y;
+
+  x = new_random_obint(b->size, &state);
+  y = new_random_obint(b->size, &state);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++) ob_release((obj *)obint_multiply(x, y));
+  ob_bench_stop(b);
+
+  ob_release((obj *)x);
+  ob_release((obj *)y);
+}
+
+/**
+ * @brief One operation converts an integer of b->size digits to a string
+ */
+static void bench_to_string(ob_bench *b){
+
+  uint64_t i, state = b->size;
+  obint *x;
+
+  x = new_random_obint(b->size, &state);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++) ob_release((obj *)obint_to_string(x));
+  ob_bench_stop(b);
+
+  ob_release((obj *)x);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("obint_add", &bench_add, sizes);
+  ob_bench_run("obint_multiply", &bench_multiply, sizes);
+  ob_bench_run("obint_to_string", &bench_to_string, sizes);
+
+  return ob_bench_finish();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file obmap_bench.c
+ * @brief obmap Benchmarks
+ * @author theck
+ */
+
+#include "harness.h"
+#include "../../include/obint.h"
+#include "../../include/obmap.h"
+
+/** Sizes of the maps benchmarked, terminated by 0 */
+static const uint64_t sizes[] = {16, 1024, 65536, 0};
+
+/**
+ * @brief Creates size distinct keys in a fixed random order
+ *
+ * @param size Number of keys
+ * @return Array of keys, each released and the array freed by free_keys
+ */
+static obint ** new_keys(uint64_t size){
+
+  uint64_t i, state = size;
+  obint **keys;
+
+  keys = malloc(sizeof(obint *)*size);
+  assert(keys != NULL);
+
+  /* a random multiple of size plus the index keeps keys distinct but
+   * unordered */
+  for(i=0; i<size; i++)
+    keys[i] = obint_new((int64_t)((ob_bench_random(&state) >> 24)*size + i));
+
+  return keys;
+}
+
+/**
+ * @brief Releases the keys created by new_keys
+ *
+ * @param keys Array of keys
+ * @param size Number of keys
+ */
+static void free_keys(obint **keys, uint64_t size){
+
+  uint64_t i;
+
+  for(i=0; i<size; i++) ob_release((obj *)keys[i]);
+  free(keys);
+}
+
+/**
+ * @brief Creates a map of every key to itself
+ *
+ * @param keys Array of keys
+ * @param size Number of keys
+ * @return New map
+ */
+static obmap * new_filled_map(obint **keys, uint64_t size){
+
+  uint64_t i;
+  obmap *m;
+
+  m = obmap_new();
+  for(i=0; i<size; i++) obmap_insert(m, (obj *)keys[i], (obj *)keys[i]);
+
+  return m;
+}
+
+/**
+ * @brief One operation inserts a key into an empty map, growing the map to
+ * b->size keys
+ */
+static void bench_insert(ob_bench *b){
+
+  uint64_t i, done;
+  obint **keys;
+  obmap *m;
+
+  keys = new_keys(b->size);
+  m = obmap_new();
+
+  ob_bench_start(b);
+  for(done=0; done<b->iterations; done+=b->size){
+    obmap_clear(m);
+    for(i=0; i<b->size && done+i<b->iterations; i++)
+      obmap_insert(m, (obj *)keys[i], (obj *)keys[i]);
+  }
+  ob_bench_stop(b);
+
+  ob_release((obj *)m);
+  free_keys(keys, b->size);
+}
+
+/**
+ * @brief One operation looks up a key of a map of b->size keys
+ */
+static void bench_lookup(ob_bench *b){
+
+  uint64_t i, found = 0;
+  obint **keys;
+  obmap *m;
+
+  keys = new_keys(b->size);
+  m = new_filled_map(keys, b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++)
+    found += obmap_lookup(m, (obj *)keys[i % b->size]) != NULL;
+  ob_bench_stop(b);
+
+  assert(found == b->iterations);
+
+  ob_release((obj *)m);
+  free_keys(keys, b->size);
+}
+
+/**
+ * @brief One operation copies a map of b->size keys and modifies the copy,
+ * paying for the copy on write
+ */
+static void bench_copy_modify(ob_bench *b){
+
+  uint64_t i;
+  obint **keys;
+  obmap *m, *copy;
+
+  keys = new_keys(b->size);
+  m = new_filled_map(keys, b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    copy = obmap_copy(m);
+    obmap_remove(copy, (obj *)keys[i % b->size]);
+    ob_release((obj *)copy);
+  }
+  ob_bench_stop(b);
+
+  ob_release((obj *)m);
+  free_keys(keys, b->size);
+}
+
+/**
+ * @brief One operation visits a pair of a map of b->size keys with a cursor
+ */
+static void bench_cursor(ob_bench *b){
+
+  uint64_t i;
+  uintptr_t sum = 0;
+  obint **keys;
+  obmap *m;
+  ob_cursor cursor;
+
+  keys = new_keys(b->size);
+  m = new_filled_map(keys, b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; ){
+    if(!obmap_cursor_begin(m, &cursor)) break;
+    do{
+      sum += (uintptr_t)obmap_cursor_value(&cursor);
+      i++;
+    }while(i<b->iterations && obmap_cursor_next(&cursor));
+  }
+  ob_bench_stop(b);
+
+  assert(sum != 0);
+
+  ob_release((obj *)m);
+  free_keys(keys, b->size);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("obmap_insert", &bench_insert, sizes);
+  ob_bench_run("obmap_lookup", &bench_lookup, sizes);
+  ob_bench_run("obmap_copy_modify", &bench_copy_modify, sizes);
+  ob_bench_run("obmap_cursor", &bench_cursor, sizes);
+
+  return ob_bench_finish();
+}
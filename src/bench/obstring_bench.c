@@ -0,0 +1,116 @@
+/**
+ * @file obstring_bench.c
+ * @brief obstring Benchmarks
+ * @author theck
+ */
+
+#include "harness.h"
+#include "../../include/obstring.h"
+#include "../../include/obvector.h"
+
+/** Lengths of the strings benchmarked, terminated by 0 */
+static const uint64_t sizes[] = {16, 1024, 65536, 0};
+
+/**
+ * @brief Creates a string of random words separated by single spaces
+ *
+ * @param length Length of the string
+ * @return New string
+ */
+static obstring * new_random_text(uint64_t length){
+
+  uint64_t i, state = length;
+  char *buffer;
+  obstring *s;
+
+  buffer = malloc(length + 1);
+  assert(buffer != NULL);
+
+  /* about one character in six is a space, never two in a row */
+  for(i=0; i<length; i++){
+    if(i > 0 && buffer[i-1] != ' ' && ob_bench_random(&state) % 6 == 0)
+      buffer[i] = ' ';
+    else buffer[i] = 'a' + (char)(ob_bench_random(&state) % 26);
+  }
+  buffer[length] = '\0';
+
+  s = obstring_new(buffer);
+  free(buffer);
+
+  return s;
+}
+
+/**
+ * @brief One operation creates a string of b->size characters and hashes it
+ */
+static void bench_new_hash(ob_bench *b){
+
+  uint64_t i;
+  ob_hash_t hash = 0;
+  obstring *text, *s;
+
+  text = new_random_text(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    s = obstring_new(obstring_cstring(text));
+    hash += ob_hash((obj *)s);
+    ob_release((obj *)s);
+  }
+  ob_bench_stop(b);
+
+  /* printing the sum keeps the hashes computed */
+  if(hash == 1) printf("%llu\n", (unsigned long long)hash);
+
+  ob_release((obj *)text);
+}
+
+/**
+ * @brief One operation concatenates two strings of b->size characters
+ */
+static void bench_concat(ob_bench *b){
+
+  uint64_t i;
+  obstring *text;
+
+  text = new_random_text(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++)
+    ob_release((obj *)obstring_concat(text, text));
+  ob_bench_stop(b);
+
+  ob_release((obj *)text);
+}
+
+/**
+ * @brief One operation splits a string of b->size characters at spaces
+ */
+static void bench_split(ob_bench *b){
+
+  uint64_t i;
+  obstring *text;
+
+  text = new_random_text(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++)
+    ob_release((obj *)obstring_split(text, " "));
+  ob_bench_stop(b);
+
+  ob_release((obj *)text);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("obstring_new_hash", &bench_new_hash, sizes);
+  ob_bench_run("obstring_concat", &bench_concat, sizes);
+  ob_bench_run("obstring_split", &bench_split, sizes);
+
+  return ob_bench_finish();
+}
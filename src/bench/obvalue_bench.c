@@ -0,0 +1,141 @@
+/**
+ * @file obvalue_bench.c
+ * @brief Unboxed Container Template Benchmarks
+ *
+ * @details
+ * Mirrors the append and sort benchmarks of obvector_bench.c with unboxed
+ * integers, and the lookup benchmark of obmap_bench.c with unboxed keys, so
+ * the cost of boxing each value in an instance can be read from the results.
+ *
+ * @author theck
+ */
+
+#include "harness.h"
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME u64vector
+#define OB_VALUE_TYPE uint64_t
+#include "../../include/obvalue_vector.h"
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME u64map
+#define OB_VALUE_KEY_TYPE uint64_t
+#define OB_VALUE_TYPE uint64_t
+#include "../../include/obvalue_map.h"
+
+/** Sizes of the containers benchmarked, terminated by 0 */
+static const uint64_t sizes[] = {16, 1024, 65536, 0};
+
+/**
+ * @brief Creates a vector of size integers in a fixed random order
+ *
+ * @param size Number of integers
+ * @return New vector
+ */
+static u64vector * new_random_vector(uint64_t size){
+
+  uint64_t i, state = size;
+  u64vector *v;
+
+  v = u64vector_new(size);
+  for(i=0; i<size; i++) u64vector_append(v, ob_bench_random(&state) >> 1);
+
+  return v;
+}
+
+/**
+ * @brief One operation appends a value to a vector, growing a vector from
+ * a capacity of 1 to b->size values
+ */
+static void bench_append(ob_bench *b){
+
+  uint64_t i, done;
+  u64vector *v;
+
+  ob_bench_start(b);
+  for(done=0; done<b->iterations; done+=b->size){
+    v = u64vector_new(1);
+    for(i=0; i<b->size && done+i<b->iterations; i++) u64vector_append(v, i);
+    ob_release((obj *)v);
+  }
+  ob_bench_stop(b);
+}
+
+/**
+ * @brief One operation sorts a copy of a shuffled vector of b->size values
+ */
+static void bench_sort(ob_bench *b){
+
+  uint64_t i;
+  u64vector *v, *copy;
+
+  v = new_random_vector(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    copy = u64vector_copy(v);
+    u64vector_sort(copy, OB_LEAST_TO_GREATEST);
+    ob_release((obj *)copy);
+  }
+  ob_bench_stop(b);
+
+  ob_release((obj *)v);
+}
+
+/**
+ * @brief One operation searches a vector of b->size values for a value it does
+ * not hold
+ */
+static void bench_find(ob_bench *b){
+
+  uint64_t i, found = 0;
+  u64vector *v;
+
+  v = new_random_vector(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++) found += u64vector_find(v, UINT64_MAX - i);
+  ob_bench_stop(b);
+
+  assert(found == 0);
+
+  ob_release((obj *)v);
+}
+
+/**
+ * @brief One operation looks up a key of a map of b->size keys
+ */
+static void bench_lookup(ob_bench *b){
+
+  uint64_t i, value, sum = 0, state = b->size;
+  u64map *m;
+
+  m = u64map_new(b->size);
+  for(i=0; i<b->size; i++) u64map_insert(m, ob_bench_random(&state), i);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    if(i % b->size == 0) state = b->size;
+    if(u64map_lookup(m, ob_bench_random(&state), &value)) sum += value + 1;
+  }
+  ob_bench_stop(b);
+
+  assert(sum != 0);
+
+  ob_release((obj *)m);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("obvalue_vector_append", &bench_append, sizes);
+  ob_bench_run("obvalue_vector_sort", &bench_sort, sizes);
+  ob_bench_run("obvalue_vector_find", &bench_find, sizes);
+  ob_bench_run("obvalue_map_lookup", &bench_lookup, sizes);
+
+  return ob_bench_finish();
+}
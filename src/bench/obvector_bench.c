@@ -0,0 +1,121 @@
+/**
+ * @file obvector_bench.c
+ * @brief obvector Benchmarks
+ * @author theck
+ */
+
+#include "harness.h"
+#include "../../include/obint.h"
+#include "../../include/obvector.h"
+
+/** Sizes of the vectors benchmarked, terminated by 0 */
+static const uint64_t sizes[] = {16, 1024, 65536, 0};
+
+/**
+ * @brief Creates a vector of size integers in a fixed random order
+ *
+ * @param size Number of integers
+ * @return New vector
+ */
+static obvector * new_random_vector(uint64_t size){
+
+  uint64_t i, state = size;
+  obint *element;
+  obvector *v;
+
+  v = obvector_new((uint32_t)size);
+  for(i=0; i<size; i++){
+    element = obint_new((int64_t)(ob_bench_random(&state) >> 1));
+    obvector_store_at_index(v, (obj *)element, (int64_t)i);
+    ob_release((obj *)element);
+  }
+
+  return v;
+}
+
+/**
+ * @brief One operation appends an element to a vector, growing a vector from
+ * a capacity of 1 to b->size elements
+ */
+static void bench_append(ob_bench *b){
+
+  uint64_t i, done;
+  obint *element;
+  obvector *v;
+
+  element = obint_new(1);
+
+  ob_bench_start(b);
+  for(done=0; done<b->iterations; done+=b->size){
+    v = obvector_new(1);
+    for(i=0; i<b->size && done+i<b->iterations; i++)
+      obvector_store_at_index(v, (obj *)element, (int64_t)i);
+    ob_release((obj *)v);
+  }
+  ob_bench_stop(b);
+
+  ob_release((obj *)element);
+}
+
+/**
+ * @brief One operation sorts a copy of a shuffled vector of b->size elements
+ */
+static void bench_sort(ob_bench *b){
+
+  uint64_t i;
+  obvector *v, *copy;
+
+  v = new_random_vector(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    copy = obvector_copy(v);
+    obvector_sort(copy, OB_LEAST_TO_GREATEST);
+    ob_release((obj *)copy);
+  }
+  ob_bench_stop(b);
+
+  ob_release((obj *)v);
+}
+
+/**
+ * @brief One operation visits an element of a vector of b->size elements with
+ * a cursor
+ */
+static void bench_cursor(ob_bench *b){
+
+  uint64_t i;
+  uintptr_t sum = 0;
+  obvector *v;
+  ob_cursor cursor;
+
+  v = new_random_vector(b->size);
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; ){
+    if(!obvector_cursor_begin(v, &cursor)) break;
+    do{
+      sum += (uintptr_t)obvector_cursor_get(&cursor);
+      i++;
+    }while(i<b->iterations && obvector_cursor_next(&cursor));
+  }
+  ob_bench_stop(b);
+
+  assert(sum != 0);
+
+  ob_release((obj *)v);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("obvector_append", &bench_append, sizes);
+  ob_bench_run("obvector_sort", &bench_sort, sizes);
+  ob_bench_run("obvector_cursor", &bench_cursor, sizes);
+
+  return ob_bench_finish();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file primes_bench.c
+ * @brief pfinder Workload Benchmark
+ *
+ * @details
+ * Finds the first primes by trial division the way the pfinder application
+ * does, with the temporaries of each candidate released by an autorelease
+ * pool.
+ *
+ * @author theck
+ */
+
+#include "harness.h"
+#include "../../include/obint.h"
+#include "../../include/obvector.h"
+
+/** Numbers of primes found, terminated by 0 */
+static const uint64_t sizes[] = {100, 1000, 0};
+
+/**
+ * @brief Finds the first primes
+ *
+ * @param count Number of primes to find
+ * @return Vector of the first count primes
+ */
+static obvector * find_primes(uint64_t count){
+
+  uint32_t i;
+  uint8_t maybe_prime;
+  obint *candidate, *next, *remainder;
+  obvector *primes;
+
+  primes = obvector_new(1);
+  candidate = obint_new(2);
+  obvector_store_at_index(primes, (obj *)candidate, 0);
+  ob_release((obj *)candidate);
+
+  candidate = obint_new(3);
+  while(obvector_length(primes) < count){
+
+    ob_push_autorelease_pool();
+
+    maybe_prime = 1;
+    for(i=0; i<obvector_length(primes); i++){
+      remainder = (obint *)ob_autorelease((obj *)obint_mod(candidate,
+                                (obint *)obvector_obj_at_index(primes, i)));
+      if(obint_is_zero(remainder)){
+        maybe_prime = 0;
+        break;
+      }
+    }
+
+    if(maybe_prime)
+      obvector_store_at_index(primes, (obj *)candidate,
+                              obvector_length(primes));
+
+    next = obint_add_primitive(candidate, 2);
+    ob_autorelease((obj *)candidate);
+    candidate = next;
+
+    ob_drain_autorelease_pool();
+  }
+
+  ob_release((obj *)candidate);
+
+  return primes;
+}
+
+/**
+ * @brief One operation finds the first b->size primes
+ */
+static void bench_primes(ob_bench *b){
+
+  uint64_t i;
+  obvector *primes;
+
+  ob_bench_start(b);
+  for(i=0; i<b->iterations; i++){
+    primes = find_primes(b->size);
+    assert(obvector_length(primes) == b->size);
+    ob_release((obj *)primes);
+  }
+  ob_bench_stop(b);
+}
+
+/**
+ * @brief Main benchmark routine
+ */
+int main(int argc, char **argv){
+
+  ob_bench_init(argc, argv);
+
+  ob_bench_run("pfinder_primes", &bench_primes, sizes);
+
+  return ob_bench_finish();
+}
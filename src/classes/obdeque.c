@@ -6,6 +6,46 @@
 
 #include "../../include/obdeque.h"
 #include "../../include/private/obdeque_private.h"
+#include "../../include/private/offbrand_serial_private.h"
+#include "../../include/private/offbrand_optrace_private.h"
+
+/* CLASS DESCRIPTORS */
+
+/** class descriptor shared by all obdeque_node instances */
+static const ob_class obdeque_node_class = {
+  .classname = "obdeque_node",
+  .size = sizeof(obdeque_node),
+  .dealloc = &obdeque_destroy_node,
+  .hash = NULL,
+  .compare = NULL,
+  .display = NULL,
+  .traverse = &obdeque_traverse_node
+};
+
+/** class descriptor shared by all obdeque_iterator instances */
+static const ob_class obdeque_iterator_class = {
+  .classname = "obdeque_iterator",
+  .size = sizeof(obdeque_iterator),
+  .dealloc = &obdeque_destroy_iterator,
+  .hash = NULL,
+  .compare = NULL,
+  .display = NULL,
+  .traverse = &obdeque_traverse_iterator
+};
+
+/** class descriptor shared by all obdeque instances */
+static const ob_class obdeque_class = {
+  .classname = "obdeque",
+  .size = sizeof(obdeque),
+  .dealloc = &obdeque_destroy,
+  .hash = &obdeque_hash,
+  .compare = &obdeque_compare,
+  .display = &obdeque_display,
+  .traverse = &obdeque_traverse,
+  .serialize = &obdeque_serialize,
+  .deserialize = &obdeque_deserialize,
+  .footprint = &obdeque_footprint
+};
 
 /* PUBLIC METHODS */
 
@@ -17,26 +57,35 @@ obdeque * obdeque_new(void){
 
 obdeque * obdeque_copy(const obdeque *to_copy){
 
-  obj *element;
-  obdeque_iterator *iter;
+  ob_cursor cursor;
   obdeque *copy;
 
   assert(to_copy);
 
-  copy = obdeque_create_default();
+  /* nodes of an arena deque are deallocated with the arena, so they are only
+   * shared by copies of deques outside of arenas */
+  if(!(to_copy->base.flags & OB_FLAG_ARENA)){
+    copy = (obdeque *)ob_alloc(&obdeque_class);
+    atomic_fetch_add_explicit(&to_copy->storage->references, 1,
+                              memory_order_relaxed);
+    copy->storage = to_copy->storage;
+    copy->head = to_copy->head;
+    copy->tail = to_copy->tail;
+    copy->length = to_copy->length;
+    copy->generation = 0;
+    return copy;
+  }
 
-  iter = obdeque_head_iterator(to_copy);
+  copy = obdeque_create_default();
 
-  if(!iter) return copy; /* if the list is empty, return empty copy */
+  /* if the list is empty, return empty copy */
+  if(!obdeque_cursor_begin(to_copy, &cursor)) return copy;
 
   /* while there are elements in the deque to copy add to the tail of the
    * deque */
   do{
-    element = obdeque_obj_at_iterator(to_copy, iter);
-    obdeque_add_at_tail(copy, element);
-  } while(obdeque_iterate_next(to_copy, iter));
-
-  ob_release((obj *)iter);
+    obdeque_add_at_tail(copy, obdeque_cursor_get(&cursor));
+  } while(obdeque_cursor_next(&cursor));
 
   return copy;
 }
@@ -67,6 +116,8 @@ obdeque_iterator * obdeque_tail_iterator(const obdeque *deque){
 
 
 obdeque_iterator * obdeque_copy_iterator(const obdeque_iterator *it){
+  assert(it);
+  assert(it->generation == it->deque->generation);
   return obdeque_new_iterator(it->deque, it->node);
 }
 
@@ -76,6 +127,7 @@ uint8_t obdeque_iterate_next(const obdeque *deque, obdeque_iterator *it){
   assert(deque);
   assert(it);
   assert(it->deque == deque);
+  assert(it->generation == deque->generation); /* nodes were not cloned */
 
   if(!it->node) return 0;
 
@@ -97,6 +149,7 @@ uint8_t obdeque_iterate_prev(const obdeque *deque, obdeque_iterator *it){
   assert(deque);
   assert(it);
   assert(it->deque == deque);
+  assert(it->generation == deque->generation); /* nodes were not cloned */
 
   if(!it->node) return 0;
 
@@ -113,6 +166,42 @@ uint8_t obdeque_iterate_prev(const obdeque *deque, obdeque_iterator *it){
 }
 
 
+uint8_t obdeque_cursor_begin(const obdeque *deque, ob_cursor *cursor){
+
+  assert(deque);
+  assert(cursor);
+
+  cursor->container = (const obj *)deque;
+  cursor->position = deque->head;
+  cursor->index = 0;
+
+  return deque->head != NULL;
+}
+
+
+uint8_t obdeque_cursor_next(ob_cursor *cursor){
+
+  const obdeque_node *node;
+
+  assert(cursor);
+  OB_ASSERT_CLASS(cursor->container, &obdeque_class);
+
+  node = cursor->position;
+  if(!node || !node->next) return 0;
+
+  cursor->position = node->next;
+  cursor->index++;
+  return 1;
+}
+
+
+obj * obdeque_cursor_get(const ob_cursor *cursor){
+  assert(cursor);
+  assert(cursor->position);
+  return ((const obdeque_node *)cursor->position)->stored;
+}
+
+
 void obdeque_add_at_head(obdeque *deque, obj *to_add){
 
   obdeque_node *new_node;
@@ -120,6 +209,8 @@ void obdeque_add_at_head(obdeque *deque, obj *to_add){
   assert(deque);
   assert(to_add);
 
+  obdeque_own_storage(deque, NULL);
+
   /* creating deque node with to_add ob_retains to account for the deque's
    * reference */
   new_node = obdeque_new_node(to_add);
@@ -146,6 +237,8 @@ void obdeque_add_at_tail(obdeque *deque, obj *to_add){
   assert(deque);
   assert(to_add);
 
+  obdeque_own_storage(deque, NULL);
+
   /* creating deque node with to_add ob_retains to account for the deque's
    * reference */
   new_node = obdeque_new_node(to_add);
@@ -172,8 +265,11 @@ void obdeque_add_at_iterator(obdeque *deque, obdeque_iterator *it, obj *to_add){
   assert(deque);
   assert(it);
   assert(it->deque == deque);
+  assert(it->generation == deque->generation); /* nodes were not cloned */
   assert(to_add);
 
+  obdeque_own_storage(deque, it);
+
   if(!it->node){
     obdeque_add_at_head(deque, to_add);
     it->node = deque->head;
@@ -205,51 +301,50 @@ void obdeque_add_at_iterator(obdeque *deque, obdeque_iterator *it, obj *to_add){
 obdeque * obdeque_join(const obdeque *d1, const obdeque *d2){
 
   obdeque *joined;
-  obdeque_iterator *it;
-  obj *element;
+  ob_cursor cursor;
 
   assert(d1);
   assert(d2);
 
   joined = obdeque_copy(d1);
 
-  it = obdeque_head_iterator(d2);
-
-  if(!it) return joined; /* if the list is empty, return joined list */
+  /* if the list is empty, return joined list */
+  if(!obdeque_cursor_begin(d2, &cursor)) return joined;
 
   /* while there are elements in the deque to copy add to the tail of the
    * deque */
   do{
-    element = obdeque_obj_at_iterator(d2, it);
-    obdeque_add_at_tail(joined, element);
-  } while(obdeque_iterate_next(d2, it));
-
-  ob_release((obj *)it);
+    obdeque_add_at_tail(joined, obdeque_cursor_get(&cursor));
+  } while(obdeque_cursor_next(&cursor));
 
   return joined;
 }
 
 uint8_t obdeque_find_obj(const obdeque *deque, const obj *to_find){
+  return obdeque_find_obj_with_funct(deque, to_find, &ob_compare);
+}
+
 
-  obdeque_iterator *it;
-  uint8_t retval = 0;
+uint8_t obdeque_find_obj_with_funct(const obdeque *deque, const obj *to_find,
+                                    ob_compare_fptr funct){
+
+  ob_cursor cursor;
+  obj *current;
 
   assert(deque);
   assert(to_find);
+  assert(funct);
 
-  it = obdeque_head_iterator(deque);
-  if(!it) return 0; /* obj is not in an empty list */
+  /* obj is not in an empty list */
+  if(!obdeque_cursor_begin(deque, &cursor)) return 0;
 
   do{
-    if(ob_compare(obdeque_obj_at_iterator(deque, it), to_find) == OB_EQUAL_TO){
-      retval = 1;
-      break;
-    }
-  } while(obdeque_iterate_next(deque, it));
+    /* typed compare functions require instances, so NULL nodes are skipped */
+    current = obdeque_cursor_get(&cursor);
+    if(current && funct(to_find, current) == OB_EQUAL_TO) return 1;
+  } while(obdeque_cursor_next(&cursor));
 
-  ob_release((obj *)it);
-
-  return retval;
+  return 0;
 }
 
 
@@ -267,12 +362,19 @@ void obdeque_sort_with_funct(obdeque *deque, int8_t order, ob_compare_fptr funct
   assert(order == OB_LEAST_TO_GREATEST || order == OB_GREATEST_TO_LEAST);
   assert(funct);
 
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obdeque_sort_with_funct", deque,
+              deque->length);
+
+  obdeque_own_storage(deque, NULL);
   sorted = obdeque_recursive_sort(*deque, order, funct);
 
   /* connect head and tail of newly sorted list to deque */
   deque->head = sorted.head;
   deque->tail = sorted.tail;
 
+  OB_OP_TRACE(OB_OP_TRACE_END, "obdeque_sort_with_funct", deque,
+              deque->length);
+
   return;
 }
 
@@ -297,6 +399,7 @@ obj * obdeque_obj_at_iterator(const obdeque *deque, const obdeque_iterator *it){
   assert(it);
   assert(it->deque == deque); /* assert that iterator belongs to provided
                                  deque */
+  assert(it->generation == deque->generation); /* nodes were not cloned */
   if(!it->node) return NULL; /* if the iterator is empty return NULL */
   return it->node->stored;
 }
@@ -309,7 +412,10 @@ void obdeque_remove_head(obdeque *deque){
   assert(deque);
 
   /* return if the list is empty */
-  if(!(temp_node = deque->head)) return;
+  if(!deque->head) return;
+
+  obdeque_own_storage(deque, NULL);
+  temp_node = deque->head;
 
   /* repair deque after removal */
   deque->head = deque->head->next;
@@ -336,7 +442,10 @@ void obdeque_remove_tail(obdeque *deque){
   assert(deque);
 
   /* return NULL if the list is empty */
-  if(!(temp_node = deque->tail)) return;
+  if(!deque->tail) return;
+
+  obdeque_own_storage(deque, NULL);
+  temp_node = deque->tail;
 
   /* repair deque after removal */
   deque->tail = deque->tail->prev;
@@ -364,9 +473,12 @@ void obdeque_remove_at_iterator(obdeque *deque, obdeque_iterator *it){
   assert(it);
   assert(deque == it->deque); /* ensure that iterator is associated with given
                                  deque */
+  assert(it->generation == deque->generation); /* nodes were not cloned */
   if(!it->node) return; /* if iterator points to no node (an empty deque)
                            do nothing */
 
+  obdeque_own_storage(deque, it);
+
   if(it->node == deque->head) deque->head = it->node->next;
   if(it->node == deque->tail) deque->tail = it->node->prev;
   if(it->node->prev) it->node->prev->next = it->node->next;
@@ -393,24 +505,16 @@ void obdeque_remove_at_iterator(obdeque *deque, obdeque_iterator *it){
 
 void obdeque_clear(obdeque *deque){
 
-  obdeque_node *tmp, *next;
-
   assert(deque);
 
-  tmp = deque->head;
-
-  while(tmp){
-
-    next = tmp->next;
-
-    /* remove references to other nodes, individual nodes may live on due to
-     * references from iterators */
-    tmp->next = NULL;
-    tmp->prev = NULL;
-
-    ob_release((obj *)tmp);
-    tmp = next;
+  /* nodes shared with copies are left to them */
+  if(atomic_load_explicit(&deque->storage->references,
+                          memory_order_acquire) > 1){
+    obdeque_release_storage(deque->storage, deque->head);
+    deque->storage = obdeque_new_storage();
+    deque->generation++;
   }
+  else obdeque_release_nodes(deque->head);
 
   deque->head = NULL;
   deque->tail = NULL;
@@ -427,17 +531,11 @@ void obdeque_clear(obdeque *deque){
 
 obdeque_node * obdeque_new_node(obj *to_store){
 
-  static const char classname[] = "obdeque_node";
   obdeque_node *new_instance;
 
   assert(to_store != NULL);
 
-  new_instance = malloc(sizeof(obdeque_node));
-  assert(new_instance != NULL);
-
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &obdeque_destroy_node, NULL, NULL, NULL,
-               classname);
+  new_instance = (obdeque_node *)ob_alloc(&obdeque_node_class);
 
   ob_retain(to_store);
   new_instance->stored = to_store;
@@ -454,7 +552,7 @@ void obdeque_destroy_node(obj *to_dealloc){
   obdeque_node *instance = (obdeque_node *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "obdeque_node"));
+  OB_ASSERT_CLASS(to_dealloc, &obdeque_node_class);
 
   ob_release(instance->stored);
 
@@ -462,26 +560,36 @@ void obdeque_destroy_node(obj *to_dealloc){
 }
 
 
+void obdeque_traverse_node(const obj *to_traverse, ob_visit_fptr visit,
+                           void *context){
+
+  const obdeque_node *instance = (obdeque_node *)to_traverse;
+
+  assert(to_traverse);
+  assert(visit);
+  OB_ASSERT_CLASS(to_traverse, &obdeque_node_class);
+
+  visit(instance->stored, context);
+
+  return;
+}
+
+
 /* obdeque_iterator Private Methods */
 
 obdeque_iterator * obdeque_new_iterator(const obdeque *deque, obdeque_node *node){
 
-  static const char classname[] = "obdeque_iterator";
   obdeque_iterator *new_instance;
 
   if(!node) return NULL; /* return nothing when iterating from an empty
                             deque */
 
-  new_instance = malloc(sizeof(obdeque_iterator));
-  assert(new_instance != NULL);
-
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &obdeque_destroy_iterator, NULL, NULL, NULL,
-               classname);
+  new_instance = (obdeque_iterator *)ob_alloc(&obdeque_iterator_class);
 
   ob_retain((obj *)node);
   new_instance->node = node;
   new_instance->deque = deque;
+  new_instance->generation = deque->generation;
 
   return new_instance;
 }
@@ -493,7 +601,7 @@ void obdeque_destroy_iterator(obj *to_dealloc){
   obdeque_iterator *instance = (obdeque_iterator *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "obdeque_iterator"));
+  OB_ASSERT_CLASS(to_dealloc, &obdeque_iterator_class);
 
   ob_release((obj *)instance->node);
 
@@ -501,28 +609,132 @@ void obdeque_destroy_iterator(obj *to_dealloc){
 }
 
 
+void obdeque_traverse_iterator(const obj *to_traverse, ob_visit_fptr visit,
+                               void *context){
+
+  const obdeque_iterator *instance = (obdeque_iterator *)to_traverse;
+
+  assert(to_traverse);
+  assert(visit);
+  OB_ASSERT_CLASS(to_traverse, &obdeque_iterator_class);
+
+  if(instance->node) visit((obj *)instance->node, context);
+
+  return;
+}
+
+
 /* obdeque Private Methods */
 
 /* add arguments to complete initialization as needed, modify
  * obdeque_Private.h as well if modifications are made */
 obdeque * obdeque_create_default(void){
 
-  static const char classname[] = "obdeque";
-  obdeque *new_instance = malloc(sizeof(obdeque));
-  assert(new_instance != NULL);
-
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &obdeque_destroy, &obdeque_hash,
-               &obdeque_compare, &obdeque_display, classname);
+  obdeque *new_instance = (obdeque *)ob_alloc(&obdeque_class);
 
+  new_instance->storage = obdeque_new_storage();
   new_instance->head = NULL;
   new_instance->tail = NULL;
   new_instance->length = 0;
+  new_instance->generation = 0;
 
   return new_instance;
 }
 
 
+obdeque_storage * obdeque_new_storage(void){
+
+  obdeque_storage *storage;
+
+  storage = malloc(sizeof(obdeque_storage));
+  assert(storage != NULL);
+
+  atomic_init(&storage->references, 1);
+
+  return storage;
+}
+
+
+void obdeque_release_storage(obdeque_storage *storage, obdeque_node *head){
+
+  /* the acquire-release decrement orders every use of the nodes by other
+   * deques before they are released */
+  if(atomic_fetch_sub_explicit(&storage->references, 1,
+                               memory_order_acq_rel) > 1)
+    return;
+
+  obdeque_release_nodes(head);
+  free(storage);
+
+  return;
+}
+
+
+void obdeque_release_nodes(obdeque_node *head){
+
+  obdeque_node *next;
+
+  while(head){
+
+    next = head->next;
+
+    /* remove references to other nodes, individual nodes may live on due to
+     * references from iterators */
+    head->next = NULL;
+    head->prev = NULL;
+
+    ob_release((obj *)head);
+    head = next;
+  }
+
+  return;
+}
+
+
+void obdeque_own_storage(obdeque *deque, obdeque_iterator *it){
+
+  obdeque_node *node, *new_node, *head, *tail;
+
+  if(atomic_load_explicit(&deque->storage->references,
+                          memory_order_acquire) == 1)
+    return;
+
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obdeque_own_storage", deque, deque->length);
+
+  head = tail = NULL;
+
+  for(node = deque->head; node; node = node->next){
+
+    new_node = obdeque_new_node(node->stored);
+    new_node->prev = tail;
+    if(tail) tail->next = new_node;
+    else head = new_node;
+    tail = new_node;
+
+    /* move the iterator used for the modification to the clone of its node */
+    if(it && it->node == node){
+      ob_retain((obj *)new_node);
+      ob_release((obj *)node);
+      it->node = new_node;
+    }
+  }
+
+  obdeque_release_storage(deque->storage, deque->head);
+
+  deque->storage = obdeque_new_storage();
+  deque->head = head;
+  deque->tail = tail;
+
+  /* iterators other than it still reference the nodes of the copies */
+  deque->generation++;
+  if(it) it->generation = deque->generation;
+
+  OB_OP_TRACE(OB_OP_TRACE_END, "obdeque_own_storage", deque, deque->length);
+
+  return;
+}
+
+
 /* private recursive sort method uses stack variables to take advantage of
  * static memory management */
 obdeque obdeque_recursive_sort(obdeque deque, int8_t order, ob_compare_fptr funct){
@@ -610,37 +822,20 @@ obdeque obdeque_recursive_sort(obdeque deque, int8_t order, ob_compare_fptr func
 
 ob_hash_t obdeque_hash(const obj *to_hash){
 
-  static int8_t init = 0;
   ob_hash_t value;
-  static ob_hash_t seed = 0;
   obdeque *instance = (obdeque *)to_hash;
-  obdeque_iterator *it;
+  ob_cursor cursor;
 
   assert(to_hash);
-  assert(ob_has_class(to_hash, "obdeque"));
+  OB_ASSERT_CLASS(to_hash, &obdeque_class);
 
-  if(init == 0){
-    srand(time(NULL));
-    seed = rand();
-    init = 1;
-  }
-
-  value = seed;
+  value = ob_hash_seed();
 
-  it = obdeque_head_iterator(instance);
-  if(!it) return value;
+  if(!obdeque_cursor_begin(instance, &cursor)) return value;
 
   do{
-    value += ob_hash(obdeque_obj_at_iterator(instance, it));
-    value += value << 10;
-    value ^= value >> 6;
-  }while(obdeque_iterate_next(instance, it));
-
-  ob_release((obj *)it);
-
-  value += value << 3;
-  value ^= value >> 11;
-  value += value << 15;
+    value = ob_hash_combine(value, ob_hash(obdeque_cursor_get(&cursor)));
+  }while(obdeque_cursor_next(&cursor));
 
   return value;
 }
@@ -648,62 +843,46 @@ ob_hash_t obdeque_hash(const obj *to_hash){
 
 int8_t obdeque_compare(const obj *a, const obj *b){
 
-  int8_t retval = OB_EQUAL_TO; /* assume equality and disprove if not */
   const obdeque *comp_a = (obdeque *)a;
   const obdeque *comp_b = (obdeque *)b;
-  obdeque_iterator *a_it, *b_it;
+  ob_cursor a_cursor, b_cursor;
 
   assert(a);
   assert(b);
-  assert(ob_has_class(a, "obdeque"));
-  assert(ob_has_class(b, "obdeque"));
+  OB_ASSERT_CLASS(a, &obdeque_class);
+  OB_ASSERT_CLASS(b, &obdeque_class);
 
   if(comp_a->length != comp_b->length) return OB_NOT_EQUAL;
 
-  a_it = obdeque_head_iterator(comp_a);
-  b_it = obdeque_head_iterator(comp_b);
-
-  if(!a_it && !b_it) return OB_EQUAL_TO;
+  /* deques of equal length are either both empty or both non-empty */
+  obdeque_cursor_begin(comp_b, &b_cursor);
+  if(!obdeque_cursor_begin(comp_a, &a_cursor)) return OB_EQUAL_TO;
 
-  if(a_it && b_it){
-    do{
-      if(ob_compare(obdeque_obj_at_iterator(comp_a, a_it),
-                    obdeque_obj_at_iterator(comp_b, b_it)) !=
-       OB_EQUAL_TO){
-      retval = OB_NOT_EQUAL;
-      break;
-    }
-    }while(obdeque_iterate_next(comp_a, a_it) &&
-           obdeque_iterate_next(comp_b, b_it));
-  }
-  else retval = OB_NOT_EQUAL;
-
-  ob_release((obj *)a_it);
-  ob_release((obj *)b_it);
+  do{
+    if(ob_compare(obdeque_cursor_get(&a_cursor),
+                  obdeque_cursor_get(&b_cursor)) != OB_EQUAL_TO)
+      return OB_NOT_EQUAL;
+  }while(obdeque_cursor_next(&a_cursor) && obdeque_cursor_next(&b_cursor));
 
-  return retval;
+  return OB_EQUAL_TO;
 }
 
 void obdeque_display(const obj *to_print){
 
   obdeque *d = (obdeque *)to_print;
-  obdeque_iterator *it;
+  ob_cursor cursor;
 
   assert(to_print != NULL);
-  assert(ob_has_class(to_print, "obdeque"));
+  OB_ASSERT_CLASS(to_print, &obdeque_class);
   fprintf(stderr, "obdeque with %llu elements\n"
                   "  [deque head]", obdeque_length(d));
 
-  it = obdeque_head_iterator(d);
-
-  if(!it) return;
+  if(!obdeque_cursor_begin(d, &cursor)) return;
 
   do{
-    ob_display(obdeque_obj_at_iterator(d, it));
+    ob_display(obdeque_cursor_get(&cursor));
     fprintf(stderr, "\n");
-  }while(obdeque_iterate_next(d, it));
-
-  ob_release((obj *)it);
+  }while(obdeque_cursor_next(&cursor));
 
   fprintf(stderr, "  [deque tail]\n");
 
@@ -717,10 +896,94 @@ void obdeque_destroy(obj *to_dealloc){
   obdeque *instance = (obdeque *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "obdeque"));
+  OB_ASSERT_CLASS(to_dealloc, &obdeque_class);
+
+  /* nodes are released unless shared with a copy */
+  obdeque_release_storage(instance->storage, instance->head);
+
+  return;
+}
+
+
+void obdeque_traverse(const obj *to_traverse, ob_visit_fptr visit,
+                      void *context){
+
+  const obdeque *instance = (obdeque *)to_traverse;
+  obdeque_node *node;
+
+  assert(to_traverse);
+  assert(visit);
+  OB_ASSERT_CLASS(to_traverse, &obdeque_class);
+
+  /* the deque holds the only list reference to each node, next and prev links
+   * are not counted references */
+  for(node = instance->head; node; node = node->next)
+    visit((obj *)node, context);
+
+  return;
+}
+
+
+void obdeque_serialize(const obj *to_write, ob_writer *writer){
+
+  ob_cursor cursor;
+  const obdeque *instance = (obdeque *)to_write;
+
+  assert(to_write);
+  OB_ASSERT_CLASS(to_write, &obdeque_class);
+
+  ob_writer_write_varint(writer, instance->length);
+
+  if(!obdeque_cursor_begin(instance, &cursor)) return;
+  do{
+    ob_serialize(obdeque_cursor_get(&cursor), writer);
+  }while(obdeque_cursor_next(&cursor));
 
-  obdeque_clear(instance);
+  return;
+}
+
+
+obj * obdeque_deserialize(ob_reader *reader){
+
+  uint64_t i, length;
+  obj *element;
+  obdeque *instance;
+
+  if(!ob_reader_read_varint(reader, &length)) return NULL;
+
+  instance = obdeque_new();
+
+  for(i=0; i<length; i++){
+    element = ob_deserialize(reader);
+    if(!element){ /* deques cannot hold NULL */
+      ob_reader_fail(reader);
+      ob_release((obj *)instance);
+      return NULL;
+    }
+    obdeque_add_at_tail(instance, element);
+    ob_release(element);
+  }
+
+  return (obj *)instance;
+}
+
+
+void obdeque_footprint(const obj *to_measure, ob_storage_fptr count,
+                       void *context){
+
+  const obdeque *instance = (obdeque *)to_measure;
+
+  assert(to_measure);
+  assert(count);
+  OB_ASSERT_CLASS(to_measure, &obdeque_class);
+
+  if(instance->storage)
+    count(instance->storage, sizeof(obdeque_storage), 0, context);
 
   return;
 }
 
+
+const ob_class * obdeque_class_descriptor(void){
+  return &obdeque_class;
+}
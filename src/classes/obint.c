@@ -6,41 +6,43 @@
 
 #include "../../include/obint.h"
 #include "../../include/private/obint_private.h"
+#include "../../include/private/offbrand_serial_private.h"
+#include "../../include/private/offbrand_optrace_private.h"
 
 /** maximum number of decimal digits to operate on as one int64_t */
 uint8_t int64_max_digits = 17;
 
+/** class descriptor shared by all obint instances */
+static const ob_class obint_class = {
+  .classname = "obint",
+  .size = sizeof(obint),
+  .dealloc = &obint_destroy,
+  .hash = &obint_hash,
+  .compare = &obint_compare,
+  .display = &obint_display,
+  .traverse = NULL,
+  .serialize = &obint_serialize,
+  .deserialize = &obint_deserialize,
+  .footprint = &obint_footprint
+};
+
+/** preallocated immortal obints, holding OB_INT_CACHE_MIN at index 0 */
+static obint int_cache[OB_INT_CACHE_SIZE];
+/** digit storage of the preallocated obints */
+static int8_t int_cache_digits[OB_INT_CACHE_SIZE][OB_INT_PRIMITIVE_DIGITS];
+/** ensures the preallocated obints are initialized once */
+static pthread_once_t int_cache_once = PTHREAD_ONCE_INIT;
+
 /* PUBLIC METHODS */
 
 obint * obint_new(int64_t num){
 
-  uint64_t i, ds;
-  int64_t partial_num;
-  obint *instance;
-
-  /* find the number of digits in the primitive, ensuring at least one for 0
-   * case */
-  ds = 1;
-  partial_num = num/10;
-  while(partial_num){
-    partial_num /= 10;
-    ds++;
+  if(num >= OB_INT_CACHE_MIN && num <= OB_INT_CACHE_MAX){
+    pthread_once(&int_cache_once, &obint_init_cache);
+    return &int_cache[num - OB_INT_CACHE_MIN];
   }
 
-  ds = ds ? ds : 1;
-
-  instance = obint_create_default(ds);
-  if(num < 0){
-    instance->sign = -1;
-    num *= -1;
-  }
-
-  for(i = 0; i < ds; i++){
-    instance->digits[i] = num%10;
-    num /= 10;
-  }
-
-  return instance;
+  return obint_create_from_primitive(num);
 }
 
 
@@ -348,95 +350,155 @@ obint * obint_mod_primitive(const obint *a, int64_t b){
 }
 
 
-/* PRIVATE METHODS */
+int8_t obint_compare_typed(const obint *a, const obint *b){
 
-/* add arguments to complete initialization as needed, modify
- * obint_Private.h as well if modifications are made */
-obint * obint_create_default(uint64_t num_digits){
+  int8_t magnitude_comp;
 
-  static const char classname[] = "obint";
-  obint *new_instance = malloc(sizeof(obint));
-  assert(new_instance != NULL);
+  assert(a);
+  assert(b);
 
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &obint_destroy, &obint_hash,
-               &obint_compare, &obint_display, classname);
+  /* if signs are equal magnitude comparision is required */
+  if(a->sign == b->sign){
 
-  new_instance->sign = 1; /* positive by default */
+    magnitude_comp = obint_compare_magnitudes(a, b);
 
-  new_instance->digits = malloc(sizeof(int8_t)*num_digits);
-  assert(new_instance->digits != NULL);
-  memset(new_instance->digits, 0, num_digits);
+    /* reverse magnitude comparision if both are negative */
+    if(a->sign == -1){
+      if(magnitude_comp == OB_LESS_THAN) magnitude_comp = OB_GREATER_THAN;
+      else if(magnitude_comp == OB_GREATER_THAN) magnitude_comp = OB_LESS_THAN;
+    }
 
-  new_instance->num_digits = num_digits;
+    return magnitude_comp;
+  }
 
-  return new_instance;
+  if(a->sign == -1) return OB_LESS_THAN;
+  return OB_GREATER_THAN;
 }
 
 
-ob_hash_t obint_hash(const obj *to_hash){
-
-  static int8_t init = 0;
-  static ob_hash_t seed = 0;
+ob_hash_t obint_hash_typed(const obint *a){
 
-  uint64_t i;
+  obint *instance = (obint *)a;
   ob_hash_t value;
-  obint *instance = (obint *)to_hash;
 
-  assert(to_hash);
-  assert(ob_has_class(to_hash, "obint"));
+  assert(a);
 
-  if(init == 0){
-    srand(time(NULL));
-    seed = rand();
-    init = 1;
+  /* leading zero digits do not change the value, so are not hashed. The hash
+   * is computed once, threads racing to fill the cache store the same value */
+  value = atomic_load_explicit(&instance->hash, memory_order_relaxed);
+  if(value == 0){
+    value = ob_hash_bytes(instance->digits, obint_most_sig(instance)+1);
+    atomic_store_explicit(&instance->hash, value, memory_order_relaxed);
   }
 
-  value = seed;
+  return value;
+}
 
-  i = obint_most_sig(instance);
 
-  /* A version of Jenkin's one at a time hash function */
-  for( ; i<instance->num_digits; i--){
-    value += instance->digits[i];
-    value += value << 10;
-    value ^= value >> 6;
+/* PRIVATE METHODS */
+
+obint * obint_create_from_primitive(int64_t num){
+
+  obint *instance;
+
+  instance = obint_create_default(obint_count_digits(num));
+  obint_store_primitive(instance, num);
+
+  return instance;
+}
+
+
+uint64_t obint_count_digits(int64_t num){
+
+  uint64_t ds;
+  int64_t partial_num;
+
+  /* find the number of digits in the primitive, ensuring at least one for 0
+   * case */
+  ds = 1;
+  partial_num = num/10;
+  while(partial_num){
+    partial_num /= 10;
+    ds++;
   }
 
-  value += value << 3;
-  value ^= value >> 11;
-  value *= value << 15;
-  return value;
+  return ds;
 }
 
 
-int8_t obint_compare(const obj *a, const obj *b){
+void obint_store_primitive(obint *a, int64_t num){
 
-  int8_t magnitude_comp;
-  const obint *comp_a = (obint *)a;
-  const obint *comp_b = (obint *)b;
+  uint64_t i;
 
-  assert(a);
-  assert(b);
-  assert(ob_has_class(a, "obint"));
-  assert(ob_has_class(b, "obint"));
+  if(num < 0){
+    a->sign = -1;
+    num *= -1;
+  }
 
-  /* if signs are equal magnitude comparision is required */
-  if(comp_a->sign == comp_b->sign){
+  for(i = 0; i < a->num_digits; i++){
+    a->digits[i] = num%10;
+    num /= 10;
+  }
 
-    magnitude_comp = obint_compare_magnitudes(comp_a, comp_b);
+  return;
+}
 
-    /* reverse magnitude comparision if both are negative */
-    if(comp_a->sign == -1){
-      if(magnitude_comp == OB_LESS_THAN) magnitude_comp = OB_GREATER_THAN;
-      else if(magnitude_comp == OB_GREATER_THAN) magnitude_comp = OB_LESS_THAN;
-    }
 
-    return magnitude_comp;
+void obint_init_cache(void){
+
+  int64_t i;
+  obint *instance;
+
+  for(i=0; i<OB_INT_CACHE_SIZE; i++){
+    instance = &int_cache[i];
+    ob_init_immortal((obj *)instance, &obint_class);
+    instance->sign = 1;
+    instance->digits = int_cache_digits[i];
+    instance->num_digits = obint_count_digits(i + OB_INT_CACHE_MIN);
+    atomic_init(&instance->hash, 0);
+    obint_store_primitive(instance, i + OB_INT_CACHE_MIN);
   }
 
-  if(comp_a->sign == -1) return OB_LESS_THAN;
-  return OB_GREATER_THAN;
+  return;
+}
+
+
+/* add arguments to complete initialization as needed, modify
+ * obint_Private.h as well if modifications are made */
+obint * obint_create_default(uint64_t num_digits){
+
+  obint *new_instance = (obint *)ob_alloc(&obint_class);
+
+  new_instance->sign = 1; /* positive by default */
+
+  new_instance->digits = malloc(sizeof(int8_t)*num_digits);
+  assert(new_instance->digits != NULL);
+  memset(new_instance->digits, 0, num_digits);
+
+  new_instance->num_digits = num_digits;
+  atomic_init(&new_instance->hash, 0);
+
+  return new_instance;
+}
+
+
+ob_hash_t obint_hash(const obj *to_hash){
+
+  assert(to_hash);
+  OB_ASSERT_CLASS(to_hash, &obint_class);
+
+  return obint_hash_typed((const obint *)to_hash);
+}
+
+
+int8_t obint_compare(const obj *a, const obj *b){
+
+  assert(a);
+  assert(b);
+  OB_ASSERT_CLASS(a, &obint_class);
+  OB_ASSERT_CLASS(b, &obint_class);
+
+  return obint_compare_typed((const obint *)a, (const obint *)b);
 }
 
 
@@ -466,7 +528,7 @@ void obint_display(const obj *to_print){
   const obint *instance = (obint *)to_print;
 
   assert(to_print);
-  assert(ob_has_class(to_print, "obint"));
+  OB_ASSERT_CLASS(to_print, &obint_class);
 
   str = obint_to_string(instance);
   fprintf(stderr, "Value:\n  %s\n", obstring_cstring(str));
@@ -483,7 +545,7 @@ void obint_destroy(obj *to_dealloc){
   obint *instance = (obint *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "obint"));
+  OB_ASSERT_CLASS(to_dealloc, &obint_class);
 
   free(instance->digits);
 
@@ -491,6 +553,106 @@ void obint_destroy(obj *to_dealloc){
 }
 
 
+void obint_serialize(const obj *to_write, ob_writer *writer){
+
+  uint64_t i, num_digits, header;
+  int64_t value;
+  unsigned char packed;
+  const obint *instance = (obint *)to_write;
+
+  assert(to_write);
+  OB_ASSERT_CLASS(to_write, &obint_class);
+
+  num_digits = obint_most_sig(instance) + 1;
+
+  /* small values are a single zigzag encoded varint, with a clear low bit */
+  if(num_digits <= OB_INT_SERIAL_SMALL_DIGITS){
+    value = obint_value(instance);
+    header = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    ob_writer_write_varint(writer, header << 1);
+    return;
+  }
+
+  /* larger values hold the digit count and sign, followed by two digits per
+   * byte, least significant first */
+  header = num_digits << 1 | (instance->sign < 0);
+  ob_writer_write_varint(writer, header << 1 | 1);
+
+  for(i=0; i<num_digits; i+=2){
+    packed = instance->digits[i];
+    if(i+1 < num_digits) packed |= instance->digits[i+1] << 4;
+    ob_writer_write(writer, &packed, 1);
+  }
+
+  return;
+}
+
+
+obj * obint_deserialize(ob_reader *reader){
+
+  uint64_t i, header, num_digits;
+  int64_t value;
+  unsigned char *packed;
+  obint *instance;
+
+  if(!ob_reader_read_varint(reader, &header)) return NULL;
+
+  if(!(header & 1)){
+    header >>= 1;
+    value = (int64_t)(header >> 1) ^ -(int64_t)(header & 1);
+    if(value <= -OB_INT_SERIAL_SMALL_MAX || value >= OB_INT_SERIAL_SMALL_MAX){
+      ob_reader_fail(reader);
+      return NULL;
+    }
+    return (obj *)obint_new(value);
+  }
+
+  header >>= 1;
+  num_digits = header >> 1;
+  if(num_digits <= OB_INT_SERIAL_SMALL_DIGITS){
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  if(!(packed = ob_reader_read_buffer(reader, (num_digits+1)/2, 0)))
+    return NULL;
+
+  instance = obint_create_default(num_digits);
+  if(header & 1) instance->sign = -1;
+
+  for(i=0; i<num_digits; i++)
+    instance->digits[i] = (packed[i/2] >> (i%2 ? 4 : 0)) & 0x0f;
+  free(packed);
+
+  /* digits must be decimal, without leading zeros */
+  for(i=0; i<num_digits && instance->digits[i] <= 9; i++);
+  if(i < num_digits || instance->digits[num_digits-1] == 0){
+    ob_release((obj *)instance);
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  return (obj *)instance;
+}
+
+
+void obint_footprint(const obj *to_measure, ob_storage_fptr count,
+                     void *context){
+
+  const obint *instance = (obint *)to_measure;
+
+  assert(to_measure != NULL);
+  assert(count != NULL);
+  OB_ASSERT_CLASS(to_measure, &obint_class);
+
+  count(instance->digits, sizeof(int8_t)*instance->num_digits,
+        sizeof(int8_t)*(instance->num_digits - obint_most_sig(instance) - 1),
+        context);
+
+  return;
+}
+
+
 obint * obint_add_unsigned(const obint *a, const obint *b){
 
   uint64_t i, large_most_sig, small_most_sig;
@@ -572,7 +734,8 @@ obint * obint_multiply_unsigned(const obint *a, const obint *b){
 
   /* base case, a and b are single digits */
   if(large_most_sig + small_most_sig < int64_max_digits)
-    return obint_new(obint_magnitude(a) * obint_magnitude(b));
+    return obint_create_from_primitive(obint_magnitude(a) *
+                                       obint_magnitude(b));
 
   split_point = large_most_sig/2+1;
   obint_split(a, split_point, &x1, &x0);
@@ -642,7 +805,7 @@ obint * obint_reduce(const obint *a, const obint *b, const obint *approx,
     }
     else{
       result_val = a_val%b_val;
-      result = obint_new(result_val);
+      result = obint_create_from_primitive(result_val);
     }
 
     return result;
@@ -657,10 +820,12 @@ obint * obint_reduce(const obint *a, const obint *b, const obint *approx,
   /* if a == b (so a/b = 1, a%b = 0) */
   else if(comp_val == OB_EQUAL_TO){
     if(quotient) return obint_add_primitive(approx,1);
-    else return obint_new(0);
+    else return obint_create_from_primitive(0);
   }
 
-  /* else recursive division approximation */
+  /* else recursive division approximation, each level of recursion traced
+   * within the previous one */
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obint_reduce", a, a_most_sig + 1);
 
   /* generate machine integers for approximation */
 
@@ -691,7 +856,7 @@ obint * obint_reduce(const obint *a, const obint *b, const obint *approx,
 
   /* perform approximation division, shift into proper decimal place, and add
    * to approximation */
-  partial = obint_new(a_val/b_val);
+  partial = obint_create_from_primitive(a_val/b_val);
   obint_shift(partial, i-j);
   product = obint_multiply_unsigned(partial, b);
 
@@ -704,7 +869,7 @@ obint * obint_reduce(const obint *a, const obint *b, const obint *approx,
     ob_release((obj *)product);
 
     b_val++;
-    partial = obint_new(a_val/b_val);
+    partial = obint_create_from_primitive(a_val/b_val);
     obint_shift(partial, i-j);
     product = obint_multiply_unsigned(partial, b);
   }
@@ -719,6 +884,8 @@ obint * obint_reduce(const obint *a, const obint *b, const obint *approx,
   ob_release((obj *)new_approx);
   ob_release((obj *)new_dividend);
 
+  OB_OP_TRACE(OB_OP_TRACE_END, "obint_reduce", a, a_most_sig + 1);
+
   return result;
 }
 
@@ -755,6 +922,8 @@ void obint_shift(obint *a, uint64_t m){
 
   int8_t *digits;
 
+  assert(!ob_is_immortal((obj *)a)); /* immortal obints are never modified */
+
   /* if shifting by zero do nothing */
   if(m == 0) return;
 
@@ -767,6 +936,7 @@ void obint_shift(obint *a, uint64_t m){
   free(a->digits);
   a->digits = digits;
   a->num_digits += m;
+  atomic_store_explicit(&a->hash, 0, memory_order_relaxed);
 
   return;
 }
@@ -789,6 +959,11 @@ int64_t obint_magnitude(const obint *a){
 }
 
 
+const ob_class * obint_class_descriptor(void){
+  return &obint_class;
+}
+
+
 void obint_set_max_digits(uint8_t digits){
   if(digits >= 2 && digits <= 17) int64_max_digits = digits;
 }
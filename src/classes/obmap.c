@@ -6,6 +6,8 @@
 
 #include "../../include/obmap.h"
 #include "../../include/private/obmap_private.h"
+#include "../../include/private/offbrand_serial_private.h"
+#include "../../include/private/offbrand_optrace_private.h"
 
 /* PRIVATE obmap CONSTANT VALUES */
 
@@ -46,6 +48,33 @@ const uint32_t NUM_CAPACITIES =
 const double MAX_LOAD_FACTOR = 0.75;
 
 
+/* CLASS DESCRIPTORS */
+
+/** class descriptor shared by all obmap_pair instances */
+static const ob_class obmap_pair_class = {
+  .classname = "obmap_pair",
+  .size = sizeof(obmap_pair),
+  .dealloc = &obmap_destroy_pair,
+  .hash = &obmap_hash_pair,
+  .compare = NULL,
+  .display = &obmap_display_pair,
+  .traverse = &obmap_traverse_pair
+};
+
+/** class descriptor shared by all obmap instances */
+static const ob_class obmap_class = {
+  .classname = "obmap",
+  .size = sizeof(obmap),
+  .dealloc = &obmap_destroy,
+  .hash = &obmap_hash,
+  .compare = &obmap_compare,
+  .display = &obmap_display,
+  .traverse = &obmap_traverse,
+  .serialize = &obmap_serialize,
+  .deserialize = &obmap_deserialize
+};
+
+
 /* PUBLIC METHODS */
 
 obmap * obmap_new(void){
@@ -68,11 +97,19 @@ obmap * obmap_new_with_capacity(uint32_t capacity){
 }
 
 
+obmap * obmap_new_weak_valued(void){
+
+  obmap *m = obmap_new();
+
+  m->weak_values = 1;
+
+  return m;
+}
+
+
 obmap * obmap_copy(const obmap *to_copy){
 
   obmap *copy;
-  obmap_pair *mp;
-  obdeque_iterator *it;
 
   assert(to_copy);
 
@@ -80,22 +117,16 @@ obmap * obmap_copy(const obmap *to_copy){
 
   copy->cap_idx = to_copy->cap_idx;
   copy->collisions = to_copy->collisions;
-  copy->pairs = obdeque_new();
+  copy->weak_values = to_copy->weak_values;
 
-  /* copy deque manually, internal objects need to be copied as well as Deque
-   * itself */
-  it = obdeque_head_iterator(to_copy->pairs);
-  if(it){
-    do{
-       mp = obmap_copy_pair((obmap_pair *)obdeque_obj_at_iterator(to_copy->pairs, it));
-       obdeque_add_at_tail(copy->pairs, (obj *)mp);
-       ob_release((obj *)mp);
-    }while(obdeque_iterate_next(to_copy->pairs, it));
-  }
-  ob_release((obj *)it);
+  /* share the table and pairs, they are copied only once either map is
+   * modified */
+  copy->hash_table = (obvector *)ob_retain((obj *)to_copy->hash_table);
+  copy->pairs = (obdeque *)ob_retain((obj *)to_copy->pairs);
 
-  obmap_rehash(copy); /* cannot grab to_copy->hash_table directly, stored
-                         iterators must point to values within copy, not to copy */
+  /* arena instances are deallocated with their arena, so the storage of arena
+   * maps is copied right away */
+  if(to_copy->base.flags & OB_FLAG_ARENA) obmap_own_storage(copy);
 
   return copy;
 }
@@ -109,6 +140,12 @@ void obmap_insert(obmap *m, obj *key, obj *value){
 
   assert(m);
 
+  obmap_own_storage(m);
+
+  /* weak valued maps store the handle of the value in its place, released
+   * below once the pair holds it */
+  if(m->weak_values && value) value = (obj *)ob_weak_new(value);
+
   hash_value = obmap_find_key(m, key);
   it = (obdeque_iterator *)obvector_obj_at_index(m->hash_table, hash_value);
 
@@ -117,16 +154,22 @@ void obmap_insert(obmap *m, obj *key, obj *value){
   if(it){
     mp = (obmap_pair *)obdeque_obj_at_iterator(m->pairs, it);
     obmap_replace_pair_value(mp, value);
+    if(m->weak_values) ob_release(value);
     return;
   }
 
-  /* if add operation will overload the map then resize the map */
+  /* if add operation will overload the map then first drop expired pairs of a
+   * weak valued map, and resize the map if that is not enough */
+  if(m->weak_values &&
+     (obdeque_length(m->pairs)+1)/MAP_CAPACITIES[m->cap_idx] > MAX_LOAD_FACTOR)
+    obmap_rehash(m);
   if((obdeque_length(m->pairs)+1)/MAP_CAPACITIES[m->cap_idx] > MAX_LOAD_FACTOR)
     obmap_increase_size(m);
 
   mp = obmap_new_pair(key, value);
   obdeque_add_at_tail(m->pairs, (obj *)mp);
   ob_release((obj *)mp); /* map deque has only reference to mp */
+  if(m->weak_values) ob_release(value);
 
   assert(it = obdeque_tail_iterator(m->pairs));
   obmap_add_to_table(m, it);
@@ -150,6 +193,59 @@ obj * obmap_lookup(const obmap *m, const obj *key){
   if(!it) return NULL;
 
   mp = (obmap_pair *)obdeque_obj_at_iterator(m->pairs, it);
+  if(m->weak_values) return obmap_pair_weak_value(mp);
+  return mp->value;
+}
+
+
+uint8_t obmap_cursor_begin(const obmap *m, ob_cursor *cursor){
+
+  assert(m);
+  assert(cursor);
+
+  /* walk the pairs deque, keeping the map so values can be resolved */
+  if(!obdeque_cursor_begin(m->pairs, cursor)) return 0;
+  cursor->container = (const obj *)m;
+
+  return 1;
+}
+
+
+uint8_t obmap_cursor_next(ob_cursor *cursor){
+
+  const obmap *m;
+  uint8_t advanced;
+
+  assert(cursor);
+  OB_ASSERT_CLASS(cursor->container, &obmap_class);
+
+  /* advance as a cursor of the pairs deque */
+  m = (const obmap *)cursor->container;
+  cursor->container = (const obj *)m->pairs;
+  advanced = obdeque_cursor_next(cursor);
+  cursor->container = (const obj *)m;
+
+  return advanced;
+}
+
+
+obj * obmap_cursor_get(const ob_cursor *cursor){
+  assert(cursor);
+  return obmap_cursor_pair(cursor)->key;
+}
+
+
+obj * obmap_cursor_value(const ob_cursor *cursor){
+
+  const obmap *m;
+  obmap_pair *mp;
+
+  assert(cursor);
+
+  m = (const obmap *)cursor->container;
+  mp = obmap_cursor_pair(cursor);
+
+  if(m->weak_values) return obmap_pair_weak_value(mp);
   return mp->value;
 }
 
@@ -166,32 +262,36 @@ void obmap_remove(obmap *m, obj *key){
 
   if(!it) return;
 
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obmap_remove", m,
+              obdeque_length(m->pairs));
+
+  obmap_own_storage(m);
+
+  /* the table of a map that shared it no longer references the pair */
+  hash_value = obmap_find_key(m, key);
+  it = (obdeque_iterator *)obvector_obj_at_index(m->hash_table, hash_value);
+
   obdeque_remove_at_iterator(m->pairs, it);
   obmap_rehash(m);
 
+  OB_OP_TRACE(OB_OP_TRACE_END, "obmap_remove", m, obdeque_length(m->pairs));
+
   return;
 }
 
 
 void obmap_rehash(obmap *m){
 
-  obdeque_iterator *it, *it_copy;
-
   assert(m);
 
-  ob_release((obj *)m->hash_table);
-  m->hash_table = obvector_new(MAP_CAPACITIES[m->cap_idx]);
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obmap_rehash", m, obdeque_length(m->pairs));
 
-  it = obdeque_head_iterator(m->pairs);
-  if(!it) return;
+  obmap_own_storage(m);
+  if(m->weak_values) obmap_remove_expired(m);
 
-  do{
-    it_copy = obdeque_copy_iterator(it);
-    obmap_add_to_table(m, it_copy);
-    ob_release((obj *)it_copy);
-  }while(obdeque_iterate_next(m->pairs, it));
+  obmap_fill_table(m);
 
-  ob_release((obj *)it);
+  OB_OP_TRACE(OB_OP_TRACE_END, "obmap_rehash", m, obdeque_length(m->pairs));
 
   return;
 }
@@ -213,13 +313,7 @@ void obmap_clear(obmap *m){
 
 obmap_pair * obmap_new_pair(obj *key, obj *value){
 
-  static const char classname[] = "obmap_pair";
-  obmap_pair *new_instance = malloc(sizeof(obmap_pair));
-  assert(new_instance != NULL);
-
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &obmap_destroy_pair, &obmap_hash_pair, NULL,
-           &obmap_display_pair, classname);
+  obmap_pair *new_instance = (obmap_pair *)ob_alloc(&obmap_pair_class);
 
   ob_retain(key);
   new_instance->key = key;
@@ -248,29 +342,14 @@ void obmap_replace_pair_value(obmap_pair *mp, obj *value){
 
 ob_hash_t obmap_hash_pair(const obj *to_hash){
 
-  static int8_t init = 0;
-  static ob_hash_t seed = 0;
-
   ob_hash_t value;
   obmap_pair *instance = (obmap_pair *)to_hash;
 
   assert(to_hash);
-  assert(ob_has_class(to_hash, "obmap_pair"));
-
-  if(init == 0){
-    srand(time(NULL));
-    seed = rand();
-    init = 1;
-  }
-
-  value = seed;
+  OB_ASSERT_CLASS(to_hash, &obmap_pair_class);
 
-  value += ob_hash(instance->key);
-  value += ob_hash(instance->value);
-
-  value += value << 3;
-  value ^= value >> 11;
-  value += value << 15;
+  value = ob_hash_combine(ob_hash_seed(), ob_hash(instance->key));
+  value = ob_hash_combine(value, ob_hash(instance->value));
 
   return value;
 }
@@ -280,7 +359,7 @@ void obmap_display_pair(const obj *to_print){
   obmap_pair *mp = (obmap_pair *)to_print;
 
   assert(to_print != NULL);
-  assert(ob_has_class(to_print, "obmap_pair"));
+  OB_ASSERT_CLASS(to_print, &obmap_pair_class);
 
   fprintf(stderr, "  [key]\n");
   ob_display(mp->key);
@@ -296,7 +375,7 @@ void obmap_destroy_pair(obj *to_dealloc){
   obmap_pair *instance = (obmap_pair *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "obmap_pair"));
+  OB_ASSERT_CLASS(to_dealloc, &obmap_pair_class);
 
   ob_release((obj *)instance->key);
   ob_release((obj *)instance->value);
@@ -305,23 +384,112 @@ void obmap_destroy_pair(obj *to_dealloc){
 }
 
 
+void obmap_traverse_pair(const obj *to_traverse, ob_visit_fptr visit,
+                         void *context){
+
+  const obmap_pair *instance = (obmap_pair *)to_traverse;
+
+  assert(to_traverse);
+  assert(visit);
+  OB_ASSERT_CLASS(to_traverse, &obmap_pair_class);
+
+  if(instance->key) visit(instance->key, context);
+  if(instance->value) visit(instance->value, context);
+
+  return;
+}
+
+
+
+obmap_pair * obmap_cursor_pair(const ob_cursor *cursor){
+  return (obmap_pair *)obdeque_cursor_get(cursor);
+}
+
+
+obj * obmap_pair_weak_value(const obmap_pair *mp){
+
+  obj *value;
+
+  assert(mp);
+
+  if(!mp->value) return NULL;
+
+  /* holding the lock reference while releasing it tells if the value was
+   * released to 0 meanwhile by another thread */
+  value = ob_weak_lock((ob_weak *)mp->value);
+  return ob_release(value);
+}
+
 
 /* obmap PRIVATE METHODS */
 
-obmap * obmap_create_default(void){
+void obmap_own_storage(obmap *m){
+
+  obdeque *pairs;
+  obmap_pair *mp;
+  ob_cursor cursor;
+
+  if(ob_is_unique((obj *)m->hash_table) && ob_is_unique((obj *)m->pairs))
+    return;
+
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obmap_own_storage", m,
+              obdeque_length(m->pairs));
 
-  static const char classname[] = "obmap";
-  obmap *new_instance = malloc(sizeof(obmap));
-  assert(new_instance != NULL);
+  /* copy deque manually, internal objects need to be copied as well as Deque
+   * itself */
+  pairs = obdeque_new();
+  if(obdeque_cursor_begin(m->pairs, &cursor)){
+    do{
+       mp = obmap_copy_pair((obmap_pair *)obdeque_cursor_get(&cursor));
+       obdeque_add_at_tail(pairs, (obj *)mp);
+       ob_release((obj *)mp);
+    }while(obdeque_cursor_next(&cursor));
+  }
 
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &obmap_destroy, &obmap_hash,
-           &obmap_compare, &obmap_display, classname);
+  ob_release((obj *)m->pairs);
+  m->pairs = pairs;
+
+  /* stored iterators must point to pairs within m, not to the shared pairs */
+  obmap_fill_table(m);
+
+  OB_OP_TRACE(OB_OP_TRACE_END, "obmap_own_storage", m,
+              obdeque_length(m->pairs));
+
+  return;
+}
+
+
+void obmap_fill_table(obmap *m){
+
+  obdeque_iterator *it, *it_copy;
+
+  ob_release((obj *)m->hash_table);
+  m->hash_table = obvector_new(MAP_CAPACITIES[m->cap_idx]);
+
+  it = obdeque_head_iterator(m->pairs);
+  if(!it) return;
+
+  do{
+    it_copy = obdeque_copy_iterator(it);
+    obmap_add_to_table(m, it_copy);
+    ob_release((obj *)it_copy);
+  }while(obdeque_iterate_next(m->pairs, it));
+
+  ob_release((obj *)it);
+
+  return;
+}
+
+
+obmap * obmap_create_default(void){
+
+  obmap *new_instance = (obmap *)ob_alloc(&obmap_class);
 
   new_instance->hash_table = NULL;
   new_instance->pairs = NULL;
   new_instance->cap_idx = 0;
   new_instance->collisions = 0;
+  new_instance->weak_values = 0;
 
   return new_instance;
 }
@@ -329,39 +497,27 @@ obmap * obmap_create_default(void){
 
 ob_hash_t obmap_hash(const obj *to_hash){
 
-  static int8_t init = 0;
-  static ob_hash_t seed = 0;
-
-  ob_hash_t value;
-  obdeque_iterator *it;
+  ob_hash_t value, pair;
+  ob_cursor cursor;
   obmap *instance = (obmap *)to_hash;
 
   assert(to_hash);
-  assert(ob_has_class(to_hash, "obmap"));
-
-  if(init == 0){
-    srand(time(NULL));
-    seed = rand();
-    init = 1;
-  }
+  OB_ASSERT_CLASS(to_hash, &obmap_class);
 
-  value = seed;
+  value = 0;
 
-  it = obdeque_head_iterator(instance->pairs);
-  if(!it) return value;
-
-  /* perform commutative hash, so order of addition to table does not matter */
-  do{
-    value += ob_hash(obdeque_obj_at_iterator(instance->pairs, it));
-  }while(obdeque_iterate_next(instance->pairs, it));
-
-  ob_release((obj *)it);
-
-  value += value << 3;
-  value ^= value >> 11;
-  value += value << 15;
+  /* sum pair hashes before combining, so order of addition to table does not
+   * matter. Pairs are hashed as obmap_hash_pair does, but with the values of
+   * weak valued maps resolved from their handles */
+  if(obmap_cursor_begin(instance, &cursor)){
+    do{
+      pair = ob_hash_combine(ob_hash_seed(),
+                             ob_hash(obmap_cursor_get(&cursor)));
+      value += ob_hash_combine(pair, ob_hash(obmap_cursor_value(&cursor)));
+    }while(obmap_cursor_next(&cursor));
+  }
 
-  return value;
+  return ob_hash_combine(ob_hash_seed(), value);
 }
 
 
@@ -369,8 +525,8 @@ int8_t obmap_compare(const obj *a, const obj *b){
 
   assert(a);
   assert(b);
-  assert(ob_has_class(a, "obmap"));
-  assert(ob_has_class(b, "obmap"));
+  OB_ASSERT_CLASS(a, &obmap_class);
+  OB_ASSERT_CLASS(b, &obmap_class);
 
   if(ob_hash(a) == ob_hash(b)) return OB_EQUAL_TO;
   return OB_NOT_EQUAL;
@@ -380,24 +536,24 @@ int8_t obmap_compare(const obj *a, const obj *b){
 void obmap_display(const obj *to_print){
 
   obmap *m = (obmap *)to_print;
-  obdeque_iterator *it;
+  ob_cursor cursor;
 
   assert(to_print != NULL);
-  assert(ob_has_class(to_print, "obmap"));
+  OB_ASSERT_CLASS(to_print, &obmap_class);
   fprintf(stderr, "obmap with key-value pairs:\n");
 
-  it = obdeque_head_iterator(m->pairs);
-
-  if(!it) return;
+  if(!obmap_cursor_begin(m, &cursor)) return;
 
+  /* values of weak valued maps are displayed rather than their handles */
   do{
-    ob_display(obdeque_obj_at_iterator(m->pairs, it));
-  }while(obdeque_iterate_next(m->pairs, it));
+    fprintf(stderr, "  [key]\n");
+    ob_display(obmap_cursor_get(&cursor));
+    fprintf(stderr, "  [value]\n");
+    ob_display(obmap_cursor_value(&cursor));
+  }while(obmap_cursor_next(&cursor));
 
   fprintf(stderr, "  [map end]\n");
 
-  ob_release((obj *)it);
-
   return;
 }
 
@@ -408,7 +564,7 @@ void obmap_destroy(obj *to_dealloc){
   obmap *instance = (obmap *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "obmap"));
+  OB_ASSERT_CLASS(to_dealloc, &obmap_class);
 
   ob_release((obj *)instance->hash_table);
   ob_release((obj *)instance->pairs);
@@ -417,6 +573,80 @@ void obmap_destroy(obj *to_dealloc){
 }
 
 
+void obmap_traverse(const obj *to_traverse, ob_visit_fptr visit,
+                    void *context){
+
+  const obmap *instance = (obmap *)to_traverse;
+
+  assert(to_traverse);
+  assert(visit);
+  OB_ASSERT_CLASS(to_traverse, &obmap_class);
+
+  if(instance->hash_table) visit((obj *)instance->hash_table, context);
+  if(instance->pairs) visit((obj *)instance->pairs, context);
+
+  return;
+}
+
+
+void obmap_serialize(const obj *to_write, ob_writer *writer){
+
+  ob_cursor cursor;
+  const obmap *instance = (obmap *)to_write;
+
+  assert(to_write);
+  OB_ASSERT_CLASS(to_write, &obmap_class);
+
+  /* expired values of weak valued maps are written as NULL */
+  ob_writer_write_varint(writer, obdeque_length(instance->pairs));
+
+  if(!obmap_cursor_begin(instance, &cursor)) return;
+  do{
+    ob_serialize(obmap_cursor_get(&cursor), writer);
+    ob_serialize(obmap_cursor_value(&cursor), writer);
+  }while(obmap_cursor_next(&cursor));
+
+  return;
+}
+
+
+obj * obmap_deserialize(ob_reader *reader){
+
+  uint64_t i, length, capacity;
+  obj *key, *value;
+  obmap *instance;
+
+  if(!ob_reader_read_varint(reader, &length)) return NULL;
+
+  /* presize the table so that reading never rehashes */
+  capacity = length;
+  if(capacity > OB_SERIAL_PRESIZE_LIMIT) capacity = OB_SERIAL_PRESIZE_LIMIT;
+  instance = obmap_new_with_capacity(capacity/MAX_LOAD_FACTOR + 1);
+
+  for(i=0; i<length; i++){
+    key = ob_deserialize(reader);
+    value = ob_deserialize(reader);
+    if(!key) ob_reader_fail(reader); /* maps cannot be keyed by NULL */
+    if(ob_reader_failed(reader)){
+      ob_release(key);
+      ob_release(value);
+      ob_release((obj *)instance);
+      return NULL;
+    }
+    obmap_insert(instance, key, value);
+    ob_release(key);
+    ob_release(value);
+  }
+
+  return (obj *)instance;
+}
+
+
+const ob_class * obmap_class_descriptor(void){
+  return &obmap_class;
+}
+
+
 void obmap_increase_size(obmap *to_size){
 
   assert(to_size);
@@ -427,7 +657,11 @@ void obmap_increase_size(obmap *to_size){
   if(to_size->cap_idx >= NUM_CAPACITIES) to_size->cap_idx = NUM_CAPACITIES-1;
   to_size->collisions = 0; /* before resize reset collisions */
 
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obmap_increase_size", to_size,
+              obdeque_length(to_size->pairs));
   obmap_rehash(to_size);
+  OB_OP_TRACE(OB_OP_TRACE_END, "obmap_increase_size", to_size,
+              obdeque_length(to_size->pairs));
 }
 
 
@@ -474,6 +708,29 @@ ob_hash_t obmap_find_key(const obmap *m, const obj *key){
 }
 
 
+void obmap_remove_expired(obmap *m){
+
+  obdeque *live;
+  ob_cursor cursor;
+  obj *mp;
+
+  assert(m);
+
+  if(!obdeque_cursor_begin(m->pairs, &cursor)) return;
+
+  live = obdeque_new();
+  do{
+    mp = obdeque_cursor_get(&cursor);
+    if(obmap_pair_weak_value((obmap_pair *)mp)) obdeque_add_at_tail(live, mp);
+  }while(obdeque_cursor_next(&cursor));
+
+  ob_release((obj *)m->pairs);
+  m->pairs = live;
+
+  return;
+}
+
+
 ob_hash_t obmap_offset_collision(ob_hash_t prev_offset){
   if(prev_offset == 0) return 1;
   else if(prev_offset == 1) return 2;
@@ -0,0 +1,558 @@
+/**
+ * @file obsnapshot.c
+ * @brief obsnapshot Method Implementation
+ * @author theck
+ */
+
+#include "../../include/obsnapshot.h"
+#include "../../include/obstring.h"
+#include "../../include/obvector.h"
+#include "../../include/obmap.h"
+#include "../../include/private/obsnapshot_private.h"
+#include "../../include/private/offbrand_hash_private.h"
+#include "../../include/private/offbrand_serial_private.h"
+
+/** class descriptor shared by all obsnapshot instances */
+static const ob_class obsnapshot_class = {
+  .classname = "obsnapshot",
+  .size = sizeof(obsnapshot),
+  .dealloc = &obsnapshot_destroy,
+  .hash = NULL,
+  .compare = NULL,
+  .display = &obsnapshot_display,
+  .traverse = NULL
+};
+
+/* PUBLIC METHODS */
+
+uint8_t obsnapshot_write(const obj *root, const char *path){
+
+  obsnapshot_header header;
+  obsnapshot_writer writer;
+
+  assert(path != NULL);
+
+  if(!(writer.file = fopen(path, "wb"))) return 0;
+  writer.offset = 0;
+  writer.failed = 0;
+
+  /* the header is rewritten once the size and root are known */
+  memset(&header, 0, sizeof(obsnapshot_header));
+  obsnapshot_write_bytes(&writer, &header, sizeof(obsnapshot_header));
+
+  memcpy(header.magic, OBSNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = OBSNAPSHOT_VERSION;
+  header.byte_order = OBSNAPSHOT_BYTE_ORDER;
+  header.seed = ob_hash_seed();
+  header.root = obsnapshot_write_instance(&writer, root);
+  header.size = writer.offset;
+
+  if(fseeko(writer.file, 0, SEEK_SET) != 0 ||
+     fwrite(&header, sizeof(obsnapshot_header), 1, writer.file) != 1)
+    writer.failed = 1;
+
+  if(fclose(writer.file) != 0) writer.failed = 1;
+
+  return !writer.failed;
+}
+
+
+obsnapshot * obsnapshot_open(const char *path){
+
+  int fd;
+  struct stat info;
+  void *data;
+  const obsnapshot_header *header;
+  obsnapshot *new_instance;
+
+  assert(path != NULL);
+
+  if((fd = open(path, O_RDONLY)) < 0) return NULL;
+
+  if(fstat(fd, &info) != 0 ||
+     info.st_size < (off_t)sizeof(obsnapshot_header)){
+    close(fd);
+    return NULL;
+  }
+
+  /* the mapping outlives the descriptor */
+  data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) return NULL;
+
+  header = data;
+  if(memcmp(header->magic, OBSNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+     header->version != OBSNAPSHOT_VERSION ||
+     header->byte_order != OBSNAPSHOT_BYTE_ORDER ||
+     header->size != (uint64_t)info.st_size){
+    munmap(data, info.st_size);
+    return NULL;
+  }
+
+  /* lookups touch few pages at random, reading ahead only wastes memory */
+  madvise(data, info.st_size, MADV_RANDOM);
+
+  new_instance = (obsnapshot *)ob_alloc(&obsnapshot_class);
+  new_instance->data = data;
+  new_instance->size = info.st_size;
+  new_instance->header = header;
+
+  return new_instance;
+}
+
+
+obsnapshot_ref obsnapshot_root(const obsnapshot *s){
+  assert(s != NULL);
+  return s->header->root;
+}
+
+
+uint8_t obsnapshot_kind(const obsnapshot *s, obsnapshot_ref ref){
+
+  const uint32_t *record;
+
+  assert(s != NULL);
+
+  if(!(record = obsnapshot_record(s, ref, OBSNAPSHOT_NULL)))
+    return OBSNAPSHOT_NULL;
+
+  return *record;
+}
+
+
+uint32_t obsnapshot_length(const obsnapshot *s, obsnapshot_ref ref){
+
+  const uint32_t *record;
+
+  assert(s != NULL);
+
+  /* every record holds its length in the word following its kind */
+  if(!(record = obsnapshot_record(s, ref, OBSNAPSHOT_NULL))) return 0;
+
+  return record[1];
+}
+
+
+const char * obsnapshot_string(const obsnapshot *s, obsnapshot_ref ref,
+                               uint32_t *length){
+
+  const obsnapshot_string_record *record;
+
+  assert(s != NULL);
+
+  if(!(record = obsnapshot_record(s, ref, OBSNAPSHOT_STRING))) return NULL;
+
+  if(length) *length = record->length;
+  return record->str;
+}
+
+
+obsnapshot_ref obsnapshot_at_index(const obsnapshot *s, obsnapshot_ref ref,
+                                   int64_t index){
+
+  const obsnapshot_vector_record *record;
+
+  assert(s != NULL);
+
+  if(!(record = obsnapshot_record(s, ref, OBSNAPSHOT_VECTOR)))
+    return OBSNAPSHOT_NONE;
+
+  /* if negatively indexing, index from the end of the array backwards */
+  if(index < 0) index += record->length;
+  if(index < 0 || index >= record->length) return OBSNAPSHOT_NONE;
+
+  return obsnapshot_child(ref, record->elements[index]);
+}
+
+
+obsnapshot_ref obsnapshot_lookup(const obsnapshot *s, obsnapshot_ref ref,
+                                 const char *key, uint32_t length){
+
+  uint64_t i, probes, mask, hash_value;
+  const obsnapshot_map_record *record;
+  const obsnapshot_slot *slot;
+  const obsnapshot_string_record *slot_key;
+
+  assert(s != NULL);
+  assert(key != NULL || length == 0);
+
+  if(!(record = obsnapshot_record(s, ref, OBSNAPSHOT_MAP)) ||
+     record->capacity == 0)
+    return OBSNAPSHOT_NONE;
+
+  hash_value = ob_hash_bytes_seeded(key, length, s->header->seed);
+  mask = record->capacity - 1;
+
+  /* probing stops at the first empty slot, bounded in case the table of a
+   * damaged snapshot has none */
+  i = hash_value & mask;
+  for(probes=0; probes<record->capacity; probes++){
+    slot = record->slots + i;
+    if(slot->key == OBSNAPSHOT_NONE) break;
+
+    if(slot->hash == hash_value &&
+       (slot_key = obsnapshot_record(s, slot->key, OBSNAPSHOT_STRING)) &&
+       slot_key->length == length && memcmp(slot_key->str, key, length) == 0)
+      return obsnapshot_child(ref, slot->value);
+
+    i = (i + 1) & mask;
+  }
+
+  return OBSNAPSHOT_NONE;
+}
+
+
+uint8_t obsnapshot_cursor_begin(const obsnapshot *s, obsnapshot_ref ref,
+                                ob_cursor *cursor){
+
+  const obsnapshot_map_record *record;
+
+  assert(s != NULL);
+  assert(cursor != NULL);
+
+  if(!(record = obsnapshot_record(s, ref, OBSNAPSHOT_MAP))) return 0;
+
+  cursor->container = (const obj *)s;
+  cursor->position = record;
+  cursor->index = 0;
+
+  if(record->capacity == 0) return 0;
+  if(record->slots[0].key != OBSNAPSHOT_NONE) return 1;
+
+  return obsnapshot_cursor_next(cursor);
+}
+
+
+uint8_t obsnapshot_cursor_next(ob_cursor *cursor){
+
+  uint64_t i;
+  const obsnapshot_map_record *record;
+
+  assert(cursor != NULL);
+  OB_ASSERT_CLASS(cursor->container, &obsnapshot_class);
+
+  record = cursor->position;
+  for(i=cursor->index+1; i<record->capacity; i++){
+    if(record->slots[i].key != OBSNAPSHOT_NONE){
+      cursor->index = i;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+obsnapshot_ref obsnapshot_cursor_key(const ob_cursor *cursor){
+
+  const obsnapshot *s;
+  const obsnapshot_map_record *record;
+
+  assert(cursor != NULL);
+  OB_ASSERT_CLASS(cursor->container, &obsnapshot_class);
+
+  s = (const obsnapshot *)cursor->container;
+  record = cursor->position;
+  return obsnapshot_child((const unsigned char *)record - s->data,
+                          record->slots[cursor->index].key);
+}
+
+
+obsnapshot_ref obsnapshot_cursor_value(const ob_cursor *cursor){
+
+  const obsnapshot *s;
+  const obsnapshot_map_record *record;
+
+  assert(cursor != NULL);
+  OB_ASSERT_CLASS(cursor->container, &obsnapshot_class);
+
+  s = (const obsnapshot *)cursor->container;
+  record = cursor->position;
+  return obsnapshot_child((const unsigned char *)record - s->data,
+                          record->slots[cursor->index].value);
+}
+
+
+obj * obsnapshot_thaw(const obsnapshot *s, obsnapshot_ref ref){
+
+  uint32_t i;
+  obj *key, *value;
+  obvector *v;
+  obmap *m;
+  ob_cursor cursor;
+
+  assert(s != NULL);
+
+  switch(obsnapshot_kind(s, ref)){
+
+    case OBSNAPSHOT_STRING:
+      return (obj *)obstring_new(obsnapshot_string(s, ref, NULL));
+
+    case OBSNAPSHOT_VECTOR:
+      v = obvector_new(obsnapshot_length(s, ref));
+      for(i=0; i<obsnapshot_length(s, ref); i++){
+        value = obsnapshot_thaw(s, obsnapshot_at_index(s, ref, i));
+        if(value) obvector_store_at_index(v, value, i);
+        ob_release(value);
+      }
+      return (obj *)v;
+
+    case OBSNAPSHOT_MAP:
+      m = obmap_new_with_capacity(obsnapshot_length(s, ref));
+      if(obsnapshot_cursor_begin(s, ref, &cursor)){
+        do{
+          key = obsnapshot_thaw(s, obsnapshot_cursor_key(&cursor));
+          value = obsnapshot_thaw(s, obsnapshot_cursor_value(&cursor));
+          if(key) obmap_insert(m, key, value);
+          ob_release(key);
+          ob_release(value);
+        }while(obsnapshot_cursor_next(&cursor));
+      }
+      return (obj *)m;
+
+    default:
+      return NULL;
+  }
+}
+
+
+/* PRIVATE METHODS */
+
+void obsnapshot_destroy(obj *to_dealloc){
+
+  obsnapshot *instance = (obsnapshot *)to_dealloc;
+
+  assert(to_dealloc);
+  OB_ASSERT_CLASS(to_dealloc, &obsnapshot_class);
+
+  munmap((void *)instance->data, instance->size);
+
+  return;
+}
+
+
+void obsnapshot_display(const obj *to_print){
+
+  const obsnapshot *s = (obsnapshot *)to_print;
+
+  assert(to_print != NULL);
+  OB_ASSERT_CLASS(to_print, &obsnapshot_class);
+
+  fprintf(stderr, "obsnapshot of %llu bytes, root kind %u\n",
+          (unsigned long long)s->size, obsnapshot_kind(s, s->header->root));
+}
+
+
+obsnapshot_ref obsnapshot_child(obsnapshot_ref parent, obsnapshot_ref child){
+
+  /* records are written after the records they reference, a reference that
+   * does not point backwards belongs to a damaged snapshot and following it
+   * could loop forever */
+  if(child >= parent) return OBSNAPSHOT_NONE;
+
+  return child;
+}
+
+
+const void * obsnapshot_record(const obsnapshot *s, obsnapshot_ref ref,
+                               uint8_t kind){
+
+  uint64_t available;
+  const uint32_t *record;
+  const obsnapshot_string_record *str;
+  const obsnapshot_map_record *map;
+
+  if(ref < sizeof(obsnapshot_header) || ref % OBSNAPSHOT_ALIGNMENT != 0 ||
+     ref > s->size - 2*sizeof(uint32_t))
+    return NULL;
+
+  /* every record starts with its kind and length, variable parts are compared
+   * against the bytes available so that no size computation overflows */
+  record = (const uint32_t *)(s->data + ref);
+  available = s->size - ref;
+  if(kind != OBSNAPSHOT_NULL && record[0] != kind) return NULL;
+
+  switch(record[0]){
+
+    case OBSNAPSHOT_STRING:
+      str = (const obsnapshot_string_record *)record;
+      if(available < sizeof(obsnapshot_string_record) ||
+         str->length >= available - sizeof(obsnapshot_string_record) ||
+         str->str[str->length] != '\0')
+        return NULL;
+      return record;
+
+    case OBSNAPSHOT_VECTOR:
+      if(record[1] > (available - sizeof(obsnapshot_vector_record))/
+                     sizeof(obsnapshot_ref))
+        return NULL;
+      return record;
+
+    case OBSNAPSHOT_MAP:
+      map = (const obsnapshot_map_record *)record;
+      if(available < sizeof(obsnapshot_map_record) ||
+         map->capacity & (map->capacity - 1) || map->count > map->capacity ||
+         map->capacity > (available - sizeof(obsnapshot_map_record))/
+                         sizeof(obsnapshot_slot))
+        return NULL;
+      return record;
+
+    default:
+      return NULL;
+  }
+}
+
+
+obsnapshot_ref obsnapshot_write_instance(obsnapshot_writer *writer,
+                                         const obj *instance){
+
+  if(!instance) return OBSNAPSHOT_NONE;
+
+  if(instance->cls == obstring_class_descriptor())
+    return obsnapshot_write_string(writer, instance);
+  if(instance->cls == obvector_class_descriptor())
+    return obsnapshot_write_vector(writer, instance);
+
+  /* only strings, vectors and maps can be frozen */
+  assert(instance->cls == obmap_class_descriptor());
+  return obsnapshot_write_map(writer, instance);
+}
+
+
+obsnapshot_ref obsnapshot_write_string(obsnapshot_writer *writer,
+                                       const obj *instance){
+
+  obsnapshot_string_record record;
+  obsnapshot_ref ref = writer->offset;
+  const obstring *s = (obstring *)instance;
+
+  record.kind = OBSNAPSHOT_STRING;
+  record.length = obstring_length(s);
+  record.hash = ob_hash(instance);
+
+  obsnapshot_write_bytes(writer, &record, sizeof(obsnapshot_string_record));
+  obsnapshot_write_bytes(writer, obstring_cstring(s), record.length + 1);
+  obsnapshot_write_padding(writer);
+
+  return ref;
+}
+
+
+obsnapshot_ref obsnapshot_write_vector(obsnapshot_writer *writer,
+                                       const obj *instance){
+
+  uint32_t i;
+  obsnapshot_vector_record record;
+  obsnapshot_ref ref, *elements;
+  const obvector *v = (obvector *)instance;
+
+  record.kind = OBSNAPSHOT_VECTOR;
+  record.length = obvector_length(v);
+
+  elements = malloc(sizeof(obsnapshot_ref)*record.length + 1);
+  assert(elements != NULL);
+
+  for(i=0; i<record.length; i++)
+    elements[i] = obsnapshot_write_instance(writer,
+                                            obvector_obj_at_index(v, i));
+
+  ref = writer->offset;
+  obsnapshot_write_bytes(writer, &record, sizeof(obsnapshot_vector_record));
+  obsnapshot_write_bytes(writer, elements,
+                         sizeof(obsnapshot_ref)*record.length);
+
+  free(elements);
+
+  return ref;
+}
+
+
+obsnapshot_ref obsnapshot_write_map(obsnapshot_writer *writer,
+                                    const obj *instance){
+
+  uint64_t i, j, count, pairs_capacity;
+  obsnapshot_map_record record;
+  obsnapshot_slot *pairs, *slots;
+  obsnapshot_ref ref;
+  ob_cursor cursor;
+  const obj *key;
+
+  /* collect the pairs bound to a value, writing their keys and values */
+  count = 0;
+  pairs_capacity = 16;
+  pairs = malloc(sizeof(obsnapshot_slot)*pairs_capacity);
+  assert(pairs != NULL);
+
+  if(obmap_cursor_begin((const obmap *)instance, &cursor)){
+    do{
+      if(!obmap_cursor_value(&cursor)) continue;
+
+      key = obmap_cursor_get(&cursor);
+      assert(key->cls == obstring_class_descriptor()); /* keys are strings */
+
+      if(count == pairs_capacity){
+        pairs_capacity *= 2;
+        pairs = realloc(pairs, sizeof(obsnapshot_slot)*pairs_capacity);
+        assert(pairs != NULL);
+      }
+
+      pairs[count].hash = ob_hash(key);
+      pairs[count].key = obsnapshot_write_string(writer, key);
+      pairs[count].value = obsnapshot_write_instance(writer,
+                                                 obmap_cursor_value(&cursor));
+      count++;
+    }while(obmap_cursor_next(&cursor));
+  }
+
+  assert(count <= UINT32_MAX);
+
+  /* keep the table at most half full so that probe sequences stay short */
+  record.kind = OBSNAPSHOT_MAP;
+  record.count = count;
+  record.capacity = count > 0 ? 1 : 0;
+  while(record.capacity < 2*count) record.capacity *= 2;
+
+  slots = calloc(record.capacity + 1, sizeof(obsnapshot_slot));
+  assert(slots != NULL);
+
+  for(i=0; i<count; i++){
+    j = pairs[i].hash & (record.capacity - 1);
+    while(slots[j].key != OBSNAPSHOT_NONE) j = (j + 1) & (record.capacity - 1);
+    slots[j] = pairs[i];
+  }
+
+  ref = writer->offset;
+  obsnapshot_write_bytes(writer, &record, sizeof(obsnapshot_map_record));
+  obsnapshot_write_bytes(writer, slots,
+                         sizeof(obsnapshot_slot)*record.capacity);
+
+  free(slots);
+  free(pairs);
+
+  return ref;
+}
+
+
+void obsnapshot_write_bytes(obsnapshot_writer *writer, const void *data,
+                            uint64_t length){
+
+  if(length == 0) return;
+
+  if(!writer->failed && fwrite(data, 1, length, writer->file) != length)
+    writer->failed = 1;
+  writer->offset += length;
+
+  return;
+}
+
+
+void obsnapshot_write_padding(obsnapshot_writer *writer){
+
+  static const unsigned char zeros[OBSNAPSHOT_ALIGNMENT] = {0};
+
+  if(writer->offset % OBSNAPSHOT_ALIGNMENT)
+    obsnapshot_write_bytes(writer, zeros, OBSNAPSHOT_ALIGNMENT -
+                                          writer->offset%OBSNAPSHOT_ALIGNMENT);
+
+  return;
+}
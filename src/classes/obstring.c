@@ -6,21 +6,57 @@
 
 #include "../../include/obstring.h"
 #include "../../include/private/obstring_private.h"
+#include "../../include/private/offbrand_serial_private.h"
 
 /** Buffer size for a string to print on a regex error */
 #define REGEX_ERROR_BUFFER_SIZE 256
 
+/** class descriptor shared by all obstring instances */
+static const ob_class obstring_class = {
+  .classname = "obstring",
+  .size = sizeof(obstring),
+  .dealloc = &obstring_destroy,
+  .hash = &obstring_hash,
+  .compare = &obstring_compare,
+  .display = &obstring_display,
+  .traverse = NULL,
+  .serialize = &obstring_serialize,
+  .deserialize = &obstring_deserialize,
+  .footprint = &obstring_footprint
+};
+
+/** immortal empty string, returned for every empty obstring */
+static obstring empty_string = {
+  .base = OB_IMMORTAL_BASE(&obstring_class),
+  .str = "",
+  .length = 0,
+  .hash = 0
+};
+
+/** preallocated immortal single character obstrings, holding
+ * OB_STRING_CACHE_FIRST at index 0 */
+static obstring char_strings[OB_STRING_CACHE_SIZE];
+/** NUL terminated characters of the single character obstrings */
+static char char_string_data[OB_STRING_CACHE_SIZE][2];
+/** ensures the single character obstrings are initialized once */
+static pthread_once_t char_strings_once = PTHREAD_ONCE_INIT;
+
 /* PUBLIC METHODS */
 
 obstring *obstring_new(const char *str){
 
   obstring *instance;
+  size_t length;
 
   assert(str);
 
+  length = strlen(str);
+  if(length <= 1 && (instance = obstring_find_immortal(str, length)))
+    return instance;
+
   instance = obstring_create_default();
 
-  instance->length = strlen(str);
+  instance->length = length;
   instance->str = realloc(instance->str, (instance->length+1)*sizeof(char));
   assert(instance->str);
 
@@ -36,8 +72,6 @@ obstring * obstring_copy_substring(const obstring *s, int64_t start, uint32_t le
 
   assert(s);
 
-  instance = obstring_create_default();
-
   /* account for negative indexing */
   if(start < 0) start += s->length;
 
@@ -53,8 +87,12 @@ obstring * obstring_copy_substring(const obstring *s, int64_t start, uint32_t le
 
   /* if specified range contains no characters return an "empty" string */
   if(start > s->length || start+length < 0 || s->length == 0 || length <= 0)
+    return &empty_string;
+
+  if(length == 1 && (instance = obstring_find_immortal(s->str+start, 1)))
     return instance;
 
+  instance = obstring_create_default();
   instance->length = length;
   instance->str = realloc(instance->str, (length+1)*sizeof(char));
   assert(instance->str);
@@ -89,11 +127,14 @@ obstring * obstring_concat(const obstring *s1, const obstring *s2){
   assert(s1);
   assert(s2);
 
+  if(s1->length + s2->length <= 1 &&
+     (concatted = obstring_find_immortal(s1->length ? s1->str : s2->str,
+                                         s1->length + s2->length)))
+    return concatted;
+
   concatted = obstring_create_default();
   concatted->length = s1->length + s2->length;
 
-  if(concatted->length == 0) return concatted;
-
   concatted->str = realloc(concatted->str, (concatted->length+1)*sizeof(char));
   assert(concatted->str);
 
@@ -113,8 +154,8 @@ const char * obstring_cstring(const obstring *s){
 obvector * obstring_split(const obstring *s, const char *delim){
 
   obvector *tokens;
-  obstring *copy, *substring;
-  char *marker;
+  obstring *substring;
+  char *copy, *marker;
   uint32_t i, delim_len, substrs;
 
 
@@ -122,31 +163,36 @@ obvector * obstring_split(const obstring *s, const char *delim){
   assert(delim);
 
   tokens = obvector_new(1);
-  copy = obstring_copy_substring(s, 0, s->length);
+
+  /* split a private copy of the characters, s may be an immortal obstring
+   * shared by the whole program */
+  copy = malloc(s->length+1);
+  assert(copy);
+  memcpy(copy, s->str, s->length+1);
   delim_len = strlen(delim);
-  marker = copy->str;
+  marker = copy;
 
   /* overwrite all instance of delimeter with NUL character(s) */
-  while(marker <= copy->str+(copy->length - delim_len)){
+  while(marker <= copy+(s->length - delim_len)){
     if(strncmp(marker, delim, delim_len) == 0)
       for(i=0; i<delim_len; i++) *(marker++) = '\0';
     else
       marker++;
   }
 
-  marker = copy->str;
+  marker = copy;
 
   /* copy all found substrings into new obstrings for Vector */
   substrs=0;
-  while(marker < copy->str+copy->length){
+  while(marker < copy+s->length){
     substring = obstring_new(marker);
     marker += substring->length;
     obvector_store_at_index(tokens, (obj *)substring, substrs++);
     ob_release((obj *)substring); /* only tokens vector needs a reference */
-    while(*marker == '\0' && marker < copy->str + copy->length) marker++;
+    while(*marker == '\0' && marker < copy + s->length) marker++;
   }
 
-  ob_release((obj *)copy);
+  free(copy);
   return tokens;
 }
 
@@ -201,24 +247,91 @@ obstring * obstring_match_regex(const obstring *s, const char *regex){
 }
 
 
+int8_t obstring_compare_typed(const obstring *a, const obstring *b){
+
+  uint32_t i;
+
+  assert(a);
+  assert(b);
+
+  /* compare string contents where both have characters */
+  for(i=0; i<a->length && i<b->length; i++){
+    if(a->str[i] < b->str[i]) return OB_LESS_THAN;
+    else if(b->str[i] < a->str[i]) return OB_GREATER_THAN;
+  }
+
+  /* if characters matched check lengths for final equality */
+  if(a->length < b->length) return OB_LESS_THAN;
+  else if(b->length < a->length) return OB_GREATER_THAN;
+  return OB_EQUAL_TO;
+}
+
+
+ob_hash_t obstring_hash_typed(const obstring *s){
+
+  obstring *instance = (obstring *)s;
+  ob_hash_t value;
+
+  assert(s);
+
+  /* strings are immutable once created, so the hash is computed once. Threads
+   * racing to fill the cache store the same value */
+  value = atomic_load_explicit(&instance->hash, memory_order_relaxed);
+  if(value == 0){
+    value = ob_hash_bytes(instance->str, instance->length);
+    atomic_store_explicit(&instance->hash, value, memory_order_relaxed);
+  }
+
+  return value;
+}
+
+
 /* PRIVATE METHODS */
 
+obstring * obstring_find_immortal(const char *str, uint32_t length){
+
+  if(length == 0) return &empty_string;
+
+  if(length == 1 && str[0] >= OB_STRING_CACHE_FIRST &&
+     str[0] <= OB_STRING_CACHE_LAST){
+    pthread_once(&char_strings_once, &obstring_init_cache);
+    return &char_strings[str[0] - OB_STRING_CACHE_FIRST];
+  }
+
+  return NULL;
+}
+
+
+void obstring_init_cache(void){
+
+  uint32_t i;
+  obstring *instance;
+
+  for(i=0; i<OB_STRING_CACHE_SIZE; i++){
+    instance = &char_strings[i];
+    ob_init_immortal((obj *)instance, &obstring_class);
+    char_string_data[i][0] = OB_STRING_CACHE_FIRST + i;
+    char_string_data[i][1] = '\0';
+    instance->str = char_string_data[i];
+    instance->length = 1;
+    atomic_init(&instance->hash, 0);
+  }
+
+  return;
+}
+
+
 /* add arguments to complete initialization as needed, modify
  * obstring_Private.h as well if modifications are made */
 obstring * obstring_create_default(void){
 
-  static const char classname[] = "obstring";
-  obstring *new_instance = malloc(sizeof(obstring));
-  assert(new_instance != NULL);
-
-  /* initialize base class data */
-  ob_init_base((obj *)new_instance, &obstring_destroy, &obstring_hash,
-               &obstring_compare, &obstring_display, classname);
+  obstring *new_instance = (obstring *)ob_alloc(&obstring_class);
 
   new_instance->str = malloc(sizeof(char));
   assert(new_instance->str);
   new_instance->str[0] = '\0';
   new_instance->length = 0;
+  atomic_init(&new_instance->hash, 0);
 
   return new_instance;
 }
@@ -226,66 +339,27 @@ obstring * obstring_create_default(void){
 
 ob_hash_t obstring_hash(const obj *to_hash){
 
-  static int8_t init = 0;
-  static ob_hash_t seed;
-
-  obstring *instance = (obstring *)to_hash;
-  ob_hash_t value;
-  char *pos;
-
   assert(to_hash);
-  assert(ob_has_class(to_hash, "obstring"));
-
-  if(init == 0){
-    srand(time(NULL));
-    seed = rand();
-    init = 1;
-  }
-
-  value = seed;
+  OB_ASSERT_CLASS(to_hash, &obstring_class);
 
-  /* A version of Jenkin's one at a time hash function */
-  pos = instance->str;
-  while(*pos != '\0'){
-    value += *(pos++);
-    value += value << 10;
-    value ^= value >> 6;
-  }
-
-  value += value << 3;
-  value ^= value >> 11;
-  value += value << 15;
-  return value;
+  return obstring_hash_typed((const obstring *)to_hash);
 }
 
 
 int8_t obstring_compare(const obj *a, const obj *b){
 
-  uint32_t i;
-  const obstring *comp_a = (obstring *)a;
-  const obstring *comp_b = (obstring *)b;
-
   assert(a);
   assert(b);
-  assert(ob_has_class(a, "obstring"));
-  assert(ob_has_class(b, "obstring"));
+  OB_ASSERT_CLASS(a, &obstring_class);
+  OB_ASSERT_CLASS(b, &obstring_class);
 
-  /* compare string contents where both have characters */
-  for(i=0; i<comp_a->length && i<comp_b->length; i++){
-    if(comp_a->str[i] < comp_b->str[i]) return OB_LESS_THAN;
-    else if(comp_b->str[i] < comp_a->str[i]) return OB_GREATER_THAN;
-  }
-
-  /* if characters matched check lengths for final equality */
-  if(comp_a->length < comp_b->length) return OB_LESS_THAN;
-  else if(comp_b->length < comp_a->length) return OB_GREATER_THAN;
-  return OB_EQUAL_TO;
+  return obstring_compare_typed((const obstring *)a, (const obstring *)b);
 }
 
 
 void obstring_display(const obj *str){
   assert(str != NULL);
-  assert(ob_has_class(str, "obstring"));
+  OB_ASSERT_CLASS(str, &obstring_class);
   fprintf(stderr, "obstring with Contents:\n  %s\n", ((obstring *)str)->str);
 }
 
@@ -296,11 +370,82 @@ void obstring_destroy(obj *to_dealloc){
   obstring *instance = (obstring *)to_dealloc;
 
   assert(to_dealloc);
-  assert(ob_has_class(to_dealloc, "obstring"));
+  OB_ASSERT_CLASS(to_dealloc, &obstring_class);
 
   if(instance->str) free(instance->str);
 
   return;
 }
 
+
+void obstring_serialize(const obj *to_write, ob_writer *writer){
+
+  const obstring *instance = (obstring *)to_write;
+
+  assert(to_write);
+  OB_ASSERT_CLASS(to_write, &obstring_class);
+
+  ob_writer_write_varint(writer, instance->length);
+  ob_writer_write(writer, instance->str, instance->length);
+
+  return;
+}
+
+
+obj * obstring_deserialize(ob_reader *reader){
+
+  uint64_t length;
+  char *str;
+  obstring *instance;
+
+  if(!ob_reader_read_varint(reader, &length)) return NULL;
+
+  if(length > UINT32_MAX){
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  if(!(str = ob_reader_read_buffer(reader, length, 1))) return NULL;
+  str[length] = '\0';
+
+  /* a C string cannot hold a NUL character */
+  if(strlen(str) != length){
+    free(str);
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  if(length <= 1 && (instance = obstring_find_immortal(str, length))){
+    free(str);
+    return (obj *)instance;
+  }
+
+  instance = obstring_create_default();
+  free(instance->str);
+  instance->str = str;
+  instance->length = length;
+
+  return (obj *)instance;
+}
+
+
+void obstring_footprint(const obj *to_measure, ob_storage_fptr count,
+                        void *context){
+
+  const obstring *instance = (obstring *)to_measure;
+
+  assert(to_measure != NULL);
+  assert(count != NULL);
+  OB_ASSERT_CLASS(to_measure, &obstring_class);
+
+  count(instance->str, sizeof(char)*(instance->length + 1), 0, context);
+
+  return;
+}
+
+
+const ob_class * obstring_class_descriptor(void){
+  return &obstring_class;
+}
+
 /* DEFINE ADDITIONAL PRIVATE METHODS HERE */
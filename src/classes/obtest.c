@@ -7,18 +7,22 @@
 #include "../../include/obtest.h"
 #include "../../include/private/obtest_private.h"
 
+/** class descriptor shared by all obtest instances */
+static const ob_class obtest_class = {
+  .classname = "obtest",
+  .size = sizeof(obtest),
+  .dealloc = &obtest_destroy,
+  .hash = &obtest_hash,
+  .compare = &obtest_compare,
+  .display = &obtest_display,
+  .traverse = NULL
+};
+
 /* PUBLIC METHODS */
 
 obtest * obtest_new(uint32_t id){
 
-  static const char classname[] = "obtest";
-
-  obtest *new_instance = malloc(sizeof(obtest));
-  assert(new_instance != NULL);
-
-  /*initialize reference counting base data*/
-  ob_init_base((obj *)new_instance, &obtest_destroy, &obtest_hash,
-               &obtest_compare, &obtest_display, classname);
+  obtest *new_instance = (obtest *)ob_alloc(&obtest_class);
 
   new_instance->id = id;
   return new_instance;
@@ -41,8 +45,8 @@ int8_t obtest_compare(const obj *a, const obj *b){
 
   assert(a != NULL);
   assert(b != NULL);
-  assert(ob_has_class(a, "obtest"));
-  assert(ob_has_class(b, "obtest"));
+  OB_ASSERT_CLASS(a, &obtest_class);
+  OB_ASSERT_CLASS(b, &obtest_class);
 
   if(((obtest *)a)->id >((obtest *)b)->id) return OB_GREATER_THAN;
   if(((obtest *)a)->id == ((obtest *)b)->id) return OB_EQUAL_TO;
@@ -51,7 +55,7 @@ int8_t obtest_compare(const obj *a, const obj *b){
 
 void obtest_display(const obj *test){
   assert(test != NULL);
-  assert(ob_has_class(test, "obtest"));
+  OB_ASSERT_CLASS(test, &obtest_class);
   fprintf(stderr, "Test ID: %u\n", ((obtest *)test)->id);
 }
 
@@ -6,39 +6,53 @@
 
 #include "../../include/obvector.h"
 #include "../../include/private/obvector_private.h"
+#include "../../include/private/offbrand_serial_private.h"
+#include "../../include/private/offbrand_optrace_private.h"
+
+/** class descriptor shared by all obvector instances */
+static const ob_class obvector_class = {
+  .classname = "obvector",
+  .size = sizeof(obvector),
+  .dealloc = &obvector_destroy,
+  .hash = &obvector_hash,
+  .compare = &obvector_compare,
+  .display = &obvector_display,
+  .traverse = &obvector_traverse,
+  .serialize = &obvector_serialize,
+  .deserialize = &obvector_deserialize,
+  .footprint = &obvector_footprint
+};
 
 /* PUBLIC METHODS */
 
 obvector * obvector_new(uint32_t initial_capacity){
 
-  uint32_t i, new_cap;
+  uint32_t new_cap;
 
   new_cap = 1;
   while(initial_capacity > new_cap) new_cap *= 2;
   if(new_cap > UINT32_MAX) new_cap = UINT32_MAX;
 
-  obvector *new_instance = obvector_create_default(new_cap);
-  for(i=0; i<new_cap; i++) new_instance->array[i] = NULL;
-
-  return new_instance;
+  return obvector_create_default(new_cap);
 }
 
 
 obvector * obvector_copy(const obvector *to_copy){
 
-  uint32_t i;
   obvector *new_vec;
 
   /* if there is nothing to copy, do nothing */
   assert(to_copy);
 
-  new_vec = obvector_create_default(to_copy->capacity);
+  /* share the element storage, it is copied only once either vector is
+   * modified */
+  new_vec = (obvector *)ob_alloc(&obvector_class);
+  atomic_fetch_add_explicit(&to_copy->storage->references, 1,
+                            memory_order_relaxed);
+  new_vec->storage = to_copy->storage;
+  new_vec->array = to_copy->array;
   new_vec->length = to_copy->length;
-
-  for(i=0; i<to_copy->capacity; i++){
-    ob_retain(to_copy->array[i]);
-    new_vec->array[i] = to_copy->array[i];
-  }
+  new_vec->capacity = to_copy->capacity;
 
   return new_vec;
 }
@@ -89,6 +103,38 @@ obj * obvector_obj_at_index(const obvector *v, int64_t index){
 }
 
 
+uint8_t obvector_cursor_begin(const obvector *v, ob_cursor *cursor){
+
+  assert(v != NULL);
+  assert(cursor != NULL);
+
+  cursor->container = (const obj *)v;
+  cursor->position = v->array;
+  cursor->index = 0;
+
+  return v->length > 0;
+}
+
+
+uint8_t obvector_cursor_next(ob_cursor *cursor){
+
+  assert(cursor != NULL);
+  OB_ASSERT_CLASS(cursor->container, &obvector_class);
+
+  if(cursor->index + 1 >= ((const obvector *)cursor->container)->length)
+    return 0;
+
+  cursor->index++;
+  return 1;
+}
+
+
+obj * obvector_cursor_get(const ob_cursor *cursor){
+  assert(cursor != NULL);
+  return ((obj * const *)cursor->position)[cursor->index];
+}
+
+
 void obvector_concat(obvector *destination, obvector *to_append){
 
   uint64_t i;
@@ -114,15 +160,23 @@ void obvector_concat(obvector *destination, obvector *to_append){
 
 
 uint8_t obvector_find_obj(const obvector *v, const obj *to_find){
+  return obvector_find_obj_with_funct(v, to_find, &ob_compare);
+}
+
+
+uint8_t obvector_find_obj_with_funct(const obvector *v, const obj *to_find,
+                                     ob_compare_fptr funct){
 
   uint32_t i;
 
   assert(v != NULL);
   assert(to_find != NULL);
+  assert(funct != NULL);
 
   for(i=0; i<v->length; i++){
-    /* if the object exists in the vector */
-    if(ob_compare(to_find, v->array[i]) == OB_EQUAL_TO){
+    /* if the object exists in the vector. Typed compare functions require
+     * instances, so empty slots are skipped */
+    if(v->array[i] && funct(to_find, v->array[i]) == OB_EQUAL_TO){
       return 1;
     }
   }
@@ -144,12 +198,17 @@ void obvector_sort_with_funct(obvector *v, int8_t order, ob_compare_fptr funct){
   assert(funct != NULL);
   assert(order == OB_LEAST_TO_GREATEST || order == OB_GREATEST_TO_LEAST);
 
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obvector_sort_with_funct", v, v->capacity);
+
+  obvector_own_storage(v);
   sorted = obvector_recursive_sort(v->array, v->capacity, order, funct);
 
-  free(v->array);
-  v->array = sorted;
+  memcpy(v->array, sorted, sizeof(obj *)*v->capacity);
+  free(sorted);
   v->length = obvector_find_valid_precursor(v->array, v->length-1) + 1;
 
+  OB_OP_TRACE(OB_OP_TRACE_END, "obvector_sort_with_funct", v, v->capacity);
+
   return;
 }
 
@@ -160,8 +219,18 @@ void obvector_clear(obvector *v){
 
   assert(v != NULL);
 
-  for(i=0; i<v->capacity; i++){
+  /* storage shared with copies is left to them */
+  if(atomic_load_explicit(&v->storage->references, memory_order_acquire) > 1){
+    obvector_release_storage(v->storage, v->capacity);
+    v->storage = obvector_new_storage(v->capacity);
+    v->array = v->storage->array;
+    v->length = 0;
+    return;
+  }
+
+  for(i=0; i<v->length; i++){
     ob_release(v->array[i]);
+    v->array[i] = NULL;
   }
 
   v->length = 0;
@@ -175,14 +244,7 @@ void obvector_clear(obvector *v){
 
 obvector * obvector_create_default(uint32_t initial_capacity){
 
-  static const char classname[] = "obvector";
-
-  obvector *new_instance = malloc(sizeof(obvector));
-  assert(new_instance != NULL);
-
-  /* initialize reference counting base data */
-  ob_init_base((obj *)new_instance, &obvector_destroy, &obvector_hash, &obvector_compare,
-           &obvector_display, classname);
+  obvector *new_instance = (obvector *)ob_alloc(&obvector_class);
 
   /* a vector with zero capacity cannot be created, create one with a capacity
    * of one */
@@ -190,8 +252,8 @@ obvector * obvector_create_default(uint32_t initial_capacity){
     initial_capacity = 1;
   }
 
-  new_instance->array = malloc(initial_capacity*sizeof(obj *));
-  assert(new_instance->array != NULL);
+  new_instance->storage = obvector_new_storage(initial_capacity);
+  new_instance->array = new_instance->storage->array;
 
   new_instance->capacity = initial_capacity;
   new_instance->length = 0;
@@ -200,30 +262,97 @@ obvector * obvector_create_default(uint32_t initial_capacity){
 }
 
 
-void obvector_resize(obvector *v, uint32_t index){
+obvector_storage * obvector_new_storage(uint32_t capacity){
+
+  obvector_storage *storage;
+
+  storage = malloc(sizeof(obvector_storage) + capacity*sizeof(obj *));
+  assert(storage != NULL);
+
+  atomic_init(&storage->references, 1);
+  memset(storage->array, 0, capacity*sizeof(obj *));
+
+  return storage;
+}
+
+
+void obvector_release_storage(obvector_storage *storage, uint32_t capacity){
+
+  uint32_t i;
+
+  /* the acquire-release decrement orders every use of the storage by other
+   * vectors before it is freed */
+  if(atomic_fetch_sub_explicit(&storage->references, 1,
+                               memory_order_acq_rel) > 1)
+    return;
+
+  for(i=0; i<capacity; i++) ob_release(storage->array[i]);
+  free(storage);
+
+  return;
+}
+
+
+void obvector_replace_storage(obvector *v, uint32_t capacity){
 
   uint32_t i;
+  obvector_storage *storage;
+
+  assert(capacity >= v->length);
+
+  storage = obvector_new_storage(capacity);
+
+  /* references held by unshared storage move with its elements */
+  if(atomic_load_explicit(&v->storage->references, memory_order_acquire) == 1){
+    memcpy(storage->array, v->array, sizeof(obj *)*v->length);
+    free(v->storage);
+  }
+  else{
+    for(i=0; i<v->length; i++)
+      storage->array[i] = ob_retain(v->array[i]);
+    obvector_release_storage(v->storage, v->capacity);
+  }
+
+  v->storage = storage;
+  v->array = storage->array;
+  v->capacity = capacity;
+
+  return;
+}
+
+
+void obvector_own_storage(obvector *v){
+
+  if(atomic_load_explicit(&v->storage->references, memory_order_acquire) == 1)
+    return;
+
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obvector_own_storage", v, v->length);
+  obvector_replace_storage(v, v->capacity);
+  OB_OP_TRACE(OB_OP_TRACE_END, "obvector_own_storage", v, v->length);
+
+  return;
+}
+
+
+void obvector_resize(obvector *v, uint32_t index){
+
   uint64_t new_cap;
-  obj **array;
 
   assert(index < UINT32_MAX);
 
-  if(index < v->capacity) return;
+  if(index < v->capacity){
+    obvector_own_storage(v);
+    return;
+  }
 
   /* find the next power of two capacity that can store the index */
   new_cap = v->capacity;
   while(index+1 > new_cap) new_cap *= 2;
   if(new_cap > UINT32_MAX) new_cap = UINT32_MAX;
 
-  array = malloc(new_cap*sizeof(obj *));
-
-  assert(array != NULL);
-  for(i=0; i<v->capacity; i++) array[i] = v->array[i];
-  for(i=v->capacity; i<new_cap; i++) array[i] = NULL;
-
-  free(v->array);
-  v->array = array;
-  v->capacity = new_cap;
+  OB_OP_TRACE(OB_OP_TRACE_BEGIN, "obvector_resize", v, v->length);
+  obvector_replace_storage(v, new_cap);
+  OB_OP_TRACE(OB_OP_TRACE_END, "obvector_resize", v, v->length);
 
   return;
 }
@@ -299,32 +428,16 @@ obj ** obvector_recursive_sort(obj **to_sort, uint32_t size, int8_t order,
 
 ob_hash_t obvector_hash(const obj *to_hash){
 
-  static int8_t init = 0;
-  static ob_hash_t seed;
-
   uint32_t i;
   ob_hash_t value;
   obvector *instance = (obvector *)to_hash;
 
   assert(to_hash);
-  assert(ob_has_class(to_hash, "obvector"));
-
-  if(init == 0){
-    srand(time(NULL));
-    seed = rand();
-    init = 1;
-  }
-
-  value = seed;
-  for(i=0; i<instance->length; i++){
-    value += ob_hash(instance->array[i]);
-    value += value << 10;
-    value ^= value >> 6;
-  }
+  OB_ASSERT_CLASS(to_hash, &obvector_class);
 
-  value += value << 3;
-  value ^= value >> 11;
-  value += value << 15;
+  value = ob_hash_seed();
+  for(i=0; i<instance->length; i++)
+    value = ob_hash_combine(value, ob_hash(instance->array[i]));
 
   return value;
 }
@@ -338,8 +451,8 @@ int8_t obvector_compare(const obj *a, const obj *b){
 
   assert(a);
   assert(b);
-  assert(ob_has_class(a, "obvector"));
-  assert(ob_has_class(b, "obvector"));
+  OB_ASSERT_CLASS(a, &obvector_class);
+  OB_ASSERT_CLASS(b, &obvector_class);
 
   if(comp_a->length != comp_b->length) return OB_NOT_EQUAL;
 
@@ -357,7 +470,7 @@ void obvector_display(const obj *to_print){
   obvector *v = (obvector *)to_print;
 
   assert(to_print != NULL);
-  assert(ob_has_class(to_print, "obvector"));
+  OB_ASSERT_CLASS(to_print, &obvector_class);
   fprintf(stderr, "obvector with %u elements\n", v->length);
 
   for(i=0; i<v->length; i++){
@@ -377,15 +490,104 @@ void obvector_destroy(obj *to_dealloc){
   obvector *instance = (obvector *)to_dealloc;
 
   assert(instance != NULL);
-  assert(ob_has_class(to_dealloc, "obvector"));
+  OB_ASSERT_CLASS(to_dealloc, &obvector_class);
+
+  /* ob_release all objs contained in vector, unless shared with a copy */
+  obvector_release_storage(instance->storage, instance->capacity);
+
+  return;
+}
+
+
+void obvector_traverse(const obj *to_traverse, ob_visit_fptr visit,
+                       void *context){
+
+  uint32_t i;
+  const obvector *instance = (obvector *)to_traverse;
+
+  assert(to_traverse != NULL);
+  assert(visit != NULL);
+  OB_ASSERT_CLASS(to_traverse, &obvector_class);
+
+  for(i=0; i<instance->length; i++)
+    if(instance->array[i]) visit(instance->array[i], context);
+
+  return;
+}
+
+
+void obvector_serialize(const obj *to_write, ob_writer *writer){
+
+  uint32_t i;
+  const obvector *instance = (obvector *)to_write;
+
+  assert(to_write != NULL);
+  OB_ASSERT_CLASS(to_write, &obvector_class);
+
+  ob_writer_write_varint(writer, instance->length);
+  for(i=0; i<instance->length; i++) ob_serialize(instance->array[i], writer);
+
+  return;
+}
+
+
+obj * obvector_deserialize(ob_reader *reader){
+
+  uint64_t i, length;
+  obj *element;
+  obvector *instance;
+
+  if(!ob_reader_read_varint(reader, &length)) return NULL;
+
+  if(length >= UINT32_MAX){
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  instance = obvector_new(length < OB_SERIAL_PRESIZE_LIMIT ?
+                          length : OB_SERIAL_PRESIZE_LIMIT);
+
+  for(i=0; i<length; i++){
+    element = ob_deserialize(reader);
+    if(ob_reader_failed(reader)){
+      ob_release((obj *)instance);
+      return NULL;
+    }
+    /* NULL elements are left as the empty slots of the new vector */
+    if(element){
+      obvector_store_at_index(instance, element, i);
+      ob_release(element);
+    }
+  }
+
+  return (obj *)instance;
+}
 
-  obvector_clear(instance); /* ob_release all objs contained in vector */
-  free(instance->array);
+
+void obvector_footprint(const obj *to_measure, ob_storage_fptr count,
+                        void *context){
+
+  const obvector *instance = (obvector *)to_measure;
+
+  assert(to_measure != NULL);
+  assert(count != NULL);
+  OB_ASSERT_CLASS(to_measure, &obvector_class);
+
+  /* storage shared with copies is reported at the same address, and counted
+   * once */
+  count(instance->storage, sizeof(obvector_storage) +
+        instance->capacity*sizeof(obj *),
+        (instance->capacity - instance->length)*sizeof(obj *), context);
 
   return;
 }
 
 
+const ob_class * obvector_class_descriptor(void){
+  return &obvector_class;
+}
+
+
 /* PRIVATE UTILITY METHODS */
 
 uint32_t obvector_find_valid_precursor(obj **array, uint32_t index){
@@ -0,0 +1,366 @@
+/**
+ * @file offbrand_alloc.c
+ * @brief Slab Allocator Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/obj_private.h"
+#include "../include/private/offbrand_alloc_private.h"
+#include "../include/private/offbrand_stats_private.h"
+#include "../include/private/offbrand_reftrace_private.h"
+#include "../include/private/offbrand_weak_private.h"
+
+/** free blocks cached by the calling thread */
+static _Thread_local ob_slab_cache slab_cache;
+/** arena entered by the calling thread, NULL if none */
+static _Thread_local ob_arena *active_arena = NULL;
+
+/** lock protecting the global free lists and chunk list */
+static pthread_mutex_t slab_lock = PTHREAD_MUTEX_INITIALIZER;
+/** global free blocks of each size class, shared by all threads */
+static ob_slab_block *slab_free_lists[OB_SLAB_NUM_CLASSES];
+/** every chunk ever allocated, linked through the first granule of each */
+static ob_slab_block *slab_chunks = NULL;
+
+/** key used to run ob_slab_thread_exit when a thread exits */
+static pthread_key_t slab_thread_key;
+/** ensures slab_thread_key is created once */
+static pthread_once_t slab_key_once = PTHREAD_ONCE_INIT;
+
+
+/* PUBLIC METHODS */
+
+obj * ob_alloc(const ob_class *cls){
+
+  obj *instance;
+  const void *caller = __builtin_return_address(0);
+
+  assert(cls != NULL);
+  assert(cls->size >= sizeof(obj));
+
+  if(active_arena){
+    instance = ob_arena_alloc(active_arena, cls->size);
+    ob_init_instance(instance, cls, caller);
+    instance->flags |= OB_FLAG_ARENA;
+    return instance;
+  }
+
+  if((instance = ob_slab_alloc(cls->size))){
+    ob_init_instance(instance, cls, caller);
+    instance->flags |= OB_FLAG_SLAB;
+    return instance;
+  }
+
+  instance = malloc(cls->size);
+  assert(instance != NULL);
+  ob_init_instance(instance, cls, caller);
+
+  return instance;
+}
+
+
+ob_arena * ob_arena_new(void){
+
+  ob_arena *new_instance = malloc(sizeof(ob_arena));
+  assert(new_instance != NULL);
+
+  new_instance->chunks = NULL;
+  new_instance->end = NULL;
+  new_instance->previous = NULL;
+  new_instance->entered = 0;
+
+  return new_instance;
+}
+
+
+void ob_arena_enter(ob_arena *arena){
+
+  assert(arena != NULL);
+  assert(!arena->entered);
+
+  arena->previous = active_arena;
+  arena->entered = 1;
+  active_arena = arena;
+
+  return;
+}
+
+
+void ob_arena_exit(void){
+
+  ob_arena *arena = active_arena;
+
+  assert(arena != NULL);
+
+  active_arena = arena->previous;
+  arena->previous = NULL;
+  arena->entered = 0;
+
+  return;
+}
+
+
+void ob_arena_destroy(ob_arena *arena){
+
+  ob_arena_chunk *chunk, *next;
+  char *pos;
+  obj *instance;
+
+  assert(arena != NULL);
+  assert(!arena->entered);
+
+  /* run every deallocator before freeing any chunk, deallocators release the
+   * arena instances they reference, which must still be readable */
+  for(chunk = arena->chunks; chunk; chunk = chunk->next){
+
+    pos = (char *)chunk + OB_ARENA_HEADER_SIZE;
+    while(pos < chunk->used_end){
+
+      instance = (obj *)pos;
+      if(atomic_load_explicit(&instance->weak, memory_order_relaxed))
+        ob_weak_clear(instance);
+      if(!(instance->flags & OB_FLAG_ESCAPED) && instance->cls->dealloc)
+        instance->cls->dealloc(instance);
+      ob_stats_record_free(instance->cls);
+      OB_REF_TRACE(OB_REF_TRACE_DEALLOC, instance, instance->cls, 0, NULL);
+
+      pos += (instance->cls->size + OB_SLAB_GRANULE - 1)/OB_SLAB_GRANULE
+             * OB_SLAB_GRANULE;
+    }
+  }
+
+  for(chunk = arena->chunks; chunk; chunk = next){
+    next = chunk->next;
+    free(chunk);
+  }
+
+  free(arena);
+
+  return;
+}
+
+
+obj * ob_arena_copy_out(obj *instance){
+
+  obj *copy;
+
+  assert(instance != NULL);
+
+  if(!(instance->flags & OB_FLAG_ARENA)) return ob_retain(instance);
+
+  assert(!(instance->flags & OB_FLAG_ESCAPED));
+
+  copy = ob_alloc_outside_arena(instance->cls);
+
+  /* move all class data following the obj base, the arena instance is no
+   * longer responsible for deallocating it */
+  memcpy((char *)copy + sizeof(obj), (char *)instance + sizeof(obj),
+         instance->cls->size - sizeof(obj));
+  instance->flags |= OB_FLAG_ESCAPED;
+
+#ifndef NDEBUG
+  if(copy->cls->traverse)
+    copy->cls->traverse(copy, &ob_arena_check_child, NULL);
+#endif
+
+  return copy;
+}
+
+
+/* PRIVATE METHODS */
+
+obj * ob_alloc_outside_arena(const ob_class *cls){
+
+  obj *instance;
+  ob_arena *arena = active_arena;
+
+  active_arena = NULL;
+  instance = ob_alloc(cls);
+  active_arena = arena;
+
+  return instance;
+}
+
+
+/** creates the thread exit key, called once through pthread_once */
+static void ob_slab_create_key(void){
+  pthread_key_create(&slab_thread_key, &ob_slab_thread_exit);
+}
+
+
+void * ob_slab_alloc(size_t size){
+
+#ifdef OB_NO_SLAB
+  (void)size;
+  return NULL;
+#else
+
+  uint32_t size_class;
+  ob_slab_block *block;
+  ob_slab_cache *cache = &slab_cache;
+
+  if(size > OB_SLAB_MAX_SIZE) return NULL;
+
+  size_class = (size + OB_SLAB_GRANULE - 1)/OB_SLAB_GRANULE - 1;
+
+  if(!cache->free_lists[size_class]) ob_slab_refill(cache, size_class);
+
+  block = cache->free_lists[size_class];
+  cache->free_lists[size_class] = block->next;
+  cache->counts[size_class]--;
+
+  return block;
+#endif
+}
+
+
+void ob_slab_free(void *block, size_t size){
+
+  uint32_t size_class;
+  ob_slab_block *freed = block;
+  ob_slab_cache *cache = &slab_cache;
+
+  assert(block != NULL);
+  assert(size <= OB_SLAB_MAX_SIZE);
+
+  size_class = (size + OB_SLAB_GRANULE - 1)/OB_SLAB_GRANULE - 1;
+
+  freed->next = cache->free_lists[size_class];
+  cache->free_lists[size_class] = freed;
+
+  /* keep thread caches bounded, threads that only free objs allocated by
+   * other threads would otherwise hoard blocks */
+  if(++cache->counts[size_class] >= 2*OB_SLAB_BATCH)
+    ob_slab_flush(cache, size_class, OB_SLAB_BATCH);
+
+  return;
+}
+
+
+void ob_slab_refill(ob_slab_cache *cache, uint32_t size_class){
+
+  uint32_t i;
+  size_t block_size;
+  char *chunk, *pos;
+  ob_slab_block *block;
+
+  /* register exit handler so blocks cached by this thread are not lost */
+  if(!cache->registered){
+    pthread_once(&slab_key_once, &ob_slab_create_key);
+    pthread_setspecific(slab_thread_key, cache);
+    cache->registered = 1;
+  }
+
+  pthread_mutex_lock(&slab_lock);
+
+  /* carve a new chunk into the global list if no free blocks remain, the first
+   * granule of the chunk links it into the chunk list */
+  if(!slab_free_lists[size_class]){
+
+    chunk = malloc(OB_SLAB_CHUNK_SIZE);
+    assert(chunk != NULL);
+
+    ((ob_slab_block *)chunk)->next = slab_chunks;
+    slab_chunks = (ob_slab_block *)chunk;
+
+    block_size = (size_class+1)*OB_SLAB_GRANULE;
+    for(pos = chunk + OB_SLAB_GRANULE;
+        pos + block_size <= chunk + OB_SLAB_CHUNK_SIZE; pos += block_size){
+      block = (ob_slab_block *)pos;
+      block->next = slab_free_lists[size_class];
+      slab_free_lists[size_class] = block;
+    }
+  }
+
+  for(i=0; i<OB_SLAB_BATCH && slab_free_lists[size_class]; i++){
+    block = slab_free_lists[size_class];
+    slab_free_lists[size_class] = block->next;
+    block->next = cache->free_lists[size_class];
+    cache->free_lists[size_class] = block;
+  }
+  cache->counts[size_class] += i;
+
+  pthread_mutex_unlock(&slab_lock);
+
+  return;
+}
+
+
+void ob_slab_flush(ob_slab_cache *cache, uint32_t size_class, uint32_t count){
+
+  uint32_t i;
+  ob_slab_block *first, *last;
+
+  if(!cache->free_lists[size_class] || count == 0) return;
+
+  /* detach up to count blocks from the head of the cached list */
+  first = last = cache->free_lists[size_class];
+  for(i=1; i<count && last->next; i++) last = last->next;
+
+  cache->free_lists[size_class] = last->next;
+  cache->counts[size_class] -= i;
+
+  pthread_mutex_lock(&slab_lock);
+  last->next = slab_free_lists[size_class];
+  slab_free_lists[size_class] = first;
+  pthread_mutex_unlock(&slab_lock);
+
+  return;
+}
+
+
+void * ob_arena_alloc(ob_arena *arena, size_t size){
+
+  size_t chunk_size;
+  ob_arena_chunk *chunk;
+  char *block;
+
+  size = (size + OB_SLAB_GRANULE - 1)/OB_SLAB_GRANULE*OB_SLAB_GRANULE;
+
+  /* start a new chunk when the current one is full, instances larger than a
+   * chunk are given a chunk of their own */
+  if(!arena->chunks || arena->chunks->used_end + size > arena->end){
+
+    chunk_size = OB_ARENA_HEADER_SIZE + size;
+    if(chunk_size < OB_ARENA_CHUNK_SIZE) chunk_size = OB_ARENA_CHUNK_SIZE;
+
+    chunk = malloc(chunk_size);
+    assert(chunk != NULL);
+
+    chunk->next = arena->chunks;
+    chunk->used_end = (char *)chunk + OB_ARENA_HEADER_SIZE;
+    arena->chunks = chunk;
+    arena->end = (char *)chunk + chunk_size;
+  }
+
+  block = arena->chunks->used_end;
+  arena->chunks->used_end += size;
+
+  return block;
+}
+
+
+void ob_arena_check_child(obj *child, void *context){
+
+  (void)child;
+  (void)context;
+
+  assert(!(child->flags & OB_FLAG_ARENA));
+
+  return;
+}
+
+
+void ob_slab_thread_exit(void *cache){
+
+  uint32_t i;
+  ob_slab_cache *exiting = cache;
+
+  for(i=0; i<OB_SLAB_NUM_CLASSES; i++)
+    ob_slab_flush(exiting, i, exiting->counts[i]);
+
+  exiting->registered = 0;
+
+  return;
+}
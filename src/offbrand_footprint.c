@@ -0,0 +1,147 @@
+/**
+ * @file offbrand_footprint.c
+ * @brief Memory Footprint Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/obj_private.h"
+#include "../include/private/offbrand_hash_private.h"
+#include "../include/private/offbrand_footprint_private.h"
+
+
+/* PUBLIC METHODS */
+
+void ob_memory_footprint(const obj *instance, ob_footprint *footprint){
+
+  obj *current;
+  ob_footprint_walk walk;
+
+  assert(footprint != NULL);
+
+  memset(footprint, 0, sizeof(ob_footprint));
+
+  walk.footprint = footprint;
+  walk.seen_capacity = OB_FOOTPRINT_INITIAL_CAPACITY;
+  walk.seen_count = 0;
+  walk.seen = calloc(walk.seen_capacity, sizeof(void *));
+  assert(walk.seen != NULL);
+  walk.pending_length = 0;
+  walk.pending_capacity = OB_FOOTPRINT_INITIAL_PENDING;
+  walk.pending = malloc(sizeof(obj *)*walk.pending_capacity);
+  assert(walk.pending != NULL);
+
+  /* the measured instance is only read, the work list holds it as any other
+   * instance */
+  ob_footprint_count_obj((obj *)instance, &walk);
+
+  while(walk.pending_length > 0){
+
+    current = walk.pending[--walk.pending_length];
+
+    if(current->cls->footprint)
+      current->cls->footprint(current, &ob_footprint_count_storage, &walk);
+
+    /* the measured instance is taken first, so far only its struct and
+     * storage are counted */
+    if(current == instance) footprint->shallow_bytes = footprint->deep_bytes;
+
+    if(current->cls->traverse)
+      current->cls->traverse(current, &ob_footprint_count_obj, &walk);
+  }
+
+  free(walk.pending);
+  free(walk.seen);
+
+  return;
+}
+
+
+/* PRIVATE METHODS */
+
+uint8_t ob_footprint_mark(ob_footprint_walk *walk, const void *address){
+
+  uint64_t slot, mask;
+
+  /* grow at half full, keeping probe sequences short */
+  if(walk->seen_count + 1 > walk->seen_capacity/2) ob_footprint_grow(walk);
+
+  mask = walk->seen_capacity - 1;
+  slot = ob_hash_finalize((uint64_t)(uintptr_t)address) & mask;
+
+  while(walk->seen[slot]){
+    if(walk->seen[slot] == address) return 0;
+    slot = (slot + 1) & mask;
+  }
+
+  walk->seen[slot] = address;
+  walk->seen_count++;
+
+  return 1;
+}
+
+
+void ob_footprint_grow(ob_footprint_walk *walk){
+
+  uint64_t i, slot, mask, capacity;
+  const void **seen;
+
+  capacity = walk->seen_capacity;
+  seen = walk->seen;
+
+  walk->seen_capacity = capacity*2;
+  walk->seen = calloc(walk->seen_capacity, sizeof(void *));
+  assert(walk->seen != NULL);
+
+  mask = walk->seen_capacity - 1;
+  for(i=0; i<capacity; i++){
+    if(!seen[i]) continue;
+    slot = ob_hash_finalize((uint64_t)(uintptr_t)seen[i]) & mask;
+    while(walk->seen[slot]) slot = (slot + 1) & mask;
+    walk->seen[slot] = seen[i];
+  }
+
+  free(seen);
+
+  return;
+}
+
+
+void ob_footprint_count_storage(const void *block, size_t size, size_t unused,
+                                void *walk){
+
+  ob_footprint_walk *state = walk;
+
+  assert(unused <= size);
+
+  if(!block || !ob_footprint_mark(state, block)) return;
+
+  state->footprint->deep_bytes += size;
+  state->footprint->unused_bytes += unused;
+
+  return;
+}
+
+
+void ob_footprint_count_obj(obj *instance, void *walk){
+
+  ob_footprint_walk *state = walk;
+
+  /* immortal instances are static, and reference no mortal instances */
+  if(!instance || (instance->flags & OB_FLAG_IMMORTAL)) return;
+  if(!ob_footprint_mark(state, instance)) return;
+
+  state->footprint->deep_bytes += instance->cls->size;
+  state->footprint->objs++;
+
+  if(state->pending_length == state->pending_capacity){
+    state->pending_capacity *= 2;
+    state->pending = realloc(state->pending,
+                             sizeof(obj *)*state->pending_capacity);
+    assert(state->pending != NULL);
+  }
+
+  state->pending[state->pending_length++] = instance;
+
+  return;
+}
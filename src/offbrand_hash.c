@@ -0,0 +1,100 @@
+/**
+ * @file offbrand_hash.c
+ * @brief Hashing Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/offbrand_hash_private.h"
+
+/** process wide seed of all hashes */
+static ob_hash_t hash_seed = 0;
+/** non-zero if the seed was set by ob_set_hash_seed */
+static uint8_t hash_seed_fixed = 0;
+/** ensures hash_seed is initialized once */
+static pthread_once_t hash_seed_once = PTHREAD_ONCE_INIT;
+
+
+/* PUBLIC METHODS */
+
+ob_hash_t ob_hash_seed(void){
+  pthread_once(&hash_seed_once, &ob_hash_init_seed);
+  return hash_seed;
+}
+
+
+void ob_set_hash_seed(ob_hash_t seed){
+  hash_seed = seed;
+  hash_seed_fixed = 1;
+}
+
+
+ob_hash_t ob_hash_bytes(const void *bytes, size_t length){
+  return ob_hash_bytes_seeded(bytes, length, ob_hash_seed());
+}
+
+
+ob_hash_t ob_hash_combine(ob_hash_t value, ob_hash_t element){
+  return (ob_hash_t)ob_hash_finalize((uint64_t)value*OB_HASH_K1 + element);
+}
+
+
+/* PRIVATE METHODS */
+
+ob_hash_t ob_hash_bytes_seeded(const void *bytes, size_t length,
+                               ob_hash_t seed){
+
+  const unsigned char *pos = bytes;
+  uint64_t value, word;
+
+  assert(bytes != NULL || length == 0);
+
+  value = (uint64_t)seed ^ (length * OB_HASH_K1);
+
+  /* consume whole 64 bit words, then the remaining bytes as a zero padded
+   * word, memcpy avoids unaligned loads */
+  while(length >= sizeof(uint64_t)){
+    memcpy(&word, pos, sizeof(uint64_t));
+    value ^= ob_hash_mix_word(word);
+    value = OB_HASH_ROTL(value, 27)*5 + OB_HASH_K3;
+    pos += sizeof(uint64_t);
+    length -= sizeof(uint64_t);
+  }
+
+  if(length > 0){
+    word = 0;
+    memcpy(&word, pos, length);
+    value ^= ob_hash_mix_word(word);
+  }
+
+  return (ob_hash_t)ob_hash_finalize(value);
+}
+
+
+void ob_hash_init_seed(void){
+
+  if(hash_seed_fixed) return;
+
+  /* mix the time with a static address, which differs between runs under
+   * address space randomization */
+  hash_seed = (ob_hash_t)ob_hash_finalize((uint64_t)time(NULL) ^
+                                          (uint64_t)(uintptr_t)&hash_seed);
+}
+
+
+uint64_t ob_hash_mix_word(uint64_t word){
+  word *= OB_HASH_K1;
+  word = OB_HASH_ROTL(word, 31);
+  word *= OB_HASH_K2;
+  return word;
+}
+
+
+uint64_t ob_hash_finalize(uint64_t value){
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+  return value;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file offbrand_optrace.c
+ * @brief Operation Tracing Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/offbrand_optrace_private.h"
+
+_Atomic(ob_op_trace_fptr) ob_op_trace_hook = NULL;
+
+/** context pointer passed to ob_op_trace_hook */
+static _Atomic(void *) op_trace_context = NULL;
+/** non-zero while the calling thread runs the hook */
+static _Thread_local uint8_t in_hook = 0;
+
+
+/* PUBLIC METHODS */
+
+void ob_set_op_trace_hook(ob_op_trace_fptr hook, void *context){
+
+  /* the context is published before the hook it belongs to */
+  atomic_store_explicit(&op_trace_context, context, memory_order_relaxed);
+  atomic_store_explicit(&ob_op_trace_hook, hook, memory_order_release);
+
+  return;
+}
+
+
+/* PRIVATE METHODS */
+
+void ob_op_trace_emit(uint8_t phase, const char *operation,
+                      const obj *instance, uint64_t size){
+
+  ob_op_trace_fptr hook;
+  ob_op_trace_event event;
+  struct timespec now;
+
+  if(in_hook) return;
+
+  hook = atomic_load_explicit(&ob_op_trace_hook, memory_order_acquire);
+  if(!hook) return;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  event.operation = operation;
+  event.instance = instance;
+  event.size = size;
+  event.timestamp_ns = (uint64_t)now.tv_sec*1000000000ULL + now.tv_nsec;
+  event.phase = phase;
+
+  in_hook = 1;
+  hook(&event, atomic_load_explicit(&op_trace_context, memory_order_relaxed));
+  in_hook = 0;
+
+  return;
+}
@@ -0,0 +1,364 @@
+/**
+ * @file offbrand_pool.c
+ * @brief Work Stealing Thread Pool Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/offbrand_pool_private.h"
+
+/** worker of the calling thread, NULL outside of any pool */
+static _Thread_local ob_pool_worker *current_worker = NULL;
+/** pool used when no pool is given, created on first use */
+static ob_pool *default_pool = NULL;
+/** ensures default_pool is created once */
+static pthread_once_t default_pool_once = PTHREAD_ONCE_INIT;
+
+
+/* PUBLIC METHODS */
+
+ob_pool * ob_pool_new(uint32_t threads){
+
+  uint32_t i;
+  int result;
+  long online;
+  ob_pool *pool;
+
+  if(threads == 0){
+    online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (uint32_t)online : 1;
+  }
+
+  pool = malloc(sizeof(ob_pool));
+  assert(pool != NULL);
+
+  /* the thread waiting for a call to complete runs tasks too, so one thread
+   * fewer is started */
+  pool->threads = threads;
+  pool->worker_count = threads - 1;
+  atomic_init(&pool->queued, 0);
+  atomic_init(&pool->sleeping, 0);
+  pool->shutdown = 0;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+
+  pool->deques = malloc(sizeof(ob_pool_deque)*(pool->worker_count + 1));
+  assert(pool->deques != NULL);
+
+  for(i=0; i<=pool->worker_count; i++){
+    pthread_mutex_init(&pool->deques[i].lock, NULL);
+    pool->deques[i].capacity = OB_POOL_INITIAL_CAPACITY;
+    pool->deques[i].tasks = malloc(sizeof(ob_pool_task)*
+                                   OB_POOL_INITIAL_CAPACITY);
+    assert(pool->deques[i].tasks != NULL);
+    pool->deques[i].top = 0;
+    pool->deques[i].bottom = 0;
+  }
+
+  pool->workers = malloc(sizeof(ob_pool_worker)*pool->worker_count);
+  /* a pool of one thread has no workers, and malloc(0) may return NULL */
+  assert(pool->workers != NULL || pool->worker_count == 0);
+
+  for(i=0; i<pool->worker_count; i++){
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+    result = pthread_create(&pool->workers[i].thread, NULL,
+                            &ob_pool_worker_main, &pool->workers[i]);
+    /* tasks pushed to the deque of a missing worker would only run when
+     * stolen, so the pool cannot start without it, even under NDEBUG */
+    if(result != 0) abort();
+  }
+
+  return pool;
+}
+
+
+void ob_pool_destroy(ob_pool *pool){
+
+  uint32_t i;
+
+  assert(pool != NULL);
+  assert(pool != default_pool); /* the default pool lives until exit */
+  assert(!current_worker || current_worker->pool != pool);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for(i=0; i<pool->worker_count; i++)
+    pthread_join(pool->workers[i].thread, NULL);
+
+  for(i=0; i<=pool->worker_count; i++){
+    pthread_mutex_destroy(&pool->deques[i].lock);
+    free(pool->deques[i].tasks);
+  }
+
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->workers);
+  free(pool->deques);
+  free(pool);
+
+  return;
+}
+
+
+ob_pool * ob_pool_default(void){
+  pthread_once(&default_pool_once, &ob_pool_init_default);
+  return default_pool;
+}
+
+
+uint32_t ob_pool_threads(const ob_pool *pool){
+  if(!pool) pool = ob_pool_default();
+  return pool->threads;
+}
+
+
+void ob_parallel_for(ob_pool *pool, uint64_t begin, uint64_t end,
+                     uint64_t grain, ob_range_fptr body, void *context){
+
+  uint32_t home;
+  uint64_t part;
+  ob_pool_join join;
+  ob_pool_task task;
+
+  assert(body != NULL);
+
+  if(begin >= end) return;
+  if(!pool) pool = ob_pool_default();
+
+  if(grain == 0){
+    grain = (end - begin)/((uint64_t)pool->threads*OB_POOL_CHUNKS_PER_THREAD);
+    if(grain == 0) grain = 1;
+  }
+
+  /* serial pools run the chunks in order on the calling thread */
+  if(pool->threads == 1){
+    for(; begin < end; begin += part){
+      part = end - begin < grain ? end - begin : grain;
+      body(begin, begin + part, context);
+    }
+    return;
+  }
+
+  atomic_init(&join.pending, 1);
+  task.task = NULL;
+  task.body = body;
+  task.context = context;
+  task.begin = begin;
+  task.end = end;
+  task.grain = grain;
+  task.join = &join;
+
+  home = ob_pool_home(pool);
+  ob_pool_run(pool, home, &task);
+  ob_pool_wait(pool, home, &join);
+
+  return;
+}
+
+
+void ob_parallel_invoke(ob_pool *pool, ob_task_fptr first, void *first_context,
+                        ob_task_fptr second, void *second_context){
+
+  uint32_t home;
+  ob_pool_join join;
+  ob_pool_task task;
+
+  assert(first != NULL);
+  assert(second != NULL);
+
+  if(!pool) pool = ob_pool_default();
+
+  if(pool->threads == 1){
+    first(first_context);
+    second(second_context);
+    return;
+  }
+
+  /* fork the second function for another thread to steal, run the first */
+  atomic_init(&join.pending, 1);
+  task.task = second;
+  task.body = NULL;
+  task.context = second_context;
+  task.join = &join;
+
+  home = ob_pool_home(pool);
+  ob_pool_push(pool, home, &task);
+  first(first_context);
+  ob_pool_wait(pool, home, &join);
+
+  return;
+}
+
+
+/* PRIVATE METHODS */
+
+void * ob_pool_worker_main(void *arg){
+
+  ob_pool_worker *worker = arg;
+  ob_pool *pool = worker->pool;
+  ob_pool_task task;
+
+  current_worker = worker;
+
+  for(;;){
+
+    if(ob_pool_take(pool, worker->index, &task)){
+      ob_pool_run(pool, worker->index, &task);
+      continue;
+    }
+
+    /* announcing the sleep before checking for tasks pairs with pushers
+     * counting the task before checking for sleepers, so either the pusher
+     * signals or this worker sees the task */
+    pthread_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->sleeping, 1);
+    while(atomic_load(&pool->queued) == 0 && !pool->shutdown)
+      pthread_cond_wait(&pool->wake, &pool->lock);
+    atomic_fetch_sub(&pool->sleeping, 1);
+
+    if(pool->shutdown){
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  current_worker = NULL;
+
+  return NULL;
+}
+
+
+void ob_pool_init_default(void){
+
+  unsigned long threads = 0;
+  const char *variable;
+
+  if((variable = getenv(OB_POOL_THREADS_VARIABLE)))
+    threads = strtoul(variable, NULL, 10);
+  if(threads > UINT32_MAX) threads = 0;
+
+  default_pool = ob_pool_new((uint32_t)threads);
+}
+
+
+uint32_t ob_pool_home(const ob_pool *pool){
+
+  if(current_worker && current_worker->pool == pool)
+    return current_worker->index;
+
+  return pool->worker_count;
+}
+
+
+void ob_pool_push(ob_pool *pool, uint32_t home, const ob_pool_task *task){
+
+  uint64_t i;
+  ob_pool_task *tasks;
+  ob_pool_deque *deque = pool->deques + home;
+
+  pthread_mutex_lock(&deque->lock);
+
+  if(deque->bottom - deque->top == deque->capacity){
+    tasks = malloc(sizeof(ob_pool_task)*deque->capacity*2);
+    assert(tasks != NULL);
+    for(i=deque->top; i<deque->bottom; i++)
+      tasks[i & (deque->capacity*2 - 1)] =
+        deque->tasks[i & (deque->capacity - 1)];
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->capacity *= 2;
+  }
+
+  deque->tasks[deque->bottom & (deque->capacity - 1)] = *task;
+  deque->bottom++;
+
+  pthread_mutex_unlock(&deque->lock);
+
+  atomic_fetch_add(&pool->queued, 1);
+  if(atomic_load(&pool->sleeping) > 0){
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  return;
+}
+
+
+uint8_t ob_pool_take(ob_pool *pool, uint32_t home, ob_pool_task *task){
+
+  uint32_t i, victim;
+  ob_pool_deque *deque;
+
+  if(atomic_load_explicit(&pool->queued, memory_order_relaxed) == 0) return 0;
+
+  /* pop the newest task of the own deque, then steal the oldest task of the
+   * others, starting after the own deque to spread thieves over victims */
+  for(i=0; i<=pool->worker_count; i++){
+
+    victim = (home + i) % (pool->worker_count + 1);
+    deque = pool->deques + victim;
+
+    pthread_mutex_lock(&deque->lock);
+    if(deque->top != deque->bottom){
+      if(i == 0){
+        deque->bottom--;
+        *task = deque->tasks[deque->bottom & (deque->capacity - 1)];
+      }
+      else{
+        *task = deque->tasks[deque->top & (deque->capacity - 1)];
+        deque->top++;
+      }
+      pthread_mutex_unlock(&deque->lock);
+      atomic_fetch_sub(&pool->queued, 1);
+      return 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+  }
+
+  return 0;
+}
+
+
+void ob_pool_run(ob_pool *pool, uint32_t home, ob_pool_task *task){
+
+  ob_pool_task fork;
+
+  if(task->task) task->task(task->context);
+  else{
+    /* fork upper halves, largest first so that thieves take large ranges,
+     * and run the remaining lower part */
+    while(task->end - task->begin > task->grain){
+      fork = *task;
+      fork.begin = task->begin + (task->end - task->begin)/2;
+      task->end = fork.begin;
+      atomic_fetch_add_explicit(&task->join->pending, 1,
+                                memory_order_relaxed);
+      ob_pool_push(pool, home, &fork);
+    }
+    task->body(task->begin, task->end, task->context);
+  }
+
+  /* releases the effects of the task to the thread waiting on the join */
+  atomic_fetch_sub_explicit(&task->join->pending, 1, memory_order_release);
+
+  return;
+}
+
+
+void ob_pool_wait(ob_pool *pool, uint32_t home, ob_pool_join *join){
+
+  ob_pool_task task;
+
+  while(atomic_load_explicit(&join->pending, memory_order_acquire) > 0){
+    if(ob_pool_take(pool, home, &task)) ob_pool_run(pool, home, &task);
+    else sched_yield();
+  }
+
+  return;
+}
@@ -0,0 +1,246 @@
+/**
+ * @file offbrand_reftrace.c
+ * @brief Reference Count Tracing Implementation
+ * @author theck
+ */
+
+#define _GNU_SOURCE /* dladdr */
+#include <dlfcn.h>
+#include "../include/offbrand.h"
+#include "../include/private/obj_private.h"
+#include "../include/private/offbrand_reftrace_private.h"
+
+/** names of each event type, indexed by OB_REF_TRACE_* */
+static const char *event_names[] = {"alloc", "retain", "release", "dealloc"};
+
+_Atomic uint8_t ob_ref_trace_enabled = 0;
+
+/** ring buffer of the calling thread, NULL until its first event */
+static _Thread_local ob_ref_trace_buffer *trace_buffer = NULL;
+/** every buffer ever created, protected by trace_lock */
+static ob_ref_trace_buffer *trace_buffers = NULL;
+/** lock protecting the list of buffers */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* PUBLIC METHODS */
+
+void ob_start_ref_trace(void){
+  atomic_store_explicit(&ob_ref_trace_enabled, 1, memory_order_relaxed);
+}
+
+
+void ob_stop_ref_trace(void){
+  atomic_store_explicit(&ob_ref_trace_enabled, 0, memory_order_relaxed);
+}
+
+
+void ob_clear_ref_trace(void){
+
+  ob_ref_trace_buffer *buffer;
+
+  pthread_mutex_lock(&trace_lock);
+  for(buffer = trace_buffers; buffer; buffer = buffer->next)
+    atomic_store_explicit(&buffer->recorded, 0, memory_order_relaxed);
+  pthread_mutex_unlock(&trace_lock);
+
+  return;
+}
+
+
+void ob_print_ref_trace_report(FILE *out, uint32_t max_lines){
+
+  uint64_t i, j, count, num_sites, lines;
+  int64_t live;
+  const void *alloc_site;
+  ob_ref_trace_event *events, *sites;
+
+  assert(out != NULL);
+
+  events = ob_ref_trace_collect(&count);
+  fprintf(out, "Reference trace: %llu events\n", (unsigned long long)count);
+
+  /* group events by call site, keeping one event per site with the number of
+   * events at the site in place of its reference count */
+  qsort(events, count, sizeof(ob_ref_trace_event), &ob_ref_trace_compare_site);
+
+  sites = malloc(sizeof(ob_ref_trace_event)*(count ? count : 1));
+  assert(sites != NULL);
+
+  for(i=0, num_sites=0; i<count; i=j){
+    for(j=i+1; j<count && ob_ref_trace_compare_site(&events[i], &events[j]) == 0;
+        j++);
+    sites[num_sites] = events[i];
+    sites[num_sites++].count = (ob_ref_count_t)(j-i);
+  }
+
+  qsort(sites, num_sites, sizeof(ob_ref_trace_event),
+        &ob_ref_trace_compare_frequency);
+
+  fprintf(out, "\nHottest call sites:\n%12s %-8s %-20s %s\n", "events",
+          "event", "class", "caller");
+  for(i=0; i<num_sites && i<max_lines; i++){
+    fprintf(out, "%12llu %-8s %-20s ", (unsigned long long)sites[i].count,
+            event_names[sites[i].type], sites[i].cls->classname);
+    ob_ref_trace_print_site(out, sites[i].caller);
+  }
+
+  free(sites);
+
+  /* instances allocated more often than deallocated within the trace window
+   * are still live, and possibly leaked */
+  qsort(events, count, sizeof(ob_ref_trace_event),
+        &ob_ref_trace_compare_instance);
+
+  fprintf(out, "\nInstances live at end of trace:\n%-18s %-20s %s\n",
+          "instance", "class", "allocated by");
+  for(i=0, lines=0; i<count && lines<max_lines; i=j){
+
+    live = 0;
+    alloc_site = NULL;
+    for(j=i; j<count && events[j].instance == events[i].instance; j++){
+      if(events[j].type == OB_REF_TRACE_ALLOC){
+        live++;
+        alloc_site = events[j].caller;
+      }
+      else if(events[j].type == OB_REF_TRACE_DEALLOC) live--;
+    }
+
+    if(live > 0){
+      fprintf(out, "%-18p %-20s ", (void *)events[i].instance,
+              events[i].cls->classname);
+      ob_ref_trace_print_site(out, alloc_site);
+      lines++;
+    }
+  }
+
+  fprintf(out, "\nResolve caller offsets with addr2line -f -e <object>\n");
+
+  free(events);
+
+  return;
+}
+
+
+/* PRIVATE METHODS */
+
+void ob_ref_trace_record(uint8_t type, const obj *instance,
+                         const ob_class *cls, ob_ref_count_t count,
+                         const void *caller){
+
+  uint64_t recorded;
+  ob_ref_trace_event *event;
+  ob_ref_trace_buffer *buffer = trace_buffer;
+
+  if(!buffer){
+    buffer = malloc(sizeof(ob_ref_trace_buffer));
+    assert(buffer != NULL);
+    atomic_init(&buffer->recorded, 0);
+
+    pthread_mutex_lock(&trace_lock);
+    buffer->next = trace_buffers;
+    trace_buffers = buffer;
+    pthread_mutex_unlock(&trace_lock);
+
+    trace_buffer = buffer;
+  }
+
+  /* only this thread writes the buffer, no read-modify-write is needed */
+  recorded = atomic_load_explicit(&buffer->recorded, memory_order_relaxed);
+  event = &buffer->events[recorded & (OB_REF_TRACE_CAPACITY-1)];
+
+  event->instance = instance;
+  event->cls = cls;
+  event->caller = caller;
+  event->count = count;
+  event->type = type;
+
+  atomic_store_explicit(&buffer->recorded, recorded+1, memory_order_release);
+
+  return;
+}
+
+
+ob_ref_trace_event * ob_ref_trace_collect(uint64_t *count){
+
+  uint64_t recorded, held, total = 0;
+  ob_ref_trace_buffer *buffer;
+  ob_ref_trace_event *events;
+
+  pthread_mutex_lock(&trace_lock);
+
+  for(buffer = trace_buffers; buffer; buffer = buffer->next){
+    recorded = atomic_load_explicit(&buffer->recorded, memory_order_acquire);
+    total += recorded < OB_REF_TRACE_CAPACITY ? recorded : OB_REF_TRACE_CAPACITY;
+  }
+
+  events = malloc(sizeof(ob_ref_trace_event)*(total ? total : 1));
+  assert(events != NULL);
+
+  *count = 0;
+  for(buffer = trace_buffers; buffer && *count < total; buffer = buffer->next){
+    recorded = atomic_load_explicit(&buffer->recorded, memory_order_acquire);
+    held = recorded < OB_REF_TRACE_CAPACITY ? recorded : OB_REF_TRACE_CAPACITY;
+    if(held > total - *count) held = total - *count;
+    memcpy(events + *count, buffer->events, sizeof(ob_ref_trace_event)*held);
+    *count += held;
+  }
+
+  pthread_mutex_unlock(&trace_lock);
+
+  return events;
+}
+
+
+void ob_ref_trace_print_site(FILE *out, const void *caller){
+
+  Dl_info info;
+
+  /* offsets into the containing object resolve with addr2line even when the
+   * object was loaded at a randomized address */
+  if(caller && dladdr(caller, &info) && info.dli_fname){
+    fprintf(out, "%s+0x%llx", info.dli_fname,
+            (unsigned long long)((uintptr_t)caller -
+                                 (uintptr_t)info.dli_fbase));
+    if(info.dli_sname) fprintf(out, " (%s)", info.dli_sname);
+    fprintf(out, "\n");
+  }
+  else fprintf(out, "%p\n", caller);
+
+  return;
+}
+
+
+int ob_ref_trace_compare_site(const void *a, const void *b){
+
+  const ob_ref_trace_event *event_a = a, *event_b = b;
+
+  if(event_a->caller != event_b->caller)
+    return (uintptr_t)event_a->caller < (uintptr_t)event_b->caller ? -1 : 1;
+  if(event_a->type != event_b->type)
+    return event_a->type < event_b->type ? -1 : 1;
+
+  return 0;
+}
+
+
+int ob_ref_trace_compare_frequency(const void *a, const void *b){
+
+  const ob_ref_trace_event *event_a = a, *event_b = b;
+
+  if(event_a->count != event_b->count)
+    return event_a->count > event_b->count ? -1 : 1;
+
+  return 0;
+}
+
+
+int ob_ref_trace_compare_instance(const void *a, const void *b){
+
+  const ob_ref_trace_event *event_a = a, *event_b = b;
+
+  if(event_a->instance != event_b->instance)
+    return (uintptr_t)event_a->instance < (uintptr_t)event_b->instance ? -1 : 1;
+
+  return 0;
+}
@@ -0,0 +1,457 @@
+/**
+ * @file offbrand_serial.c
+ * @brief Binary Serialization Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/obj_private.h"
+#include "../include/private/offbrand_serial_private.h"
+
+/** accessors of the descriptors of the library classes, resolved by name */
+static const ob_class * (* const library_classes[])(void) = {
+  &obint_class_descriptor,
+  &obstring_class_descriptor,
+  &obvector_class_descriptor,
+  &obdeque_class_descriptor,
+  &obmap_class_descriptor
+};
+
+
+/* PUBLIC METHODS */
+
+ob_writer * ob_writer_new_file(FILE *file){
+  assert(file != NULL);
+  return ob_writer_create(file, -1);
+}
+
+
+ob_writer * ob_writer_new_fd(int fd){
+  assert(fd >= 0);
+  return ob_writer_create(NULL, fd);
+}
+
+
+uint8_t ob_writer_flush(ob_writer *writer){
+
+  assert(writer != NULL);
+
+  ob_writer_drain(writer);
+  if(writer->file && fflush(writer->file) != 0) writer->failed = 1;
+
+  return !writer->failed;
+}
+
+
+void ob_writer_destroy(ob_writer *writer){
+
+  assert(writer != NULL);
+
+  ob_writer_flush(writer);
+  free(writer->met.classes);
+  free(writer);
+
+  return;
+}
+
+
+ob_reader * ob_reader_new_file(FILE *file){
+  assert(file != NULL);
+  return ob_reader_create(file, -1);
+}
+
+
+ob_reader * ob_reader_new_fd(int fd){
+  assert(fd >= 0);
+  return ob_reader_create(NULL, fd);
+}
+
+
+uint8_t ob_reader_at_end(ob_reader *reader){
+
+  assert(reader != NULL);
+
+  if(reader->failed) return 1;
+  if(reader->start == reader->end) ob_reader_fill(reader);
+
+  return reader->start == reader->end;
+}
+
+
+uint8_t ob_reader_failed(const ob_reader *reader){
+  assert(reader != NULL);
+  return reader->failed;
+}
+
+
+void ob_reader_destroy(ob_reader *reader){
+
+  assert(reader != NULL);
+
+  free(reader->met.classes);
+  free(reader);
+
+  return;
+}
+
+
+void ob_serialize(const obj *instance, ob_writer *writer){
+
+  uint64_t index, length;
+  const ob_class *cls;
+
+  assert(writer != NULL);
+
+  if(!instance){
+    ob_writer_write_varint(writer, OB_SERIAL_NULL);
+    return;
+  }
+
+  cls = instance->cls;
+  assert(cls->serialize != NULL); /* class must implement serialization */
+
+  /* name each class once per stream, refer to it by index afterwards */
+  index = ob_serial_find_met(&writer->met, cls);
+  if(index == writer->met.count){
+    length = strlen(cls->classname);
+    assert(length <= OB_SERIAL_MAX_NAME);
+    ob_writer_write_varint(writer, OB_SERIAL_NEW_CLASS);
+    ob_writer_write_varint(writer, length);
+    ob_writer_write(writer, cls->classname, length);
+    ob_serial_add_met(&writer->met, cls);
+  }
+  else ob_writer_write_varint(writer, index + OB_SERIAL_FIRST_INDEX);
+
+  cls->serialize(instance, writer);
+
+  return;
+}
+
+
+obj * ob_deserialize(ob_reader *reader){
+
+  uint64_t reference, length;
+  char classname[OB_SERIAL_MAX_NAME+1];
+  const ob_class *cls;
+  obj *instance;
+
+  assert(reader != NULL);
+
+  if(reader->failed || !ob_reader_read_varint(reader, &reference))
+    return NULL;
+
+  if(reference == OB_SERIAL_NULL) return NULL;
+
+  if(reference == OB_SERIAL_NEW_CLASS){
+    if(!ob_reader_read_varint(reader, &length)) return NULL;
+    if(length > OB_SERIAL_MAX_NAME){
+      ob_reader_fail(reader);
+      return NULL;
+    }
+    if(!ob_reader_read(reader, classname, length)) return NULL;
+    classname[length] = '\0';
+
+    if(!(cls = ob_serial_find_class(classname))){
+      ob_reader_fail(reader);
+      return NULL;
+    }
+    ob_serial_add_met(&reader->met, cls);
+  }
+  else if(reference - OB_SERIAL_FIRST_INDEX < reader->met.count){
+    cls = reader->met.classes[reference - OB_SERIAL_FIRST_INDEX];
+  }
+  else{
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  if(reader->depth == OB_SERIAL_MAX_DEPTH){
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  reader->depth++;
+  instance = cls->deserialize(reader);
+  reader->depth--;
+
+  return instance;
+}
+
+
+/* PRIVATE METHODS */
+
+ob_writer * ob_writer_create(FILE *file, int fd){
+
+  ob_writer *writer;
+
+  writer = malloc(sizeof(ob_writer));
+  assert(writer != NULL);
+
+  writer->file = file;
+  writer->fd = fd;
+  writer->failed = 0;
+  writer->used = 0;
+  writer->met.classes = NULL;
+  writer->met.count = 0;
+  writer->met.capacity = 0;
+
+  return writer;
+}
+
+
+void ob_writer_write(ob_writer *writer, const void *data, size_t length){
+
+  size_t part;
+  const unsigned char *bytes = data;
+
+  while(length > 0){
+
+    if(writer->used == OB_SERIAL_BUFFER_SIZE) ob_writer_drain(writer);
+
+    part = OB_SERIAL_BUFFER_SIZE - writer->used;
+    if(part > length) part = length;
+
+    memcpy(writer->buffer + writer->used, bytes, part);
+    writer->used += part;
+    bytes += part;
+    length -= part;
+  }
+
+  return;
+}
+
+
+void ob_writer_write_varint(ob_writer *writer, uint64_t value){
+
+  unsigned char bytes[10];
+  size_t length = 0;
+
+  while(value >= 0x80){
+    bytes[length++] = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+  bytes[length++] = value;
+
+  ob_writer_write(writer, bytes, length);
+
+  return;
+}
+
+
+void ob_writer_drain(ob_writer *writer){
+
+  size_t written;
+  ssize_t result;
+
+  /* data following a failed write is dropped, the stream is already broken */
+  if(writer->failed){
+    writer->used = 0;
+    return;
+  }
+
+  if(writer->file){
+    if(fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used)
+      writer->failed = 1;
+    writer->used = 0;
+    return;
+  }
+
+  written = 0;
+  while(written < writer->used){
+    result = write(writer->fd, writer->buffer + written,
+                   writer->used - written);
+    if(result < 0){
+      if(errno == EINTR) continue;
+      writer->failed = 1;
+      break;
+    }
+    written += result;
+  }
+
+  writer->used = 0;
+
+  return;
+}
+
+
+ob_reader * ob_reader_create(FILE *file, int fd){
+
+  ob_reader *reader;
+
+  reader = malloc(sizeof(ob_reader));
+  assert(reader != NULL);
+
+  reader->file = file;
+  reader->fd = fd;
+  reader->failed = 0;
+  reader->exhausted = 0;
+  reader->depth = 0;
+  reader->start = 0;
+  reader->end = 0;
+  reader->met.classes = NULL;
+  reader->met.count = 0;
+  reader->met.capacity = 0;
+
+  return reader;
+}
+
+
+uint8_t ob_reader_read(ob_reader *reader, void *data, size_t length){
+
+  size_t part;
+  unsigned char *bytes = data;
+
+  while(length > 0 && !reader->failed){
+
+    if(reader->start == reader->end){
+      ob_reader_fill(reader);
+      if(reader->start == reader->end){
+        ob_reader_fail(reader); /* truncated data */
+        break;
+      }
+    }
+
+    part = reader->end - reader->start;
+    if(part > length) part = length;
+
+    memcpy(bytes, reader->buffer + reader->start, part);
+    reader->start += part;
+    bytes += part;
+    length -= part;
+  }
+
+  return !reader->failed;
+}
+
+
+uint8_t ob_reader_read_varint(ob_reader *reader, uint64_t *value){
+
+  unsigned char byte;
+  uint8_t shift;
+
+  *value = 0;
+
+  for(shift = 0; shift < 64; shift += 7){
+    if(!ob_reader_read(reader, &byte, 1)) return 0;
+    *value |= (uint64_t)(byte & 0x7f) << shift;
+    if(!(byte & 0x80)) return 1;
+  }
+
+  ob_reader_fail(reader); /* more than 64 bits */
+  return 0;
+}
+
+
+void * ob_reader_read_buffer(ob_reader *reader, uint64_t length, size_t extra){
+
+  uint64_t done, part, capacity;
+  unsigned char *buffer;
+
+  if(length > SIZE_MAX - extra){
+    ob_reader_fail(reader);
+    return NULL;
+  }
+
+  capacity = length < OB_SERIAL_BUFFER_SIZE ? length : OB_SERIAL_BUFFER_SIZE;
+  buffer = malloc(capacity + extra);
+  assert(buffer != NULL);
+
+  for(done = 0; done < length; done += part){
+
+    if(done == capacity){
+      capacity = length - capacity < capacity ? length : capacity*2;
+      buffer = realloc(buffer, capacity + extra);
+      assert(buffer != NULL);
+    }
+
+    part = capacity - done;
+    if(!ob_reader_read(reader, buffer + done, part)){
+      free(buffer);
+      return NULL;
+    }
+  }
+
+  return buffer;
+}
+
+
+void ob_reader_fail(ob_reader *reader){
+  reader->failed = 1;
+}
+
+
+void ob_reader_fill(ob_reader *reader){
+
+  ssize_t result;
+
+  reader->start = 0;
+  reader->end = 0;
+
+  if(reader->exhausted) return;
+
+  if(reader->file){
+    reader->end = fread(reader->buffer, 1, OB_SERIAL_BUFFER_SIZE,
+                        reader->file);
+    if(reader->end == 0){
+      if(ferror(reader->file)) reader->failed = 1;
+      reader->exhausted = 1;
+    }
+    return;
+  }
+
+  do{
+    result = read(reader->fd, reader->buffer, OB_SERIAL_BUFFER_SIZE);
+  }while(result < 0 && errno == EINTR);
+
+  if(result <= 0){
+    if(result < 0) reader->failed = 1;
+    reader->exhausted = 1;
+    return;
+  }
+
+  reader->end = result;
+
+  return;
+}
+
+
+uint64_t ob_serial_find_met(const ob_serial_classes *met, const ob_class *cls){
+
+  uint64_t i;
+
+  /* streams hold few classes, a linear search is fastest */
+  for(i=0; i<met->count; i++)
+    if(met->classes[i] == cls) break;
+
+  return i;
+}
+
+
+void ob_serial_add_met(ob_serial_classes *met, const ob_class *cls){
+
+  if(met->count == met->capacity){
+    met->capacity = met->capacity ? met->capacity*2 : 8;
+    met->classes = realloc(met->classes,
+                           met->capacity*sizeof(const ob_class *));
+    assert(met->classes != NULL);
+  }
+
+  met->classes[met->count++] = cls;
+
+  return;
+}
+
+
+const ob_class * ob_serial_find_class(const char *classname){
+
+  uint64_t i;
+  const ob_class *cls;
+
+  for(i=0; i<sizeof(library_classes)/sizeof(library_classes[0]); i++){
+    cls = library_classes[i]();
+    if(strcmp(cls->classname, classname) == 0 && cls->deserialize)
+      return cls;
+  }
+
+  return NULL;
+}
@@ -0,0 +1,348 @@
+/**
+ * @file offbrand_stats.c
+ * @brief Class Statistics Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/obj_private.h"
+#include "../include/private/offbrand_stats_private.h"
+
+/** statistics table of the calling thread */
+static _Thread_local ob_stats_table stats_table;
+
+/** counts of exited threads, protected by stats_lock */
+static ob_stats_table retired_table = {
+  .lock = PTHREAD_MUTEX_INITIALIZER
+};
+/** list of the tables of all running threads, protected by stats_lock */
+static ob_stats_table *stats_tables = NULL;
+/** lock protecting the list of tables and the retired table */
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** key used to run ob_stats_thread_exit when a thread exits */
+static pthread_key_t stats_thread_key;
+/** ensures stats_thread_key is created once */
+static pthread_once_t stats_key_once = PTHREAD_ONCE_INIT;
+/** ensures the at exit report is registered once */
+static pthread_once_t stats_exit_once = PTHREAD_ONCE_INIT;
+
+
+/* PUBLIC METHODS */
+
+uint8_t ob_get_class_stats(const char *classname, ob_class_stats *stats){
+
+  uint64_t i, count;
+  uint8_t found = 0;
+  ob_class_stats *all;
+
+  assert(classname != NULL);
+  assert(stats != NULL);
+
+  all = ob_stats_merge(&count);
+
+  for(i=0; i<count; i++){
+    if(strcmp(all[i].classname, classname) == 0){
+      *stats = all[i];
+      found = 1;
+      break;
+    }
+  }
+
+  free(all);
+
+  return found;
+}
+
+
+void ob_get_total_class_stats(ob_class_stats *stats){
+
+  uint64_t i, count;
+  ob_class_stats *all;
+
+  assert(stats != NULL);
+
+  all = ob_stats_merge(&count);
+
+  memset(stats, 0, sizeof(ob_class_stats));
+  for(i=0; i<count; i++){
+    stats->allocations += all[i].allocations;
+    stats->frees += all[i].frees;
+    stats->live += all[i].live;
+    stats->peak_live += all[i].peak_live;
+    stats->live_bytes += all[i].live_bytes;
+  }
+
+  free(all);
+
+  return;
+}
+
+
+void ob_print_class_stats(FILE *out){
+
+  uint64_t i, count;
+  ob_class_stats *all;
+
+  assert(out != NULL);
+
+  all = ob_stats_merge(&count);
+
+  fprintf(out, "%-20s %12s %12s %12s %12s %14s\n", "class", "allocations",
+          "frees", "live", "peak live", "live bytes");
+  for(i=0; i<count; i++){
+    fprintf(out, "%-20s %12llu %12llu %12llu %12llu %14llu\n",
+            all[i].classname, (unsigned long long)all[i].allocations,
+            (unsigned long long)all[i].frees, (unsigned long long)all[i].live,
+            (unsigned long long)all[i].peak_live,
+            (unsigned long long)all[i].live_bytes);
+  }
+
+  free(all);
+
+  return;
+}
+
+
+void ob_print_class_stats_at_exit(void){
+  pthread_once(&stats_exit_once, &ob_stats_register_at_exit);
+}
+
+
+/* PRIVATE METHODS */
+
+/** creates the thread exit key, called once through pthread_once */
+static void ob_stats_create_key(void){
+  pthread_key_create(&stats_thread_key, &ob_stats_thread_exit);
+}
+
+
+void ob_stats_register_at_exit(void){
+  atexit(&ob_stats_print_at_exit);
+}
+
+
+void ob_stats_record_alloc(const ob_class *cls){
+
+#ifdef OB_NO_CLASS_STATS
+  (void)cls;
+#else
+  uint64_t allocations, live;
+  ob_stats_entry *entry = ob_stats_entry_for(&stats_table, cls);
+
+  /* only this thread writes the entry, so plain loads and stores suffice */
+  allocations = atomic_load_explicit(&entry->allocations,
+                                     memory_order_relaxed) + 1;
+  atomic_store_explicit(&entry->allocations, allocations,
+                        memory_order_relaxed);
+
+  live = allocations - atomic_load_explicit(&entry->frees,
+                                            memory_order_relaxed);
+  if(live <= allocations &&
+     live > atomic_load_explicit(&entry->peak_live, memory_order_relaxed))
+    atomic_store_explicit(&entry->peak_live, live, memory_order_relaxed);
+#endif
+
+  return;
+}
+
+
+void ob_stats_record_free(const ob_class *cls){
+
+#ifdef OB_NO_CLASS_STATS
+  (void)cls;
+#else
+  ob_stats_entry *entry = ob_stats_entry_for(&stats_table, cls);
+
+  atomic_store_explicit(&entry->frees,
+                        atomic_load_explicit(&entry->frees,
+                                             memory_order_relaxed) + 1,
+                        memory_order_relaxed);
+#endif
+
+  return;
+}
+
+
+ob_stats_entry * ob_stats_entry_for(ob_stats_table *table, const ob_class *cls){
+
+  uint32_t i, j, old_capacity;
+  const ob_class *slot_cls;
+  ob_stats_entry *old_entries;
+
+  /* descriptors are spread out in memory, a multiplicative hash of the
+   * address picks a well distributed slot */
+  if(table->capacity > 0){
+    i = (uint32_t)(((uintptr_t)cls * 0x9e3779b97f4a7c15ULL) >> 32) &
+        (table->capacity - 1);
+    while((slot_cls = atomic_load_explicit(&table->entries[i].cls,
+                                           memory_order_relaxed))){
+      if(slot_cls == cls) return &table->entries[i];
+      i = (i+1) & (table->capacity - 1);
+    }
+  }
+
+  /* first use of the table on this thread, register it for merging */
+  if(!table->registered && table != &retired_table){
+    pthread_once(&stats_key_once, &ob_stats_create_key);
+    pthread_mutex_init(&table->lock, NULL);
+    pthread_setspecific(stats_thread_key, table);
+
+    pthread_mutex_lock(&stats_lock);
+    table->next = stats_tables;
+    stats_tables = table;
+    table->registered = 1;
+    pthread_mutex_unlock(&stats_lock);
+  }
+
+  /* keep the table at most half full, rehashing into a larger table */
+  if(2*(table->count+1) > table->capacity){
+
+    pthread_mutex_lock(&table->lock);
+
+    old_entries = table->entries;
+    old_capacity = table->capacity;
+    table->capacity = old_capacity ? old_capacity*2 : OB_STATS_INITIAL_CAPACITY;
+    table->entries = calloc(table->capacity, sizeof(ob_stats_entry));
+    assert(table->entries != NULL);
+
+    for(j=0; j<old_capacity; j++){
+      slot_cls = atomic_load_explicit(&old_entries[j].cls,
+                                      memory_order_relaxed);
+      if(!slot_cls) continue;
+      i = (uint32_t)(((uintptr_t)slot_cls * 0x9e3779b97f4a7c15ULL) >> 32) &
+          (table->capacity - 1);
+      while(atomic_load_explicit(&table->entries[i].cls, memory_order_relaxed))
+        i = (i+1) & (table->capacity - 1);
+      table->entries[i] = old_entries[j];
+    }
+
+    pthread_mutex_unlock(&table->lock);
+    free(old_entries);
+  }
+
+  i = (uint32_t)(((uintptr_t)cls * 0x9e3779b97f4a7c15ULL) >> 32) &
+      (table->capacity - 1);
+  while(atomic_load_explicit(&table->entries[i].cls, memory_order_relaxed))
+    i = (i+1) & (table->capacity - 1);
+
+  /* publish the class after its zeroed counters, for merging threads */
+  atomic_store_explicit(&table->entries[i].cls, cls, memory_order_release);
+  table->count++;
+
+  return &table->entries[i];
+}
+
+
+ob_class_stats * ob_stats_merge(uint64_t *count){
+
+  uint32_t i;
+  uint64_t j, capacity = 0, allocations, frees, peak;
+  const ob_class *cls;
+  ob_stats_table *table;
+  ob_class_stats *all = NULL;
+
+  *count = 0;
+
+  pthread_mutex_lock(&stats_lock);
+
+  table = &retired_table;
+  while(table){
+
+    pthread_mutex_lock(&table->lock);
+    for(i=0; i<table->capacity; i++){
+
+      cls = atomic_load_explicit(&table->entries[i].cls, memory_order_acquire);
+      if(!cls) continue;
+
+      allocations = atomic_load_explicit(&table->entries[i].allocations,
+                                         memory_order_relaxed);
+      frees = atomic_load_explicit(&table->entries[i].frees,
+                                   memory_order_relaxed);
+      peak = atomic_load_explicit(&table->entries[i].peak_live,
+                                  memory_order_relaxed);
+
+      for(j=0; j<*count && all[j].classname != cls->classname; j++);
+      if(j == *count){
+        if(*count == capacity){
+          capacity = capacity ? capacity*2 : 16;
+          all = realloc(all, sizeof(ob_class_stats)*capacity);
+          assert(all != NULL);
+        }
+        memset(&all[j], 0, sizeof(ob_class_stats));
+        all[j].classname = cls->classname;
+        all[j].live_bytes = cls->size; /* scaled by live count below */
+        (*count)++;
+      }
+
+      all[j].allocations += allocations;
+      all[j].frees += frees;
+      if(peak > all[j].peak_live) all[j].peak_live = peak;
+    }
+    pthread_mutex_unlock(&table->lock);
+
+    table = table == &retired_table ? stats_tables : table->next;
+  }
+
+  pthread_mutex_unlock(&stats_lock);
+
+  /* instances freed by a thread other than the one allocating them make per
+   * thread peaks approximate, the merged live count bounds the peak below */
+  for(j=0; j<*count; j++){
+    all[j].live = all[j].allocations > all[j].frees ?
+                  all[j].allocations - all[j].frees : 0;
+    all[j].live_bytes *= all[j].live;
+    if(all[j].live > all[j].peak_live) all[j].peak_live = all[j].live;
+  }
+
+  return all;
+}
+
+
+void ob_stats_thread_exit(void *table){
+
+  uint32_t i;
+  const ob_class *cls;
+  ob_stats_entry *retired;
+  ob_stats_table *exiting = table, **link;
+
+  pthread_mutex_lock(&stats_lock);
+
+  for(i=0; i<exiting->capacity; i++){
+
+    cls = atomic_load_explicit(&exiting->entries[i].cls, memory_order_relaxed);
+    if(!cls) continue;
+
+    retired = ob_stats_entry_for(&retired_table, cls);
+    atomic_store_explicit(&retired->allocations,
+      atomic_load_explicit(&retired->allocations, memory_order_relaxed) +
+      atomic_load_explicit(&exiting->entries[i].allocations,
+                           memory_order_relaxed), memory_order_relaxed);
+    atomic_store_explicit(&retired->frees,
+      atomic_load_explicit(&retired->frees, memory_order_relaxed) +
+      atomic_load_explicit(&exiting->entries[i].frees, memory_order_relaxed),
+      memory_order_relaxed);
+    if(atomic_load_explicit(&exiting->entries[i].peak_live,
+                            memory_order_relaxed) >
+       atomic_load_explicit(&retired->peak_live, memory_order_relaxed))
+      atomic_store_explicit(&retired->peak_live,
+        atomic_load_explicit(&exiting->entries[i].peak_live,
+                             memory_order_relaxed), memory_order_relaxed);
+  }
+
+  for(link = &stats_tables; *link != exiting; link = &(*link)->next);
+  *link = exiting->next;
+
+  pthread_mutex_unlock(&stats_lock);
+
+  free(exiting->entries);
+  pthread_mutex_destroy(&exiting->lock);
+  memset(exiting, 0, sizeof(ob_stats_table));
+
+  return;
+}
+
+
+void ob_stats_print_at_exit(void){
+  ob_print_class_stats(stderr);
+}
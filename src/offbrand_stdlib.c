@@ -4,74 +4,267 @@
  * @author theck
  */
 
+/* the out of line definitions of the inline fast paths live here */
+#define OB_NO_INLINE_FAST_PATHS
+
 #include "../include/offbrand.h"
 #include "../include/private/obj_private.h"
+#include "../include/private/offbrand_alloc_private.h"
+#include "../include/private/offbrand_stats_private.h"
+#include "../include/private/offbrand_reftrace_private.h"
+#include "../include/private/offbrand_weak_private.h"
+#include <pthread.h>
+
+/** autorelease pools of the calling thread */
+static _Thread_local ob_autorelease_stack autorelease_stack;
+/** objs awaiting deferred destruction on the calling thread */
+static _Thread_local ob_deferred_queue deferred_queue;
+/** non-zero once the calling thread registered its storage to be freed */
+static _Thread_local uint8_t thread_storage_registered;
+/** key used to run ob_thread_storage_exit when a thread exits */
+static pthread_key_t thread_storage_key;
+/** ensures thread_storage_key is created once */
+static pthread_once_t thread_storage_once = PTHREAD_ONCE_INIT;
+
+/** objs handed to the reaper thread, protected by reaper_lock */
+static ob_deferred_queue reaper_queue;
+/** lock protecting reaper_queue and reaper_running */
+static pthread_mutex_t reaper_lock = PTHREAD_MUTEX_INITIALIZER;
+/** signals the reaper thread of new objs or a stop request */
+static pthread_cond_t reaper_signal = PTHREAD_COND_INITIALIZER;
+/** non-zero while the reaper thread accepts objs */
+static uint8_t reaper_running = 0;
+/** the reaper thread */
+static pthread_t reaper_thread;
+
+void ob_init_base(obj *instance, const ob_class *cls){
+  ob_init_instance(instance, cls, __builtin_return_address(0));
+}
 
-void ob_init_base(obj *instance, ob_dealloc_fptr dealloc_funct,
-                  ob_hash_fptr hash_funct, ob_compare_fptr compare_funct,
-                  ob_display_fptr display_funct, const char *classname){
-
-  assert(classname != NULL);
 
-  *instance = malloc(sizeof(struct obj_struct));
+obj * ob_release(obj *instance){
 
-  assert((*instance) != NULL);
+  ob_ref_count_t remaining;
+  const ob_class *cls;
 
-  (*instance)->references = 1;
+  if(!instance || (instance->flags & OB_FLAG_IMMORTAL)) return instance;
 
-  (*instance)->dealloc = dealloc_funct;
+  /* once the count is decremented another thread may deallocate a shared
+   * instance, so the class is read for tracing beforehand */
+  cls = instance->cls;
 
-  if(hash_funct != &ob_hash) (*instance)->hash = hash_funct;
-  else (*instance)->hash = NULL;
+  /* owning thread fast path avoids atomic read-modify-write instructions, the
+   * acquire-release decrement orders all prior uses of a shared instance
+   * before its deallocation */
+  if(!(instance->flags & OB_FLAG_SHARED)){
+    remaining = atomic_load_explicit(&instance->references,
+                                     memory_order_relaxed) - 1;
+    atomic_store_explicit(&instance->references, remaining,
+                          memory_order_relaxed);
+  }
+  else{
+    remaining = atomic_fetch_sub_explicit(&instance->references, 1,
+                                          memory_order_acq_rel) - 1;
+  }
 
-  if(compare_funct != &ob_compare) (*instance)->compare = compare_funct;
-  else (*instance)->compare = NULL;
+  OB_REF_TRACE(OB_REF_TRACE_RELEASE, instance, cls, remaining,
+               __builtin_return_address(0));
 
-  if(display_funct != &ob_display) (*instance)->display = display_funct;
-  else (*instance)->display = NULL;
+  /* if no other part of the program references the instance, destroy it */
+  if(remaining == 0){
 
-  (*instance)->classname = classname;
+    /* arena instances are deallocated together when their arena is
+     * destroyed */
+    if(instance->flags & OB_FLAG_ARENA) return NULL;
 
-  return;
-}
+    if(deferred_queue.enabled){
+      if(!(instance->flags & OB_FLAG_SHARED) || deferred_queue.reaper ||
+         !ob_reaper_defer(instance))
+        ob_defer(&deferred_queue, instance);
+      return NULL;
+    }
 
+    ob_destroy(instance);
+    return NULL;
+  }
 
-obj * ob_release(obj *instance){
+  return instance;
+}
 
-  if(!instance) return NULL;
 
-  /* if no other part of the program references the instance, destroy it */
-  if(--((*instance)->references) <= 0){
+obj * ob_retain(obj *instance){
 
-    /* call class specific memory cleanup, if it exists */
-    if((*instance)->dealloc)
-      (*instance)->dealloc(instance);
+  ob_ref_count_t count;
 
-    free((struct obj_struct *)*instance); /* free reference counted base */
-    free(instance); /* free the entire object */
+  if(!instance || (instance->flags & OB_FLAG_IMMORTAL)) return instance;
 
-    return NULL;
+  if(!(instance->flags & OB_FLAG_SHARED)){
+    count = atomic_load_explicit(&instance->references, memory_order_relaxed);
+    assert(count < UINT32_MAX); /* reference count > UINT32_MAX cannot be
+                                   handled by lib */
+    atomic_store_explicit(&instance->references, count+1,
+                          memory_order_relaxed);
   }
+  else{
+    /* a new reference can only be created from an existing one, so no
+     * ordering is required when incrementing */
+    count = atomic_fetch_add_explicit(&instance->references, 1,
+                                      memory_order_relaxed);
+    assert(count < UINT32_MAX);
+  }
+
+  OB_REF_TRACE(OB_REF_TRACE_RETAIN, instance, instance->cls, count+1,
+               __builtin_return_address(0));
 
   return instance;
 }
 
 
-obj * ob_retain(obj *instance){
+obj * ob_autorelease(obj *instance){
+
+  ob_autorelease_stack *stack = &autorelease_stack;
 
   if(!instance) return instance;
 
-  assert((*instance)->references < UINT32_MAX); /* reference count > UINT32_MAX
-                                                   cannot be handled by lib */
-  ++((*instance)->references);
+  assert(stack->depth > 0); /* autorelease requires a pushed pool */
+
+  if(stack->length == stack->capacity){
+    ob_thread_storage_register();
+    stack->capacity = stack->capacity ? stack->capacity*2 : 64;
+    stack->objs = realloc(stack->objs, sizeof(obj *)*stack->capacity);
+    assert(stack->objs != NULL);
+  }
+
+  stack->objs[stack->length++] = instance;
 
   return instance;
 }
 
 
+void ob_push_autorelease_pool(void){
+
+  ob_autorelease_stack *stack = &autorelease_stack;
+
+  if(stack->depth == stack->mark_capacity){
+    ob_thread_storage_register();
+    stack->mark_capacity = stack->mark_capacity ? stack->mark_capacity*2 : 8;
+    stack->marks = realloc(stack->marks,
+                           sizeof(uint64_t)*stack->mark_capacity);
+    assert(stack->marks != NULL);
+  }
+
+  stack->marks[stack->depth++] = stack->length;
+
+  return;
+}
+
+
+void ob_drain_autorelease_pool(void){
+
+  uint64_t mark;
+  ob_autorelease_stack *stack = &autorelease_stack;
+
+  assert(stack->depth > 0); /* cannot drain without a pushed pool */
+
+  mark = stack->marks[stack->depth-1];
+
+  /* release most recent first, deallocators may autorelease more objs onto
+   * the pool while it drains */
+  while(stack->length > mark)
+    ob_release(stack->objs[--stack->length]);
+
+  /* the storage is kept for the next pool, and freed when the thread exits */
+  stack->depth--;
+
+  return;
+}
+
+
+void ob_defer_destruction(uint8_t enabled){
+  deferred_queue.enabled = enabled;
+}
+
+
+uint64_t ob_drain_deferred(uint64_t max_objs){
+
+  uint64_t i;
+  uint8_t enabled;
+  ob_deferred_queue *queue = &deferred_queue;
+
+  /* objs released by deallocators join the queue rather than recursing, even
+   * if deferral was disabled after these objs were queued */
+  enabled = queue->enabled;
+  queue->enabled = 1;
+
+  for(i=0; i<max_objs && queue->length > 0; i++)
+    ob_destroy(queue->objs[--queue->length]);
+
+  /* the storage is kept for the next objs queued, and freed when the thread
+   * exits */
+  queue->enabled = enabled;
+
+  return queue->length;
+}
+
+
+void ob_start_reaper(void){
+
+  pthread_mutex_lock(&reaper_lock);
+  assert(!reaper_running);
+  reaper_running = 1;
+  pthread_mutex_unlock(&reaper_lock);
+
+  pthread_create(&reaper_thread, NULL, &ob_reaper_main, NULL);
+
+  return;
+}
+
+
+void ob_stop_reaper(void){
+
+  pthread_mutex_lock(&reaper_lock);
+  assert(reaper_running);
+  reaper_running = 0;
+  pthread_cond_signal(&reaper_signal);
+  pthread_mutex_unlock(&reaper_lock);
+
+  pthread_join(reaper_thread, NULL);
+
+  return;
+}
+
+
+void ob_share(obj *instance){
+
+  /* already shared instances have had their references shared as well, which
+   * also stops traversal of reference cycles. Immortal instances need no
+   * sharing, and reference no mortal instances */
+  if(!instance || (instance->flags & (OB_FLAG_SHARED | OB_FLAG_IMMORTAL)))
+    return;
+
+  instance->flags |= OB_FLAG_SHARED;
+  if(instance->cls->traverse)
+    instance->cls->traverse(instance, &ob_share_child, NULL);
+
+  return;
+}
+
+
+uint8_t ob_is_shared(const obj *instance){
+  if(!instance) return 0;
+  return (instance->flags & OB_FLAG_SHARED) != 0;
+}
+
+
+uint8_t ob_is_immortal(const obj *instance){
+  if(!instance) return 0;
+  return (instance->flags & OB_FLAG_IMMORTAL) != 0;
+}
+
+
 uint32_t ob_reference_count(obj *instance){
   if(!instance) return 0;
-  return (*instance)->references;
+  return atomic_load_explicit(&instance->references, memory_order_relaxed);
 }
 
 
@@ -81,7 +274,10 @@ uint8_t ob_has_class(const obj *a, const char *classname){
     if(strcmp(classname, "NULL") == 0) return 1;
     return 0;
   }
-  if(strcmp((*a)->classname, classname) == 0) return 1;
+  /* class names are stored once per descriptor, callers passing the same
+   * string constant used to define the class match without a string compare */
+  if(a->cls->classname == classname) return 1;
+  if(strcmp(a->cls->classname, classname) == 0) return 1;
   else return 0;
 }
 
@@ -90,7 +286,7 @@ uint8_t ob_has_same_class(const obj *a, const obj *b){
   /* if both NULL, both are of the "NULL" class */
   if(!a && !b) return 1;
   else if(!a || !b) return 0;
-  return ob_has_class(a, (*b)->classname);
+  return a->cls == b->cls; /* each class has exactly one descriptor */
 }
 
 
@@ -100,14 +296,8 @@ ob_hash_t ob_hash(const obj *to_hash){
 
   if(!to_hash) return 0;
 
-  if((*to_hash)->hash) retval = (*to_hash)->hash(to_hash);
-  else{
-    retval = (ob_hash_t)to_hash;
-    retval += (retval << 6);
-    retval ^= (retval >> 10);
-    retval += (retval >> 7);
-    retval ^= (retval << 12);
-  }
+  if(to_hash->cls->hash) retval = to_hash->cls->hash(to_hash);
+  else retval = ob_hash_combine(ob_hash_seed(), (ob_hash_t)to_hash);
 
   return retval;
 }
@@ -121,8 +311,8 @@ int8_t ob_compare(const obj *a, const obj *b){
   else if(a == NULL || b == NULL) return OB_NOT_EQUAL;
 
 
-  if(ob_has_same_class(a, b) && (*a)->compare != NULL)
-    retval = (*a)->compare(a, b);
+  if(a->cls == b->cls && a->cls->compare != NULL)
+    retval = a->cls->compare(a, b);
   else if(a == b) retval = OB_EQUAL_TO;
   else retval = OB_NOT_EQUAL;
 
@@ -137,7 +327,192 @@ void ob_display(const obj *to_print){
   }
 
   fprintf(stderr, "Instance of class %s, at address 0x%p\n",
-                  (*to_print)->classname, to_print);
-  if((*to_print)->display) (*to_print)->display(to_print);
+                  to_print->cls->classname, to_print);
+  if(to_print->cls->display) to_print->cls->display(to_print);
 }
 
+
+/* PRIVATE METHODS */
+
+/** creates the thread exit key, called once through pthread_once */
+static void ob_thread_storage_create_key(void){
+  pthread_key_create(&thread_storage_key, &ob_thread_storage_exit);
+}
+
+
+void ob_thread_storage_register(void){
+
+  if(thread_storage_registered) return;
+
+  /* the key needs a non-NULL value for its exit handler to run */
+  pthread_once(&thread_storage_once, &ob_thread_storage_create_key);
+  pthread_setspecific(thread_storage_key, &autorelease_stack);
+  thread_storage_registered = 1;
+
+  return;
+}
+
+
+void ob_thread_storage_exit(void *unused){
+
+  ob_autorelease_stack *stack = &autorelease_stack;
+  ob_deferred_queue *queue = &deferred_queue;
+
+  (void)unused;
+
+  free(queue->objs);
+  queue->objs = NULL;
+  queue->length = 0;
+  queue->capacity = 0;
+
+  free(stack->objs);
+  free(stack->marks);
+  stack->objs = NULL;
+  stack->marks = NULL;
+  stack->length = 0;
+  stack->capacity = 0;
+  stack->depth = 0;
+  stack->mark_capacity = 0;
+
+  return;
+}
+
+
+void ob_share_child(obj *child, void *context){
+  (void)context;
+  ob_share(child);
+}
+
+
+void ob_init_instance(obj *instance, const ob_class *cls, const void *caller){
+
+  assert(instance != NULL);
+  assert(cls != NULL);
+  assert(cls->classname != NULL);
+
+  /* generic functions dispatch to the class descriptor, a descriptor pointing
+   * back to them would recurse forever. NULL selects the default instead */
+  assert(cls->hash != &ob_hash);
+  assert(cls->compare != &ob_compare);
+  assert(cls->display != &ob_display);
+
+  instance->cls = cls;
+  atomic_init(&instance->references, 1);
+  instance->flags = 0;
+  atomic_init(&instance->weak, 0);
+
+  ob_stats_record_alloc(cls);
+  OB_REF_TRACE(OB_REF_TRACE_ALLOC, instance, cls, 1, caller);
+
+  return;
+}
+
+
+void ob_init_immortal(obj *instance, const ob_class *cls){
+
+  assert(instance != NULL);
+  assert(cls != NULL);
+
+  instance->cls = cls;
+  atomic_init(&instance->references, 1);
+  instance->flags = OB_FLAG_IMMORTAL;
+  atomic_init(&instance->weak, 0);
+
+  return;
+}
+
+
+void ob_destroy(obj *instance){
+
+  ob_stats_record_free(instance->cls);
+  OB_REF_TRACE(OB_REF_TRACE_DEALLOC, instance, instance->cls, 0, NULL);
+
+  /* weak handles stop resolving to the instance before it is torn down */
+  if(atomic_load_explicit(&instance->weak, memory_order_relaxed))
+    ob_weak_clear(instance);
+
+  /* call class specific memory cleanup, if it exists */
+  if(instance->cls->dealloc)
+    instance->cls->dealloc(instance);
+
+  /* free the entire object, including the embedded base, back to where it
+   * was allocated from */
+  if(instance->flags & OB_FLAG_SLAB)
+    ob_slab_free(instance, instance->cls->size);
+  else
+    free(instance);
+
+  return;
+}
+
+
+void ob_defer(ob_deferred_queue *queue, obj *instance){
+
+  if(queue->length == queue->capacity){
+    ob_thread_storage_register();
+    queue->capacity = queue->capacity ? queue->capacity*2 : 64;
+    queue->objs = realloc(queue->objs, sizeof(obj *)*queue->capacity);
+    assert(queue->objs != NULL);
+  }
+
+  queue->objs[queue->length++] = instance;
+
+  return;
+}
+
+
+uint8_t ob_reaper_defer(obj *instance){
+
+  uint8_t queued = 0;
+
+  pthread_mutex_lock(&reaper_lock);
+  if(reaper_running){
+    ob_defer(&reaper_queue, instance);
+    pthread_cond_signal(&reaper_signal);
+    queued = 1;
+  }
+  pthread_mutex_unlock(&reaper_lock);
+
+  return queued;
+}
+
+
+void * ob_reaper_main(void *arg){
+
+  obj **batch;
+  uint64_t i, length;
+  ob_deferred_queue *queue = &deferred_queue;
+
+  (void)arg;
+
+  /* objs released while destroying a batch are shared as well, and are queued
+   * on the reaper's own queue instead of being handed back to itself */
+  queue->enabled = 1;
+  queue->reaper = 1;
+
+  pthread_mutex_lock(&reaper_lock);
+  while(reaper_running || reaper_queue.length > 0){
+
+    if(reaper_queue.length == 0){
+      pthread_cond_wait(&reaper_signal, &reaper_lock);
+      continue;
+    }
+
+    /* take the whole queue so other threads are never blocked on a drain */
+    batch = reaper_queue.objs;
+    length = reaper_queue.length;
+    reaper_queue.objs = NULL;
+    reaper_queue.length = 0;
+    reaper_queue.capacity = 0;
+    pthread_mutex_unlock(&reaper_lock);
+
+    for(i=0; i<length; i++) ob_destroy(batch[i]);
+    free(batch);
+    ob_drain_deferred(UINT64_MAX);
+
+    pthread_mutex_lock(&reaper_lock);
+  }
+  pthread_mutex_unlock(&reaper_lock);
+
+  return NULL;
+}
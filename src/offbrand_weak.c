@@ -0,0 +1,244 @@
+/**
+ * @file offbrand_weak.c
+ * @brief Weak Reference Implementation
+ * @author theck
+ */
+
+#include "../include/offbrand.h"
+#include "../include/private/obj_private.h"
+#include "../include/private/offbrand_alloc_private.h"
+#include "../include/private/offbrand_hash_private.h"
+#include "../include/private/offbrand_weak_private.h"
+
+/** class descriptor shared by all weak handles */
+static const ob_class ob_weak_class = {
+  .classname = "ob_weak",
+  .size = sizeof(ob_weak),
+  .dealloc = &ob_weak_destroy,
+  .hash = NULL,
+  .compare = NULL,
+  .display = &ob_weak_display,
+  .traverse = NULL /* targets are not referenced, only pointed to */
+};
+
+/** handle of every weakly referenced instance, protected by weak_lock */
+static ob_weak_table weak_table;
+/** lock protecting weak_table, handle targets and instance weak fields */
+static pthread_mutex_t weak_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* PUBLIC METHODS */
+
+ob_weak * ob_weak_new(obj *target){
+
+  uint64_t slot;
+  ob_weak *handle, *existing;
+
+  assert(target != NULL);
+  assert(ob_reference_count(target) > 0); /* caller must hold a reference */
+
+  /* handles are reached by any thread looking up the same target, so their
+   * own reference count is always atomic */
+  handle = (ob_weak *)ob_alloc_outside_arena(&ob_weak_class);
+  handle->target = NULL;
+  ob_share((obj *)handle);
+
+  pthread_mutex_lock(&weak_lock);
+
+  if(weak_table.count + 1 > weak_table.capacity/2) ob_weak_table_grow();
+
+  slot = ob_weak_table_slot(target);
+  existing = weak_table.handles[slot];
+
+  if(existing && ob_weak_retain_if_live((obj *)existing)){
+    pthread_mutex_unlock(&weak_lock);
+    ob_release((obj *)handle);
+    return existing;
+  }
+
+  /* an existing handle being deallocated by another thread is replaced, and
+   * leaves the table untouched when its deallocator runs */
+  if(existing) existing->target = NULL;
+  else weak_table.count++;
+
+  weak_table.handles[slot] = handle;
+  handle->target = target;
+  atomic_store_explicit(&target->weak, 1, memory_order_relaxed);
+
+  pthread_mutex_unlock(&weak_lock);
+
+  return handle;
+}
+
+
+obj * ob_weak_lock(ob_weak *weak){
+
+  obj *target;
+
+  assert(weak != NULL);
+  OB_ASSERT_CLASS(weak, &ob_weak_class);
+
+  pthread_mutex_lock(&weak_lock);
+  target = weak->target;
+  if(target && !ob_weak_retain_if_live(target)) target = NULL;
+  pthread_mutex_unlock(&weak_lock);
+
+  return target;
+}
+
+
+/* PRIVATE METHODS */
+
+void ob_weak_clear(obj *target){
+
+  uint64_t slot;
+  ob_weak *handle;
+
+  pthread_mutex_lock(&weak_lock);
+
+  /* the handle may have been deallocated since the weak field was read */
+  if(weak_table.count > 0){
+    slot = ob_weak_table_slot(target);
+    if((handle = weak_table.handles[slot])){
+      handle->target = NULL;
+      ob_weak_table_remove(slot);
+    }
+  }
+  atomic_store_explicit(&target->weak, 0, memory_order_relaxed);
+
+  pthread_mutex_unlock(&weak_lock);
+
+  return;
+}
+
+
+uint8_t ob_weak_retain_if_live(obj *instance){
+
+  ob_ref_count_t count;
+
+  count = atomic_load_explicit(&instance->references, memory_order_relaxed);
+
+  if(!(instance->flags & OB_FLAG_SHARED)){
+    if(count == 0) return 0;
+    ob_retain(instance);
+    return 1;
+  }
+
+  /* a shared instance may be released to 0 by another thread at any time, it
+   * must never be revived once it has been */
+  do{
+    if(count == 0) return 0;
+  }while(!atomic_compare_exchange_weak_explicit(&instance->references, &count,
+                                                count+1, memory_order_relaxed,
+                                                memory_order_relaxed));
+
+  OB_REF_TRACE(OB_REF_TRACE_RETAIN, instance, instance->cls, count+1,
+               __builtin_return_address(0));
+
+  return 1;
+}
+
+
+uint64_t ob_weak_table_slot(const obj *target){
+
+  uint64_t slot, mask = weak_table.capacity - 1;
+
+  slot = ob_hash_finalize((uint64_t)(uintptr_t)target) & mask;
+  while(weak_table.handles[slot] && weak_table.handles[slot]->target != target)
+    slot = (slot + 1) & mask;
+
+  return slot;
+}
+
+
+void ob_weak_table_remove(uint64_t slot){
+
+  uint64_t next, home, mask = weak_table.capacity - 1;
+  ob_weak *handle;
+
+  /* move back each following handle whose home slot is not between the hole
+   * and its current slot */
+  next = slot;
+  while((handle = weak_table.handles[next = (next + 1) & mask])){
+    home = ob_hash_finalize((uint64_t)(uintptr_t)handle->target) & mask;
+    if(((next - home) & mask) >= ((next - slot) & mask)){
+      weak_table.handles[slot] = handle;
+      slot = next;
+    }
+  }
+
+  weak_table.handles[slot] = NULL;
+  weak_table.count--;
+
+  /* return the table storage once no instance is weakly referenced */
+  if(weak_table.count == 0){
+    free(weak_table.handles);
+    weak_table.handles = NULL;
+    weak_table.capacity = 0;
+  }
+
+  return;
+}
+
+
+void ob_weak_table_grow(void){
+
+  uint64_t i, capacity;
+  ob_weak **handles;
+
+  handles = weak_table.handles;
+  capacity = weak_table.capacity;
+
+  weak_table.capacity = capacity ? capacity*2 : OB_WEAK_INITIAL_CAPACITY;
+  weak_table.handles = calloc(weak_table.capacity, sizeof(ob_weak *));
+  assert(weak_table.handles != NULL);
+
+  for(i=0; i<capacity; i++)
+    if(handles[i])
+      weak_table.handles[ob_weak_table_slot(handles[i]->target)] = handles[i];
+
+  free(handles);
+
+  return;
+}
+
+
+void ob_weak_destroy(obj *to_dealloc){
+
+  uint64_t slot;
+  ob_weak *instance = (ob_weak *)to_dealloc;
+
+  assert(to_dealloc);
+  OB_ASSERT_CLASS(to_dealloc, &ob_weak_class);
+
+  pthread_mutex_lock(&weak_lock);
+
+  if(instance->target){
+    slot = ob_weak_table_slot(instance->target);
+    assert(weak_table.handles[slot] == instance);
+    atomic_store_explicit(&instance->target->weak, 0, memory_order_relaxed);
+    ob_weak_table_remove(slot);
+  }
+
+  pthread_mutex_unlock(&weak_lock);
+
+  return;
+}
+
+
+void ob_weak_display(const obj *to_print){
+
+  obj *target;
+
+  assert(to_print);
+  OB_ASSERT_CLASS(to_print, &ob_weak_class);
+
+  pthread_mutex_lock(&weak_lock);
+  target = ((ob_weak *)to_print)->target;
+  pthread_mutex_unlock(&weak_lock);
+
+  if(target) fprintf(stderr, "  weak reference to 0x%p\n", (void *)target);
+  else fprintf(stderr, "  weak reference to a deallocated instance\n");
+
+  return;
+}
@@ -7,14 +7,54 @@
 #include "../../include/offbrand.h"
 #include "../../include/obdeque.h"
 #include "../../include/obtest.h"
+#include "../../include/obint.h"
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+/** instance searched for by find_first */
+static const obj *searched;
+
+/**
+ * @brief Comparison function checking that the instance searched for is
+ * passed as its first argument
+ */
+static int8_t find_first(const obj *a, const obj *b){
+  assert(a == searched);
+  return ob_compare(a, b);
+}
+
+/**
+ * @brief Counts the elements visited by a cursor over a deque
+ */
+static uint64_t count_visited(const obdeque *deque){
+
+  uint64_t count = 0;
+  ob_cursor cursor;
+
+  if(obdeque_cursor_begin(deque, &cursor)){
+    do{
+      count++;
+    }while(obdeque_cursor_next(&cursor));
+  }
+
+  return count;
+}
 
 /** main unit test routine */
 int main (){
 
   obdeque *test_deque_a, *test_deque_b, *joined_deque;
   obdeque_iterator *head_it, *tail_it, *copy_it;
+  ob_cursor cursor;
   obtest *a, *b, *c, *d, *e;
   uint32_t i;
+  obint *number;
+  ob_writer *writer;
+  ob_reader *reader;
+  FILE *file;
+  pid_t child;
+  int status;
 
   /* create test objects */
   test_deque_a = obdeque_new();
@@ -30,6 +70,7 @@ int main (){
   assert(obdeque_length(test_deque_a) == 0);
   assert(obdeque_head_iterator(test_deque_a) == NULL);
   assert(obdeque_tail_iterator(test_deque_a) == NULL);
+  assert(obdeque_cursor_begin(test_deque_a, &cursor) == 0);
 
   /* test a deque with a single element */
   obdeque_add_at_head(test_deque_a, (obj *)a);
@@ -49,6 +90,8 @@ int main (){
   assert(obtest_id((obtest *)obdeque_obj_at_iterator(test_deque_a, tail_it)) == 1);
 
   assert(obdeque_find_obj(test_deque_a, (obj *)a));
+  searched = (obj *)b;
+  assert(!obdeque_find_obj_with_funct(test_deque_a, (obj *)b, &find_first));
 
   /* test removing the only element from the deque */
   obdeque_remove_tail(test_deque_a);
@@ -90,12 +133,15 @@ int main (){
 
   test_deque_b = obdeque_copy(test_deque_a);
 
-  assert(ob_reference_count((obj *)a) == 3);
+  /* the copy shares nodes with test_deque_a until either is modified */
+  assert(ob_reference_count((obj *)a) == 2);
   assert(ob_compare((obj *)test_deque_a, (obj *)test_deque_b) == OB_EQUAL_TO);
   assert(ob_hash((obj *)test_deque_a) ==  ob_hash((obj *)test_deque_b));
 
   obdeque_sort(test_deque_a, OB_LEAST_TO_GREATEST);
 
+  assert(ob_reference_count((obj *)a) == 3);
+  assert(obtest_id((obtest *)obdeque_obj_at_head(test_deque_b)) == 4);
   assert(obdeque_length(test_deque_a) == 5);
   assert(ob_compare((obj *)test_deque_a, (obj *)test_deque_b) == OB_NOT_EQUAL);
   assert(ob_hash((obj *)test_deque_a) !=  ob_hash((obj *)test_deque_b));
@@ -108,6 +154,15 @@ int main (){
   }while(obdeque_iterate_next(test_deque_a, head_it));
 
   ob_release((obj *)head_it);
+
+  /* cursors visit the same elements without allocating */
+  i = 1;
+  assert(obdeque_cursor_begin(test_deque_a, &cursor));
+  do{
+    assert(obtest_id((obtest *)obdeque_cursor_get(&cursor)) == i);
+    i++;
+  }while(obdeque_cursor_next(&cursor));
+  assert(i == 6);
   ob_release((obj *)test_deque_a);
   assert(ob_reference_count((obj *)a) == 2);
 
@@ -116,7 +171,7 @@ int main (){
   obdeque_sort(joined_deque, OB_GREATEST_TO_LEAST);
 
   assert(obdeque_length(joined_deque) == 10);
-  assert(ob_reference_count((obj *)a) == 5); /* the joined deque has two references,
+  assert(ob_reference_count((obj *)a) == 4); /* the joined deque has two references,
                                             as a is contained within twice */
 
   tail_it = obdeque_tail_iterator(joined_deque);
@@ -164,6 +219,89 @@ int main (){
   ob_release((obj *)b);
   ob_release((obj *)a);
 
+  /* test deques read back equal and in order */
+  test_deque_a = obdeque_new();
+  for(i=0; i<2048; i++){
+    number = obint_new((int64_t)i*i - 1000);
+    obdeque_add_at_tail(test_deque_a, (obj *)number);
+    ob_release((obj *)number);
+  }
+
+  file = tmpfile();
+  assert(file);
+  writer = ob_writer_new_file(file);
+  ob_serialize((obj *)test_deque_a, writer);
+  obdeque_clear(test_deque_a);
+  ob_serialize((obj *)test_deque_a, writer);
+  assert(ob_writer_flush(writer));
+  ob_writer_destroy(writer);
+
+  rewind(file);
+  reader = ob_reader_new_file(file);
+  test_deque_b = (obdeque *)ob_deserialize(reader);
+  assert(obdeque_length(test_deque_b) == 2048);
+  for(i=0; i<2048; i++){
+    number = (obint *)obdeque_obj_at_head(test_deque_b);
+    assert(obint_value(number) == (int64_t)i*i - 1000);
+    obdeque_remove_head(test_deque_b);
+  }
+  ob_release((obj *)test_deque_b);
+  test_deque_b = (obdeque *)ob_deserialize(reader);
+  assert(obdeque_is_empty(test_deque_b));
+  assert(ob_reader_at_end(reader) && !ob_reader_failed(reader));
+  ob_reader_destroy(reader);
+  fclose(file);
+  ob_release((obj *)test_deque_b);
+  ob_release((obj *)test_deque_a);
+
+  /* test the iterator used to modify a copied deque moves to its cloned nodes,
+   * leaving the copy untouched */
+  test_deque_a = obdeque_new();
+  for(i=0; i<3; i++){
+    number = obint_new(i);
+    obdeque_add_at_tail(test_deque_a, (obj *)number);
+    ob_release((obj *)number);
+  }
+  tail_it = obdeque_tail_iterator(test_deque_a);
+  test_deque_b = obdeque_copy(test_deque_a);
+  number = obint_new(3);
+  obdeque_add_at_iterator(test_deque_a, tail_it, (obj *)number);
+  obdeque_remove_at_iterator(test_deque_a, tail_it);
+  assert(obdeque_obj_at_iterator(test_deque_a, tail_it) ==
+         obdeque_obj_at_tail(test_deque_b));
+  assert(obdeque_length(test_deque_a) == 3 && count_visited(test_deque_a) == 3);
+  assert(obdeque_length(test_deque_b) == 3 && count_visited(test_deque_b) == 3);
+  assert(obdeque_obj_at_head(test_deque_a) == obdeque_obj_at_head(test_deque_b));
+  ob_release((obj *)tail_it);
+  ob_release((obj *)test_deque_b);
+
+  /* test other iterators of a deque cloned by a modification are rejected
+   * rather than modifying its copy */
+  tail_it = obdeque_tail_iterator(test_deque_a);
+  test_deque_b = obdeque_copy(test_deque_a);
+  obdeque_add_at_head(test_deque_a, (obj *)number);
+#ifndef NDEBUG
+  fflush(stdout);
+  child = fork();
+  assert(child >= 0);
+  if(child == 0){
+    assert(freopen("/dev/null", "w", stderr));
+    obdeque_remove_at_iterator(test_deque_a, tail_it);
+    _exit(0);
+  }
+  assert(waitpid(child, &status, 0) == child);
+  assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+#else
+  (void)child;
+  (void)status;
+#endif
+  assert(obdeque_length(test_deque_a) == 4 && count_visited(test_deque_a) == 4);
+  assert(obdeque_length(test_deque_b) == 3 && count_visited(test_deque_b) == 3);
+  ob_release((obj *)tail_it);
+  ob_release((obj *)number);
+  ob_release((obj *)test_deque_b);
+  ob_release((obj *)test_deque_a);
+
   printf("obdeque: TESTS PASSED\n");
   return 0;
 }
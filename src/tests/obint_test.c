@@ -8,6 +8,11 @@
 #include "../../include/obint.h"
 #include "../../include/private/obint_private.h"
 #include "../../include/obstring.h"
+#include "../../include/obvector.h"
+#include "../../include/obtyped.h"
+#include <unistd.h>
+
+OB_DEFINE_TYPED_COMPARE(compare_ints, obint, obint_compare_typed)
 
 /**
  * @brief Main unit testing routine
@@ -16,6 +21,13 @@ int main (){
 
   obint *a, *b, *c;
   obstring *str1, *str2;
+  obvector *v;
+  ob_writer *writer;
+  ob_reader *reader;
+  int fds[2];
+  /* obint of 40 digits, truncated after its first byte of digits */
+  const unsigned char malformed[] = {1, 5, 'o', 'b', 'i', 'n', 't',
+                                     0xa1, 1, 1};
 
   /* test machine integer creation and value methods */
   a = obint_new(1024);
@@ -286,6 +298,106 @@ int main (){
   ob_release((obj *)b);
   ob_release((obj *)c);
 
+  /* test cached hashes, which must be reset when digits are modified */
+  a = obint_new(120000);
+  b = obint_new(1200);
+  assert(ob_hash((obj *)a) != ob_hash((obj *)b));
+  assert(ob_hash((obj *)b) == ob_hash((obj *)b));
+  obint_shift(b, 2);
+  assert(ob_hash((obj *)a) == ob_hash((obj *)b));
+
+  ob_release((obj *)a);
+  ob_release((obj *)b);
+
+  /* test statically dispatched comparisions and hashes, which must agree with
+   * the class descriptor functions */
+  a = obint_new(-700);
+  b = obint_new(35);
+  c = obint_new(-700000);
+  assert(ob_compare_typed(a, b) == OB_LESS_THAN);
+  assert(ob_compare_typed(b, a) == OB_GREATER_THAN);
+  assert(ob_compare_typed(a, c) == ob_compare((obj *)a, (obj *)c));
+  assert(ob_compare_typed((const obint *)a, a) == OB_EQUAL_TO);
+  assert(ob_hash_typed(c) == ob_hash((obj *)c));
+
+  v = obvector_new(8);
+  obvector_store_at_index(v, (obj *)b, 0);
+  obvector_store_at_index(v, (obj *)a, 1);
+  obvector_store_at_index(v, (obj *)c, 2);
+  assert(ob_compare_typed((obj *)v, (obj *)v) == OB_EQUAL_TO);
+  assert(ob_hash_typed((obj *)v) == ob_hash((obj *)v));
+
+  obvector_sort_with_funct(v, OB_LEAST_TO_GREATEST, &compare_ints);
+  assert(obvector_length(v) == 3);
+  assert(obvector_obj_at_index(v, 0) == (obj *)c);
+  assert(obvector_obj_at_index(v, 1) == (obj *)a);
+  assert(obvector_obj_at_index(v, 2) == (obj *)b);
+  ob_release((obj *)c);
+  c = obint_new(-700);
+  assert(obvector_find_obj_with_funct(v, (obj *)c, &compare_ints));
+  ob_release((obj *)c);
+  c = obint_new(700);
+  assert(!obvector_find_obj_with_funct(v, (obj *)c, &compare_ints));
+
+  ob_release((obj *)a);
+  ob_release((obj *)b);
+  ob_release((obj *)c);
+  ob_release((obj *)v);
+
+  /* test immortal small integers, which arithmetic results never modify */
+  a = obint_new(-3);
+  assert(a == obint_new(-3) && ob_is_immortal((obj *)a));
+  c = obint_new(OB_INT_CACHE_MAX+1);
+  assert(!ob_is_immortal((obj *)c));
+  ob_release((obj *)c);
+  b = obint_multiply_primitive(a, 2);
+  c = obint_divide_primitive(b, -3);
+  assert(obint_value(b) == -6 && obint_value(c) == 2);
+  ob_release((obj *)b);
+  ob_release((obj *)c);
+  b = obint_mod_primitive(a, 2);
+  assert(obint_value(b) == -1 && obint_value(a) == -3);
+  assert(obint_value(obint_new(6)) == 6 && obint_value(obint_new(2)) == 2);
+  assert(ob_release((obj *)a) == (obj *)a && obint_value(a) == -3);
+  ob_release((obj *)b);
+
+  /* test integers of either representation read back equal, through file
+   * descriptors written and read without stdio */
+  str1 = obstring_new("-123456789012345678901234567890");
+  a = obint_from_string(str1);
+  b = obint_new(-(OB_INT_CACHE_MAX+1));
+  assert(pipe(fds) == 0);
+  writer = ob_writer_new_fd(fds[1]);
+  ob_serialize((obj *)a, writer);
+  ob_serialize((obj *)b, writer);
+  ob_writer_destroy(writer);
+  close(fds[1]);
+
+  reader = ob_reader_new_fd(fds[0]);
+  c = (obint *)ob_deserialize(reader);
+  assert(ob_compare((obj *)c, (obj *)a) == OB_EQUAL_TO);
+  ob_release((obj *)c);
+  c = (obint *)ob_deserialize(reader);
+  assert(obint_value(c) == -(OB_INT_CACHE_MAX+1));
+  assert(ob_reader_at_end(reader));
+  ob_reader_destroy(reader);
+  close(fds[0]);
+  ob_release((obj *)a);
+  ob_release((obj *)b);
+  ob_release((obj *)c);
+  ob_release((obj *)str1);
+
+  /* test truncated data fails rather than returning a partial instance */
+  assert(pipe(fds) == 0);
+  assert(write(fds[1], malformed, sizeof(malformed)) == sizeof(malformed));
+  close(fds[1]);
+
+  reader = ob_reader_new_fd(fds[0]);
+  assert(ob_deserialize(reader) == NULL);
+  assert(ob_reader_failed(reader));
+  ob_reader_destroy(reader);
+  close(fds[0]);
+
   printf("obint: TESTS PASSED\n");
   return 0;
 }
@@ -8,6 +8,9 @@
 #include "../../include/obmap.h"
 #include "../../include/private/obmap_private.h"
 #include "../../include/obtest.h"
+#include "../../include/obint.h"
+#include "../../include/obstring.h"
+#include "../../include/obvector.h"
 
 /** Size of array to use in testing larger Map capacities */
 #define ARRAY_SIZE 2048
@@ -19,10 +22,21 @@ int main (){
 
   uint32_t i;
 
-  obmap *test_map, *map_copy;
+  obmap *test_map, *map_copy, *weak_map, *weak_copy, *serial_map, *read_map;
+  obmap *plain_equal, *weak_equal;
+  obint *big;
+  obstring *numstr;
+  ob_writer *writer;
+  ob_reader *reader;
+  FILE *file;
+  uint32_t key_references;
   obtest *a, *b, *c, *d, *e, *f, *g, *h;
   obtest *test_array[ARRAY_SIZE];
   obtest *test;
+  ob_cursor cursor;
+  obmap *footprint_map, *footprint_copy;
+  obvector *footprint_both;
+  ob_footprint footprint, copy_footprint;
 
   test_map = obmap_new();
   a = obtest_new(1);
@@ -68,8 +82,13 @@ int main (){
   test = (obtest *)obmap_lookup(test_map, (obj *)h);
   assert(ob_compare((obj *)f, (obj *)test) == OB_EQUAL_TO);
 
+  /* copies share pairs until either map is modified */
+  i = ob_reference_count((obj *)c);
   map_copy = obmap_copy(test_map);
+  assert(ob_reference_count((obj *)c) == i);
+
   obmap_insert(test_map, (obj *)e, NULL); /* remove binding of e -> c */
+  assert(ob_reference_count((obj *)c) == i);
   test = (obtest *)obmap_lookup(map_copy, (obj *)e);
 
   assert(ob_compare((obj *)test, (obj *)c) == OB_EQUAL_TO);
@@ -106,6 +125,124 @@ int main (){
     assert(ob_compare((obj *) test_array[i],
                    obmap_lookup(test_map, (obj *)test_array[i])) ==OB_EQUAL_TO);
 
+  /* cursors visit every pair exactly once */
+  i = 0;
+  assert(obmap_cursor_begin(test_map, &cursor));
+  do{
+    assert(obmap_lookup(test_map, obmap_cursor_get(&cursor)) ==
+           obmap_cursor_value(&cursor));
+    i++;
+  }while(obmap_cursor_next(&cursor));
+  assert(i == obdeque_length(test_map->pairs));
+  assert(!obmap_cursor_begin(map_copy, &cursor));
+
+  /* weak valued maps do not keep values alive, and drop expired entries */
+  weak_map = obmap_new_weak_valued();
+  test = obtest_new(ARRAY_SIZE);
+  key_references = ob_reference_count((obj *)a);
+  obmap_insert(weak_map, (obj *)a, (obj *)test);
+  obmap_insert(weak_map, (obj *)b, (obj *)c);
+
+  assert(obmap_lookup(weak_map, (obj *)a) == (obj *)test);
+  assert(ob_reference_count((obj *)test) == 1);
+
+  weak_copy = obmap_copy(weak_map);
+  ob_release((obj *)test);
+
+  assert(obmap_lookup(weak_map, (obj *)a) == NULL);
+  assert(obmap_lookup(weak_copy, (obj *)a) == NULL);
+  assert(obmap_lookup(weak_copy, (obj *)b) == (obj *)c);
+  assert(obmap_cursor_begin(weak_map, &cursor) &&
+         obmap_cursor_value(&cursor) == NULL);
+
+  obmap_rehash(weak_map);
+  obmap_rehash(weak_copy);
+  assert(obdeque_length(weak_map->pairs) == 1);
+  assert(ob_reference_count((obj *)a) == key_references);
+  assert(obmap_lookup(weak_map, (obj *)b) == (obj *)c);
+
+  /* weak valued maps hash and compare by their values rather than by the
+   * handles holding them */
+  test = obtest_new(3);
+  plain_equal = obmap_new();
+  obmap_insert(plain_equal, (obj *)b, (obj *)test);
+  weak_equal = obmap_new_weak_valued();
+  obmap_insert(weak_equal, (obj *)b, (obj *)test);
+  assert(ob_compare((obj *)weak_map, (obj *)plain_equal) == OB_EQUAL_TO);
+  assert(ob_compare((obj *)weak_map, (obj *)weak_equal) == OB_EQUAL_TO);
+  assert(ob_hash((obj *)weak_map) == ob_hash((obj *)plain_equal));
+  obmap_insert(plain_equal, (obj *)b, (obj *)a);
+  assert(ob_compare((obj *)weak_map, (obj *)plain_equal) == OB_NOT_EQUAL);
+
+  ob_release((obj *)weak_equal);
+  ob_release((obj *)plain_equal);
+  ob_release((obj *)test);
+  ob_release((obj *)weak_copy);
+  ob_release((obj *)weak_map);
+
+  /* maps read back equal to what was written, sharing key and value classes */
+  serial_map = obmap_new();
+  numstr = obstring_new("-123456789012345678901234567890");
+  big = obint_from_string(numstr);
+
+  for(i=0; i<ARRAY_SIZE; i++){
+    test = (obtest *)obint_new((int64_t)i*i - 1000);
+    obmap_insert(serial_map, (obj *)test, (obj *)numstr);
+    ob_release((obj *)test);
+  }
+  obmap_insert(serial_map, (obj *)numstr, (obj *)big);
+
+  file = tmpfile();
+  assert(file);
+  writer = ob_writer_new_file(file);
+  ob_serialize((obj *)serial_map, writer);
+  ob_serialize(NULL, writer);
+  assert(ob_writer_flush(writer));
+  ob_writer_destroy(writer);
+
+  rewind(file);
+  reader = ob_reader_new_file(file);
+  read_map = (obmap *)ob_deserialize(reader);
+  assert(read_map);
+  assert(obdeque_length(read_map->pairs) == ARRAY_SIZE+1);
+  assert(ob_compare((obj *)read_map, (obj *)serial_map) == OB_EQUAL_TO);
+  assert(ob_hash((obj *)read_map) == ob_hash((obj *)serial_map));
+  assert(ob_deserialize(reader) == NULL && !ob_reader_failed(reader));
+  assert(ob_reader_at_end(reader));
+  ob_reader_destroy(reader);
+  fclose(file);
+  ob_release((obj *)read_map);
+
+  /* footprints count the table, pairs, nodes and iterators of a map, and
+   * instances shared by pairs or copies once */
+  footprint_map = obmap_new();
+  for(i=0; i<ARRAY_SIZE; i++)
+    obmap_insert(footprint_map, (obj *)test_array[i], (obj *)test_array[i]);
+
+  ob_memory_footprint((obj *)footprint_map, &footprint);
+  assert(footprint.objs == 3 + 4*ARRAY_SIZE);
+  assert(footprint.deep_bytes > footprint.shallow_bytes);
+  assert(footprint.unused_bytes < footprint.deep_bytes);
+
+  footprint_copy = obmap_copy(footprint_map);
+  footprint_both = obvector_new(2);
+  obvector_store_at_index(footprint_both, (obj *)footprint_map, 0);
+  obvector_store_at_index(footprint_both, (obj *)footprint_copy, 1);
+  ob_memory_footprint((obj *)footprint_both, &copy_footprint);
+  assert(copy_footprint.objs == footprint.objs + 2);
+  assert(copy_footprint.deep_bytes < 2*footprint.deep_bytes);
+
+  ob_memory_footprint(NULL, &footprint);
+  assert(footprint.objs == 0 && footprint.deep_bytes == 0);
+
+  ob_release((obj *)footprint_both);
+  ob_release((obj *)footprint_copy);
+  ob_release((obj *)footprint_map);
+
+  ob_release((obj *)big);
+  ob_release((obj *)numstr);
+  ob_release((obj *)serial_map);
+
   ob_release((obj *)a);
   ob_release((obj *)b);
   ob_release((obj *)c);
@@ -0,0 +1,178 @@
+/**
+ * @file obsnapshot_test.c
+ * @brief obsnapshot Unit Tests
+ * @author theck
+ */
+
+#include "../../include/offbrand.h"
+#include "../../include/obsnapshot.h"
+#include "../../include/obstring.h"
+#include "../../include/obvector.h"
+#include "../../include/obmap.h"
+#include "../../include/private/obsnapshot_private.h" /* For testing purposes
+                                                         only */
+#include <stddef.h>
+
+/** Number of pairs of the map frozen in testing */
+#define PAIR_COUNT 1000
+
+/**
+ * @brief Main unit testing routine
+ */
+int main (){
+
+  uint32_t i, length;
+  char path[] = "/tmp/obsnapshot_testXXXXXX";
+  char buffer[32];
+  int fd;
+  obmap *dictionary, *inner, *inner_thawed;
+  obvector *list;
+  obstring *key, *value;
+  obsnapshot *snapshot;
+  obsnapshot_ref root, ref;
+  uint64_t damaged[2];
+  ob_cursor cursor;
+  obj *thawed;
+  const char *view;
+
+  fd = mkstemp(path);
+  assert(fd >= 0);
+  close(fd);
+
+  dictionary = obmap_new();
+  for(i=0; i<PAIR_COUNT; i++){
+    sprintf(buffer, "key%u", i);
+    key = obstring_new(buffer);
+    sprintf(buffer, "value%u", i);
+    value = obstring_new(buffer);
+    obmap_insert(dictionary, (obj *)key, (obj *)value);
+    ob_release((obj *)key);
+    ob_release((obj *)value);
+  }
+
+  inner = obmap_new();
+  list = obvector_new(4);
+  key = obstring_new("nested");
+  obmap_insert(inner, (obj *)key, (obj *)key);
+  obvector_store_at_index(list, (obj *)key, 0);
+  obvector_store_at_index(list, (obj *)inner, 2);
+  obmap_insert(dictionary, (obj *)key, (obj *)list);
+  ob_release((obj *)key);
+
+  assert(obsnapshot_write((obj *)dictionary, path));
+  snapshot = obsnapshot_open(path);
+  assert(snapshot);
+
+  /* lookups read the mapped table, strings are views into the mapping */
+  root = obsnapshot_root(snapshot);
+  assert(obsnapshot_kind(snapshot, root) == OBSNAPSHOT_MAP);
+  assert(obsnapshot_length(snapshot, root) == PAIR_COUNT + 1);
+
+  for(i=0; i<PAIR_COUNT; i++){
+    sprintf(buffer, "key%u", i);
+    ref = obsnapshot_lookup(snapshot, root, buffer, strlen(buffer));
+    view = obsnapshot_string(snapshot, ref, &length);
+    sprintf(buffer, "value%u", i);
+    assert(view && length == strlen(buffer) && strcmp(view, buffer) == 0);
+    assert(view > (char *)snapshot->data &&
+           view < (char *)snapshot->data + snapshot->size);
+  }
+
+  assert(obsnapshot_lookup(snapshot, root, "key", 3) == OBSNAPSHOT_NONE);
+  assert(obsnapshot_lookup(snapshot, root, "key10", 4) ==
+         obsnapshot_lookup(snapshot, root, "key1", 4));
+  assert(obsnapshot_string(snapshot, root, NULL) == NULL);
+
+  ref = obsnapshot_lookup(snapshot, root, "nested", 6);
+  assert(obsnapshot_kind(snapshot, ref) == OBSNAPSHOT_VECTOR);
+  assert(obsnapshot_length(snapshot, ref) == 3);
+  assert(obsnapshot_at_index(snapshot, ref, 1) == OBSNAPSHOT_NONE);
+  assert(obsnapshot_at_index(snapshot, ref, 3) == OBSNAPSHOT_NONE);
+  assert(strcmp(obsnapshot_string(snapshot,
+                                  obsnapshot_at_index(snapshot, ref, 0), NULL),
+                "nested") == 0);
+  ref = obsnapshot_at_index(snapshot, ref, -1);
+  assert(obsnapshot_kind(snapshot, ref) == OBSNAPSHOT_MAP);
+  assert(obsnapshot_lookup(snapshot, ref, "nested", 6) != OBSNAPSHOT_NONE);
+
+  /* cursors visit every pair exactly once */
+  i = 0;
+  assert(obsnapshot_cursor_begin(snapshot, root, &cursor));
+  do{
+    view = obsnapshot_string(snapshot, obsnapshot_cursor_key(&cursor),
+                             &length);
+    assert(obsnapshot_lookup(snapshot, root, view, length) ==
+           obsnapshot_cursor_value(&cursor));
+    i++;
+  }while(obsnapshot_cursor_next(&cursor));
+  assert(i == PAIR_COUNT + 1);
+
+  thawed = obsnapshot_thaw(snapshot, root);
+  assert(ob_compare(thawed, (obj *)dictionary) == OB_EQUAL_TO);
+  ob_release(thawed);
+
+  /* references that do not address a record are rejected */
+  assert(obsnapshot_kind(snapshot, OBSNAPSHOT_NONE) == OBSNAPSHOT_NULL);
+  assert(obsnapshot_kind(snapshot, root + 4) == OBSNAPSHOT_NULL);
+  assert(obsnapshot_kind(snapshot, snapshot->size) == OBSNAPSHOT_NULL);
+  assert(obsnapshot_thaw(snapshot, root + 8) == NULL);
+
+  ob_release((obj *)snapshot);
+
+  /* references to the record holding them or to later records are damaged,
+   * so thawing a snapshot patched to contain cycles terminates */
+  assert(obsnapshot_write((obj *)list, path));
+  snapshot = obsnapshot_open(path);
+  assert(snapshot);
+  root = obsnapshot_root(snapshot);
+  ref = obsnapshot_at_index(snapshot, root, 2);
+  assert(obsnapshot_cursor_begin(snapshot, ref, &cursor));
+  damaged[0] = root + offsetof(obsnapshot_vector_record, elements);
+  damaged[1] = ref + offsetof(obsnapshot_map_record, slots) +
+               cursor.index*sizeof(obsnapshot_slot) +
+               offsetof(obsnapshot_slot, value);
+  ob_release((obj *)snapshot);
+
+  fd = open(path, O_WRONLY);
+  assert(fd >= 0);
+  assert(pwrite(fd, &root, sizeof(root), damaged[0]) == sizeof(root));
+  assert(pwrite(fd, &ref, sizeof(ref), damaged[1]) == sizeof(ref));
+  close(fd);
+
+  snapshot = obsnapshot_open(path);
+  assert(snapshot);
+  assert(obsnapshot_at_index(snapshot, root, 0) == OBSNAPSHOT_NONE);
+  assert(obsnapshot_lookup(snapshot, ref, "nested", 6) == OBSNAPSHOT_NONE);
+  assert(obsnapshot_cursor_begin(snapshot, ref, &cursor));
+  assert(obsnapshot_cursor_value(&cursor) == OBSNAPSHOT_NONE);
+  assert(obsnapshot_cursor_key(&cursor) != OBSNAPSHOT_NONE);
+
+  thawed = obsnapshot_thaw(snapshot, root);
+  assert(obvector_obj_at_index((obvector *)thawed, 0) == NULL);
+  inner_thawed = (obmap *)obvector_obj_at_index((obvector *)thawed, 2);
+  key = obstring_new("nested");
+  assert(obmap_lookup(inner_thawed, (obj *)key) == NULL);
+  ob_release((obj *)key);
+  ob_release(thawed);
+  ob_release((obj *)snapshot);
+
+  /* truncated and foreign files are not opened */
+  assert(truncate(path, sizeof(obsnapshot_header) + 8) == 0);
+  assert(obsnapshot_open(path) == NULL);
+  assert(truncate(path, 0) == 0);
+  assert(obsnapshot_open(path) == NULL);
+
+  assert(obsnapshot_write(NULL, path));
+  snapshot = obsnapshot_open(path);
+  assert(snapshot && obsnapshot_root(snapshot) == OBSNAPSHOT_NONE);
+  ob_release((obj *)snapshot);
+
+  unlink(path);
+  ob_release((obj *)inner);
+  ob_release((obj *)list);
+  ob_release((obj *)dictionary);
+
+  printf("obsnapshot: TESTS PASSED\n");
+
+  return 0;
+}
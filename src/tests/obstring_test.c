@@ -6,6 +6,10 @@
 
 #include "../../include/offbrand.h"
 #include "../../include/obstring.h"
+#include "../../include/obdeque.h"
+#include "../../include/obtyped.h"
+
+OB_DEFINE_TYPED_COMPARE(compare_strings, obstring, obstring_compare_typed)
 
 /**
  * @brief Main unit testing routine
@@ -14,7 +18,11 @@ int main (){
 
   obstring *str1, *str2, *str3, *null_str;
   obvector *tokens;
+  obdeque *deque;
   const char *contents;
+  ob_writer *writer;
+  ob_reader *reader;
+  FILE *file;
 
   str1 = obstring_new("Hello, World!");
 
@@ -69,6 +77,29 @@ int main (){
   assert(ob_compare((obj *)str1, (obj *)str3) == OB_LESS_THAN);
   assert(ob_compare((obj *)str1, (obj *)null_str) == OB_GREATER_THAN);
 
+  /* Test String Hashing, equal strings hash equally */
+  assert(ob_hash((obj *)str1) == ob_hash((obj *)str2));
+  assert(ob_hash((obj *)str1) != ob_hash((obj *)str3));
+  assert(ob_hash((obj *)str1) == ob_hash_bytes("Hello, World!", 13));
+  assert(ob_hash_combine(ob_hash((obj *)str1), ob_hash((obj *)str3)) !=
+         ob_hash_combine(ob_hash((obj *)str3), ob_hash((obj *)str1)));
+
+  /* Test statically dispatched comparision and hashing */
+  assert(ob_compare_typed(str1, str2) == OB_EQUAL_TO);
+  assert(ob_compare_typed(str1, str3) == OB_LESS_THAN);
+  assert(ob_compare_typed(str1, null_str) == OB_GREATER_THAN);
+  assert(ob_hash_typed(str1) == ob_hash((obj *)str1));
+  assert(ob_hash_typed((const obstring *)str3) == ob_hash((obj *)str3));
+
+  deque = obdeque_new();
+  obdeque_add_at_tail(deque, (obj *)str3);
+  obdeque_add_at_tail(deque, (obj *)null_str);
+  assert(obdeque_find_obj_with_funct(deque, (obj *)str3, &compare_strings));
+  assert(!obdeque_find_obj_with_funct(deque, (obj *)str1, &compare_strings));
+  obdeque_add_at_tail(deque, (obj *)str2);
+  assert(obdeque_find_obj_with_funct(deque, (obj *)str1, &compare_strings));
+  ob_release((obj *)deque);
+
   ob_release((obj *)str2);
   ob_release((obj *)str3);
 
@@ -109,6 +140,55 @@ int main (){
   ob_release((obj *)str1);
   ob_release((obj *)null_str);
 
+  /* Test immortal empty and single character strings */
+  str1 = obstring_new("");
+  str2 = obstring_new("a,b");
+  str3 = obstring_copy_substring(str2, 0, 1);
+  assert(ob_is_immortal((obj *)str1) && ob_is_immortal((obj *)str3));
+  assert(str1 == obstring_concat(str1, str1));
+  assert(str3 == obstring_new("a"));
+  assert(ob_release((obj *)str3) == (obj *)str3);
+  assert(ob_reference_count((obj *)str3) == 1);
+
+  tokens = obstring_split(str2, ",");
+  assert(obvector_obj_at_index(tokens, 0) == (obj *)str3);
+  assert(strcmp(obstring_cstring(str3), "a") == 0);
+  ob_release((obj *)tokens);
+
+  tokens = obstring_split(obstring_new(","), ",");
+  assert(obvector_obj_at_index(tokens, 0) == (obj *)str1);
+  assert(strcmp(obstring_cstring(obstring_new(",")), ",") == 0);
+  ob_release((obj *)tokens);
+
+  ob_release((obj *)str2);
+
+  /* test strings read back equal, the class named only once in the stream */
+  str1 = obstring_new("Hello, World!");
+  file = tmpfile();
+  assert(file);
+  writer = ob_writer_new_file(file);
+  ob_serialize((obj *)str1, writer);
+  ob_serialize((obj *)obstring_new(""), writer);
+  ob_serialize((obj *)str1, writer);
+  assert(ob_writer_flush(writer));
+  ob_writer_destroy(writer);
+
+  rewind(file);
+  reader = ob_reader_new_file(file);
+  str2 = (obstring *)ob_deserialize(reader);
+  assert(ob_compare((obj *)str2, (obj *)str1) == OB_EQUAL_TO);
+  ob_release((obj *)str2);
+  str2 = (obstring *)ob_deserialize(reader);
+  assert(obstring_length(str2) == 0);
+  ob_release((obj *)str2);
+  str2 = (obstring *)ob_deserialize(reader);
+  assert(strcmp(obstring_cstring(str2), "Hello, World!") == 0);
+  ob_release((obj *)str2);
+  assert(ob_reader_at_end(reader) && !ob_reader_failed(reader));
+  ob_reader_destroy(reader);
+  fclose(file);
+  ob_release((obj *)str1);
+
   /* TESTS COMPLETE */
   printf("obstring: TESTS PASSED\n");
 
@@ -6,6 +6,214 @@
 
 #include "../../include/offbrand.h"
 #include "../../include/obtest.h"
+#include "../../include/obvector.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/** Number of threads concurrently retaining and releasing shared objs */
+#define NUM_THREADS 4
+/** Number of objs stored in the shared vector */
+#define NUM_SHARED 64
+/** Number of copy and release cycles each thread performs */
+#define NUM_CYCLES 2000
+/** Number of iterations of parallel loops */
+#define NUM_ITERATIONS 10000
+/** Argument of the parallel recursive Fibonacci computation */
+#define FIB_ARGUMENT 20
+/** Number of operation trace events kept by trace_hook */
+#define MAX_TRACE_EVENTS 16
+
+/** Number of times each iteration of a parallel loop ran */
+static _Atomic uint32_t visits[NUM_ITERATIONS];
+/** Start of the next range a serial pool is expected to run */
+static uint64_t next_begin;
+/** Operation trace events passed to trace_hook */
+static ob_op_trace_event trace_events[MAX_TRACE_EVENTS];
+/** Number of operation trace events passed to trace_hook */
+static uint32_t trace_count;
+
+/**
+ * @brief Argument and result of a parallel Fibonacci computation
+ */
+typedef struct fib_task_struct{
+  uint64_t n; /**< argument */
+  uint64_t result; /**< Fibonacci number n */
+} fib_task;
+
+/**
+ * @brief Thread routine, repeatedly copies, modifies and releases a shared
+ * obvector so that every contained obj is retained and released concurrently
+ *
+ * @param arg Shared obvector instance
+ * @return NULL
+ */
+void * share_worker(void *arg){
+
+  int i;
+  obvector *copy;
+
+  for(i=0; i<NUM_CYCLES; i++){
+    copy = obvector_copy((obvector *)arg);
+    obvector_store_at_index(copy, NULL, 0); /* copies the shared storage */
+    ob_release((obj *)copy);
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Thread routine, repeatedly locks a weak handle to a shared obj until
+ * the obj has been deallocated
+ *
+ * @param arg Weak handle
+ * @return NULL
+ */
+void * weak_worker(void *arg){
+
+  int i;
+  obj *target;
+
+  for(i=0; i<NUM_CYCLES; i++){
+    if(!(target = ob_weak_lock((ob_weak *)arg))) break;
+    ob_release(target);
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief Thread routine, repeatedly pushes and drains autorelease pools and
+ * deferred destruction queues, whose storage is kept between drains and freed
+ * when the thread exits
+ *
+ * @param arg Unused
+ * @return NULL
+ */
+void * autorelease_worker(void *arg){
+
+  int i;
+
+  (void)arg;
+
+  for(i=0; i<NUM_CYCLES; i++){
+    ob_push_autorelease_pool();
+    ob_autorelease((obj *)obtest_new(i));
+    ob_drain_autorelease_pool();
+  }
+
+  ob_defer_destruction(1);
+  for(i=0; i<NUM_CYCLES; i++){
+    ob_release((obj *)obtest_new(i));
+    ob_drain_deferred(UINT64_MAX);
+  }
+  ob_defer_destruction(0);
+
+  return NULL;
+}
+
+/**
+ * @brief Parallel loop body, counts each visit of an iteration
+ *
+ * @param begin First iteration
+ * @param end Iteration following the last
+ * @param context Unused
+ */
+void visit_range(uint64_t begin, uint64_t end, void *context){
+  (void)context;
+  for(; begin<end; begin++) atomic_fetch_add(&visits[begin], 1);
+}
+
+/**
+ * @brief Parallel loop body, visits each iteration of a row with a nested
+ * parallel loop
+ *
+ * @param begin First row
+ * @param end Row following the last
+ * @param context Pool to run the nested loop on
+ */
+void visit_rows(uint64_t begin, uint64_t end, void *context){
+  for(; begin<end; begin++)
+    ob_parallel_for(context, begin*100, (begin+1)*100, 7, &visit_range, NULL);
+}
+
+/**
+ * @brief Parallel loop body, checks that a serial pool runs whole grains in
+ * order
+ *
+ * @param begin First iteration
+ * @param end Iteration following the last
+ * @param context Unused
+ */
+void serial_range(uint64_t begin, uint64_t end, void *context){
+  (void)context;
+  if(begin != next_begin || (end - begin != 64 && end != NUM_ITERATIONS)){
+    fprintf(stderr, "obtest_test: serial pool ran ranges out of order, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+  next_begin = end;
+}
+
+/**
+ * @brief Task, computes a Fibonacci number by forking both subproblems
+ *
+ * @param arg fib_task to compute
+ */
+void fib(void *arg){
+
+  fib_task *task = arg;
+  fib_task first, second;
+
+  if(task->n < 2){
+    task->result = task->n;
+    return;
+  }
+
+  first.n = task->n - 1;
+  second.n = task->n - 2;
+  ob_parallel_invoke(NULL, &fib, &first, &fib, &second);
+  task->result = first.result + second.result;
+}
+
+/**
+ * @brief Operation trace hook, keeps each event and counts it in the context,
+ * then grows a vector of its own which must not be traced
+ *
+ * @param event Event of a traced operation
+ * @param context Counter of calls
+ */
+void trace_hook(const ob_op_trace_event *event, void *context){
+
+  obvector *scratch;
+
+  if(trace_count < MAX_TRACE_EVENTS) trace_events[trace_count] = *event;
+  trace_count++;
+  (*(uint32_t *)context)++;
+
+  scratch = obvector_new(1);
+  obvector_store_at_index(scratch, (obj *)scratch, 8);
+  obvector_store_at_index(scratch, NULL, 8);
+  ob_release((obj *)scratch);
+}
+
+/**
+ * @brief Checks that every iteration of a parallel loop ran exactly once and
+ * clears the visit counts
+ *
+ * @return non-zero if every iteration ran exactly once
+ */
+uint8_t visited_once(void){
+
+  int i;
+  uint8_t retval = 1;
+
+  for(i=0; i<NUM_ITERATIONS; i++){
+    if(atomic_load(&visits[i]) != 1) retval = 0;
+    atomic_store(&visits[i], 0);
+  }
+
+  return retval;
+}
 
 /**
  * @brief Main unit testing routine
@@ -13,7 +221,20 @@
 int main(){
 
   int i;
+  char name[16];
+  pthread_t threads[NUM_THREADS];
   obtest *test_obj, *a, *b;
+  obvector *shared_vec, *arena_vec, *footprint_vec, *copy_vec, *outer_vec;
+  ob_footprint footprint, shared_footprint;
+  uint32_t hook_calls = 0;
+  ob_arena *arena;
+  ob_weak *weak, *weak_copy;
+  ob_pool *pool;
+  fib_task fib_root;
+  void *freed_block;
+  ob_class_stats stats;
+  FILE *report;
+  char line[128];
   test_obj = obtest_new(1);
   a = obtest_new(3);
   b = obtest_new(3);
@@ -57,8 +278,331 @@ int main(){
     exit(1);
   }
 
+  /* class name built at runtime cannot share the descriptor string */
+  strcpy(name, "obtest");
+  if(!ob_has_class((obj *)a, name) || ob_has_class((obj *)a, "obtes")){
+    fprintf(stderr, "obtest_test: class check by a non-constant class name "
+                    "failed, TEST FAILED\n");
+    exit(1);
+  }
+
   ob_hash((obj *)a);
 
+  /* autoreleased objs are released only when their own pool drains */
+  ob_push_autorelease_pool();
+  ob_autorelease(ob_retain((obj *)a));
+  ob_push_autorelease_pool();
+  ob_autorelease(ob_retain((obj *)a));
+  ob_autorelease((obj *)obtest_new(4));
+
+  if(ob_reference_count((obj *)a) != 3){
+    fprintf(stderr, "obtest_test: ob_autorelease changed reference count "
+                    "before drain, TEST FAILED\n");
+    exit(1);
+  }
+
+  ob_drain_autorelease_pool();
+  if(ob_reference_count((obj *)a) != 2){
+    fprintf(stderr, "obtest_test: inner pool drain did not release exactly "
+                    "its objs, TEST FAILED\n");
+    exit(1);
+  }
+
+  ob_drain_autorelease_pool();
+  if(ob_reference_count((obj *)a) != 1){
+    fprintf(stderr, "obtest_test: outer pool drain did not release its objs, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+
+  pthread_create(&threads[0], NULL, &autorelease_worker, NULL);
+  pthread_join(threads[0], NULL);
+
+#ifndef OB_NO_SLAB
+  /* a released obtest block is the first one reused by the next obtest */
+  test_obj = obtest_new(5);
+  freed_block = test_obj;
+  ob_release((obj *)test_obj);
+  test_obj = obtest_new(6);
+  if((void *)test_obj != freed_block){
+    fprintf(stderr, "obtest_test: released obtest memory was not reused by "
+                    "the next obtest, TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)test_obj);
+#endif
+
+  /* arena instances are deallocated on arena destruction, releasing the
+   * normally allocated instances they reference */
+  arena = ob_arena_new();
+  ob_arena_enter(arena);
+  arena_vec = obvector_new(4);
+  obvector_store_at_index(arena_vec, (obj *)a, 0);
+  test_obj = obtest_new(9);
+  obvector_store_at_index(arena_vec, (obj *)test_obj, 1);
+  ob_release((obj *)test_obj);
+  ob_release((obj *)arena_vec);
+  test_obj = (obtest *)ob_arena_copy_out((obj *)obtest_new(10));
+  ob_arena_exit();
+
+  if(ob_reference_count((obj *)a) != 2){
+    fprintf(stderr, "obtest_test: arena instance released before arena "
+                    "destruction, TEST FAILED\n");
+    exit(1);
+  }
+
+  ob_arena_destroy(arena);
+  if(ob_reference_count((obj *)a) != 1 ||
+     ob_reference_count((obj *)test_obj) != 1 || obtest_id(test_obj) != 10){
+    fprintf(stderr, "obtest_test: arena destruction did not release "
+                    "referenced instances or damaged a copied out instance, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)test_obj);
+
+  /* deferred destruction releases contents only when drained */
+  ob_defer_destruction(1);
+  arena_vec = obvector_new(4);
+  obvector_store_at_index(arena_vec, (obj *)a, 0);
+  ob_release((obj *)arena_vec);
+  if(ob_reference_count((obj *)a) != 2 || ob_drain_deferred(1) != 0 ||
+     ob_reference_count((obj *)a) != 1){
+    fprintf(stderr, "obtest_test: deferred destruction did not wait for a "
+                    "drain, TEST FAILED\n");
+    exit(1);
+  }
+
+  /* objects shared between threads keep exact reference counts */
+  shared_vec = obvector_new(NUM_SHARED);
+  for(i=0; i<NUM_SHARED; i++){
+    test_obj = obtest_new(i);
+    obvector_store_at_index(shared_vec, (obj *)test_obj, i);
+    ob_release((obj *)test_obj);
+  }
+
+  if(ob_is_shared((obj *)a)){
+    fprintf(stderr, "obtest_test: new obtest considered shared, TEST FAILED\n");
+    exit(1);
+  }
+
+  ob_share((obj *)shared_vec);
+  if(!ob_is_shared(obvector_obj_at_index(shared_vec, NUM_SHARED-1))){
+    fprintf(stderr, "obtest_test: ob_share did not share vector contents, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+
+  for(i=0; i<NUM_THREADS; i++)
+    pthread_create(&threads[i], NULL, &share_worker, shared_vec);
+  for(i=0; i<NUM_THREADS; i++)
+    pthread_join(threads[i], NULL);
+
+  for(i=0; i<NUM_SHARED; i++){
+    if(ob_reference_count(obvector_obj_at_index(shared_vec, i)) != 1){
+      fprintf(stderr, "obtest_test: shared obtest reference count corrupted by "
+                      "concurrent retain/release, TEST FAILED\n");
+      exit(1);
+    }
+  }
+
+  /* shared instances are destroyed by the reaper thread */
+  ob_start_reaper();
+  ob_release((obj *)shared_vec);
+  ob_stop_reaper();
+  ob_defer_destruction(0);
+  if(ob_drain_deferred(UINT64_MAX) != 0){
+    fprintf(stderr, "obtest_test: shared instances not handed to the reaper "
+                    "thread, TEST FAILED\n");
+    exit(1);
+  }
+
+  /* footprints count instances held twice once, and report unused capacity */
+  footprint_vec = obvector_new(8);
+  obvector_store_at_index(footprint_vec, (obj *)a, 0);
+  obvector_store_at_index(footprint_vec, (obj *)a, 1);
+  obvector_store_at_index(footprint_vec, (obj *)b, 2);
+  ob_memory_footprint((obj *)footprint_vec, &footprint);
+  if(footprint.objs != 3 || footprint.unused_bytes != 5*sizeof(obj *) ||
+     footprint.deep_bytes <= footprint.shallow_bytes){
+    fprintf(stderr, "obtest_test: footprint miscounted instances, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+
+  /* storage shared by copies on write is counted once, until modified */
+  copy_vec = obvector_copy(footprint_vec);
+  outer_vec = obvector_new(2);
+  obvector_store_at_index(outer_vec, (obj *)footprint_vec, 0);
+  obvector_store_at_index(outer_vec, (obj *)copy_vec, 1);
+  ob_memory_footprint((obj *)outer_vec, &shared_footprint);
+  obvector_store_at_index(copy_vec, NULL, 2);
+  ob_memory_footprint((obj *)outer_vec, &footprint);
+  if(shared_footprint.objs != 5 ||
+     footprint.deep_bytes <= shared_footprint.deep_bytes){
+    fprintf(stderr, "obtest_test: footprint counted shared storage twice, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)outer_vec);
+  ob_release((obj *)copy_vec);
+  ob_release((obj *)footprint_vec);
+
+  /* expensive operations pass begin and end events to the hook while set */
+  footprint_vec = obvector_new(1);
+  ob_set_op_trace_hook(&trace_hook, &hook_calls);
+  obvector_store_at_index(footprint_vec, (obj *)b, 3);
+  obvector_store_at_index(footprint_vec, (obj *)a, 0);
+  obvector_sort(footprint_vec, OB_LEAST_TO_GREATEST);
+  ob_set_op_trace_hook(NULL, NULL);
+  obvector_store_at_index(footprint_vec, (obj *)a, 100);
+  if(trace_count != 4 || hook_calls != 4 ||
+     strcmp(trace_events[0].operation, "obvector_resize") != 0 ||
+     trace_events[0].phase != OB_OP_TRACE_BEGIN ||
+     trace_events[1].phase != OB_OP_TRACE_END ||
+     strcmp(trace_events[2].operation, "obvector_sort_with_funct") != 0 ||
+     trace_events[2].size != 4 || trace_events[3].phase != OB_OP_TRACE_END ||
+     trace_events[3].instance != (obj *)footprint_vec ||
+     trace_events[3].timestamp_ns < trace_events[0].timestamp_ns){
+    fprintf(stderr, "obtest_test: operation trace events incorrect, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)footprint_vec);
+
+  ob_release((obj *)a);
+  ob_release((obj *)b);
+
+  /* weak handles resolve to their target only while it is alive */
+  test_obj = obtest_new(12);
+  weak = ob_weak_new((obj *)test_obj);
+  weak_copy = ob_weak_new((obj *)test_obj);
+  if(weak != weak_copy || ob_reference_count((obj *)test_obj) != 1 ||
+     ob_weak_lock(weak) != (obj *)test_obj ||
+     ob_reference_count((obj *)test_obj) != 2){
+    fprintf(stderr, "obtest_test: weak handle did not resolve to its live "
+                    "target, TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)test_obj);
+  ob_release((obj *)test_obj);
+  ob_release((obj *)weak_copy);
+  if(ob_weak_lock(weak) != NULL){
+    fprintf(stderr, "obtest_test: weak handle resolved to a deallocated "
+                    "target, TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)weak);
+
+  /* shared targets may be deallocated while other threads lock handles */
+  test_obj = obtest_new(13);
+  ob_share((obj *)test_obj);
+  weak = ob_weak_new((obj *)test_obj);
+  for(i=0; i<NUM_THREADS; i++)
+    pthread_create(&threads[i], NULL, &weak_worker, weak);
+  ob_release((obj *)test_obj);
+  for(i=0; i<NUM_THREADS; i++)
+    pthread_join(threads[i], NULL);
+  if(ob_weak_lock(weak) != NULL){
+    fprintf(stderr, "obtest_test: weak handle to a shared target resolved "
+                    "after deallocation, TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)weak);
+
+  /* arena targets stop resolving once their arena is destroyed */
+  arena = ob_arena_new();
+  ob_arena_enter(arena);
+  test_obj = obtest_new(14);
+  weak = ob_weak_new((obj *)test_obj);
+  ob_arena_exit();
+  if(ob_weak_lock(weak) != (obj *)test_obj){
+    fprintf(stderr, "obtest_test: weak handle to an arena instance did not "
+                    "resolve, TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)test_obj);
+  ob_arena_destroy(arena);
+  if(ob_weak_lock(weak) != NULL){
+    fprintf(stderr, "obtest_test: weak handle resolved to an instance of a "
+                    "destroyed arena, TEST FAILED\n");
+    exit(1);
+  }
+  ob_release((obj *)weak);
+
+#ifndef OB_NO_REF_TRACE
+  /* traced instances appear in the report until deallocated */
+  ob_start_ref_trace();
+  test_obj = obtest_new(11);
+  ob_retain((obj *)test_obj);
+  ob_release((obj *)test_obj);
+  ob_stop_ref_trace();
+
+  report = tmpfile();
+  ob_print_ref_trace_report(report, 10);
+  rewind(report);
+  i = 0;
+  while(fgets(line, sizeof(line), report))
+    if(strstr(line, "obtest")) i++;
+  fclose(report);
+  ob_release((obj *)test_obj);
+  ob_clear_ref_trace();
+
+  /* alloc, retain and release call sites, and the live instance */
+  if(i != 4){
+    fprintf(stderr, "obtest_test: reference trace report incorrect, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+#endif
+
+#ifndef OB_NO_CLASS_STATS
+  /* every obtest allocated by any thread has been freed */
+  if(!ob_get_class_stats("obtest", &stats) || stats.live != 0 ||
+     stats.allocations != stats.frees || stats.peak_live < NUM_SHARED ||
+     ob_get_class_stats("not a class", &stats)){
+    fprintf(stderr, "obtest_test: class statistics incorrect, TEST FAILED\n");
+    exit(1);
+  }
+#endif
+
+  /* parallel loops run every iteration once, on any pool and nested */
+  pool = ob_pool_new(NUM_THREADS);
+  ob_parallel_for(pool, 0, NUM_ITERATIONS, 0, &visit_range, NULL);
+  if(ob_pool_threads(pool) != NUM_THREADS || !visited_once()){
+    fprintf(stderr, "obtest_test: parallel loop missed iterations, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+  ob_parallel_for(pool, 0, NUM_ITERATIONS/100, 1, &visit_rows, pool);
+  i = visited_once();
+  ob_parallel_for(NULL, 0, NUM_ITERATIONS/100, 3, &visit_rows, pool);
+  if(!i || !visited_once()){
+    fprintf(stderr, "obtest_test: nested parallel loops missed iterations, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+  ob_pool_destroy(pool);
+
+  fib_root.n = FIB_ARGUMENT;
+  fib(&fib_root);
+  if(fib_root.result != 6765){
+    fprintf(stderr, "obtest_test: fork-join computed wrong result, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+
+  /* serial pools run loops in order on the calling thread */
+  pool = ob_pool_new(1);
+  next_begin = 0;
+  ob_parallel_for(pool, 0, NUM_ITERATIONS, 64, &serial_range, NULL);
+  if(next_begin != NUM_ITERATIONS){
+    fprintf(stderr, "obtest_test: serial pool missed iterations, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+  ob_pool_destroy(pool);
+
   printf("obtest: TEST PASSED\n");
   return 0;
 }
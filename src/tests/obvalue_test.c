@@ -0,0 +1,261 @@
+/**
+ * @file obvalue_test.c
+ * @brief Unboxed Container Template Unit Tests
+ * @author theck
+ */
+
+#include "../../include/offbrand.h"
+#include <math.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+/** Point with a custom comparison, ordered by x only */
+typedef struct{
+  int32_t x; /**< sort key */
+  int32_t y; /**< payload */
+} point;
+
+/** Compares points by x, so sorts may be checked for stability with y */
+#define POINT_COMPARE(a, b) \
+  ((a).x < (b).x ? OB_LESS_THAN : ((b).x < (a).x ? OB_GREATER_THAN : \
+                                                   OB_EQUAL_TO))
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME u32vector
+#define OB_VALUE_TYPE uint32_t
+#include "../../include/obvalue_vector.h"
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME pointvector
+#define OB_VALUE_TYPE point
+#define OB_VALUE_COMPARE(a, b) POINT_COMPARE(a, b)
+#define OB_VALUE_EQUAL(a, b) ((a).x == (b).x && (a).y == (b).y)
+#define OB_VALUE_HASH(p) ob_hash_combine(ob_hash_bytes(&(p).x, 4), \
+                                         ob_hash_bytes(&(p).y, 4))
+#include "../../include/obvalue_vector.h"
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME i64deque
+#define OB_VALUE_TYPE int64_t
+#include "../../include/obvalue_deque.h"
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME u32map
+#define OB_VALUE_KEY_TYPE uint32_t
+#define OB_VALUE_TYPE double
+#include "../../include/obvalue_map.h"
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME f64vector
+#define OB_VALUE_TYPE double
+#include "../../include/obvalue_vector.h"
+
+#define OB_VALUE_IMPLEMENTATION
+#define OB_VALUE_NAME f64map
+#define OB_VALUE_KEY_TYPE double
+#define OB_VALUE_TYPE uint32_t
+#include "../../include/obvalue_map.h"
+
+/** Number of values added by each test */
+#define NUM_VALUES 1000
+
+/**
+ * @brief Main unit testing routine
+ */
+int main (){
+
+  uint32_t i, key;
+  uint64_t cursor;
+  double value;
+  u32vector *vec, *vec_copy;
+  pointvector *points;
+  point p;
+  i64deque *deque, *deque_copy;
+  u32map *map, *map_copy;
+  f64vector *zeros, *negative_zeros;
+  f64map *f64_map;
+  uint32_t found;
+  pid_t child;
+  int status;
+  ob_footprint footprint;
+
+  /* test vector access, growth and search */
+  vec = u32vector_new(0);
+  for(i=0; i<NUM_VALUES; i++) u32vector_append(vec, (i*7919) % NUM_VALUES);
+  assert(u32vector_length(vec) == NUM_VALUES);
+  assert(u32vector_at(vec, 1) == 919);
+  assert(u32vector_find(vec, 999));
+  assert(!u32vector_find(vec, NUM_VALUES));
+  u32vector_set(vec, 1, 5000);
+  assert(u32vector_find(vec, 5000) && u32vector_values(vec)[1] == 5000);
+  u32vector_set(vec, 1, 919);
+
+  /* test vector sorting, equality and hashing */
+  vec_copy = u32vector_copy(vec);
+  assert(ob_compare((obj *)vec, (obj *)vec_copy) == OB_EQUAL_TO);
+  assert(ob_hash((obj *)vec) == ob_hash((obj *)vec_copy));
+  u32vector_sort(vec, OB_LEAST_TO_GREATEST);
+  for(i=0; i<NUM_VALUES; i++) assert(u32vector_at(vec, i) == i);
+  assert(ob_compare((obj *)vec, (obj *)vec_copy) == OB_NOT_EQUAL);
+  u32vector_sort(vec_copy, OB_GREATEST_TO_LEAST);
+  for(i=0; i<NUM_VALUES; i++)
+    assert(u32vector_at(vec_copy, i) == NUM_VALUES-1-i);
+  assert(u32vector_pop(vec_copy) == 0);
+  assert(u32vector_length(vec_copy) == NUM_VALUES-1);
+
+  /* test values are stored inline, in a single block */
+  u32vector_reserve(vec, NUM_VALUES);
+  ob_memory_footprint((obj *)vec, &footprint);
+  assert(footprint.objs == 1);
+  assert(footprint.deep_bytes == sizeof(u32vector) +
+                                 NUM_VALUES*sizeof(uint32_t));
+  assert(footprint.unused_bytes == 0);
+
+  u32vector_clear(vec);
+  assert(u32vector_length(vec) == 0 && !u32vector_find(vec, 0));
+  ob_release((obj *)vec);
+  ob_release((obj *)vec_copy);
+
+  /* test struct values with custom comparison, sorting is stable */
+  points = pointvector_new(4);
+  for(i=0; i<NUM_VALUES; i++){
+    p.x = i % 10;
+    p.y = i;
+    pointvector_append(points, p);
+  }
+  pointvector_sort(points, OB_LEAST_TO_GREATEST);
+  for(i=1; i<NUM_VALUES; i++){
+    assert(pointvector_at(points, i-1).x <= pointvector_at(points, i).x);
+    if(pointvector_at(points, i-1).x == pointvector_at(points, i).x)
+      assert(pointvector_at(points, i-1).y < pointvector_at(points, i).y);
+  }
+  p.x = 3;
+  p.y = 13;
+  assert(pointvector_find(points, p));
+  p.y = 14;
+  assert(!pointvector_find(points, p));
+  ob_release((obj *)points);
+
+  /* test deque access at both ends, wrapping around its storage */
+  deque = i64deque_new(4);
+  for(i=0; i<3; i++) i64deque_add_at_tail(deque, i);
+  assert(i64deque_remove_head(deque) == 0);
+  assert(i64deque_remove_head(deque) == 1);
+  for(i=3; i<6; i++) i64deque_add_at_tail(deque, i);
+  assert(deque->capacity == 4 && deque->head + deque->length > 4);
+  i64deque_add_at_head(deque, -1);
+  assert(i64deque_length(deque) == 5);
+  assert(i64deque_value_at_head(deque) == -1);
+  assert(i64deque_value_at_tail(deque) == 5);
+  assert(i64deque_at(deque, 1) == 2 && i64deque_at(deque, 4) == 5);
+  assert(i64deque_find(deque, 5) && i64deque_find(deque, -1));
+  assert(!i64deque_find(deque, 0));
+
+  /* test deque sorting, copying and equality */
+  for(i=0; i<NUM_VALUES; i++){
+    if(i % 2) i64deque_add_at_head(deque, i);
+    else i64deque_add_at_tail(deque, -(int64_t)i);
+  }
+  deque_copy = i64deque_copy(deque);
+  assert(ob_compare((obj *)deque, (obj *)deque_copy) == OB_EQUAL_TO);
+  assert(ob_hash((obj *)deque) == ob_hash((obj *)deque_copy));
+  i64deque_sort(deque, OB_LEAST_TO_GREATEST);
+  for(i=1; i<i64deque_length(deque); i++)
+    assert(i64deque_at(deque, i-1) <= i64deque_at(deque, i));
+  assert(ob_compare((obj *)deque, (obj *)deque_copy) == OB_NOT_EQUAL);
+  assert(i64deque_remove_tail(deque) == NUM_VALUES-1);
+  assert(i64deque_value_at_head(deque) == -(NUM_VALUES-2));
+  i64deque_clear(deque);
+  assert(i64deque_is_empty(deque));
+  ob_release((obj *)deque);
+  ob_release((obj *)deque_copy);
+
+  /* test map insertion, replacement and lookup */
+  map = u32map_new(0);
+  for(i=0; i<NUM_VALUES; i++) u32map_insert(map, i*31, i/2.0);
+  assert(u32map_length(map) == NUM_VALUES);
+  assert(u32map_lookup(map, 31*10, &value) && value == 5.0);
+  assert(!u32map_lookup(map, 30, NULL));
+  u32map_insert(map, 31*10, -1.0);
+  assert(u32map_length(map) == NUM_VALUES);
+  assert(u32map_lookup(map, 31*10, &value) && value == -1.0);
+  u32map_insert(map, 31*10, 5.0);
+
+  /* test map equality is independent of insertion order */
+  map_copy = u32map_new(NUM_VALUES);
+  for(i=NUM_VALUES; i>0; i--) u32map_insert(map_copy, (i-1)*31, (i-1)/2.0);
+  assert(ob_compare((obj *)map, (obj *)map_copy) == OB_EQUAL_TO);
+  assert(ob_hash((obj *)map) == ob_hash((obj *)map_copy));
+  ob_release((obj *)map_copy);
+
+  /* test removal leaves every remaining key reachable */
+  map_copy = u32map_copy(map);
+  for(i=0; i<NUM_VALUES; i+=2) assert(u32map_remove(map, i*31));
+  assert(!u32map_remove(map, 0));
+  assert(u32map_length(map) == NUM_VALUES/2);
+  for(i=0; i<NUM_VALUES; i++)
+    assert(u32map_lookup(map, i*31, &value) == i % 2);
+  assert(ob_compare((obj *)map, (obj *)map_copy) == OB_NOT_EQUAL);
+
+  /* test iteration visits each pair once */
+  cursor = 0;
+  i = 0;
+  while(u32map_next(map, &cursor, &key, &value)){
+    assert(key % 62 == 31 && value == key/62.0);
+    i++;
+  }
+  assert(i == NUM_VALUES/2);
+
+  u32map_clear(map);
+  assert(u32map_length(map) == 0 && !u32map_lookup(map, 31, NULL));
+  ob_release((obj *)map);
+  ob_release((obj *)map_copy);
+
+  /* test 0.0 and -0.0, which are equal, hash equally */
+  zeros = f64vector_new(0);
+  negative_zeros = f64vector_new(0);
+  f64vector_append(zeros, 0.0);
+  f64vector_append(negative_zeros, -0.0);
+  assert(ob_compare((obj *)zeros, (obj *)negative_zeros) == OB_EQUAL_TO);
+  assert(ob_hash((obj *)zeros) == ob_hash((obj *)negative_zeros));
+  assert(f64vector_find(negative_zeros, 0.0));
+  f64vector_append(zeros, NAN);
+  assert(!f64vector_find(zeros, NAN));
+  ob_release((obj *)zeros);
+  ob_release((obj *)negative_zeros);
+
+  /* test a map finds 0.0 and -0.0 as the same key, at any capacity */
+  f64_map = f64map_new(0);
+  for(i=1; i<NUM_VALUES; i++) f64map_insert(f64_map, i/4.0, i);
+  f64map_insert(f64_map, -0.0, NUM_VALUES);
+  assert(f64map_lookup(f64_map, 0.0, &found) && found == NUM_VALUES);
+  f64map_insert(f64_map, 0.0, 0);
+  assert(f64map_length(f64_map) == NUM_VALUES);
+  assert(f64map_lookup(f64_map, -0.0, &found) && found == 0);
+  assert(f64map_remove(f64_map, 0.0) && !f64map_lookup(f64_map, -0.0, NULL));
+  assert(!f64map_lookup(f64_map, NAN, NULL));
+
+  /* test a NaN key, which could never be found, is rejected */
+#ifndef NDEBUG
+  fflush(stdout);
+  child = fork();
+  assert(child >= 0);
+  if(child == 0){
+    assert(freopen("/dev/null", "w", stderr));
+    f64map_insert(f64_map, NAN, 1);
+    _exit(0);
+  }
+  assert(waitpid(child, &status, 0) == child);
+  assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+#else
+  (void)child;
+  (void)status;
+#endif
+  ob_release((obj *)f64_map);
+
+  /* TESTS COMPLETE */
+  printf("obvalue: TESTS PASSED\n");
+
+  return 0;
+}
@@ -9,13 +9,21 @@
 #include "../../include/private/obvector_private.h" /* For testing purposes
                                                        only */
 #include "../../include/obtest.h"
+#include "../../include/obint.h"
+#include "../../include/private/offbrand_serial_private.h" /* For the depth
+                                                              limit */
 
 /** main unit testing routine */
 int main(){
 
   uint32_t i, id;
   obtest *tests[6], *singleton, *tmp;
-  obvector *main_vec, *copy_vec;
+  obvector *main_vec, *copy_vec, *nested;
+  ob_cursor cursor;
+  obint *number;
+  ob_writer *writer;
+  ob_reader *reader;
+  FILE *file;
 
   main_vec = obvector_new(1);
   singleton = obtest_new(7);
@@ -155,12 +163,12 @@ int main(){
   ob_release((obj *)singleton); /* ob_release singleton once so it is only referenced
                                 by containing vectors */
 
-  for(i=0; i<obvector_length(main_vec); i++){
-    if(ob_reference_count((obj *)(obtest *)obvector_obj_at_index(main_vec, i)) != 2){
-      fprintf(stderr, "obvector_test: vector contents not ob_retained on copy, "
-                      "TEST FAILED\n");
-      exit(1);
-    }
+  /* copies share contents until either vector is modified */
+  if(copy_vec->array != main_vec->array ||
+     ob_reference_count(obvector_obj_at_index(main_vec, 0)) != 1){
+    fprintf(stderr, "obvector_test: vector contents copied eagerly, "
+                    "TEST FAILED\n");
+    exit(1);
   }
 
   /* get obj at index and ob_retain it so it isnt deallocated */
@@ -169,6 +177,22 @@ int main(){
 
   obvector_store_at_index(main_vec, NULL, 3);
 
+  if(copy_vec->array == main_vec->array ||
+     obvector_obj_at_index(copy_vec, 3) != (obj *)tmp){
+    fprintf(stderr, "obvector_test: modifying a vector changed its copy, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+
+  for(i=0; i<obvector_length(main_vec); i++){
+    if(i != 3 &&
+       ob_reference_count(obvector_obj_at_index(main_vec, i)) != 2){
+      fprintf(stderr, "obvector_test: vector contents not ob_retained on "
+                      "separation from a copy, TEST FAILED\n");
+      exit(1);
+    }
+  }
+
   assert(ob_compare((obj *)copy_vec, (obj *)main_vec) == OB_NOT_EQUAL);
   assert(ob_hash((obj *)copy_vec) != ob_hash((obj *)main_vec));
 
@@ -192,6 +216,21 @@ int main(){
     }
   }
 
+  /* cursors visit every index in order */
+  i = 0;
+  assert(obvector_cursor_begin(main_vec, &cursor));
+  do{
+    if(obvector_cursor_get(&cursor) != obvector_obj_at_index(main_vec, i))
+      break;
+    i++;
+  }while(obvector_cursor_next(&cursor));
+
+  if(i != obvector_length(main_vec)){
+    fprintf(stderr, "obvector_test: cursor did not visit each index, "
+                    "TEST FAILED\n");
+    exit(1);
+  }
+
   ob_release((obj *)main_vec);
   ob_release((obj *)copy_vec);
 
@@ -204,6 +243,65 @@ int main(){
 
   ob_release((obj *)tmp);
 
+  /* test vectors read back equal, keeping the NULL slots between elements */
+  main_vec = obvector_new(4);
+  for(i=0; i<6; i++){
+    number = obint_new((int64_t)i*1000003 - 3);
+    obvector_store_at_index(main_vec, (obj *)number, 2*i);
+    ob_release((obj *)number);
+  }
+
+  file = tmpfile();
+  assert(file);
+  writer = ob_writer_new_file(file);
+  ob_serialize((obj *)main_vec, writer);
+  assert(ob_writer_flush(writer));
+  ob_writer_destroy(writer);
+
+  rewind(file);
+  reader = ob_reader_new_file(file);
+  copy_vec = (obvector *)ob_deserialize(reader);
+  assert(obvector_length(copy_vec) == 11);
+  assert(obvector_obj_at_index(copy_vec, 3) == NULL);
+  assert(ob_compare((obj *)copy_vec, (obj *)main_vec) == OB_EQUAL_TO);
+  assert(ob_reader_at_end(reader) && !ob_reader_failed(reader));
+  ob_reader_destroy(reader);
+  fclose(file);
+  ob_release((obj *)copy_vec);
+  ob_release((obj *)main_vec);
+
+  /* test vectors nested up to the depth limit are read, and deeper ones fail
+   * rather than exhausting the stack */
+  nested = (obvector *)obint_new(1);
+  for(i=1; i<=OB_SERIAL_MAX_DEPTH; i++){
+    main_vec = obvector_new(1);
+    obvector_store_at_index(main_vec, (obj *)nested, 0);
+    ob_release((obj *)nested);
+    nested = main_vec;
+
+    if(i < OB_SERIAL_MAX_DEPTH - 1) continue;
+
+    file = tmpfile();
+    assert(file);
+    writer = ob_writer_new_file(file);
+    ob_serialize((obj *)nested, writer);
+    assert(ob_writer_flush(writer));
+    ob_writer_destroy(writer);
+
+    rewind(file);
+    reader = ob_reader_new_file(file);
+    copy_vec = (obvector *)ob_deserialize(reader);
+    if(i < OB_SERIAL_MAX_DEPTH){
+      assert(ob_compare((obj *)copy_vec, (obj *)nested) == OB_EQUAL_TO);
+      assert(!ob_reader_failed(reader));
+      ob_release((obj *)copy_vec);
+    }
+    else assert(copy_vec == NULL && ob_reader_failed(reader));
+    ob_reader_destroy(reader);
+    fclose(file);
+  }
+  ob_release((obj *)nested);
+
   printf("obvector: TESTS PASSED\n");
   return 0;
 }